@@ -20,8 +20,15 @@
 #ifdef WIN32
 #include <direct.h>
 #endif
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 #include <sys/stat.h>
+#include <cstring>
+#include <iostream>
 #include "util/check.hh"
+#include "util/exception.hh"
+#include "util/file.hh"
 #include <string>
 #include "OnDiskWrapper.h"
 
@@ -30,7 +37,29 @@ using namespace std;
 namespace OnDiskPt
 {
 
+namespace
+{
+
+void MapFile(const string &filePath, util::scoped_memory &to)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(filePath.c_str()));
+  const UINT64 size = util::SizeFile(file.get());
+  // an empty file, e.g. the target phrases of an empty table, can't be mapped
+  if (size == 0) {
+    to.reset();
+    return;
+  }
+  util::MapRead(util::LAZY, file.get(), 0, size, to);
+#ifndef WIN32
+  // lookups jump all over the file, reading ahead only wastes page cache
+  madvise(to.get(), to.size(), MADV_RANDOM);
+#endif
+}
+
+}
+
 OnDiskWrapper::OnDiskWrapper()
+  :m_rootSourceNode(NULL)
 {
 }
 
@@ -50,19 +79,29 @@ bool OnDiskWrapper::BeginLoad(const std::string &filePath)
   UINT64 rootFilePos = GetMisc("RootNodeOffset");
   m_rootSourceNode = new PhraseNode(rootFilePos, *this);
 
+#ifndef WIN32
+  // every lookup starts with a binary search of the root's children, which
+  // for a large grammar spans many pages. Have them read in now
+  UINT64 numChildren;
+  memcpy(&numChildren, GetMemSource(rootFilePos, sizeof(UINT64)), sizeof(UINT64));
+  const size_t rootSize = PhraseNode::GetNodeSize(numChildren, GetSourceWordSize(), GetNumCounts());
+  const UINT64 rootStart = rootFilePos - rootFilePos % util::SizePage();
+  madvise(const_cast<char*>(m_memSource.begin()) + rootStart, rootFilePos + rootSize - rootStart, MADV_WILLNEED);
+#endif
+
   return true;
 }
 
 bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
 {
-  m_fileSource.open((filePath + "/Source.dat").c_str(), ios::in | ios::binary);
-  CHECK(m_fileSource.is_open());
-
-  m_fileTargetInd.open((filePath + "/TargetInd.dat").c_str(), ios::in | ios::binary);
-  CHECK(m_fileTargetInd.is_open());
-
-  m_fileTargetColl.open((filePath + "/TargetColl.dat").c_str(), ios::in | ios::binary);
-  CHECK(m_fileTargetColl.is_open());
+  try {
+    MapFile(filePath + "/Source.dat", m_memSource);
+    MapFile(filePath + "/TargetInd.dat", m_memTargetInd);
+    MapFile(filePath + "/TargetColl.dat", m_memTargetColl);
+  } catch (const util::Exception &e) {
+    cerr << e.what() << endl;
+    return false;
+  }
 
   m_fileVocab.open((filePath + "/Vocab.dat").c_str(), ios::in);
   CHECK(m_fileVocab.is_open());
@@ -189,6 +228,12 @@ UINT64 OnDiskWrapper::GetMisc(const std::string &key) const
   return iter->second;
 }
 
+const char *OnDiskWrapper::GetMem(const util::scoped_memory &mem, UINT64 filePos, size_t size) const
+{
+  CHECK(filePos + size <= mem.size());
+  return mem.begin() + filePos;
+}
+
 PhraseNode &OnDiskWrapper::GetRootSourceNode()
 {
   return *m_rootSourceNode;
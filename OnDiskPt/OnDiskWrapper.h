@@ -23,6 +23,7 @@
 #include "Vocab.h"
 #include "PhraseNode.h"
 #include "../moses/src/Word.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -36,6 +37,10 @@ protected:
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
 
+  // when loading, the node and target phrase files are mapped read-only
+  // and decoded in place, so one wrapper can serve all threads
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
 
@@ -44,6 +49,7 @@ protected:
   void SaveMisc();
   bool OpenForLoad(const std::string &filePath);
   bool LoadMisc();
+  const char *GetMem(const util::scoped_memory &mem, UINT64 filePos, size_t size) const;
 
 public:
   OnDiskWrapper();
@@ -75,6 +81,19 @@ public:
     return m_fileVocab;
   }
 
+  //! the size bytes at filePos of the loaded Source.dat
+  const char *GetMemSource(UINT64 filePos, size_t size) const {
+    return GetMem(m_memSource, filePos, size);
+  }
+  //! the size bytes at filePos of the loaded TargetInd.dat
+  const char *GetMemTargetInd(UINT64 filePos, size_t size) const {
+    return GetMem(m_memTargetInd, filePos, size);
+  }
+  //! the size bytes at filePos of the loaded TargetColl.dat
+  const char *GetMemTargetColl(UINT64 filePos, size_t size) const {
+    return GetMem(m_memTargetColl, filePos, size);
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
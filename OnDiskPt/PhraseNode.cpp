@@ -17,6 +17,7 @@
  License along with this library; if not, write to the Free Software
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
+#include <cstring>
 #include "util/check.hh"
 #include "PhraseNode.h"
 #include "OnDiskWrapper.h"
@@ -53,38 +54,22 @@ PhraseNode::PhraseNode(UINT64 filePos, OnDiskWrapper &onDiskWrapper)
 
   size_t countSize = onDiskWrapper.GetNumCounts();
 
-  std::fstream &file = onDiskWrapper.GetFileSource();
-  file.seekg(filePos);
-  CHECK(filePos == (UINT64)file.tellg());
-
-  file.read((char*) &m_numChildrenLoad, sizeof(UINT64));
+  // decode the node in place
+  memcpy(&m_numChildrenLoad, onDiskWrapper.GetMemSource(filePos, sizeof(UINT64)), sizeof(UINT64));
 
   size_t memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
-  m_memLoad = (char*) malloc(memAlloc);
-
-  // go to start of node again
-  file.seekg(filePos);
-  CHECK(filePos == (UINT64)file.tellg());
-
-  // read everything into memory
-  file.read(m_memLoad, memAlloc);
-  CHECK(filePos + memAlloc == (UINT64)file.tellg());
+  m_memLoad = onDiskWrapper.GetMemSource(filePos, memAlloc);
 
   // get value
-  m_value = ((UINT64*)m_memLoad)[1];
+  memcpy(&m_value, m_memLoad + sizeof(UINT64), sizeof(UINT64));
 
   // get counts
-  float *memFloat = (float*) (m_memLoad + sizeof(UINT64) * 2);
-
   CHECK(countSize == 1);
-  m_counts[0] = memFloat[0];
-
-  m_memLoadLast = m_memLoad + memAlloc;
+  memcpy(&m_counts[0], m_memLoad + sizeof(UINT64) * 2, sizeof(float));
 }
 
 PhraseNode::~PhraseNode()
 {
-  free(m_memLoad);
   //CHECK(m_saved);
 }
 
@@ -227,7 +212,7 @@ void PhraseNode::GetChild(Word &wordFound, UINT64 &childFilePos, size_t ind, OnD
   size_t wordSize = onDiskWrapper.GetSourceWordSize();
   size_t childSize = wordSize + sizeof(UINT64);
 
-  char *currMem = m_memLoad
+  const char *currMem = m_memLoad
                   + sizeof(UINT64) * 2 // size & file pos of target phrase coll
                   + sizeof(float) * onDiskWrapper.GetNumCounts() // count info
                   + childSize * ind;
@@ -240,9 +225,8 @@ size_t PhraseNode::ReadChild(Word &wordFound, UINT64 &childFilePos, const char *
 {
   size_t memRead = wordFound.ReadFromMemory(mem);
 
-  const char *currMem = mem + memRead;
-  UINT64 *memArray = (UINT64*) (currMem);
-  childFilePos = memArray[0];
+  // the children of a node are not aligned
+  memcpy(&childFilePos, mem + memRead, sizeof(UINT64));
 
   memRead += sizeof(UINT64);
   return memRead;
@@ -45,7 +45,7 @@ protected:
 
   TargetPhraseCollection m_targetPhraseColl;
 
-  char *m_memLoad, *m_memLoadLast;
+  const char *m_memLoad; /**< the saved node, in the mapping of the source file */
   UINT64 m_numChildrenLoad;
 
   void AddTargetPhrase(size_t pos, const SourcePhrase &sourcePhrase
@@ -19,6 +19,7 @@
  ***********************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "../moses/src/Util.h"
 #include "../moses/src/TargetPhrase.h"
@@ -230,55 +231,56 @@ Moses::TargetPhrase *TargetPhrase::ConvertToMoses(const std::vector<Moses::Facto
   return ret;
 }
 
-UINT64 TargetPhrase::ReadOtherInfoFromFile(UINT64 filePos, std::fstream &fileTPColl)
+UINT64 TargetPhrase::ReadOtherInfoFromFile(UINT64 filePos, const OnDiskWrapper &onDiskWrapper)
 {
-  CHECK(filePos == (UINT64)fileTPColl.tellg());
-
-  UINT64 memUsed = 0;
-  fileTPColl.read((char*) &m_filePos, sizeof(UINT64));
-  memUsed += sizeof(UINT64);
+  // phrase id and number of alignments come first, they give the size of the rest
+  const char *mem = onDiskWrapper.GetMemTargetColl(filePos, sizeof(UINT64) * 2);
+  memcpy(&m_filePos, mem, sizeof(UINT64));
   CHECK(m_filePos != 0);
 
-  memUsed += ReadAlignFromFile(fileTPColl);
-  CHECK((memUsed + filePos) == (UINT64)fileTPColl.tellg());
+  UINT64 numAlign;
+  memcpy(&numAlign, mem + sizeof(UINT64), sizeof(UINT64));
+  UINT64 memUsed = sizeof(UINT64) * 2 + 2 * sizeof(UINT64) * numAlign + sizeof(float) * m_scores.size();
+  mem = onDiskWrapper.GetMemTargetColl(filePos, memUsed);
 
-  memUsed += ReadScoresFromFile(fileTPColl);
-  CHECK((memUsed + filePos) == (UINT64)fileTPColl.tellg());
+  UINT64 memRead = sizeof(UINT64);
+  memRead += ReadAlignFromMemory(mem + memRead);
+  memRead += ReadScoresFromMemory(mem + memRead);
+  CHECK(memRead == memUsed);
 
   return memUsed;
 }
 
-UINT64 TargetPhrase::ReadFromFile(std::fstream &fileTP)
+UINT64 TargetPhrase::ReadFromFile(const OnDiskWrapper &onDiskWrapper)
 {
-  UINT64 bytesRead = 0;
-
-  fileTP.seekg(m_filePos);
-
   UINT64 numWords;
-  fileTP.read((char*) &numWords, sizeof(UINT64));
-  bytesRead += sizeof(UINT64);
+  memcpy(&numWords, onDiskWrapper.GetMemTargetInd(m_filePos, sizeof(UINT64)), sizeof(UINT64));
+
+  const size_t wordSize = onDiskWrapper.GetTargetWordSize();
+  UINT64 bytesRead = sizeof(UINT64) + wordSize * numWords;
+  const char *mem = onDiskWrapper.GetMemTargetInd(m_filePos, bytesRead) + sizeof(UINT64);
 
   for (size_t ind = 0; ind < numWords; ++ind) {
     Word *word = new Word();
-    bytesRead += word->ReadFromFile(fileTP);
+    mem += word->ReadFromMemory(mem);
     AddWord(word);
   }
 
   return bytesRead;
 }
 
-UINT64 TargetPhrase::ReadAlignFromFile(std::fstream &fileTPColl)
+UINT64 TargetPhrase::ReadAlignFromMemory(const char *mem)
 {
   UINT64 bytesRead = 0;
 
   UINT64 numAlign;
-  fileTPColl.read((char*) &numAlign, sizeof(UINT64));
+  memcpy(&numAlign, mem, sizeof(UINT64));
   bytesRead += sizeof(UINT64);
 
   for (size_t ind = 0; ind < numAlign; ++ind) {
     AlignPair alignPair;
-    fileTPColl.read((char*) &alignPair.first, sizeof(UINT64));
-    fileTPColl.read((char*) &alignPair.second, sizeof(UINT64));
+    memcpy(&alignPair.first, mem + bytesRead, sizeof(UINT64));
+    memcpy(&alignPair.second, mem + bytesRead + sizeof(UINT64), sizeof(UINT64));
     m_align.push_back(alignPair);
 
     bytesRead += sizeof(UINT64) * 2;
@@ -287,17 +289,12 @@ UINT64 TargetPhrase::ReadAlignFromFile(std::fstream &fileTPColl)
   return bytesRead;
 }
 
-UINT64 TargetPhrase::ReadScoresFromFile(std::fstream &fileTPColl)
+UINT64 TargetPhrase::ReadScoresFromMemory(const char *mem)
 {
   CHECK(m_scores.size() > 0);
 
-  UINT64 bytesRead = 0;
-
-  for (size_t ind = 0; ind < m_scores.size(); ++ind) {
-    fileTPColl.read((char*) &m_scores[ind], sizeof(float));
-
-    bytesRead += sizeof(float);
-  }
+  UINT64 bytesRead = sizeof(float) * m_scores.size();
+  memcpy(&m_scores[0], mem, bytesRead);
 
   std::transform(m_scores.begin(),m_scores.end(),m_scores.begin(), Moses::TransformScore);
   std::transform(m_scores.begin(),m_scores.end(),m_scores.begin(), Moses::FloorScore);
@@ -54,8 +54,8 @@ protected:
   size_t WriteAlignToMemory(char *mem) const;
   size_t WriteScoresToMemory(char *mem) const;
 
-  UINT64 ReadAlignFromFile(std::fstream &fileTPColl);
-  UINT64 ReadScoresFromFile(std::fstream &fileTPColl);
+  UINT64 ReadAlignFromMemory(const char *mem);
+  UINT64 ReadScoresFromMemory(const char *mem);
 
 public:
   TargetPhrase(size_t numScores);
@@ -90,8 +90,8 @@ public:
                                       , const std::vector<float> &weightT
                                       , const Moses::WordPenaltyProducer* wpProducer
                                       , const Moses::LMList &lmList) const;
-  UINT64 ReadOtherInfoFromFile(UINT64 filePos, std::fstream &fileTPColl);
-  UINT64 ReadFromFile(std::fstream &fileTP);
+  UINT64 ReadOtherInfoFromFile(UINT64 filePos, const OnDiskWrapper &onDiskWrapper);
+  UINT64 ReadFromFile(const OnDiskWrapper &onDiskWrapper);
 
 	virtual void DebugPrint(std::ostream &out, const Vocab &vocab) const;
 
@@ -18,6 +18,7 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#include <cstring>
 #include "../moses/src/FactorCollection.h"
 #include "../moses/src/Util.h"
 #include "../moses/src/Word.h"
@@ -67,8 +68,8 @@ size_t Word::WriteToMemory(char *mem) const
 
 size_t Word::ReadFromMemory(const char *mem)
 {
-  UINT64 *vocabMem = (UINT64*) mem;
-  m_vocabId = vocabMem[0];
+  // words are stored unaligned within a node
+  memcpy(&m_vocabId, mem, sizeof(UINT64));
 
   size_t memUsed = sizeof(UINT64);
 
@@ -81,19 +82,6 @@ size_t Word::ReadFromMemory(const char *mem)
   return memUsed;
 }
 
-size_t Word::ReadFromFile(std::fstream &file)
-{
-  size_t memAlloc = sizeof(UINT64) + sizeof(char);
-  char *mem = (char*) malloc(memAlloc);
-  file.read(mem, memAlloc);
-
-  size_t memUsed = ReadFromMemory(mem);
-  CHECK(memAlloc == memUsed);
-  free(mem);
-
-  return memUsed;
-}
-
 Moses::Word *Word::ConvertToMoses(Moses::FactorDirection direction
                                   , const std::vector<Moses::FactorType> &outputFactorsVec
                                   , const Vocab &vocab) const
@@ -0,0 +1,95 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sys/time.h>
+#include <time.h>
+#include "Benchmark.h"
+
+namespace
+{
+// not atomic: only counts exactly while a single thread allocates
+size_t s_allocations = 0;
+volatile size_t s_sink = 0;
+}
+
+// count every allocation of the benchmarked code, new[] goes through here too
+void *operator new(size_t size) throw (std::bad_alloc)
+{
+  ++s_allocations;
+  void *ptr = malloc(size ? size : 1);
+  if (ptr == NULL) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) throw ()
+{
+  free(ptr);
+}
+
+namespace Moses
+{
+namespace Bench
+{
+
+size_t GetAllocations()
+{
+  return s_allocations;
+}
+
+double Now()
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
+    return now.tv_sec + now.tv_nsec * 1e-9;
+  }
+#endif
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+void Sink(size_t value)
+{
+  s_sink += value;
+}
+
+void Report(const std::string &name, const Result &result)
+{
+  std::cout << std::left << std::setw(48) << name << std::right;
+  if (result.ops == 0) {
+    std::cout << "      (nothing to measure)" << std::endl;
+    return;
+  }
+  std::cout << std::fixed
+            << std::setw(12) << std::setprecision(1) << result.GetNsPerOp() << " ns/op"
+            << std::setw(10) << std::setprecision(2) << result.GetAllocsPerOp() << " allocs/op"
+            << "  (" << result.ops << " ops)" << std::endl;
+}
+
+}
+}
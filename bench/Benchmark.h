@@ -0,0 +1,105 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_bench_Benchmark_h
+#define moses_bench_Benchmark_h
+
+#include <cstddef>
+#include <string>
+
+namespace Moses
+{
+namespace Bench
+{
+
+//! number of allocations with operator new since the program started
+size_t GetAllocations();
+
+//! seconds on a monotonic clock
+double Now();
+
+//! keeps the compiler from dropping a computation whose result is otherwise unused
+void Sink(size_t value);
+
+//! time and allocations per operation of a benchmark
+struct Result {
+  double seconds;
+  size_t allocations;
+  size_t ops;
+
+  Result() : seconds(0), allocations(0), ops(0) {}
+
+  double GetNsPerOp() const {
+    return ops ? seconds * 1e9 / ops : 0;
+  }
+  double GetAllocsPerOp() const {
+    return ops ? static_cast<double>(allocations) / ops : 0;
+  }
+  //! for benchmarks measured in parts, e.g. one sentence at a time
+  void Add(const Result &other) {
+    seconds += other.seconds;
+    allocations += other.allocations;
+    ops += other.ops;
+  }
+};
+
+//! print one line: name, ns/op, allocations/op and number of operations
+void Report(const std::string &name, const Result &result);
+
+/** Measures body, a class with two methods:
+ *  - void Setup(), called before each Run() and not measured
+ *  - size_t Run(), which does the operations and returns how many it did.
+ *  Run() is called until minTime seconds have been measured, and this is done
+ *  repeats times. The fastest of the repeats is returned, which is the one
+ *  least disturbed by the rest of the system.
+ *  Allocations are counted for all threads, so the operations should not run
+ *  other threads.
+ */
+template <class Body> Result Measure(Body &body, double minTime = 0.2, size_t repeats = 5)
+{
+  // warm up the caches and whatever is built on first use
+  body.Setup();
+  if (body.Run() == 0) {
+    return Result();
+  }
+
+  Result best;
+  for (size_t repeat = 0 ; repeat < repeats ; ++repeat) {
+    Result current;
+    while (current.seconds < minTime) {
+      body.Setup();
+      const size_t allocations = GetAllocations();
+      const double start = Now();
+      current.ops += body.Run();
+      current.seconds += Now() - start;
+      current.allocations += GetAllocations() - allocations;
+    }
+    if (best.ops == 0 || current.GetNsPerOp() < best.GetNsPerOp()) {
+      best = current;
+    }
+  }
+  return best;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,345 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/** Benchmarks of the decoder hot paths on real models: takes the same switches
+ *  as moses (-f moses.ini, -input-file ...) and measures, over all sentences
+ *  of the input, the phrase table lookups, the creation and scoring of
+ *  hypotheses, adding them to a stack and the decoding of whole sentences.
+ */
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ChartManager.h"
+#include "Hypothesis.h"
+#include "HypothesisStackNormal.h"
+#include "InputFileStream.h"
+#include "Manager.h"
+#include "Parameter.h"
+#include "PhraseDictionary.h"
+#include "Sentence.h"
+#include "StaticData.h"
+#include "TranslationOptionCollection.h"
+#include "TranslationSystem.h"
+#include "WordsRange.h"
+#include "Benchmark.h"
+
+using namespace std;
+using namespace Moses;
+using namespace Moses::Bench;
+
+namespace
+{
+
+// each sentence is short, so measure less of it than of the micro benchmarks
+const double MIN_TIME = 0.05;
+const size_t REPEATS = 3;
+
+//! the results of each benchmark, summed over the sentences, in the order first run
+class Totals
+{
+public:
+  void Add(const string &name, const Result &result) {
+    if (m_results.find(name) == m_results.end()) {
+      m_names.push_back(name);
+    }
+    m_results[name].Add(result);
+  }
+  void Report() const {
+    for (size_t i = 0 ; i < m_names.size() ; ++i) {
+      Bench::Report(m_names[i], m_results.find(m_names[i])->second);
+    }
+  }
+
+private:
+  vector<string> m_names;
+  map<string, Result> m_results;
+};
+
+//! GetTargetPhraseCollection() of every span of the sentence a phrase can cover
+class PhraseLookupBench
+{
+public:
+  PhraseLookupBench(const PhraseDictionary &dictionary, const InputType &source)
+    : m_dictionary(dictionary) {
+    const size_t maxLength = StaticData::Instance().GetMaxPhraseLength();
+    for (size_t start = 0 ; start < source.GetSize() ; ++start) {
+      for (size_t end = start ; end < source.GetSize() && end - start < maxLength ; ++end) {
+        m_phrases.push_back(source.GetSubString(WordsRange(start, end)));
+      }
+    }
+  }
+
+  void Setup() {}
+
+  size_t Run() {
+    size_t found = 0;
+    for (size_t i = 0 ; i < m_phrases.size() ; ++i) {
+      if (m_dictionary.GetTargetPhraseCollection(m_phrases[i]) != NULL) {
+        ++found;
+      }
+    }
+    Sink(found);
+    return m_phrases.size();
+  }
+
+private:
+  const PhraseDictionary &m_dictionary;
+  vector<Phrase> m_phrases;
+};
+
+/** what the hypothesis benchmarks need of a sentence: its translation options
+ *  and the initial hypothesis they extend */
+class SentenceContext
+{
+public:
+  SentenceContext(const InputType &source, const TranslationSystem &system)
+    : m_manager(source, StaticData::Instance().GetSearchAlgorithm(), &system)
+    , m_transOptColl(source.CreateTranslationOptionCollection(&system)) {
+    m_manager.ResetSentenceStats(source);
+    m_transOptColl->CreateTranslationOptions();
+    m_initial = Hypothesis::Create(m_manager, source, m_emptyTarget);
+    for (size_t start = 0 ; start < source.GetSize() ; ++start) {
+      for (size_t end = start ; end < source.GetSize() ; ++end) {
+        const TranslationOptionList &options = m_transOptColl->GetTranslationOptionList(WordsRange(start, end));
+        m_options.insert(m_options.end(), options.begin(), options.end());
+      }
+    }
+  }
+  ~SentenceContext() {
+    FREEHYPO(m_initial);
+    delete m_transOptColl;
+  }
+
+  //! a new, scored hypothesis for each translation option, returns the number of options
+  size_t Expand(vector<Hypothesis*> &hypos) {
+    Arena &arena = m_manager.GetArena();
+    const SquareMatrix &futureScore = m_transOptColl->GetFutureScore();
+    for (size_t i = 0 ; i < m_options.size() ; ++i) {
+      Hypothesis *hypo = m_initial->CreateNext(*m_options[i], NULL, arena);
+      if (hypo != NULL) {
+        hypo->CalcScore(futureScore);
+        hypos.push_back(hypo);
+      }
+    }
+    return m_options.size();
+  }
+
+  //! an empty stack with the limits of the configuration
+  HypothesisStackNormal *CreateStack() {
+    const StaticData &staticData = StaticData::Instance();
+    HypothesisStackNormal *stack = new HypothesisStackNormal(m_manager);
+    stack->SetMaxHypoStackSize(staticData.GetMaxHypoStackSize(), staticData.GetMinHypoStackDiversity());
+    stack->SetBeamWidth(staticData.GetBeamWidth());
+    return stack;
+  }
+
+private:
+  Manager m_manager;
+  TranslationOptionCollection *m_transOptColl;
+  TargetPhrase m_emptyTarget;
+  Hypothesis *m_initial;
+  vector<const TranslationOption*> m_options;
+};
+
+//! Hypothesis::CreateNext() and CalcScore() of every translation option
+class ExpandBench
+{
+public:
+  ExpandBench(SentenceContext &context) : m_context(context) {}
+  ~ExpandBench() {
+    Free();
+  }
+
+  void Setup() {
+    Free();
+  }
+
+  size_t Run() {
+    return m_context.Expand(m_hypos);
+  }
+
+private:
+  SentenceContext &m_context;
+  vector<Hypothesis*> m_hypos;
+
+  void Free() {
+    for (size_t i = 0 ; i < m_hypos.size() ; ++i) {
+      FREEHYPO(m_hypos[i]);
+    }
+    m_hypos.clear();
+  }
+};
+
+//! HypothesisStackNormal::AddPrune() of the hypotheses made from every translation option
+class AddPruneBench
+{
+public:
+  AddPruneBench(SentenceContext &context) : m_context(context) {}
+
+  void Setup() {
+    // the stack owns and frees what was added to it
+    m_stack.reset(m_context.CreateStack());
+    m_hypos.clear();
+    m_context.Expand(m_hypos);
+  }
+
+  size_t Run() {
+    for (size_t i = 0 ; i < m_hypos.size() ; ++i) {
+      m_stack->AddPrune(m_hypos[i]);
+    }
+    return m_hypos.size();
+  }
+
+private:
+  SentenceContext &m_context;
+  auto_ptr<HypothesisStackNormal> m_stack;
+  vector<Hypothesis*> m_hypos;
+};
+
+//! the whole search of a phrase-based sentence, Manager::ProcessSentence()
+class DecodeBench
+{
+public:
+  DecodeBench(const InputType &source, const TranslationSystem &system)
+    : m_source(source), m_system(system) {}
+
+  void Setup() {
+    m_manager.reset();
+    m_manager.reset(new Manager(m_source, StaticData::Instance().GetSearchAlgorithm(), &m_system));
+  }
+
+  size_t Run() {
+    m_manager->ProcessSentence();
+    Sink(m_manager->GetBestHypothesis() != NULL);
+    return 1;
+  }
+
+private:
+  const InputType &m_source;
+  const TranslationSystem &m_system;
+  auto_ptr<Manager> m_manager;
+};
+
+//! the whole search of a hierarchical sentence, which runs ChartCell::ProcessSentence() for each span
+class ChartDecodeBench
+{
+public:
+  ChartDecodeBench(const InputType &source, const TranslationSystem &system)
+    : m_source(source), m_system(system) {}
+
+  void Setup() {
+    m_manager.reset();
+    m_manager.reset(new ChartManager(m_source, &m_system));
+  }
+
+  size_t Run() {
+    m_manager->ProcessSentence();
+    Sink(m_manager->GetBestHypothesis() != NULL);
+    return 1;
+  }
+
+private:
+  const InputType &m_source;
+  const TranslationSystem &m_system;
+  auto_ptr<ChartManager> m_manager;
+};
+
+void RunPhraseBased(const Sentence &source, const TranslationSystem &system, Totals &totals)
+{
+  {
+    const vector<PhraseDictionaryFeature*> &dictionaries = system.GetPhraseDictionaries();
+    SentenceContext context(source, system);
+    for (size_t i = 0 ; i < dictionaries.size() ; ++i) {
+      PhraseLookupBench bench(*dictionaries[i]->GetDictionary(), source);
+      totals.Add("phrase table " + dictionaries[i]->GetScoreProducerDescription(0) + " lookup",
+                 Measure(bench, MIN_TIME, REPEATS));
+    }
+    {
+      ExpandBench bench(context);
+      totals.Add("Hypothesis CreateNext+CalcScore", Measure(bench, MIN_TIME, REPEATS));
+    }
+    {
+      AddPruneBench bench(context);
+      totals.Add("HypothesisStackNormal::AddPrune", Measure(bench, MIN_TIME, REPEATS));
+    }
+  }
+  // only one manager of a sentence may be alive at a time
+  DecodeBench bench(source, system);
+  totals.Add("Manager::ProcessSentence, per sentence", Measure(bench, MIN_TIME, REPEATS));
+}
+
+void RunChart(const Sentence &source, const TranslationSystem &system, Totals &totals)
+{
+  ChartDecodeBench bench(source, system);
+  totals.Add("ChartManager::ProcessSentence, per sentence", Measure(bench, MIN_TIME, REPEATS));
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  Parameter *params = new Parameter();
+  if (!params->LoadParam(argc, argv)) {
+    params->Explain();
+    return 1;
+  }
+  if (!StaticData::LoadDataStatic(params)) {
+    return 1;
+  }
+  const StaticData &staticData = StaticData::Instance();
+  // every decoding would report its progress on stderr otherwise
+  staticData.SetVerboseLevel(0);
+
+  auto_ptr<InputFileStream> inputFile;
+  if (staticData.GetParam("input-file").size() == 1) {
+    inputFile.reset(new InputFileStream(staticData.GetParam("input-file")[0]));
+  }
+  istream &in = inputFile.get() ? *inputFile : cin;
+
+  try {
+    const TranslationSystem &system = staticData.GetTranslationSystem(TranslationSystem::DEFAULT);
+    const bool chart = staticData.GetSearchAlgorithm() == ChartDecoding;
+    Totals totals;
+    size_t numSentences = 0;
+    while (true) {
+      Sentence source;
+      if (!source.Read(in, staticData.GetInputFactorOrder())) {
+        break;
+      }
+      if (chart) {
+        RunChart(source, system, totals);
+      } else {
+        RunPhraseBased(source, system, totals);
+      }
+      ++numSentences;
+    }
+    cout << numSentences << " sentences" << endl;
+    totals.Report();
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,301 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/** Benchmarks of decoder building blocks on synthetic data, which need no
+ *  model files, except the language model benchmark, which scores random
+ *  words with the KenLM model given on the command line.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lm/binary_format.hh"
+#include "lm/model.hh"
+#include "FactorCollection.h"
+#include "WordsBitmap.h"
+#include "WordsRange.h"
+#include "Benchmark.h"
+
+using namespace std;
+using namespace Moses;
+using namespace Moses::Bench;
+
+namespace
+{
+
+const size_t NUM_ITEMS = 10000;
+
+//! random spans of up to 7 words, as translation options of a sentence
+vector<pair<size_t, size_t> > RandomSpans(size_t sentenceLength, size_t count)
+{
+  vector<pair<size_t, size_t> > spans(count);
+  for (size_t i = 0 ; i < count ; ++i) {
+    const size_t start = rand() % sentenceLength;
+    const size_t end = min(sentenceLength - 1, start + rand() % 7);
+    spans[i] = make_pair(start, end);
+  }
+  return spans;
+}
+
+/** what the search does with the coverage of a hypothesis: check a span is
+ *  free, mark it, find the first gap and the id of the result */
+class WordsBitmapCoverBench
+{
+public:
+  WordsBitmapCoverBench(size_t sentenceLength)
+    : m_length(sentenceLength)
+    , m_spans(RandomSpans(sentenceLength, NUM_ITEMS)) {}
+
+  void Setup() {}
+
+  size_t Run() {
+    WordsBitmap bitmap(m_length);
+    size_t sum = 0;
+    for (size_t i = 0 ; i < m_spans.size() ; ++i) {
+      const size_t start = m_spans[i].first, end = m_spans[i].second;
+      if (bitmap.IsComplete()) {
+        bitmap.SetValue(0, m_length - 1, false);
+      }
+      if (!bitmap.Overlap(WordsRange(start, end))) {
+        sum += bitmap.GetIDPlus(start, end);
+        bitmap.SetValue(start, end, true);
+      }
+      sum += bitmap.GetFirstGapPos() + bitmap.GetNumWordsCovered();
+    }
+    Sink(sum);
+    return m_spans.size();
+  }
+
+private:
+  size_t m_length;
+  vector<pair<size_t, size_t> > m_spans;
+};
+
+//! copying and comparing coverage, as done for each new hypothesis and on recombination
+class WordsBitmapCopyBench
+{
+public:
+  WordsBitmapCopyBench(size_t sentenceLength) {
+    vector<pair<size_t, size_t> > spans = RandomSpans(sentenceLength, 1000);
+    for (size_t i = 0 ; i < spans.size() ; ++i) {
+      WordsBitmap *bitmap = new WordsBitmap(sentenceLength);
+      bitmap->SetValue(spans[i].first, spans[i].second, true);
+      m_bitmaps.push_back(bitmap);
+    }
+  }
+  ~WordsBitmapCopyBench() {
+    for (size_t i = 0 ; i < m_bitmaps.size() ; ++i) {
+      delete m_bitmaps[i];
+    }
+  }
+
+  void Setup() {}
+
+  size_t Run() {
+    size_t sum = 0;
+    for (size_t i = 1 ; i < m_bitmaps.size() ; ++i) {
+      WordsBitmap copy(*m_bitmaps[i]);
+      sum += copy.Compare(*m_bitmaps[i - 1]) + 1;
+    }
+    Sink(sum);
+    return m_bitmaps.size() - 1;
+  }
+
+private:
+  vector<WordsBitmap*> m_bitmaps;
+};
+
+//! looking up factors that exist, as when reading input and phrase tables
+class FactorLookupBench
+{
+public:
+  FactorLookupBench() {
+    for (size_t i = 0 ; i < NUM_ITEMS ; ++i) {
+      ostringstream word;
+      word << "bench-word-" << rand() % (NUM_ITEMS * 10);
+      m_words.push_back(word.str());
+      FactorCollection::Instance().AddFactor(m_words.back());
+    }
+  }
+
+  void Setup() {}
+
+  size_t Run() {
+    FactorCollection &factors = FactorCollection::Instance();
+    size_t sum = 0;
+    for (size_t i = 0 ; i < m_words.size() ; ++i) {
+      sum += reinterpret_cast<size_t>(factors.AddFactor(m_words[i]));
+    }
+    Sink(sum);
+    return m_words.size();
+  }
+
+private:
+  vector<string> m_words;
+};
+
+//! adding factors that do not exist yet
+class FactorInsertBench
+{
+public:
+  FactorInsertBench() : m_next(0) {}
+
+  void Setup() {
+    m_words.clear();
+    for (size_t i = 0 ; i < NUM_ITEMS ; ++i) {
+      ostringstream word;
+      word << "bench-new-" << m_next++;
+      m_words.push_back(word.str());
+    }
+  }
+
+  size_t Run() {
+    FactorCollection &factors = FactorCollection::Instance();
+    size_t sum = 0;
+    for (size_t i = 0 ; i < m_words.size() ; ++i) {
+      sum += reinterpret_cast<size_t>(factors.AddFactor(m_words[i]));
+    }
+    Sink(sum);
+    return m_words.size();
+  }
+
+private:
+  size_t m_next;
+  vector<string> m_words;
+};
+
+//! FullScore() of random words, each extending the state of the one before
+template <class Model> class KenLMBench
+{
+public:
+  KenLMBench(const Model &model) : m_model(model) {
+    const lm::WordIndex bound = model.GetVocabulary().Bound();
+    for (size_t i = 0 ; i < NUM_ITEMS ; ++i) {
+      m_words.push_back(bound > 1 ? 1 + rand() % (bound - 1) : 0);
+    }
+  }
+
+  void Setup() {}
+
+  size_t Run() {
+    typename Model::State state(m_model.BeginSentenceState()), out;
+    size_t sum = 0;
+    for (size_t i = 0 ; i < m_words.size() ; ++i) {
+      lm::FullScoreReturn ret = m_model.FullScore(state, m_words[i], out);
+      sum += ret.ngram_length;
+      state = out;
+    }
+    Sink(sum);
+    return m_words.size();
+  }
+
+private:
+  const Model &m_model;
+  vector<lm::WordIndex> m_words;
+};
+
+template <class Model> void RunKenLM(const char *file)
+{
+  Model model(file);
+  KenLMBench<Model> bench(model);
+  Report("kenlm FullScore", Measure(bench));
+}
+
+void RunKenLM(const char *file)
+{
+  using namespace lm::ngram;
+  ModelType modelType;
+  if (!RecognizeBinary(file, modelType)) {
+    RunKenLM<ProbingModel>(file);
+    return;
+  }
+  switch (modelType) {
+  case HASH_PROBING:
+    RunKenLM<ProbingModel>(file);
+    break;
+  case TRIE_SORTED:
+    RunKenLM<TrieModel>(file);
+    break;
+  case QUANT_TRIE_SORTED:
+    RunKenLM<QuantTrieModel>(file);
+    break;
+  case ARRAY_TRIE_SORTED:
+    RunKenLM<ArrayTrieModel>(file);
+    break;
+  case QUANT_ARRAY_TRIE_SORTED:
+    RunKenLM<QuantArrayTrieModel>(file);
+    break;
+  default:
+    cerr << "Unrecognized kenlm model type " << modelType << endl;
+  }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 2 || (argc == 2 && !strcmp(argv[1], "--help"))) {
+    cerr << "Usage: " << argv[0] << " [lm_file]" << endl
+         << "The language model benchmark is only run if an ARPA or KenLM binary file is given, e.g. lm/test.arpa" << endl;
+    return 1;
+  }
+  // the same synthetic data on every run
+  srand(1234);
+
+  try {
+    {
+      WordsBitmapCoverBench bench(30);
+      Report("WordsBitmap cover, 30 words", Measure(bench));
+    }
+    {
+      WordsBitmapCoverBench bench(100);
+      Report("WordsBitmap cover, 100 words", Measure(bench));
+    }
+    {
+      WordsBitmapCopyBench bench(30);
+      Report("WordsBitmap copy+compare, 30 words", Measure(bench));
+    }
+    {
+      WordsBitmapCopyBench bench(100);
+      Report("WordsBitmap copy+compare, 100 words", Measure(bench));
+    }
+    {
+      FactorLookupBench bench;
+      Report("FactorCollection::AddFactor, existing", Measure(bench));
+    }
+    {
+      FactorInsertBench bench;
+      Report("FactorCollection::AddFactor, new", Measure(bench));
+    }
+    if (argc == 2) {
+      RunKenLM(argv[1]);
+    }
+  } catch (const std::exception &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -74,8 +74,8 @@ void Alignment::Create(const string& fileName)
       if (! sscanf(alignmentSequence[i].c_str(), "%d-%d", &s, &t)) {
         cerr << "WARNING: " << alignmentSequence[i] << " is a bad alignment point in sentence " << sentenceId << endl;
       }
-      m_array[alignmentPointIndex++] = (char) s;
-      m_array[alignmentPointIndex++] = (char) t;
+      m_array[alignmentPointIndex++] = s;
+      m_array[alignmentPointIndex++] = t;
     }
     m_sentenceEnd[ sentenceId++ ] = alignmentPointIndex - 2;
   }
@@ -159,9 +159,7 @@ bool Alignment::PhraseAlignment( INDEX sentence, int target_length,
   }
 
   // create array for unaligned words
-  for( int i=0; i<target_length; i++ ) {
-    m_unaligned[i] = true;
-  }
+  m_unaligned.assign( target_length, true );
   for(INDEX ap = sentenceStart; ap <= m_sentenceEnd[ sentence ]; ap += 2 ) {
     int target =  m_array[ ap+1 ];
     m_unaligned[ target ] = false;
@@ -1,18 +1,20 @@
 #pragma once
 
+#include <stdint.h>
+
 #include "Vocabulary.h"
 
 class Alignment
 {
 public:
-  typedef unsigned int INDEX;
+  typedef uint64_t INDEX;
 
 private:
   int *m_array;
   INDEX *m_sentenceEnd;
   INDEX m_size;
   INDEX m_sentenceCount;
-  char m_unaligned[ 256 ]; // here for speed (local to PhraseAlignment)
+  std::vector< bool > m_unaligned; // here for speed (local to PhraseAlignment)
 
   // No copying allowed.
   Alignment(const Alignment&);
@@ -35,12 +35,8 @@ Mismatch::Mismatch( SuffixArray *sa, TargetCorpus *tc, Alignment *a, INDEX sente
     ,m_unaligned(true)
 {
   // initialize unaligned indexes
-  for (int i = 0; i < m_source_length; i++) {
-    m_source_unaligned[i] = true;
-  }
-  for (int i = 0; i < m_target_length; i++) {
-    m_target_unaligned[i] = true;
-  }
+  m_source_unaligned.assign( m_source_length, true );
+  m_target_unaligned.assign( m_target_length, true );
   m_num_alignment_points =
       m_alignment->GetNumberOfAlignmentPoints( sentence_id );
   for(INDEX ap=0; ap<m_num_alignment_points; ap++) {
@@ -58,7 +54,8 @@ Mismatch::~Mismatch () {}
 
 void Mismatch::PrintClippedHTML( ostream* out, int width )
 {
-    int source_annotation[256], target_annotation[256];
+    vector< int > source_annotation( m_source_length, UNANNOTATED );
+    vector< int > target_annotation( m_target_length, UNANNOTATED );
     vector< string > label_class;
 	label_class.push_back( "" );
 	label_class.push_back( "mismatch_pre_aligned" );
@@ -67,9 +64,6 @@ void Mismatch::PrintClippedHTML( ostream* out, int width )
 	label_class.push_back( "mismatch_misaligned" );
 	label_class.push_back( "mismatch_aligned" );
 
-	for(int i=0; i<m_source_length;i++) source_annotation[i] = UNANNOTATED;
-	for(int i=0; i<m_target_length;i++) target_annotation[i] = UNANNOTATED;
-	
 	if (m_unaligned) {
 		// find alignment points for prior and next word(s) and
 		// center target phrase around those.
@@ -281,7 +275,7 @@ void Mismatch::PrintClippedHTML( ostream* out, int width )
 	*out << "</td></tr>";
 }
 
-void Mismatch::LabelSourceMatches(int *source_annotation, int *target_annotation, int source_id, int label ) {
+void Mismatch::LabelSourceMatches(vector< int > &source_annotation, vector< int > &target_annotation, int source_id, int label ) {
 	for(INDEX ap=0; ap<m_num_alignment_points; ap++) {
 		if (m_alignment->GetSourceWord( m_sentence_id, ap ) == source_id) {
 			source_annotation[ source_id ] = label;
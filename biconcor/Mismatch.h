@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iosfwd>
+#include <vector>
+#include <stdint.h>
 
 class Alignment;
 class SuffixArray;
@@ -9,7 +11,7 @@ class TargetCorpus;
 class Mismatch
 {
 public:
-  typedef unsigned int INDEX;
+  typedef uint64_t INDEX;
 
 private:
   SuffixArray *m_suffixArray;
@@ -22,8 +24,8 @@ private:
   INDEX m_source_position;
   int m_source_start;
   int m_source_end;
-  bool m_source_unaligned[ 256 ];
-  bool m_target_unaligned[ 256 ];
+  std::vector< bool > m_source_unaligned;
+  std::vector< bool > m_target_unaligned;
   bool m_unaligned;
 
   // No copying allowed.
@@ -36,5 +38,5 @@ public:
 
   bool Unaligned() const { return m_unaligned; }
   void PrintClippedHTML(std::ostream* out, int width );
-  void LabelSourceMatches(int *source_annotation, int *target_annotation, int source_id, int label );
+  void LabelSourceMatches(std::vector< int > &source_annotation, std::vector< int > &target_annotation, int source_id, int label );
 };
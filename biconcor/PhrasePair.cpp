@@ -19,15 +19,15 @@ void PhrasePair::Print( ostream* out, int width ) const
   string source = "";
   string source_post = "";
   for( size_t space=0; space<source_width/2; space++ ) source_pre += " ";
-  for( char i=0; i<m_source_start; i++ ) {
+  for( int i=0; i<m_source_start; i++ ) {
     source_pre += " " + m_suffixArray->GetWord( sentence_start + i );
   }
-  for( char i=m_source_start; i<=m_source_end; i++ ) {
+  for( int i=m_source_start; i<=m_source_end; i++ ) {
     if (i>m_source_start) source += " ";
     source += m_suffixArray->GetWord( sentence_start + i );
   }
-  char source_length = m_suffixArray->GetSentenceLength( m_suffixArray->GetSentence( m_source_position ) );
-  for( char i=m_source_end+1; i<source_length; i++ ) {
+  int source_length = m_suffixArray->GetSentenceLength( m_suffixArray->GetSentence( m_source_position ) );
+  for( int i=m_source_end+1; i<source_length; i++ ) {
     if (i>m_source_end+1) source_post += " ";
     source_post += m_suffixArray->GetWord( sentence_start + i );
   }
@@ -51,14 +51,14 @@ void PhrasePair::Print( ostream* out, int width ) const
   string target = "";
   string target_post = "";
   for( size_t space=0; space<target_width/2; space++ ) target_pre += " ";
-  for( char i=0; i<m_target_start; i++ ) {
+  for( int i=0; i<m_target_start; i++ ) {
     target_pre += " " + m_targetCorpus->GetWord( m_sentence_id, i);
   }
-  for( char i=m_target_start; i<=m_target_end; i++ ) {
+  for( int i=m_target_start; i<=m_target_end; i++ ) {
     if (i>m_target_start) target += " ";
     target += m_targetCorpus->GetWord( m_sentence_id, i);
   }
-  for( char i=m_target_end+1; i<m_target_length; i++ ) {
+  for( int i=m_target_end+1; i<m_target_length; i++ ) {
     if (i>m_target_end+1) target_post += " ";
     target_post += m_targetCorpus->GetWord( m_sentence_id, i);
   }
@@ -78,7 +78,7 @@ void PhrasePair::Print( ostream* out, int width ) const
 
 void PhrasePair::PrintTarget( ostream* out ) const
 {
-  for( char i=m_target_start; i<=m_target_end; i++ ) {
+  for( int i=m_target_start; i<=m_target_end; i++ ) {
     if (i>m_target_start) *out << " ";
     *out << m_targetCorpus->GetWord( m_sentence_id, i);
   }
@@ -88,37 +88,37 @@ void PhrasePair::PrintHTML( ostream* out ) const
 {
   // source
   int sentence_start = m_source_position - m_source_start;
-  char source_length = m_suffixArray->GetSentenceLength( m_suffixArray->GetSentence( m_source_position ) );
+  int source_length = m_suffixArray->GetSentenceLength( m_suffixArray->GetSentence( m_source_position ) );
 
   *out << "<tr><td align=right class=\"pp_source_left\">";
-  for( char i=0; i<m_source_start; i++ ) {
+  for( int i=0; i<m_source_start; i++ ) {
     if (i>0) *out << " ";
     *out << m_suffixArray->GetWord( sentence_start + i );
   }
   *out << "</td><td class=\"pp_source\">";
-  for( char i=m_source_start; i<=m_source_end; i++ ) {
+  for( int i=m_source_start; i<=m_source_end; i++ ) {
     if (i>m_source_start) *out << " ";
     *out << m_suffixArray->GetWord( sentence_start + i );
   }
   *out << "</td><td class=\"pp_source_right\">";
-  for( char i=m_source_end+1; i<source_length; i++ ) {
+  for( int i=m_source_end+1; i<source_length; i++ ) {
     if (i>m_source_end+1) *out << " ";
     *out << m_suffixArray->GetWord( sentence_start + i );
   }
 
   // target
   *out << "</td><td class=\"pp_target_left\">";
-  for( char i=0; i<m_target_start; i++ ) {
+  for( int i=0; i<m_target_start; i++ ) {
     if (i>0) *out << " ";
     *out << m_targetCorpus->GetWord( m_sentence_id, i);
   }
   *out << "</td><td class=\"pp_target\">";
-  for( char i=m_target_start; i<=m_target_end; i++ ) {
+  for( int i=m_target_start; i<=m_target_end; i++ ) {
     if (i>m_target_start) *out << " ";
     *out << m_targetCorpus->GetWord( m_sentence_id, i);
   }
   *out << "</td><td class=\"pp_target_right\">";
-  for( char i=m_target_end+1; i<m_target_length; i++ ) {
+  for( int i=m_target_end+1; i<m_target_length; i++ ) {
     if (i>m_target_end+1) *out << " ";
     *out << m_targetCorpus->GetWord( m_sentence_id, i);
   }
@@ -135,15 +135,15 @@ void PhrasePair::PrintClippedHTML( ostream* out, int width ) const
   string source_pre = "";
   string source = "";
   string source_post = "";
-  for( char i=0; i<m_source_start; i++ ) {
+  for( int i=0; i<m_source_start; i++ ) {
     source_pre += " " + m_suffixArray->GetWord( sentence_start + i );
   }
-  for( char i=m_source_start; i<=m_source_end; i++ ) {
+  for( int i=m_source_start; i<=m_source_end; i++ ) {
     if (i>m_source_start) source += " ";
     source += m_suffixArray->GetWord( sentence_start + i );
   }
-  char source_length = m_suffixArray->GetSentenceLength( m_suffixArray->GetSentence( m_source_position ) );
-  for( char i=m_source_end+1; i<source_length; i++ ) {
+  int source_length = m_suffixArray->GetSentenceLength( m_suffixArray->GetSentence( m_source_position ) );
+  for( int i=m_source_end+1; i<source_length; i++ ) {
     if (i>m_source_end+1) source_post += " ";
     source_post += m_suffixArray->GetWord( sentence_start + i );
   }
@@ -187,17 +187,17 @@ void PhrasePair::PrintClippedHTML( ostream* out, int width ) const
   string target_post = "";
 	size_t target_pre_null_width = 0;
 	size_t target_post_null_width = 0;
-  for( char i=0; i<m_target_start; i++ ) {
+  for( int i=0; i<m_target_start; i++ ) {
 		WORD word = m_targetCorpus->GetWord( m_sentence_id, i);
     target_pre += " " + word;
 		if (i >= m_target_start-m_pre_null)
 			target_pre_null_width += word.size() + 1;
   }
-  for( char i=m_target_start; i<=m_target_end; i++ ) {
+  for( int i=m_target_start; i<=m_target_end; i++ ) {
     if (i>m_target_start) target += " ";
     target += m_targetCorpus->GetWord( m_sentence_id, i);
   }
-  for( char i=m_target_end+1; i<m_target_length; i++ ) {
+  for( int i=m_target_end+1; i<m_target_length; i++ ) {
     if (i>m_target_end+1) target_post += " ";
 		WORD word = m_targetCorpus->GetWord( m_sentence_id, i);
     target_post += word;
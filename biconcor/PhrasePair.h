@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iosfwd>
+#include <stdint.h>
 
 class Alignment;
 class SuffixArray;
@@ -9,22 +10,22 @@ class TargetCorpus;
 class PhrasePair
 {
 public:
-  typedef unsigned int INDEX;
+  typedef uint64_t INDEX;
 
 private:
   SuffixArray *m_suffixArray;
   TargetCorpus *m_targetCorpus;
   Alignment *m_alignment;
   INDEX m_sentence_id;
-  char m_target_length;
+  int m_target_length;
   INDEX m_source_position;
-  char m_source_start, m_source_end;
-  char m_target_start, m_target_end;
-  char m_start_null, m_end_null;
-  char m_pre_null, m_post_null;
+  int m_source_start, m_source_end;
+  int m_target_start, m_target_end;
+  int m_start_null, m_end_null;
+  int m_pre_null, m_post_null;
 
 public:
-  PhrasePair( SuffixArray *sa, TargetCorpus *tc, Alignment *a, INDEX sentence_id, char target_length, INDEX position, char source_start, char source_end, char target_start, char target_end, char start_null, char end_null, char pre_null, char post_null)
+  PhrasePair( SuffixArray *sa, TargetCorpus *tc, Alignment *a, INDEX sentence_id, int target_length, INDEX position, int source_start, int source_end, int target_start, int target_end, int start_null, int end_null, int pre_null, int post_null)
     :m_suffixArray(sa)
     ,m_targetCorpus(tc)
     ,m_alignment(a)
@@ -39,7 +39,7 @@ bool PhrasePairCollection::GetCollection( const vector< string >& sourceString )
 
   map< vector< WORD_ID >, INDEX > index;
   for( INDEX i=first_match; i<=last_match; i++ ) {
-    int position = m_suffixArray->GetPosition( i );
+    INDEX position = m_suffixArray->GetPosition( i );
     int source_start = m_suffixArray->GetWordInSentence( position );
     int source_end = source_start + sourceString.size()-1;
     INDEX sentence_id = m_suffixArray->GetSentence( position );
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include <vector>
 #include <string>
 
@@ -12,7 +13,7 @@ class Mismatch;
 class PhrasePairCollection
 {
 public:
-  typedef unsigned int INDEX;
+  typedef uint64_t INDEX;
 
 private:
   SuffixArray *m_suffixArray;
@@ -4,11 +4,169 @@
 #include <string>
 #include <stdlib.h>
 #include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace {
 
 const int LINE_MAX_LENGTH = 10000;
 
+// start of a saved suffix array, followed by the arrays at 8 byte boundaries
+const char MAGIC[8] = { 'b', 'i', 'c', 'o', 'n', 's', 'a', '3' };
+struct Header {
+  char magic[8];
+  uint64_t size;
+  uint64_t sentenceCount;
+};
+
+size_t Align( size_t offset )
+{
+  return (offset + 7) & ~(size_t)7;
+}
+
+// SA-IS suffix array construction (Nong, Zhang and Chan 2009), linear in the
+// length of the text. The text s has length n, its symbols are at most k, and
+// it ends in a 0 that does not occur elsewhere.
+
+typedef SuffixArray::INDEX INDEX;
+const INDEX EMPTY = (INDEX) -1;
+
+template <class Symbol>
+void GetBuckets( const Symbol *s, INDEX *bucket, INDEX n, INDEX k, bool end )
+{
+  std::fill( bucket, bucket + k + 1, 0 );
+  for( INDEX i=0; i<n; i++ ) {
+    bucket[ s[i] ]++;
+  }
+  INDEX sum = 0;
+  for( INDEX i=0; i<=k; i++ ) {
+    sum += bucket[i];
+    bucket[i] = end ? sum : sum - bucket[i];
+  }
+}
+
+inline bool IsLMS( const std::vector<bool> &sType, INDEX i )
+{
+  return i > 0 && sType[i] && !sType[i-1];
+}
+
+// place the L-type suffixes from the sorted suffixes to their right, then
+// the S-type ones from the suffixes to their left
+template <class Symbol>
+void Induce( const std::vector<bool> &sType, INDEX *sa, const Symbol *s, INDEX *bucket, INDEX n, INDEX k )
+{
+  GetBuckets( s, bucket, n, k, false );
+  for( INDEX i=0; i<n; i++ ) {
+    if (sa[i] != EMPTY && sa[i] > 0 && !sType[ sa[i]-1 ]) {
+      INDEX j = sa[i]-1;
+      sa[ bucket[ s[j] ]++ ] = j;
+    }
+  }
+  GetBuckets( s, bucket, n, k, true );
+  for( INDEX i=n; i-- > 0; ) {
+    if (sa[i] != EMPTY && sa[i] > 0 && sType[ sa[i]-1 ]) {
+      INDEX j = sa[i]-1;
+      sa[ --bucket[ s[j] ] ] = j;
+    }
+  }
+}
+
+template <class Symbol>
+void SAIS( const Symbol *s, INDEX *sa, INDEX n, INDEX k )
+{
+  // classify the suffixes, S-type if smaller than the next one
+  std::vector<bool> sType( n, false );
+  sType[ n-1 ] = true;
+  for( INDEX i=n-1; i-- > 0; ) {
+    sType[i] = s[i] < s[i+1] || (s[i] == s[i+1] && sType[i+1]);
+  }
+
+  // sort the LMS substrings by inducing from them in text order
+  std::vector<INDEX> bucket( k+1 );
+  GetBuckets( s, &bucket[0], n, k, true );
+  std::fill( sa, sa + n, EMPTY );
+  for( INDEX i=1; i<n; i++ ) {
+    if (IsLMS( sType, i )) {
+      sa[ --bucket[ s[i] ] ] = i;
+    }
+  }
+  Induce( sType, sa, s, &bucket[0], n, k );
+
+  // move the sorted LMS substrings to the front
+  INDEX n1 = 0;
+  for( INDEX i=0; i<n; i++ ) {
+    if (IsLMS( sType, sa[i] )) {
+      sa[ n1++ ] = sa[i];
+    }
+  }
+
+  // name them, equal substrings get equal names
+  std::fill( sa + n1, sa + n, EMPTY );
+  INDEX name = 0, prev = EMPTY;
+  for( INDEX i=0; i<n1; i++ ) {
+    INDEX pos = sa[i];
+    bool diff = false;
+    for( INDEX d=0; d<n; d++ ) {
+      if (prev == EMPTY || s[pos+d] != s[prev+d] || sType[pos+d] != sType[prev+d]) {
+        diff = true;
+        break;
+      } else if (d > 0 && (IsLMS( sType, pos+d ) || IsLMS( sType, prev+d ))) {
+        break;
+      }
+    }
+    if (diff) {
+      name++;
+      prev = pos;
+    }
+    sa[ n1 + pos/2 ] = name-1;
+  }
+  for( INDEX i=n, j=n; i-- > n1; ) {
+    if (sa[i] != EMPTY) {
+      sa[ --j ] = sa[i];
+    }
+  }
+
+  // sort the reduced text, recursively unless all names are different
+  INDEX *s1 = sa + n - n1;
+  if (name < n1) {
+    SAIS( s1, sa, n1, name-1 );
+  } else {
+    for( INDEX i=0; i<n1; i++ ) {
+      sa[ s1[i] ] = i;
+    }
+  }
+
+  // put the sorted LMS suffixes in their buckets, then induce the rest
+  GetBuckets( s, &bucket[0], n, k, true );
+  for( INDEX i=1, j=0; i<n; i++ ) {
+    if (IsLMS( sType, i )) {
+      s1[ j++ ] = i;
+    }
+  }
+  for( INDEX i=0; i<n1; i++ ) {
+    sa[i] = s1[ sa[i] ];
+  }
+  std::fill( sa + n1, sa + n, EMPTY );
+  for( INDEX i=n1; i-- > 0; ) {
+    INDEX j = sa[i];
+    sa[i] = EMPTY;
+    sa[ --bucket[ s[j] ] ] = j;
+  }
+  Induce( sType, sa, s, &bucket[0], n, k );
+}
+
+// orders word ids by their spelling
+struct CompareSpelling {
+  const Vocabulary &m_vcb;
+  CompareSpelling( const Vocabulary &vcb ) : m_vcb(vcb) {}
+  bool operator()( WORD_ID a, WORD_ID b ) const {
+    return m_vcb.GetWord(a) < m_vcb.GetWord(b);
+  }
+};
+
 } // namespace
 
 using namespace std;
@@ -16,16 +174,21 @@ using namespace std;
 SuffixArray::SuffixArray()
     : m_array(NULL),
       m_index(NULL),
-      m_buffer(NULL),
       m_wordInSentence(NULL),
       m_sentence(NULL),
       m_sentenceLength(NULL),
       m_vcb(),
       m_size(0),
-      m_sentenceCount(0) { }
+      m_sentenceCount(0),
+      m_mapped(NULL),
+      m_mappedSize(0) { }
 
 SuffixArray::~SuffixArray()
 {
+  if (m_mapped != NULL) {
+    munmap(m_mapped, m_mappedSize);
+    return;
+  }
   free(m_array);
   free(m_index);
   free(m_wordInSentence);
@@ -64,14 +227,20 @@ void SuffixArray::Create(const string& fileName )
 
   // allocate memory
   m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
-  m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
+  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size+1 ); // room for the end of the text while sorting
+  m_wordInSentence = (POSITION*) calloc( sizeof( POSITION ), m_size );
+  m_sentence = (SENTENCE_ID*) calloc( sizeof( SENTENCE_ID ), m_size );
+  m_sentenceLength = (POSITION*) calloc( sizeof( POSITION ), m_sentenceCount );
+
+  if (m_array == NULL || m_index == NULL || m_wordInSentence == NULL ||
+      m_sentence == NULL || m_sentenceLength == NULL) {
+    cerr << "cannot allocate memory for " << m_size << " words" << endl;
+    exit(1);
+  }
 
   // fill the array
-  int wordIndex = 0;
-  int sentenceId = 0;
+  INDEX wordIndex = 0;
+  SENTENCE_ID sentenceId = 0;
   textFile.open(fileName.c_str());
 
   if (!textFile) {
@@ -87,12 +256,10 @@ void SuffixArray::Create(const string& fileName )
     vector< WORD_ID >::const_iterator i;
 
     for( i=words.begin(); i!=words.end(); i++) {
-      m_index[ wordIndex ] = wordIndex;
       m_sentence[ wordIndex ] = sentenceId;
       m_wordInSentence[ wordIndex ] = i-words.begin();
       m_array[ wordIndex++ ] = *i;
     }
-    m_index[ wordIndex ] = wordIndex;
     m_array[ wordIndex++ ] = m_endOfSentence;
     m_sentenceLength[ sentenceId++ ] = words.size();
   }
@@ -100,48 +267,34 @@ void SuffixArray::Create(const string& fileName )
   cerr << "done reading " << wordIndex << " words, " << sentenceId << " sentences." << endl;
   // List(0,9);
 
-  // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
-
-  if (m_buffer == NULL) {
-    cerr << "cannot allocate memory to m_buffer" << endl;
-    exit(1);
-  }
-
-  Sort( 0, m_size-1 );
-  free( m_buffer );
+  Sort();
   cerr << "done sorting" << endl;
 }
 
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
+// suffixes are ordered by the spelling of their words, so the text is
+// rewritten in ranks of the spellings, which SA-IS sorts as integers
+void SuffixArray::Sort()
 {
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  INDEX i = start;
-  INDEX j = mid;
-  INDEX k = 0;
-  INDEX length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
-    } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
-    }
+  const WORD_ID vocabSize = m_vcb.vocab.size();
+  vector< WORD_ID > bySpelling( vocabSize );
+  for( WORD_ID id=0; id<vocabSize; id++ ) {
+    bySpelling[ id ] = id;
+  }
+  std::sort( bySpelling.begin(), bySpelling.end(), CompareSpelling( m_vcb ) );
+  vector< WORD_ID > rank( vocabSize );
+  for( WORD_ID r=0; r<vocabSize; r++ ) {
+    rank[ bySpelling[ r ] ] = r+1; // 0 ends the text
   }
 
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
+  vector< WORD_ID > text( m_size+1 );
+  for( INDEX i=0; i<m_size; i++ ) {
+    text[ i ] = rank[ m_array[ i ] ];
+  }
+  text[ m_size ] = 0;
+
+  // the end of the text is the smallest suffix, drop it
+  SAIS( &text[0], m_index, m_size+1, (INDEX) vocabSize );
+  memmove( m_index, m_index+1, sizeof( INDEX ) * m_size );
 }
 
 int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
@@ -279,14 +432,30 @@ void SuffixArray::Save(const string& fileName ) const
     exit(1);
   }
 
-  fwrite( &m_size, sizeof(INDEX), 1, pFile );
-  fwrite( m_array, sizeof(WORD_ID), m_size, pFile ); // corpus
-  fwrite( m_index, sizeof(INDEX), m_size, pFile );   // suffix array
-  fwrite( m_wordInSentence, sizeof(char), m_size, pFile); // word index
-  fwrite( m_sentence, sizeof(INDEX), m_size, pFile); // sentence index
-
-  fwrite( &m_sentenceCount, sizeof(INDEX), 1, pFile );
-  fwrite( m_sentenceLength, sizeof(char), m_sentenceCount, pFile); // sentence length
+  // the arrays are written at 8 byte boundaries, so that Load can map them
+  Header header;
+  memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+  header.size = m_size;
+  header.sentenceCount = m_sentenceCount;
+  const char padding[8] = { 0 };
+  size_t offset = 0;
+  const void *data[] = { &header, m_index, m_array, m_sentence, m_wordInSentence, m_sentenceLength };
+  const size_t bytes[] = { sizeof( Header ),
+                           sizeof( INDEX ) * m_size,          // suffix array
+                           sizeof( WORD_ID ) * m_size,        // corpus
+                           sizeof( SENTENCE_ID ) * m_size,    // sentence index
+                           sizeof( POSITION ) * m_size,       // word index
+                           sizeof( POSITION ) * m_sentenceCount // sentence length
+                         };
+  for( size_t i=0; i<sizeof( bytes )/sizeof( bytes[0] ); i++ ) {
+    fwrite( padding, 1, Align( offset ) - offset, pFile );
+    offset = Align( offset );
+    if (fwrite( data[i], 1, bytes[i], pFile ) != bytes[i]) {
+      cerr << "Error: cannot write " << fileName << endl;
+      exit(1);
+    }
+    offset += bytes[i];
+  }
   fclose( pFile );
 
   m_vcb.Save( fileName + ".src-vcb" );
@@ -294,57 +463,54 @@ void SuffixArray::Save(const string& fileName ) const
 
 void SuffixArray::Load(const string& fileName )
 {
-  FILE *pFile = fopen ( fileName.c_str() , "r" );
-  if (pFile == NULL) {
+  int fd = open( fileName.c_str(), O_RDONLY );
+  if (fd == -1) {
     cerr << "no such file or directory " << fileName << endl;
     exit(1);
   }
 
   cerr << "loading from " << fileName << endl;
 
-  fread( &m_size, sizeof(INDEX), 1, pFile );
-  cerr << "words in corpus: " << m_size << endl;
-  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
-  m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
-
-  if (m_array == NULL) {
-    cerr << "Error: cannot allocate memory to m_array" << endl;
+  // the arrays are used where they are in the file, only the pages that
+  // queries touch are read
+  struct stat st;
+  Header header;
+  if (fstat( fd, &st ) != 0 || (size_t) st.st_size < sizeof( Header ) ||
+      pread( fd, &header, sizeof( Header ), 0 ) != (ssize_t) sizeof( Header ) ||
+      memcmp( header.magic, MAGIC, sizeof( MAGIC ) ) != 0) {
+    cerr << "Error: " << fileName << " is not a suffix array of this version of biconcor, please create it again" << endl;
     exit(1);
   }
-
-  if (m_index == NULL) {
-    cerr << "Error: cannot allocate memory to m_index" << endl;
+  m_mappedSize = st.st_size;
+  m_mapped = mmap( NULL, m_mappedSize, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if (m_mapped == MAP_FAILED) {
+    m_mapped = NULL;
+    cerr << "Error: cannot map " << fileName << endl;
     exit(1);
   }
 
-  if (m_wordInSentence == NULL) {
-    cerr << "Error: cannot allocate memory to m_wordInSentence" << endl;
-    exit(1);
-  }
-
-  if (m_sentence == NULL) {
-    cerr << "Error: cannot allocate memory to m_sentence" << endl;
-    exit(1);
-  }
-
-  fread( m_array, sizeof(WORD_ID), m_size, pFile ); // corpus
-  fread( m_index, sizeof(INDEX), m_size, pFile );   // suffix array
-  fread( m_wordInSentence, sizeof(char), m_size, pFile); // word index
-  fread( m_sentence, sizeof(INDEX), m_size, pFile); // sentence index
-
-  fread( &m_sentenceCount, sizeof(INDEX), 1, pFile );
+  m_size = header.size;
+  m_sentenceCount = header.sentenceCount;
+  cerr << "words in corpus: " << m_size << endl;
   cerr << "sentences in corpus: " << m_sentenceCount << endl;
-  m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
 
-  if (m_sentenceLength == NULL) {
-    cerr << "Error: cannot allocate memory to m_sentenceLength" << endl;
+  char *base = static_cast<char*>( m_mapped );
+  size_t offset = Align( sizeof( Header ) );
+  m_index = (INDEX*) (base + offset);
+  offset = Align( offset + sizeof( INDEX ) * m_size );
+  m_array = (WORD_ID*) (base + offset);
+  offset = Align( offset + sizeof( WORD_ID ) * m_size );
+  m_sentence = (SENTENCE_ID*) (base + offset);
+  offset = Align( offset + sizeof( SENTENCE_ID ) * m_size );
+  m_wordInSentence = (POSITION*) (base + offset);
+  offset = Align( offset + sizeof( POSITION ) * m_size );
+  m_sentenceLength = (POSITION*) (base + offset);
+  offset += sizeof( POSITION ) * m_sentenceCount;
+  if (offset > m_mappedSize) {
+    cerr << "Error: " << fileName << " is truncated" << endl;
     exit(1);
   }
 
-  fread( m_sentenceLength, sizeof(char), m_sentenceCount, pFile); // sentence length
-  fclose( pFile );
-
   m_vcb.Load( fileName + ".src-vcb" );
 }
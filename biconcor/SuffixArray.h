@@ -1,23 +1,28 @@
 #pragma once
 
+#include <stdint.h>
+
 #include "Vocabulary.h"
 
 class SuffixArray
 {
 public:
-  typedef unsigned int INDEX;
+  typedef uint64_t INDEX;
+  typedef unsigned int SENTENCE_ID;
+  typedef uint16_t POSITION; // in a sentence, lines are read up to 10000 chars
 
 private:
   WORD_ID *m_array;
   INDEX *m_index;
-  INDEX *m_buffer;
-  char *m_wordInSentence;
-  INDEX *m_sentence;
-  char *m_sentenceLength;
+  POSITION *m_wordInSentence;
+  SENTENCE_ID *m_sentence;
+  POSITION *m_sentenceLength;
   WORD_ID m_endOfSentence;
   Vocabulary m_vcb;
   INDEX m_size;
   INDEX m_sentenceCount;
+  void *m_mapped; // file the arrays point into, if loaded
+  size_t m_mappedSize;
 
   // No copying allowed.
   SuffixArray(const SuffixArray&);
@@ -28,7 +33,7 @@ public:
   ~SuffixArray();
 
   void Create(const std::string& fileName );
-  void Sort(INDEX start, INDEX end);
+  void Sort();
   int CompareIndex( INDEX a, INDEX b ) const;
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
@@ -43,13 +48,13 @@ public:
   inline INDEX GetPosition( INDEX index ) const {
     return m_index[ index ];
   }
-  inline INDEX GetSentence( INDEX position ) const {
+  inline SENTENCE_ID GetSentence( INDEX position ) const {
     return m_sentence[position];
   }
-  inline char GetWordInSentence( INDEX position ) const {
+  inline int GetWordInSentence( INDEX position ) const {
     return m_wordInSentence[position];
   }
-  inline char GetSentenceLength( INDEX sentenceId ) const {
+  inline int GetSentenceLength( SENTENCE_ID sentenceId ) const {
     return m_sentenceLength[sentenceId];
   }
   inline INDEX GetSize() const {
@@ -0,0 +1,99 @@
+#include "SuffixArray.h"
+
+#define BOOST_TEST_MODULE BiconcorSuffixArray
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+typedef SuffixArray::INDEX INDEX;
+
+const int LONG_SENTENCE = 300;
+
+// the order of the merge sort that SA-IS replaced
+struct CompareSuffix {
+  const SuffixArray &m_sa;
+  CompareSuffix( const SuffixArray &sa ) : m_sa(sa) {}
+  bool operator()( INDEX a, INDEX b ) const {
+    return m_sa.CompareIndex( a, b ) < 0;
+  }
+};
+
+// a small vocabulary so that suffixes share long prefixes, and one sentence
+// longer than 127 words
+string WriteCorpus()
+{
+  char fileName[] = "/tmp/biconcor_test_XXXXXX";
+  int fd = mkstemp( fileName );
+  BOOST_REQUIRE( fd != -1 );
+  close( fd );
+
+  ofstream out( fileName );
+  unsigned int seed = 1;
+  for( int sentence=0; sentence<200; sentence++ ) {
+    int length = 1 + sentence % 17;
+    for( int i=0; i<length; i++ ) {
+      seed = seed * 1103515245 + 12345;
+      out << (i ? " " : "") << "w" << (seed >> 16) % 5;
+    }
+    out << "\n";
+  }
+  for( int i=0; i<LONG_SENTENCE; i++ ) {
+    out << (i ? " " : "") << "w" << i % 3;
+  }
+  out << "\n";
+  return fileName;
+}
+
+void Remove( const string &fileName )
+{
+  remove( fileName.c_str() );
+  remove( ( fileName + ".src-vcb" ).c_str() );
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(sais_matches_comparison_sort) {
+  string corpus = WriteCorpus();
+  SuffixArray sa;
+  sa.Create( corpus );
+
+  vector< INDEX > expected( sa.GetSize() );
+  for( INDEX i=0; i<sa.GetSize(); i++ ) {
+    expected[i] = i;
+  }
+  stable_sort( expected.begin(), expected.end(), CompareSuffix( sa ) );
+
+  for( INDEX i=0; i<sa.GetSize(); i++ ) {
+    BOOST_REQUIRE_EQUAL( expected[i], sa.GetPosition( i ) );
+  }
+  Remove( corpus );
+}
+
+BOOST_AUTO_TEST_CASE(long_sentence_positions) {
+  string corpus = WriteCorpus();
+  string saved = corpus + ".sa";
+  {
+    SuffixArray sa;
+    sa.Create( corpus );
+    sa.Save( saved );
+  }
+
+  SuffixArray sa;
+  sa.Load( saved );
+  const SuffixArray::SENTENCE_ID sentence = 200;
+  BOOST_CHECK_EQUAL( LONG_SENTENCE, sa.GetSentenceLength( sentence ) );
+  INDEX last = sa.GetSize() - 2; // before the end of sentence marker
+  BOOST_CHECK_EQUAL( sentence, sa.GetSentence( last ) );
+  BOOST_CHECK_EQUAL( LONG_SENTENCE-1, sa.GetWordInSentence( last ) );
+  Remove( corpus );
+  Remove( saved );
+}
@@ -110,12 +110,12 @@ WORD_ID TargetCorpus::GetWordId( INDEX sentence, int word ) const
   return m_array[ m_sentenceEnd[ sentence-1 ] + 1 + word ] ;
 }
 
-char TargetCorpus::GetSentenceLength( INDEX sentence ) const
+int TargetCorpus::GetSentenceLength( INDEX sentence ) const
 {
   if (sentence == 0) {
-    return (char) m_sentenceEnd[ 0 ]+1;
+    return m_sentenceEnd[ 0 ]+1;
   }
-  return (char) ( m_sentenceEnd[ sentence ] - m_sentenceEnd[ sentence-1 ] );
+  return m_sentenceEnd[ sentence ] - m_sentenceEnd[ sentence-1 ];
 }
 
 void TargetCorpus::Save(const string& fileName ) const
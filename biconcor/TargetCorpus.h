@@ -1,11 +1,13 @@
 #pragma once
 
+#include <stdint.h>
+
 #include "Vocabulary.h"
 
 class TargetCorpus
 {
 public:
-  typedef unsigned int INDEX;
+  typedef uint64_t INDEX;
 
 private:
   WORD_ID *m_array;
@@ -26,7 +28,7 @@ public:
   WORD GetWordFromId( const WORD_ID id ) const;
   WORD GetWord( INDEX sentence, int word ) const;
   WORD_ID GetWordId( INDEX sentence, int word ) const;
-  char GetSentenceLength( INDEX sentence ) const;
+  int GetSentenceLength( INDEX sentence ) const;
   void Load(const std::string& fileName );
   void Save(const std::string& fileName ) const;
 };
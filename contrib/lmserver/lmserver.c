@@ -369,6 +369,10 @@ conn *conn_new(const int sfd, const int init_state, const int event_flags,
 
     c->noreply = false;
 
+    c->batch_left = 0;
+    c->batch_size = 0;
+    c->batch_buf = 0;
+
     event_set(&c->event, sfd, event_flags, event_handler, (void *)c);
     event_base_set(base, &c->event);
     c->ev_flags = event_flags;
@@ -396,6 +400,12 @@ static void conn_cleanup(conn *c) {
         free(c->write_and_free);
         c->write_and_free = 0;
     }
+
+    if (c->batch_buf) {
+        free(c->batch_buf);
+        c->batch_buf = 0;
+    }
+    c->batch_left = 0;
 }
 
 /*
@@ -882,19 +892,23 @@ static void process_stat(conn *c, token_t *tokens, const size_t ntokens) {
     out_string(c, "ERROR");
 }
 
-static inline void process_srilm_command(conn *c, token_t *tokens, size_t ntokens) {
-    int context[6];
-    int i = 1;
-    int j = ntokens - 3;
+/* log probability of the n-gram in tokens: the word, then its history, most
+ * recent word first */
+static float ngram_prob(token_t *tokens) {
+    int context[MAX_TOKENS];
+    int i = 0;
     while (tokens[i].length) {
-        context[i-1] = srilm_getvoc(tokens[i].value);
-	++i;
-    }
-    float p = -999.0f;
-    if (context[0] != -1) {
-      context[i-1] = -1;
-      p = srilm_wordprob(context[0], &context[1]);
+        context[i] = srilm_getvoc(tokens[i].value);
+        ++i;
     }
+    if (i == 0 || context[0] == -1)
+        return -999.0f;
+    context[i] = -1;
+    return srilm_wordprob(context[0], &context[1]);
+}
+
+static inline void process_srilm_command(conn *c, token_t *tokens, size_t ntokens) {
+    float p = ngram_prob(&tokens[1]);
 
     memcpy(c->wbuf, &p, sizeof(float));
     memcpy(c->wbuf + sizeof(float), "\r\n", 2);
@@ -905,6 +919,67 @@ static inline void process_srilm_command(conn *c, token_t *tokens, size_t ntoken
     c->write_and_go = conn_read;
 }
 
+#define MAX_BATCH_SIZE 65536
+#define BATCH_HEADER_SIZE (2 * sizeof(unsigned int))
+
+/*
+ * probs <id> <count>
+ *
+ * The next <count> lines are n-grams in the format of the prob command.
+ * Once the last one is read, the reply is sent in one piece: <id> and <count>
+ * as unsigned ints, then the <count> log probabilities as floats, all in
+ * host byte order like the reply to prob. Clients need not wait for the
+ * reply before they send the next batch; replies come in request order.
+ */
+static void process_probs_command(conn *c, token_t *tokens, size_t ntokens) {
+    char *end;
+    unsigned long id, count;
+    unsigned int header[2];
+
+    id = strtoul(tokens[1].value, &end, 10);
+    if (*end != '\0' || id > UINT_MAX) {
+        out_string(c, "CLIENT_ERROR bad command line format");
+        return;
+    }
+    count = strtoul(tokens[2].value, &end, 10);
+    if (*end != '\0' || count == 0 || count > MAX_BATCH_SIZE) {
+        out_string(c, "CLIENT_ERROR bad command line format");
+        return;
+    }
+
+    c->batch_size = c->batch_left = count;
+    /* without memory the n-grams are still read, so the stream stays in step */
+    c->batch_buf = malloc(BATCH_HEADER_SIZE + count * sizeof(float));
+    if (c->batch_buf) {
+        header[0] = id;
+        header[1] = count;
+        memcpy(c->batch_buf, header, BATCH_HEADER_SIZE);
+    }
+    conn_set_state(c, conn_read);
+}
+
+/* one n-gram line of a probs batch */
+static void process_batch_ngram(conn *c, char *line) {
+    token_t tokens[MAX_TOKENS];
+    float p;
+
+    tokenize_command(line, tokens, MAX_TOKENS);
+    if (c->batch_buf) {
+        p = ngram_prob(tokens);
+        memcpy(c->batch_buf + BATCH_HEADER_SIZE + (c->batch_size - c->batch_left) * sizeof(float), &p, sizeof(float));
+    }
+
+    if (--c->batch_left > 0) {
+        conn_set_state(c, conn_read);
+    } else if (c->batch_buf) {
+        char *buf = c->batch_buf;
+        c->batch_buf = 0;
+        write_and_free(c, buf, BATCH_HEADER_SIZE + c->batch_size * sizeof(float));
+    } else {
+        out_string(c, "SERVER_ERROR out of memory preparing response");
+    }
+}
+
 static void process_command(conn *c, char *command) {
 
     token_t tokens[MAX_TOKENS];
@@ -916,6 +991,11 @@ static void process_command(conn *c, char *command) {
     if (settings.verbose > 1)
         fprintf(stderr, "<%d %s\n", c->sfd, command);
 
+    if (c->batch_left > 0) {
+        process_batch_ngram(c, command);
+        return;
+    }
+
     /*
      * for commands set/add/replace, we build an item and read the data
      * directly into it, then continue in nread_complete().
@@ -933,6 +1013,9 @@ static void process_command(conn *c, char *command) {
     if (ntokens >1 &&
       strcmp(tokens[COMMAND_TOKEN].value, "prob") == 0) {
         process_srilm_command(c, tokens, ntokens);
+    } else if (ntokens == 4 &&
+      strcmp(tokens[COMMAND_TOKEN].value, "probs") == 0) {
+        process_probs_command(c, tokens, ntokens);
     } else if (ntokens >= 2 && (strcmp(tokens[COMMAND_TOKEN].value, "stats") == 0)) {
 
         process_stat(c, tokens, ntokens);
@@ -225,6 +225,11 @@ struct conn {
                          a managed instance. -1 (_not_ 0) means invalid. */
     int    gen;       /* generation requested for the bucket */
     bool   noreply;   /* True if the reply should not be sent. */
+
+    /* data for the probs command, whose n-grams follow on separate lines */
+    int    batch_left; /* how many n-gram lines of the batch are still to come */
+    int    batch_size; /* number of n-grams in the batch */
+    char   *batch_buf; /* the reply: request id, count, then one float per n-gram */
     conn   *next;     /* Used for generating a list of conn structures */
 };
 
@@ -53,11 +53,13 @@ struct Left {
   bool operator==(const Left &other) const {
     return 
       (length == other.length) && 
-      pointers[length - 1] == other.pointers[length - 1];
+      (!length || pointers[length - 1] == other.pointers[length - 1]);
   }
 
   int Compare(const Left &other) const {
     if (length != other.length) return length < other.length ? -1 : 1;
+    // with no pointers, pointers[-1] would be length and the padding after it
+    if (!length) return 0;
     if (pointers[length - 1] > other.pointers[length - 1]) return 1;
     if (pointers[length - 1] < other.pointers[length - 1]) return -1;
     return 0;
@@ -65,7 +67,7 @@ struct Left {
 
   bool operator<(const Left &other) const {
     if (length != other.length) return length < other.length;
-    return pointers[length - 1] < other.pointers[length - 1];
+    return length && pointers[length - 1] < other.pointers[length - 1];
   }
 
   void ZeroRemaining() {
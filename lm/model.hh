@@ -136,6 +136,14 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
         // Amount of additional content that should be considered by the next call.
         unsigned char &next_use) const;
 
+    /* Hint that new_word will be scored after the context soon, so that the
+     * entries this needs can be fetched from memory in the meantime.  The
+     * context is passed as for FullScoreForgotState.  
+     */
+    void Prefetch(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word) const {
+      search_.Prefetch(context_rbegin, std::min(context_rend, context_rbegin + P::Order() - 1), new_word);
+    }
+
   private:
     friend void lm::ngram::LoadLM<>(const char *file, const Config &config, GenericModel<Search, VocabularyT> &to);
 
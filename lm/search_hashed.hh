@@ -146,6 +146,24 @@ template <class MiddleT, class LongestT> class TemplateHashedSearch : public Has
       return true;
     }
 
+    // Start fetching the entries that scoring new_word after the context will
+    // look up.  The keys only depend on the words, so every order can be fetched.  
+    void Prefetch(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word) const {
+#ifdef __GNUC__
+      __builtin_prefetch(&unigram.Lookup(new_word));
+#endif
+      Node node = static_cast<Node>(new_word);
+      typename std::vector<Middle>::const_iterator mid = middle_.begin();
+      for (const WordIndex *i = context_rbegin; i < context_rend; ++i, ++mid) {
+        node = CombineWordHash(node, *i);
+        if (mid == middle_.end()) {
+          longest.Prefetch(node);
+          return;
+        }
+        mid->Prefetch(node);
+      }
+    }
+
     // Geenrate a node without necessarily checking that it actually exists.  
     // Optionally return false if it's know to not exist.  
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
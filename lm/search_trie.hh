@@ -89,6 +89,14 @@ template <class Quant, class Bhiksha> class TrieSearch {
       return longest.Find(word, prob, node);
     }
 
+    // Only the unigram can be fetched early: the position of longer n-grams
+    // depends on what the lookups of shorter ones find.  
+    void Prefetch(const WordIndex * /*context_rbegin*/, const WordIndex * /*context_rend*/, const WordIndex new_word) const {
+#ifdef __GNUC__
+      __builtin_prefetch(&unigram.Lookup(new_word));
+#endif
+    }
+
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
       // TODO: don't decode backoff.
       assert(begin != end);
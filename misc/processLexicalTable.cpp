@@ -15,6 +15,8 @@ void printHelp()
             "options: \n"
             "\t-in  string -- input table file name\n"
             "\t-out string -- prefix of binary table files\n"
+            "\t-hash       -- write one hash table (.binlexr.hash), which is mapped rather than read\n"
+            "\t-factor-delimiter string -- with -hash, factor delimiter of the table, which the decoder must use too (default |)\n"
             "If -in is not specified reads from stdin\n"
             "\n";
 }
@@ -24,6 +26,8 @@ int main(int argc, char** argv)
   std::cerr << "processLexicalTable v0.1 by Konrad Rawlik\n";
   std::string inFilePath;
   std::string outFilePath("out");
+  bool hash = false;
+  std::string factorDelimiter("|");
   if(1 >= argc) {
     printHelp();
     return 1;
@@ -36,6 +40,11 @@ int main(int argc, char** argv)
     } else if("-out" == arg && i+1 < argc) {
       ++i;
       outFilePath = argv[i];
+    } else if("-hash" == arg) {
+      hash = true;
+    } else if("-factor-delimiter" == arg && i+1 < argc) {
+      ++i;
+      factorDelimiter = argv[i];
     } else {
       //somethings wrong... print help
       printHelp();
@@ -45,11 +54,15 @@ int main(int argc, char** argv)
 
   if(inFilePath.empty()) {
     std::cerr << "processing stdin to " << outFilePath << ".*\n";
+    if(hash) {
+      return LexicalReorderingTableMemory::Create(std::cin, outFilePath, factorDelimiter) ? 0 : 1;
+    }
     return LexicalReorderingTableTree::Create(std::cin, outFilePath);
   } else {
     std::cerr << "processing " << inFilePath<< " to " << outFilePath << ".*\n";
     InputFileStream file(inFilePath);
-    bool success = LexicalReorderingTableTree::Create(file, outFilePath);
+    bool success = hash ? LexicalReorderingTableMemory::Create(file, outFilePath, factorDelimiter)
+                   : LexicalReorderingTableTree::Create(file, outFilePath);
     return (success ? 0 : 1);
   }
 }
@@ -269,6 +269,13 @@ int main(int argc, char* argv[])
     pool.Stop(true);  // flush remaining jobs
 #endif
   
+    IFVERBOSE(1) {
+      const OnDiskRuleCache &ruleCache = staticData.GetOnDiskRuleCache();
+      if (ruleCache.GetHits() + ruleCache.GetMisses() > 0) {
+        TRACE_ERR(ruleCache << endl);
+      }
+    }
+
     delete ioWrapper;
   
     IFVERBOSE(1)
@@ -32,8 +32,10 @@ POSSIBILITY OF SUCH DAMAGE.
 
 // example file on how to use moses library
 
+#include <algorithm>
 #include <iostream>
 #include <stack>
+#include <stdexcept>
 #include "TypeDef.h"
 #include "Util.h"
 #include "IOWrapper.h"
@@ -58,10 +60,15 @@ IOWrapper::IOWrapper(
   ,m_inputFactorUsed(inputFactorUsed)
   ,m_inputFile(NULL)
   ,m_inputStream(&std::cin)
+  ,m_inputFilePiece(NULL)
+#ifdef WITH_THREADS
+  ,m_readAhead(NULL)
+#endif
   ,m_nBestStream(NULL)
   ,m_outputWordGraphStream(NULL)
   ,m_outputSearchGraphStream(NULL)
   ,m_detailedTranslationReportingStream(NULL)
+  ,m_sentenceStatsStream(NULL)
   ,m_alignmentOutputStream(NULL)
 {
   Initialization(inputFactorOrder, outputFactorOrder
@@ -79,24 +86,41 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
   ,m_outputFactorOrder(outputFactorOrder)
   ,m_inputFactorUsed(inputFactorUsed)
   ,m_inputFilePath(inputFilePath)
-  ,m_inputFile(new InputFileStream(inputFilePath))
+  ,m_inputFile(NULL)
+  ,m_inputStream(NULL)
+  ,m_inputFilePiece(NULL)
+#ifdef WITH_THREADS
+  ,m_readAhead(NULL)
+#endif
   ,m_nBestStream(NULL)
   ,m_outputWordGraphStream(NULL)
   ,m_outputSearchGraphStream(NULL)
   ,m_detailedTranslationReportingStream(NULL)
+  ,m_sentenceStatsStream(NULL)
   ,m_alignmentOutputStream(NULL)
 {
   Initialization(inputFactorOrder, outputFactorOrder
                  , inputFactorUsed
                  , nBestSize, nBestFilePath);
 
-  m_inputStream = m_inputFile;
+  // a sentence is a line, which is taken straight from the mapped or buffered file
+  if (StaticData::Instance().GetInputType() == SentenceInput) {
+    m_inputFilePiece = new util::FilePiece(inputFilePath.c_str());
+  } else {
+    m_inputFile = new InputFileStream(inputFilePath);
+    m_inputStream = m_inputFile;
+  }
 }
 
 IOWrapper::~IOWrapper()
 {
+#ifdef WITH_THREADS
+  // stop the reading thread before what it reads from
+  delete m_readAhead;
+#endif
   if (m_inputFile != NULL)
     delete m_inputFile;
+  delete m_inputFilePiece;
   if (m_nBestStream != NULL && !m_surpressSingleBestOutput) {
     // outputting n-best to file, rather than stdout. need to close file and delete obj
     delete m_nBestStream;
@@ -108,6 +132,7 @@ IOWrapper::~IOWrapper()
     delete m_outputSearchGraphStream;
   }
   delete m_detailedTranslationReportingStream;
+  delete m_sentenceStatsStream;
   delete m_alignmentOutputStream;
 }
 
@@ -161,6 +186,13 @@ void IOWrapper::Initialization(const std::vector<FactorType>	&/*inputFactorOrder
     CHECK(m_detailedTranslationReportingStream->good());
   }
 
+  // timing and counts of each sentence
+  if (!staticData.GetSentenceStatsFilePath().empty()) {
+    const std::string &path = staticData.GetSentenceStatsFilePath();
+    m_sentenceStatsStream = new std::ofstream(path.c_str());
+    CHECK(m_sentenceStatsStream->good());
+  }
+
   // sentence alignment output
   if (! staticData.GetAlignmentOutputFile().empty()) {
     m_alignmentOutputStream = new ofstream(staticData.GetAlignmentOutputFile().c_str());
@@ -171,11 +203,8 @@ void IOWrapper::Initialization(const std::vector<FactorType>	&/*inputFactorOrder
 
 InputType*IOWrapper::GetInput(InputType* inputType)
 {
-  if(inputType->Read(*m_inputStream, m_inputFactorOrder)) {
-    if (long x = inputType->GetTranslationId()) {
-      if (x>=m_translationId) m_translationId = x+1;
-    } else inputType->SetTranslationId(m_translationId++);
-
+  if(Read(*inputType)) {
+    SetTranslationId(*inputType);
     return inputType;
   } else {
     delete inputType;
@@ -183,6 +212,154 @@ InputType*IOWrapper::GetInput(InputType* inputType)
   }
 }
 
+InputType*IOWrapper::GetInput(InputTypeEnum inputType)
+{
+#ifdef WITH_THREADS
+  if (m_readAhead != NULL) {
+    InputType *input = m_readAhead->Pop();
+    if (input != NULL) {
+      SetTranslationId(*input);
+    }
+    return input;
+  }
+#endif
+  InputType *input = ReadNextInput(inputType);
+  if (input != NULL) {
+    SetTranslationId(*input);
+  }
+  return input;
+}
+
+bool IOWrapper::Read(InputType &inputType)
+{
+  if (m_inputFilePiece == NULL) {
+    return inputType.Read(*m_inputStream, m_inputFactorOrder);
+  }
+  // only made for sentence input, one per line
+  StringPiece line;
+  try {
+    line = m_inputFilePiece->ReadLine();
+  } catch (const util::EndOfFileException &) {
+    return false;
+  }
+  static_cast<Sentence&>(inputType).InitFromLine(line, m_inputFactorOrder);
+  return true;
+}
+
+InputType*IOWrapper::ReadNextInput(InputTypeEnum inputType)
+{
+  InputType *input = NULL;
+  switch(inputType) {
+  case SentenceInput:
+    input = new Sentence;
+    break;
+  case ConfusionNetworkInput:
+    input = new ConfusionNet;
+    break;
+  case WordLatticeInput:
+    input = new WordLattice;
+    break;
+  default:
+    TRACE_ERR("Unknown input type: " << inputType << "\n");
+    return NULL;
+  }
+  if (!Read(*input)) {
+    delete input;
+    return NULL;
+  }
+  return input;
+}
+
+void IOWrapper::SetTranslationId(InputType &input)
+{
+  if (long x = input.GetTranslationId()) {
+    if (x>=m_translationId) m_translationId = x+1;
+  } else input.SetTranslationId(m_translationId++);
+}
+
+#ifdef WITH_THREADS
+void IOWrapper::StartReadAhead(InputTypeEnum inputType, size_t maxQueued)
+{
+  CHECK(m_readAhead == NULL);
+  m_readAhead = new InputReadAhead(*this, inputType, maxQueued);
+}
+
+InputReadAhead::InputReadAhead(IOWrapper &ioWrapper, InputTypeEnum inputType, size_t maxQueued)
+  :m_ioWrapper(ioWrapper)
+  ,m_inputType(inputType)
+  ,m_maxQueued(std::max<size_t>(1, maxQueued))
+  ,m_end(false)
+  ,m_stop(false)
+  ,m_thread(&InputReadAhead::Run, this)
+{
+}
+
+InputReadAhead::~InputReadAhead()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stop = true;
+    m_queueChanged.notify_all();
+  }
+  m_thread.join();
+  for (size_t i = 0; i < m_queue.size(); ++i) {
+    delete m_queue[i];
+  }
+}
+
+InputType *InputReadAhead::Pop()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (m_queue.empty() && !m_end) {
+    m_queueChanged.wait(lock);
+  }
+  if (m_queue.empty()) {
+    if (!m_error.empty()) {
+      throw std::runtime_error(m_error);
+    }
+    return NULL;
+  }
+  InputType *input = m_queue.front();
+  m_queue.pop_front();
+  m_queueChanged.notify_all();
+  return input;
+}
+
+void InputReadAhead::Run()
+{
+  try {
+    while (true) {
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (m_queue.size() >= m_maxQueued && !m_stop) {
+          m_queueChanged.wait(lock);
+        }
+        if (m_stop) {
+          return;
+        }
+      }
+      // parsed without the lock, this is the work taken off the decoder's thread
+      InputType *input = m_ioWrapper.ReadNextInput(m_inputType);
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (input == NULL) {
+        m_end = true;
+      } else {
+        m_queue.push_back(input);
+      }
+      m_queueChanged.notify_all();
+      if (m_end) {
+        return;
+      }
+    }
+  } catch (const std::exception &e) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_error = e.what();
+    m_end = true;
+    m_queueChanged.notify_all();
+  }
+}
+#endif
+
 /***
  * print surface factor only for the given phrase
  */
@@ -525,19 +702,7 @@ void IOWrapper::OutputLatticeMBRNBestList(const vector<LatticeMBRSolution>& solu
 bool ReadInput(IOWrapper &ioWrapper, InputTypeEnum inputType, InputType*& source)
 {
   delete source;
-  switch(inputType) {
-  case SentenceInput:
-    source = ioWrapper.GetInput(new Sentence);
-    break;
-  case ConfusionNetworkInput:
-    source = ioWrapper.GetInput(new ConfusionNet);
-    break;
-  case WordLatticeInput:
-    source = ioWrapper.GetInput(new WordLattice);
-    break;
-  default:
-    TRACE_ERR("Unknown input type: " << inputType << "\n");
-  }
+  source = ioWrapper.GetInput(inputType);
   return (source ? true : false);
 }
 
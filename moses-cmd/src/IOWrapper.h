@@ -36,10 +36,18 @@ POSSIBILITY OF SUCH DAMAGE.
 #define moses_cmd_IOWrapper_h
 
 #include <cassert>
+#include <deque>
 #include <fstream>
 #include <ostream>
 #include <vector>
 #include "util/check.hh"
+#include "util/file_piece.hh"
+
+#ifdef WITH_THREADS
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
 
 #include "TypeDef.h"
 #include "Sentence.h"
@@ -53,8 +61,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "WordLattice.h"
 #include "LatticeMBR.h"
 
+class InputReadAhead;
+
 class IOWrapper
 {
+  friend class InputReadAhead;
+
 protected:
   long m_translationId;
 
@@ -64,9 +76,14 @@ protected:
   std::string										m_inputFilePath;
   Moses::InputFileStream				*m_inputFile;
   std::istream									*m_inputStream;
+  util::FilePiece               *m_inputFilePiece; //! sentences of an input file are read with this, not m_inputStream
+#ifdef WITH_THREADS
+  InputReadAhead                *m_readAhead;
+#endif
   std::ostream 									*m_nBestStream
   ,*m_outputWordGraphStream,*m_outputSearchGraphStream;
   std::ostream                  *m_detailedTranslationReportingStream;
+  std::ostream                  *m_sentenceStatsStream;
   std::ofstream *m_alignmentOutputStream;
   bool													m_surpressSingleBestOutput;
 
@@ -76,6 +93,12 @@ protected:
                       , size_t												nBestSize
                       , const std::string							&nBestFilePath);
 
+  //! fill inputType with the next input, false at the end of the input
+  bool Read(Moses::InputType &inputType);
+  //! the next input of the given type, without translation id, NULL at the end of the input
+  Moses::InputType* ReadNextInput(Moses::InputTypeEnum inputType);
+  void SetTranslationId(Moses::InputType &input);
+
 public:
   IOWrapper(const std::vector<Moses::FactorType>	&inputFactorOrder
             , const std::vector<Moses::FactorType>			&outputFactorOrder
@@ -92,6 +115,12 @@ public:
   ~IOWrapper();
 
   Moses::InputType* GetInput(Moses::InputType *inputType);
+  //! the next input of the given type, NULL at the end of the input
+  Moses::InputType* GetInput(Moses::InputTypeEnum inputType);
+#ifdef WITH_THREADS
+  //! read and parse up to maxQueued inputs ahead of GetInput() on a separate thread
+  void StartReadAhead(Moses::InputTypeEnum inputType, size_t maxQueued);
+#endif
 
   void OutputBestHypo(const Moses::Hypothesis *hypo, long translationId, bool reportSegmentation, bool reportAllFactors);
   void OutputLatticeMBRNBestList(const std::vector<LatticeMBRSolution>& solutions,long translationId);
@@ -116,8 +145,43 @@ public:
     assert (m_detailedTranslationReportingStream);
     return *m_detailedTranslationReportingStream;
   }
+
+  std::ostream &GetSentenceStatsStream() {
+    assert (m_sentenceStatsStream);
+    return *m_sentenceStatsStream;
+  }
 };
 
+#ifdef WITH_THREADS
+/** Reads and parses the input on its own thread, up to a number of inputs
+ *  ahead of the decoder taking them, so that the thread handing sentences to
+ *  the translation threads doesn't parse them as well.
+ */
+class InputReadAhead
+{
+public:
+  InputReadAhead(IOWrapper &ioWrapper, Moses::InputTypeEnum inputType, size_t maxQueued);
+  //! stops reading, waiting for the input being read to be complete
+  ~InputReadAhead();
+
+  //! the next input in order, NULL at the end of the input. An error reading it is thrown here
+  Moses::InputType* Pop();
+
+private:
+  IOWrapper &m_ioWrapper;
+  const Moses::InputTypeEnum m_inputType;
+  const size_t m_maxQueued;
+  std::deque<Moses::InputType*> m_queue;
+  bool m_end, m_stop;
+  std::string m_error;
+  boost::mutex m_mutex;
+  boost::condition_variable m_queueChanged;
+  boost::thread m_thread; // last, so that it starts once the rest is initialised
+
+  void Run();
+};
+#endif
+
 IOWrapper *GetIODevice(const Moses::StaticData &staticData);
 bool ReadInput(IOWrapper &ioWrapper, Moses::InputTypeEnum inputType, Moses::InputType*& source);
 void OutputBestSurface(std::ostream &out, const Moses::Hypothesis *hypo, const std::vector<Moses::FactorType> &outputFactorOrder, bool reportSegmentation, bool reportAllFactors);
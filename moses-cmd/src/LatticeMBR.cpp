@@ -33,45 +33,107 @@ void GetOutputWords(const TrellisPath &path, vector <Word> &translation)
 }
 
 
-void extract_ngrams(const vector<Word >& sentence, map < Phrase, int >  & allngrams)
+
+NgramIndex::NgramIndex()
 {
-  for (int k = 0; k < (int)bleu_order; k++) {
-    for(int i =0; i < max((int)sentence.size()-k,0); i++) {
-      Phrase ngram( k+1);
-      for ( int j = i; j<= i+k; j++) {
-        ngram.AddWord(sentence[j]);
-      }
-      ++allngrams[ngram];
-    }
+  Ngram empty;
+  empty.prefix = NOT_FOUND;
+  empty.order = 0;
+  m_ngrams.push_back(empty);
+}
+
+size_t NgramIndex::KeyHasher::operator()(const Key& key) const
+{
+  size_t seed = key.first;
+  for (size_t factorType = 0; factorType < MAX_NUM_FACTORS; ++factorType) {
+    boost::hash_combine(seed, key.second[factorType]);
   }
+  return seed;
 }
 
+bool NgramIndex::KeyEqual::operator()(const Key& a, const Key& b) const
+{
+  if (a.first != b.first || a.second.IsNonTerminal() != b.second.IsNonTerminal())
+    return false;
+  for (size_t factorType = 0; factorType < MAX_NUM_FACTORS; ++factorType) {
+    if (a.second[factorType] != b.second[factorType])
+      return false;
+  }
+  return true;
+}
+
+size_t NgramIndex::Extend(size_t prefix, const Word& word)
+{
+  std::pair<boost::unordered_map<Key, size_t, KeyHasher, KeyEqual>::iterator, bool> inserted =
+    m_index.insert(make_pair(Key(prefix, word), m_ngrams.size()));
+  if (inserted.second) {
+    Ngram ngram;
+    ngram.prefix = prefix;
+    ngram.word = word;
+    ngram.order = m_ngrams[prefix].order + 1;
+    m_ngrams.push_back(ngram);
+  }
+  return inserted.first->second;
+}
 
+size_t NgramIndex::Find(size_t prefix, const Word& word) const
+{
+  boost::unordered_map<Key, size_t, KeyHasher, KeyEqual>::const_iterator it = m_index.find(Key(prefix, word));
+  return it == m_index.end() ? NOT_FOUND : it->second;
+}
 
-void NgramScores::addScore(const Hypothesis* node, const Phrase& ngram, float score)
+Phrase NgramIndex::GetPhrase(size_t ngram) const
 {
-  set<Phrase>::const_iterator ngramIter = m_ngrams.find(ngram);
-  if (ngramIter == m_ngrams.end()) {
-    ngramIter = m_ngrams.insert(ngram).first;
-  }
-  map<const Phrase*,float>& ngramScores = m_scores[node];
-  map<const Phrase*,float>::iterator scoreIter = ngramScores.find(&(*ngramIter));
-  if (scoreIter == ngramScores.end()) {
-    ngramScores[&(*ngramIter)] = score;
-  } else {
-    ngramScores[&(*ngramIter)] = log_sum(score,scoreIter->second);
+  vector<const Word*> words;
+  for (; ngram != EMPTY; ngram = GetPrefix(ngram)) {
+    words.push_back(&GetLastWord(ngram));
   }
+  Phrase phrase(words.size());
+  for (vector<const Word*>::reverse_iterator it = words.rbegin(); it != words.rend(); ++it) {
+    phrase.AddWord(**it);
+  }
+  return phrase;
 }
 
-NgramScores::NodeScoreIterator NgramScores::nodeBegin(const Hypothesis* node)
+void NgramPosteriors::AddScore(size_t ngram, float score)
 {
-  return m_scores[node].begin();
+  if (ngram >= m_scores.size()) {
+    m_scores.resize(m_index.GetSize());
+    m_scored.resize(m_index.GetSize());
+  }
+  if (m_scored[ngram]) {
+    m_scores[ngram] = log_sum(score, m_scores[ngram]);
+  } else {
+    m_scores[ngram] = score;
+    m_scored[ngram] = true;
+  }
 }
 
+void NgramPosteriors::Normalise(float logZ)
+{
+  for (size_t ngram = 0; ngram < m_scores.size(); ++ngram) {
+    if (m_scored[ngram]) {
+      m_scores[ngram] -= logZ;
+      VERBOSE(2,m_index.GetPhrase(ngram) << " [" << m_scores[ngram] << "]" << endl);
+    }
+  }
+}
 
-NgramScores::NodeScoreIterator NgramScores::nodeEnd(const Hypothesis* node)
+void extract_ngrams(const vector<Word >& sentence, const NgramPosteriors& ngramScores, vector<size_t>& ngrams)
 {
-  return m_scores[node].end();
+  const NgramIndex& index = ngramScores.GetIndex();
+  float score;
+  for (size_t i = 0; i < sentence.size(); ++i) {
+    size_t ngram = NgramIndex::EMPTY;
+    //the prefixes of every numbered n-gram are numbered, so stop at the first miss
+    for (size_t j = i; j < sentence.size() && j < i + bleu_order; ++j) {
+      ngram = index.Find(ngram, sentence[j]);
+      if (ngram == NOT_FOUND)
+        break;
+      if (ngramScores.GetScore(ngram, score))
+        ngrams.push_back(ngram);
+    }
+  }
 }
 
 LatticeMBRSolution::LatticeMBRSolution(const TrellisPath& path, bool isMap) :
@@ -95,25 +157,29 @@ LatticeMBRSolution::LatticeMBRSolution(const TrellisPath& path, bool isMap) :
 }
 
 
-void LatticeMBRSolution::CalcScore(map<Phrase, float>& finalNgramScores, const vector<float>& thetas, float mapWeight)
+void LatticeMBRSolution::CalcScore(const NgramPosteriors& finalNgramScores, const vector<float>& thetas, float mapWeight)
 {
   m_ngramScores.assign(thetas.size()-1, -10000);
 
-  map < Phrase, int > counts;
-  extract_ngrams(m_words,counts);
-
   //Now score this translation
   m_score = thetas[0] * m_words.size();
 
-  //Calculate the ngramScores, working in log space at first
-  for (map < Phrase, int >::iterator ngrams = counts.begin(); ngrams != counts.end(); ++ngrams) {
-    float ngramPosterior = UNKNGRAMLOGPROB;
-    map<Phrase,float>::const_iterator ngramPosteriorIt = finalNgramScores.find(ngrams->first);
-    if (ngramPosteriorIt != finalNgramScores.end()) {
-      ngramPosterior = ngramPosteriorIt->second;
+  //Calculate the ngramScores, working in log space at first.
+  //Every occurrence adds its posterior, n-grams not in the lattice add UNKNGRAMLOGPROB
+  const NgramIndex& index = finalNgramScores.GetIndex();
+  for (size_t i = 0; i < m_words.size(); ++i) {
+    size_t ngram = NgramIndex::EMPTY;
+    for (size_t j = i; j < m_words.size() && j < i + bleu_order; ++j) {
+      if (ngram != NOT_FOUND) {
+        ngram = index.Find(ngram, m_words[j]);
+      }
+      float ngramPosterior = UNKNGRAMLOGPROB;
+      if (ngram != NOT_FOUND) {
+        finalNgramScores.GetScore(ngram, ngramPosterior);
+      }
+      size_t ngramSize = j - i + 1;
+      m_ngramScores[ngramSize-1] = log_sum(ngramPosterior,m_ngramScores[ngramSize-1]);
     }
-    size_t ngramSize = ngrams->first.GetSize();
-    m_ngramScores[ngramSize-1] = log_sum(log((float)ngrams->second) + ngramPosterior,m_ngramScores[ngramSize-1]);
   }
 
   //convert from log to probability and create weighted sum
@@ -127,9 +193,51 @@ void LatticeMBRSolution::CalcScore(map<Phrase, float>& finalNgramScores, const v
   m_score += m_mapScore*mapWeight;
 }
 
+void Lattice::Build(const vector<const Hypothesis*>& nodes, const vector<RawEdge>& edges)
+{
+  m_nodes = nodes;
+  sort(m_nodes.begin(), m_nodes.end(), ascendingCoverageCmp); //sort by increasing source word cov
 
-void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const Hypothesis* > > & outgoingHyps, map<const Hypothesis*, vector<Edge> >& incomingEdges,
-                    const vector< float> & estimatedScores, const Hypothesis* bestHypo, size_t edgeDensity, float scale)
+  boost::unordered_map<const Hypothesis*, size_t> nodeIds;
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    nodeIds[m_nodes[i]] = i;
+  }
+
+  //count the edges into every node, then place them
+  m_firstEdge.assign(m_nodes.size() + 1, 0);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    ++m_firstEdge[nodeIds[edges[i].head] + 1];
+  }
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    m_firstEdge[i+1] += m_firstEdge[i];
+  }
+  vector<size_t> next(m_firstEdge.begin(), m_firstEdge.end() - 1);
+  vector<size_t> position(edges.size());
+  for (size_t i = 0; i < edges.size(); ++i) {
+    position[next[nodeIds[edges[i].head]]++] = i;
+  }
+  m_edges.clear();
+  m_edges.reserve(edges.size());
+  for (size_t i = 0; i < position.size(); ++i) {
+    const RawEdge& edge = edges[position[i]];
+    m_edges.push_back(Edge(nodeIds[edge.tail], nodeIds[edge.head], edge.score, *edge.words));
+  }
+}
+
+
+namespace
+{
+
+struct ScoreLess {
+  bool operator()(const pair<float, const Hypothesis*>& a, const pair<float, const Hypothesis*>& b) const {
+    return a.first < b.first;
+  }
+};
+
+}
+
+void pruneLatticeFB(vector<const Hypothesis*> & connectedHyp, map < const Hypothesis*, set <const Hypothesis* > > & outgoingHyps,
+                    const vector< float> & estimatedScores, const Hypothesis* bestHypo, size_t edgeDensity, float scale, Lattice& lattice)
 {
 
   //Need hyp 0 in connectedHyp - Find empty hypothesis
@@ -146,27 +254,30 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       outgoingHyps[emptyHyp].insert(connectedHyp[i]);
   }
 
-  //sort hyps based on estimated scores - do so by copying to multimap
-  multimap<float, const Hypothesis*> sortHypsByVal;
+  //sort hyps based on estimated scores, best first. Of equal scores, the later one goes first
+  vector<pair<float, const Hypothesis*> > sortHypsByVal;
+  sortHypsByVal.reserve(estimatedScores.size() + 1);
   for (size_t i =0; i < estimatedScores.size(); ++i) {
-    sortHypsByVal.insert(make_pair(estimatedScores[i], connectedHyp[i]));
+    sortHypsByVal.push_back(make_pair(estimatedScores[i], connectedHyp[i]));
   }
-
-  multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end();
-  float bestScore = it->first;
+  float bestScore = max_element(sortHypsByVal.begin(), sortHypsByVal.end(), ScoreLess())->first;
   //store best score as score of hyp 0
-  sortHypsByVal.insert(make_pair(bestScore, emptyHyp));
+  sortHypsByVal.push_back(make_pair(bestScore, emptyHyp));
+  stable_sort(sortHypsByVal.begin(), sortHypsByVal.end(), ScoreLess());
+  reverse(sortHypsByVal.begin(), sortHypsByVal.end());
 
 
   IFVERBOSE(3) {
-    for (multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end(); it != --sortHypsByVal.begin(); --it) {
-      const Hypothesis* currHyp =  it->second;
-      cerr << "Hyp " << currHyp->GetId() << ", estimated score: " << it->first << endl;
+    for (size_t i = 0; i < sortHypsByVal.size(); ++i) {
+      const Hypothesis* currHyp =  sortHypsByVal[i].second;
+      cerr << "Hyp " << currHyp->GetId() << ", estimated score: " << sortHypsByVal[i].first << endl;
     }
   }
 
 
-  set <const Hypothesis*> survivingHyps; //store hyps that make the cut in this
+  boost::unordered_map<const Hypothesis*, bool> survivingHyps; //store hyps that make the cut in this
+  vector<const Hypothesis*> survivingList;
+  vector<Lattice::RawEdge> edges;
 
   VERBOSE(2, "BEST HYPO TARGET LENGTH : " << bestHypo->GetSize() << endl)
   size_t numEdgesTotal = edgeDensity * bestHypo->GetSize(); //as per Shankar, aim for (density * target length of MAP solution) arcs
@@ -175,24 +286,24 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
 
   float prevScore = -999999;
 
-  //now iterate over multimap
-  for (multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end(); it != --sortHypsByVal.begin(); --it) {
-    float currEstimatedScore = it->first;
-    const Hypothesis* currHyp =  it->second;
+  //now iterate over sorted hyps
+  for (size_t i = 0; i < sortHypsByVal.size(); ++i) {
+    float currEstimatedScore = sortHypsByVal[i].first;
+    const Hypothesis* currHyp =  sortHypsByVal[i].second;
 
     if (numEdgesCreated >= numEdgesTotal && prevScore > currEstimatedScore) //if this hyp has equal estimated score to previous, include its edges too
       break;
 
     prevScore = currEstimatedScore;
     VERBOSE(3, "Num edges created : "<< numEdgesCreated << ", numEdges wanted " << numEdgesTotal << endl)
-    VERBOSE(3, "Considering hyp " << currHyp->GetId() << ", estimated score: " << it->first << endl)
+    VERBOSE(3, "Considering hyp " << currHyp->GetId() << ", estimated score: " << currEstimatedScore << endl)
 
-    survivingHyps.insert(currHyp); //CurrHyp made the cut
+    if (survivingHyps.insert(make_pair(currHyp, true)).second) //CurrHyp made the cut
+      survivingList.push_back(currHyp);
 
     // is its best predecessor already included ?
-    if (survivingHyps.find(currHyp->GetPrevHypo()) != survivingHyps.end()) { //yes, then add an edge
-      vector <Edge>& edges = incomingEdges[currHyp];
-      Edge winningEdge(currHyp->GetPrevHypo(),currHyp,scale*(currHyp->GetScore() - currHyp->GetPrevHypo()->GetScore()),currHyp->GetCurrTargetPhrase());
+    if (survivingHyps.count(currHyp->GetPrevHypo())) { //yes, then add an edge
+      Lattice::RawEdge winningEdge = {currHyp->GetPrevHypo(),currHyp,scale*(currHyp->GetScore() - currHyp->GetPrevHypo()->GetScore()),&currHyp->GetCurrTargetPhrase()};
       edges.push_back(winningEdge);
       ++numEdgesCreated;
     }
@@ -204,10 +315,9 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       for (iterArcList = arcList->begin() ; iterArcList != arcList->end() ; ++iterArcList) {
         const Hypothesis *loserHypo = *iterArcList;
         const Hypothesis* loserPrevHypo = loserHypo->GetPrevHypo();
-        if (survivingHyps.find(loserPrevHypo) != survivingHyps.end()) { //found it, add edge
+        if (survivingHyps.count(loserPrevHypo)) { //found it, add edge
           double arcScore = loserHypo->GetScore() - loserPrevHypo->GetScore();
-          Edge losingEdge(loserPrevHypo, currHyp, arcScore*scale, loserHypo->GetCurrTargetPhrase());
-          vector <Edge>& edges = incomingEdges[currHyp];
+          Lattice::RawEdge losingEdge = {loserPrevHypo, currHyp, static_cast<float>(arcScore*scale), &loserHypo->GetCurrTargetPhrase()};
           edges.push_back(losingEdge);
           ++numEdgesCreated;
         }
@@ -222,15 +332,13 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       for (set<const Hypothesis*>::const_iterator outHypIts = outHyps.begin(); outHypIts != outHyps.end(); ++outHypIts) {
         const Hypothesis* succHyp = *outHypIts;
 
-        if (survivingHyps.find(succHyp) == survivingHyps.end()) //Have we encountered the successor yet?
+        if (!survivingHyps.count(succHyp)) //Have we encountered the successor yet?
           continue; //No, move on to next
 
         //Curr Hyp can be : a) the best predecessor  of succ b) or an arc attached to succ
         if (succHyp->GetPrevHypo() == currHyp) { //best predecessor
-          vector <Edge>& succEdges = incomingEdges[succHyp];
-          Edge succWinningEdge(currHyp, succHyp, scale*(succHyp->GetScore() - currHyp->GetScore()), succHyp->GetCurrTargetPhrase());
-          succEdges.push_back(succWinningEdge);
-          survivingHyps.insert(succHyp);
+          Lattice::RawEdge succWinningEdge = {currHyp, succHyp, scale*(succHyp->GetScore() - currHyp->GetScore()), &succHyp->GetCurrTargetPhrase()};
+          edges.push_back(succWinningEdge);
           ++numEdgesCreated;
         }
 
@@ -243,10 +351,9 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
             const Hypothesis *loserHypo = *iterArcList;
             const Hypothesis* loserPrevHypo = loserHypo->GetPrevHypo();
             if (loserPrevHypo == currHyp) { //found it
-              vector <Edge>& succEdges = incomingEdges[succHyp];
               double arcScore = loserHypo->GetScore() - currHyp->GetScore();
-              Edge losingEdge(currHyp, succHyp,scale* arcScore, loserHypo->GetCurrTargetPhrase());
-              succEdges.push_back(losingEdge);
+              Lattice::RawEdge losingEdge = {currHyp, succHyp, static_cast<float>(scale* arcScore), &loserHypo->GetCurrTargetPhrase()};
+              edges.push_back(losingEdge);
               ++numEdgesCreated;
             }
           }
@@ -255,17 +362,14 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
     }
   }
 
-  connectedHyp.clear();
-  for (set <const Hypothesis*>::iterator it =  survivingHyps.begin(); it != survivingHyps.end(); ++it) {
-    connectedHyp.push_back(*it);
-  }
+  lattice.Build(survivingList, edges);
 
   VERBOSE(2, "Done! Num edges created : "<< numEdgesCreated << ", numEdges wanted " << numEdgesTotal << endl)
 
   IFVERBOSE(3) {
     cerr << "Surviving hyps: " ;
-    for (set <const Hypothesis*>::iterator it =  survivingHyps.begin(); it != survivingHyps.end(); ++it) {
-      cerr << (*it)->GetId() << " ";
+    for (size_t i = 0; i < lattice.GetSize(); ++i) {
+      cerr << lattice.GetNode(i)->GetId() << " ";
     }
     cerr << endl;
   }
@@ -273,222 +377,233 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
 
 }
 
-void calcNgramExpectations(Lattice & connectedHyp, map<const Hypothesis*, vector<Edge> >& incomingEdges,
-                           map<Phrase, float>& finalNgramScores, bool posteriors)
+namespace
 {
 
-  sort(connectedHyp.begin(),connectedHyp.end(),ascendingCoverageCmp); //sort by increasing source word cov
+/** An n-gram that ends on an edge. path is the number of the sequence of
+ *  edges the n-gram spans */
+struct EdgeNgram {
+  size_t ngram;
+  size_t path;
+  size_t count;
 
-  /*cerr << "Lattice:" << endl;
-  for (Lattice::const_iterator i = connectedHyp.begin(); i != connectedHyp.end(); ++i) {
-      const Hypothesis* h = *i;
-      cerr << *h << endl;
-      const vector<Edge>& edges = incomingEdges[h];
-      for (size_t e = 0; e < edges.size(); ++e) {
-          cerr << edges[e];
-      }
-  }*/
+  bool operator<(const EdgeNgram& other) const {
+    return ngram < other.ngram || (ngram == other.ngram && path < other.path);
+  }
+};
+
+/** Numbers the sequences of edges that n-grams span. A path is a shorter
+ *  path followed by an edge, and its score is the forward score of the node
+ *  it starts from plus the scores of its edges */
+class PathIndex
+{
+public:
+  static const size_t EMPTY = 0;
+
+  PathIndex() : m_scores(1, 0.0f) {}
+
+  size_t Extend(size_t prefix, size_t edge, float score) {
+    std::pair<boost::unordered_map<std::pair<size_t, size_t>, size_t>::iterator, bool> inserted =
+      m_index.insert(make_pair(make_pair(prefix, edge), m_scores.size()));
+    if (inserted.second) {
+      m_scores.push_back(m_scores[prefix] + score);
+    }
+    return inserted.first->second;
+  }
+
+  float GetScore(size_t path) const {
+    return m_scores[path];
+  }
+
+private:
+  std::vector<float> m_scores;
+  boost::unordered_map<std::pair<size_t, size_t>, size_t> m_index;
+};
+
+//do the last words of ngram match the last words of phrase?
+bool EndsLike(const NgramIndex& index, size_t ngram, const Phrase& phrase)
+{
+  size_t back = min(index.GetOrder(ngram), phrase.GetSize());
+  for (size_t i = 0; i < back; ++i, ngram = index.GetPrefix(ngram)) {
+    if (index.GetLastWord(ngram) != phrase.GetWord(phrase.GetSize() - 1 - i))
+      return false;
+  }
+  return true;
+}
+
+}
+
+void calcNgramExpectations(const Lattice& lattice, NgramPosteriors& finalNgramScores, bool posteriors)
+{
+  NgramIndex& index = finalNgramScores.GetIndex();
+  PathIndex paths;
+
+  vector<float> forwardScore(lattice.GetSize());
+  forwardScore[0] = 0.0f; //forward score of hyp 0 is 1 (or 0 in logprob space)
+  vector<size_t> finalHyps; //store completed hyps
+
+  //the n-grams ending on each edge, in edge order
+  vector<EdgeNgram> edgeNgrams;
+  vector<size_t> firstEdgeNgram(lattice.GetNumEdges() + 1, 0);
 
-  map<const Hypothesis*, float> forwardScore;
-  forwardScore[connectedHyp[0]] = 0.0f; //forward score of hyp 0 is 1 (or 0 in logprob space)
-  set< const Hypothesis *> finalHyps; //store completed hyps
+  //ngram scores for each hyp, in node order
+  vector<pair<size_t, float> > nodeNgramScores;
+  vector<size_t> firstNodeNgramScore(lattice.GetSize() + 1, 0);
 
-  NgramScores ngramScores;//ngram scores for each hyp
+  //scratch space, indexed by n-gram, for the node being processed
+  vector<float> currScores;
+  vector<size_t> currScoreNode; //node+1 if currScores holds a score for the node
+  vector<size_t> introducedBy; //edge+1 if the edge introduces the n-gram
+  vector<size_t> currNgrams;
 
-  for (size_t i = 1; i < connectedHyp.size(); ++i) {
-    const Hypothesis* currHyp = connectedHyp[i];
+  for (size_t node = 1; node < lattice.GetSize(); ++node) {
+    const Hypothesis* currHyp = lattice.GetNode(node);
     if (currHyp->GetWordsBitmap().IsComplete()) {
-      finalHyps.insert(currHyp);
+      finalHyps.push_back(node);
     }
 
     VERBOSE(3, "Processing hyp: " << currHyp->GetId() << ", num words cov= " << currHyp->GetWordsBitmap().GetNumWordsCovered() <<  endl)
 
-    vector <Edge> & edges = incomingEdges[currHyp];
-    for (size_t e = 0; e < edges.size(); ++e) {
-      const Edge& edge = edges[e];
-      if (forwardScore.find(currHyp) == forwardScore.end()) {
-        forwardScore[currHyp] = forwardScore[edge.GetTailNode()] + edge.GetScore();
-        VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] = fwdScore["<<edge.GetTailNode()->GetId() << "] + edge Score: " << edge.GetScore() << endl)
+    const size_t edgesBegin = lattice.GetFirstEdge(node), edgesEnd = lattice.GetFirstEdge(node + 1);
+    for (size_t e = edgesBegin; e < edgesEnd; ++e) {
+      const Edge& edge = lattice.GetEdge(e);
+      if (e == edgesBegin) {
+        forwardScore[node] = forwardScore[edge.GetTailNode()] + edge.GetScore();
       } else {
-        forwardScore[currHyp] = log_sum(forwardScore[currHyp], forwardScore[edge.GetTailNode()] + edge.GetScore());
-        VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] += fwdScore["<<edge.GetTailNode()->GetId() << "] + edge Score: " << edge.GetScore() << endl)
+        forwardScore[node] = log_sum(forwardScore[node], forwardScore[edge.GetTailNode()] + edge.GetScore());
       }
+      VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] += fwdScore["<<lattice.GetNode(edge.GetTailNode())->GetId() << "] + edge Score: " << edge.GetScore() << endl)
+    }
+
+    //Find the ngrams ending on the incoming edges
+    for (size_t e = edgesBegin; e < edgesEnd; ++e) {
+      const Edge& edge = lattice.GetEdge(e);
+      const Phrase& words = edge.GetWords();
+      const size_t begin = edgeNgrams.size();
+
+      //the n-grams local to this edge
+      const size_t localPath = paths.Extend(PathIndex::EMPTY, e, forwardScore[edge.GetTailNode()] + edge.GetScore());
+      for (size_t start = 0; start < words.GetSize(); ++start) {
+        size_t ngram = NgramIndex::EMPTY;
+        for (size_t end = start; end < start + bleu_order && end < words.GetSize(); ++end) {
+          ngram = index.Extend(ngram, words.GetWord(end));
+          EdgeNgram local = {ngram, localPath, 1};
+          edgeNgrams.push_back(local);
+        }
+      }
+
+      //the n-grams straddling the previous edges and this one
+      const size_t tail = edge.GetTailNode();
+      for (size_t prev = lattice.GetFirstEdge(tail); prev < lattice.GetFirstEdge(tail + 1); ++prev) {
+        const Phrase& prevWords = lattice.GetEdge(prev).GetWords();
+        for (size_t i = firstEdgeNgram[prev]; i < firstEdgeNgram[prev + 1]; ++i) {
+          const EdgeNgram prevNgram = edgeNgrams[i];
+          if (!EndsLike(index, prevNgram.ngram, prevWords)) //we need the suffix of previous edge
+            continue;
+          const size_t path = paths.Extend(prevNgram.path, e, edge.GetScore());
+          size_t ngram = prevNgram.ngram;
+          for (size_t j = 0; j < words.GetSize() && j + index.GetOrder(prevNgram.ngram) < bleu_order; ++j) {
+            ngram = index.Extend(ngram, words.GetWord(j));
+            EdgeNgram straddling = {ngram, path, prevNgram.count};
+            edgeNgrams.push_back(straddling);
+          }
+        }
+      }
+
+      //merge repeats of an n-gram on one path
+      sort(edgeNgrams.begin() + begin, edgeNgrams.end());
+      size_t last = begin;
+      for (size_t i = begin + 1; i < edgeNgrams.size(); ++i) {
+        if (edgeNgrams[i].ngram == edgeNgrams[last].ngram && edgeNgrams[i].path == edgeNgrams[last].path) {
+          edgeNgrams[last].count += edgeNgrams[i].count;
+        } else {
+          edgeNgrams[++last] = edgeNgrams[i];
+        }
+      }
+      if (begin < edgeNgrams.size()) {
+        edgeNgrams.resize(last + 1);
+      }
+      firstEdgeNgram[e + 1] = edgeNgrams.size();
     }
 
     //Process ngrams now
-    for (size_t j =0 ; j < edges.size(); ++j) {
-      Edge& edge = edges[j];
-      const NgramHistory & incomingPhrases = edge.GetNgrams(incomingEdges);
+    if (currScores.size() < index.GetSize()) {
+      currScores.resize(index.GetSize());
+      currScoreNode.resize(index.GetSize(), 0);
+      introducedBy.resize(index.GetSize(), 0);
+    }
+    currNgrams.clear();
+    for (size_t e = edgesBegin; e < edgesEnd; ++e) {
+      const Edge& edge = lattice.GetEdge(e);
 
       //let's first score ngrams introduced by this edge
-      for (NgramHistory::const_iterator it = incomingPhrases.begin(); it != incomingPhrases.end(); ++it) {
-        const Phrase& ngram = it->first;
-        const PathCounts& pathCounts = it->second;
-        VERBOSE(4, "Calculating score for: " << it->first << endl)
-
-        for (PathCounts::const_iterator pathCountIt = pathCounts.begin(); pathCountIt != pathCounts.end(); ++pathCountIt) {
-          //Score of an n-gram is forward score of head node of leftmost edge + all edge scores
-          const Path&  path = pathCountIt->first;
-          //cerr << "path count for " << ngram << " is " << pathCountIt->second << endl;
-          float score = forwardScore[path[0]->GetTailNode()];
-          for (size_t i = 0; i < path.size(); ++i) {
-            score += path[i]->GetScore();
-          }
-          //if we're doing expectations, then the number of times the ngram
-          //appears on the path is relevant.
-          size_t count = posteriors ? 1 : pathCountIt->second;
-          for (size_t k = 0; k < count; ++k) {
-            ngramScores.addScore(currHyp,ngram,score);
-          }
+      for (size_t i = firstEdgeNgram[e]; i < firstEdgeNgram[e + 1]; ++i) {
+        const EdgeNgram& edgeNgram = edgeNgrams[i];
+        //Score of an n-gram is forward score of head node of leftmost edge + all edge scores
+        //if we're doing expectations, then the number of times the ngram
+        //appears on the path is relevant.
+        float score = paths.GetScore(edgeNgram.path);
+        if (!posteriors && edgeNgram.count > 1) {
+          score += log((float)edgeNgram.count);
+        }
+        introducedBy[edgeNgram.ngram] = e + 1;
+        if (currScoreNode[edgeNgram.ngram] == node + 1) {
+          currScores[edgeNgram.ngram] = log_sum(score, currScores[edgeNgram.ngram]);
+        } else {
+          currScoreNode[edgeNgram.ngram] = node + 1;
+          currScores[edgeNgram.ngram] = score;
+          currNgrams.push_back(edgeNgram.ngram);
         }
       }
 
       //Now score ngrams that are just being propagated from the history
-      for (NgramScores::NodeScoreIterator it = ngramScores.nodeBegin(edge.GetTailNode());
-           it != ngramScores.nodeEnd(edge.GetTailNode()); ++it) {
-        const Phrase & currNgram = *(it->first);
-        float currNgramScore = it->second;
-        VERBOSE(4, "Calculating score for: " << currNgram << endl)
-
+      const size_t tail = edge.GetTailNode();
+      for (size_t i = firstNodeNgramScore[tail]; i < firstNodeNgramScore[tail + 1]; ++i) {
+        const size_t ngram = nodeNgramScores[i].first;
         // For posteriors, don't double count ngrams
-        if (!posteriors || incomingPhrases.find(currNgram) == incomingPhrases.end()) {
-          float score = edge.GetScore() + currNgramScore;
-          ngramScores.addScore(currHyp,currNgram,score);
+        if (posteriors && introducedBy[ngram] == e + 1)
+          continue;
+        float score = edge.GetScore() + nodeNgramScores[i].second;
+        if (currScoreNode[ngram] == node + 1) {
+          currScores[ngram] = log_sum(score, currScores[ngram]);
+        } else {
+          currScoreNode[ngram] = node + 1;
+          currScores[ngram] = score;
+          currNgrams.push_back(ngram);
         }
       }
+    }
 
+    for (size_t i = 0; i < currNgrams.size(); ++i) {
+      nodeNgramScores.push_back(make_pair(currNgrams[i], currScores[currNgrams[i]]));
     }
+    firstNodeNgramScore[node + 1] = nodeNgramScores.size();
   }
 
   float Z = 9999999; //the total score of the lattice
 
   //Done - Print out ngram posteriors for final hyps
-  for (set< const Hypothesis *>::iterator finalHyp = finalHyps.begin(); finalHyp != finalHyps.end(); ++finalHyp) {
-    const Hypothesis* hyp = *finalHyp;
-
-    for (NgramScores::NodeScoreIterator it = ngramScores.nodeBegin(hyp); it != ngramScores.nodeEnd(hyp); ++it) {
-      const Phrase& ngram = *(it->first);
-      if (finalNgramScores.find(ngram) == finalNgramScores.end()) {
-        finalNgramScores[ngram] = it->second;
-      } else {
-        finalNgramScores[ngram] = log_sum(it->second,  finalNgramScores[ngram]);
-      }
+  for (size_t f = 0; f < finalHyps.size(); ++f) {
+    const size_t node = finalHyps[f];
+    for (size_t i = firstNodeNgramScore[node]; i < firstNodeNgramScore[node + 1]; ++i) {
+      finalNgramScores.AddScore(nodeNgramScores[i].first, nodeNgramScores[i].second);
     }
 
     if (Z == 9999999) {
-      Z = forwardScore[hyp];
+      Z = forwardScore[node];
     } else {
-      Z = log_sum(Z, forwardScore[hyp]);
+      Z = log_sum(Z, forwardScore[node]);
     }
   }
 
   //Z *= scale;  //scale the score
 
-  for (map<Phrase, float>::iterator finalScoresIt = finalNgramScores.begin();  finalScoresIt != finalNgramScores.end(); ++finalScoresIt) {
-    finalScoresIt->second =  finalScoresIt->second - Z;
-    IFVERBOSE(2) {
-      VERBOSE(2,finalScoresIt->first << " [" << finalScoresIt->second << "]" << endl);
-    }
-  }
-
-}
-
-const NgramHistory& Edge::GetNgrams(map<const Hypothesis*, vector<Edge> > & incomingEdges)
-{
-
-  if (m_ngrams.size() > 0)
-    return m_ngrams;
-
-  const Phrase& currPhrase = GetWords();
-  //Extract the n-grams local to this edge
-  for (size_t start = 0; start < currPhrase.GetSize(); ++start) {
-    for (size_t end = start; end < start + bleu_order; ++end) {
-      if (end < currPhrase.GetSize()) {
-        Phrase edgeNgram(end-start+1);
-        for (size_t index = start; index <= end; ++index) {
-          edgeNgram.AddWord(currPhrase.GetWord(index));
-        }
-        //cout << "Inserting Phrase : " << edgeNgram << endl;
-        vector<const Edge*> edgeHistory;
-        edgeHistory.push_back(this);
-        storeNgramHistory(edgeNgram, edgeHistory);
-      } else {
-        break;
-      }
-    }
-  }
-
-  map<const Hypothesis*, vector<Edge> >::iterator it = incomingEdges.find(m_tailNode);
-  if (it != incomingEdges.end()) { //node has incoming edges
-    vector<Edge> & inEdges = it->second;
-
-    for (vector<Edge>::iterator edge = inEdges.begin(); edge != inEdges.end(); ++edge) {//add the ngrams straddling prev and curr edge
-      const NgramHistory & edgeIncomingNgrams = edge->GetNgrams(incomingEdges);
-      for (NgramHistory::const_iterator edgeInNgramHist = edgeIncomingNgrams.begin(); edgeInNgramHist != edgeIncomingNgrams.end(); ++edgeInNgramHist) {
-        const Phrase& edgeIncomingNgram = edgeInNgramHist->first;
-        const PathCounts &  edgeIncomingNgramPaths = edgeInNgramHist->second;
-        size_t back = min(edgeIncomingNgram.GetSize(), edge->GetWordsSize());
-        const Phrase&  edgeWords = edge->GetWords();
-        IFVERBOSE(3) {
-          cerr << "Edge: "<< *edge <<endl;
-          cerr << "edgeWords: " << edgeWords << endl;
-          cerr << "edgeInNgram: " << edgeIncomingNgram << endl;
-        }
-
-        Phrase edgeSuffix(ARRAY_SIZE_INCR);
-        Phrase ngramSuffix(ARRAY_SIZE_INCR);
-        GetPhraseSuffix(edgeWords,back,edgeSuffix);
-        GetPhraseSuffix(edgeIncomingNgram,back,ngramSuffix);
-
-        if (ngramSuffix == edgeSuffix) { //we've got the suffix of previous edge
-          size_t  edgeInNgramSize =  edgeIncomingNgram.GetSize();
-
-          for (size_t i = 0; i < GetWordsSize() && i + edgeInNgramSize < bleu_order ; ++i) {
-            Phrase newNgram(edgeIncomingNgram);
-            for (size_t j = 0; j <= i ; ++j) {
-              newNgram.AddWord(GetWords().GetWord(j));
-            }
-            VERBOSE(3, "Inserting New Phrase : " << newNgram << endl)
-
-            for (PathCounts::const_iterator pathIt = edgeIncomingNgramPaths.begin(); pathIt !=  edgeIncomingNgramPaths.end(); ++pathIt) {
-              Path newNgramPath = pathIt->first;
-              newNgramPath.push_back(this);
-              storeNgramHistory(newNgram, newNgramPath, pathIt->second);
-            }
-          }
-        }
-      }
-    }
-  }
-  return m_ngrams;
-}
-
-//Add the last lastN words of origPhrase to targetPhrase
-void Edge::GetPhraseSuffix(const Phrase&  origPhrase, size_t lastN, Phrase& targetPhrase) const
-{
-  size_t origSize = origPhrase.GetSize();
-  size_t startIndex = origSize - lastN;
-  for (size_t index = startIndex; index < origPhrase.GetSize(); ++index) {
-    targetPhrase.AddWord(origPhrase.GetWord(index));
-  }
-}
-
-bool Edge::operator< (const Edge& compare ) const
-{
-  if (m_headNode->GetId() < compare.m_headNode->GetId())
-    return true;
-  if (compare.m_headNode->GetId() < m_headNode->GetId())
-    return false;
-  if (m_tailNode->GetId() < compare.m_tailNode->GetId())
-    return true;
-  if (compare.m_tailNode->GetId() < m_tailNode->GetId())
-    return false;
-  return GetScore() <  compare.GetScore();
+  finalNgramScores.Normalise(Z);
 }
 
 ostream& operator<< (ostream& out, const Edge& edge)
 {
-  out << "Head: " << edge.m_headNode->GetId() << ", Tail: " << edge.m_tailNode->GetId() << ", Score: " << edge.m_score << ", Phrase: " << edge.m_targetPhrase << endl;
+  out << "Head: " << edge.m_headNode << ", Tail: " << edge.m_tailNode << ", Score: " << edge.m_score << ", Phrase: " << *edge.m_words << endl;
   return out;
 }
 
@@ -503,13 +618,13 @@ void getLatticeMBRNBest(Manager& manager, TrellisPathList& nBestList,
   const StaticData& staticData = StaticData::Instance();
   std::map < int, bool > connected;
   std::vector< const Hypothesis *> connectedList;
-  map<Phrase, float> ngramPosteriors;
+  NgramPosteriors ngramPosteriors;
   std::map < const Hypothesis*, set <const Hypothesis*> > outgoingHyps;
-  map<const Hypothesis*, vector<Edge> > incomingEdges;
+  Lattice lattice;
   vector< float> estimatedScores;
   manager.GetForwardBackwardSearchGraph(&connected, &connectedList, &outgoingHyps, &estimatedScores);
-  pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores, manager.GetBestHypothesis(), staticData.GetLatticeMBRPruningFactor(),staticData.GetMBRScale());
-  calcNgramExpectations(connectedList, incomingEdges, ngramPosteriors,true);
+  pruneLatticeFB(connectedList, outgoingHyps, estimatedScores, manager.GetBestHypothesis(), staticData.GetLatticeMBRPruningFactor(),staticData.GetMBRScale(), lattice);
+  calcNgramExpectations(lattice, ngramPosteriors,true);
 
   vector<float> mbrThetas = staticData.GetLatticeMBRThetas();
   float p = staticData.GetLatticeMBRPrecision();
@@ -561,24 +676,23 @@ const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestLi
   const StaticData& staticData = StaticData::Instance();
   std::map < int, bool > connected;
   std::vector< const Hypothesis *> connectedList;
-  map<Phrase, float> ngramExpectations;
+  NgramPosteriors ngramExpectations;
   std::map < const Hypothesis*, set <const Hypothesis*> > outgoingHyps;
-  map<const Hypothesis*, vector<Edge> > incomingEdges;
+  Lattice lattice;
   vector< float> estimatedScores;
   manager.GetForwardBackwardSearchGraph(&connected, &connectedList, &outgoingHyps, &estimatedScores);
-  pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores, manager.GetBestHypothesis(), staticData.GetLatticeMBRPruningFactor(),staticData.GetMBRScale());
-  calcNgramExpectations(connectedList, incomingEdges, ngramExpectations,false);
+  pruneLatticeFB(connectedList, outgoingHyps, estimatedScores, manager.GetBestHypothesis(), staticData.GetLatticeMBRPruningFactor(),staticData.GetMBRScale(), lattice);
+  calcNgramExpectations(lattice, ngramExpectations,false);
 
   //expected length is sum of expected unigram counts
   //cerr << "Thread " << pthread_self() <<  " Ngram expectations size: " << ngramExpectations.size() << endl;
+  const NgramIndex& ngramIndex = ngramExpectations.GetIndex();
   float ref_length = 0.0f;
-  for (map<Phrase,float>::const_iterator ref_iter = ngramExpectations.begin();
-       ref_iter != ngramExpectations.end(); ++ref_iter) {
-    //cerr << "Ngram: " << ref_iter->first << " score: " <<
-    //    ref_iter->second << endl;
-    if (ref_iter->first.GetSize() == 1) {
-      ref_length += exp(ref_iter->second);
-      //    cerr << "Expected for " << ref_iter->first << " is " << exp(ref_iter->second) << endl;
+  for (size_t ngram = 0; ngram < ngramIndex.GetSize(); ++ngram) {
+    float expectation;
+    if (ngramIndex.GetOrder(ngram) == 1 && ngramExpectations.GetScore(ngram, expectation)) {
+      ref_length += exp(expectation);
+      //    cerr << "Expected for " << ngramIndex.GetPhrase(ngram) << " is " << exp(expectation) << endl;
     }
   }
 
@@ -592,14 +706,15 @@ const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestLi
   for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter) {
     const TrellisPath &path = **iter;
     vector<Word> words;
-    map<Phrase,int> ngrams;
+    vector<size_t> ngrams;
     GetOutputWords(path,words);
     /*for (size_t i = 0; i < words.size(); ++i) {
         cerr << words[i].GetFactor(0)->GetString() << " ";
     }
     cerr << endl;
     */
-    extract_ngrams(words,ngrams);
+    extract_ngrams(words,ngramExpectations,ngrams);
+    sort(ngrams.begin(), ngrams.end());
 
     vector<float> comps(2*BLEU_ORDER+1);
     float logbleu = 0.0;
@@ -610,13 +725,16 @@ const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestLi
       comps[2*i+1] = max(hyp_length-i,0);
     }
 
-    for (map<Phrase,int>::const_iterator hyp_iter = ngrams.begin();
-         hyp_iter != ngrams.end(); ++hyp_iter) {
-      map<Phrase,float>::const_iterator ref_iter = ngramExpectations.find(hyp_iter->first);
-      if (ref_iter != ngramExpectations.end()) {
-        comps[2*(hyp_iter->first.GetSize()-1)] += min(exp(ref_iter->second), (float)(hyp_iter->second));
+    for (size_t i = 0; i < ngrams.size(); ) {
+      size_t j = i + 1;
+      while (j < ngrams.size() && ngrams[j] == ngrams[i]) {
+        ++j;
       }
-
+      //an n-gram on no complete path has expectation 0
+      float expectation;
+      if (ngramExpectations.GetScore(ngrams[i], expectation))
+        comps[2*(ngramIndex.GetOrder(ngrams[i])-1)] += min(exp(expectation), (float)(j - i));
+      i = j;
     }
     comps[comps.size()-1] = ref_length;
     /*for (size_t i = 0; i < comps.size(); ++i) {
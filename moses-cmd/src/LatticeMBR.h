@@ -13,37 +13,29 @@
 #include <map>
 #include <vector>
 #include <set>
+#include <boost/unordered_map.hpp>
 #include "Hypothesis.h"
 #include "Manager.h"
 #include "TrellisPathList.h"
 
 
-
-class Edge;
-
-typedef std::vector< const Moses::Hypothesis *> Lattice;
-typedef std::vector<const Edge*> Path;
-typedef std::map<Path, size_t> PathCounts;
-typedef std::map<Moses::Phrase, PathCounts > NgramHistory;
-
+/** An edge of the lattice, between the numbers of two nodes */
 class Edge
 {
-  const Moses::Hypothesis* m_tailNode;
-  const Moses::Hypothesis* m_headNode;
+  size_t m_tailNode;
+  size_t m_headNode;
   float m_score;
-  Moses::TargetPhrase m_targetPhrase;
-  NgramHistory m_ngrams;
+  const Moses::Phrase* m_words; //owned by the hypothesis that created the edge
 
 public:
-  Edge(const Moses::Hypothesis* from, const Moses::Hypothesis* to, float score, const Moses::TargetPhrase& targetPhrase) : m_tailNode(from), m_headNode(to), m_score(score), m_targetPhrase(targetPhrase) {
-    //cout << "Creating new edge from Node " << from->GetId() << ", to Node : " << to->GetId() << ", score: " << score << " phrase: " << targetPhrase << endl;
+  Edge(size_t from, size_t to, float score, const Moses::Phrase& words) : m_tailNode(from), m_headNode(to), m_score(score), m_words(&words) {
   }
 
-  const Moses::Hypothesis* GetHeadNode() const {
+  size_t GetHeadNode() const {
     return m_headNode;
   }
 
-  const Moses::Hypothesis* GetTailNode() const {
+  size_t GetTailNode() const {
     return m_tailNode;
   }
 
@@ -52,46 +44,142 @@ public:
   }
 
   size_t GetWordsSize() const {
-    return m_targetPhrase.GetSize();
+    return m_words->GetSize();
   }
 
   const Moses::Phrase& GetWords() const {
-    return m_targetPhrase;
+    return *m_words;
   }
 
   friend std::ostream& operator<< (std::ostream& out, const Edge& edge);
+};
+
+/**
+* The pruned search graph. Nodes are numbered in topological order, by the
+* number of source words their hypothesis covers, so node 0 is the empty
+* hypothesis. The edges into a node are stored next to each other, and the
+* edges of the nodes in node order (compressed sparse rows).
+*/
+class Lattice
+{
+public:
+  Lattice() {}
+
+  size_t GetSize() const {
+    return m_nodes.size();
+  }
+  const Moses::Hypothesis* GetNode(size_t node) const {
+    return m_nodes[node];
+  }
+
+  //! the edges into node are the ones from GetFirstEdge(node) to GetFirstEdge(node+1)
+  size_t GetFirstEdge(size_t node) const {
+    return m_firstEdge[node];
+  }
+  size_t GetNumEdges() const {
+    return m_edges.size();
+  }
+  const Edge& GetEdge(size_t edge) const {
+    return m_edges[edge];
+  }
 
-  const NgramHistory&  GetNgrams(  std::map<const Moses::Hypothesis*, std::vector<Edge> > & incomingEdges) ;
+  /** Build from the surviving hypotheses and the edges between them, as
+   *  (tail, head, score, words). The edges into one node keep their order */
+  struct RawEdge {
+    const Moses::Hypothesis* tail;
+    const Moses::Hypothesis* head;
+    float score;
+    const Moses::Phrase* words;
+  };
+  void Build(const std::vector<const Moses::Hypothesis*>& nodes, const std::vector<RawEdge>& edges);
 
-  bool operator < (const Edge & compare) const;
+private:
+  std::vector<const Moses::Hypothesis*> m_nodes;
+  std::vector<size_t> m_firstEdge; //one more than nodes
+  std::vector<Edge> m_edges;
+};
+
+/**
+* Numbers the n-grams of a lattice. An n-gram is its (n-1)-gram prefix
+* followed by a word, so every n-gram gets a small integer, and the n-grams of
+* a sentence are found by extending the number of the shorter one a word at a
+* time.
+*/
+class NgramIndex
+{
+public:
+  static const size_t EMPTY = 0; //! the n-gram without words, prefix of the unigrams
+
+  NgramIndex();
 
-  void GetPhraseSuffix(const Moses::Phrase& origPhrase, size_t lastN, Moses::Phrase& targetPhrase) const;
+  //! number of prefix followed by word, added if it is new
+  size_t Extend(size_t prefix, const Moses::Word& word);
+  //! number of prefix followed by word, or NOT_FOUND
+  size_t Find(size_t prefix, const Moses::Word& word) const;
 
-  void storeNgramHistory(const Moses::Phrase& phrase, Path & path, size_t count = 1) {
-    m_ngrams[phrase][path]+= count;
+  size_t GetSize() const {
+    return m_ngrams.size();
   }
+  size_t GetOrder(size_t ngram) const {
+    return m_ngrams[ngram].order;
+  }
+  size_t GetPrefix(size_t ngram) const {
+    return m_ngrams[ngram].prefix;
+  }
+  const Moses::Word& GetLastWord(size_t ngram) const {
+    return m_ngrams[ngram].word;
+  }
+  //! the words of ngram, for debugging output
+  Moses::Phrase GetPhrase(size_t ngram) const;
 
+private:
+  struct Ngram {
+    size_t prefix;
+    Moses::Word word;
+    size_t order;
+  };
+  typedef std::pair<size_t, Moses::Word> Key;
+  struct KeyHasher {
+    size_t operator()(const Key& key) const;
+  };
+  struct KeyEqual {
+    bool operator()(const Key& a, const Key& b) const;
+  };
+
+  std::vector<Ngram> m_ngrams;
+  boost::unordered_map<Key, size_t, KeyHasher, KeyEqual> m_index;
 };
 
 /**
-* Data structure to hold the ngram scores as we traverse the lattice. Maps (hypo,ngram) to score
+* Log posteriors, or log expected counts, of the n-grams of a lattice,
+* indexed by the numbers of an NgramIndex
 */
-class NgramScores
+class NgramPosteriors
 {
 public:
-  NgramScores() {}
+  NgramIndex& GetIndex() {
+    return m_index;
+  }
+  const NgramIndex& GetIndex() const {
+    return m_index;
+  }
 
   /** logsum this score to the existing score */
-  void addScore(const Moses::Hypothesis* node, const Moses::Phrase& ngram, float score);
-
-  /** Iterate through ngrams for selected node */
-  typedef std::map<const Moses::Phrase*, float>::const_iterator NodeScoreIterator;
-  NodeScoreIterator nodeBegin(const Moses::Hypothesis* node);
-  NodeScoreIterator nodeEnd(const Moses::Hypothesis* node);
+  void AddScore(size_t ngram, float score);
+  //! subtract the log total score of the lattice from all scores
+  void Normalise(float logZ);
+  //! false if ngram is on no complete path
+  bool GetScore(size_t ngram, float& score) const {
+    if (ngram >= m_scored.size() || !m_scored[ngram])
+      return false;
+    score = m_scores[ngram];
+    return true;
+  }
 
 private:
-  std::set<Moses::Phrase> m_ngrams;
-  std::map<const Moses::Hypothesis*, std::map<const Moses::Phrase*, float> > m_scores;
+  NgramIndex m_index;
+  std::vector<float> m_scores;
+  std::vector<bool> m_scored;
 };
 
 
@@ -115,7 +203,7 @@ public:
   }
 
   /** Initialise ngram scores */
-  void CalcScore(std::map<Moses::Phrase, float>& finalNgramScores, const std::vector<float>& thetas, float mapWeight);
+  void CalcScore(const NgramPosteriors& finalNgramScores, const std::vector<float>& thetas, float mapWeight);
 
 private:
   std::vector<Moses::Word> m_words;
@@ -130,16 +218,17 @@ struct LatticeMBRSolutionComparator {
   }
 };
 
-void pruneLatticeFB(Lattice & connectedHyp, std::map < const Moses::Hypothesis*, std::set <const Moses::Hypothesis* > > & outgoingHyps, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges,
-                    const std::vector< float> & estimatedScores, const Moses::Hypothesis*, size_t edgeDensity,float scale);
+//Keep the best edges of the search graph, as per Shankar, and number the surviving hypotheses
+void pruneLatticeFB(std::vector<const Moses::Hypothesis*> & connectedHyp, std::map < const Moses::Hypothesis*, std::set <const Moses::Hypothesis* > > & outgoingHyps,
+                    const std::vector< float> & estimatedScores, const Moses::Hypothesis*, size_t edgeDensity,float scale, Lattice& lattice);
 
 //Use the ngram scores to rerank the nbest list, return at most n solutions
 void getLatticeMBRNBest(Moses::Manager& manager, Moses::TrellisPathList& nBestList, std::vector<LatticeMBRSolution>& solutions, size_t n);
 //calculate expectated ngram counts, clipping at 1 (ie calculating posteriors) if posteriors==true.
-void calcNgramExpectations(Lattice & connectedHyp, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges, std::map<Moses::Phrase,
-                           float>& finalNgramScores, bool posteriors);
+void calcNgramExpectations(const Lattice& lattice, NgramPosteriors& finalNgramScores, bool posteriors);
 void GetOutputFactors(const Moses::TrellisPath &path, std::vector <Moses::Word> &translation);
-void extract_ngrams(const std::vector<Moses::Word >& sentence, std::map < Moses::Phrase, int >  & allngrams);
+//numbers of the n-grams of sentence that have a score, once per occurrence
+void extract_ngrams(const std::vector<Moses::Word >& sentence, const NgramPosteriors& ngramScores, std::vector<size_t>& ngrams);
 bool ascendingCoverageCmp(const Moses::Hypothesis* a, const Moses::Hypothesis* b);
 std::vector<Moses::Word> doLatticeMBR(Moses::Manager& manager, Moses::TrellisPathList& nBestList);
 const Moses::TrellisPath doConsensusDecoding(Moses::Manager& manager, Moses::TrellisPathList& nBestList);
@@ -37,6 +37,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "IOWrapper.h"
 #include "LatticeMBR.h"
 #include "Manager.h"
+#include "SentenceStats.h"
 #include "StaticData.h"
 #include "Util.h"
 #include "mbr.h"
@@ -53,6 +54,8 @@ using namespace Moses;
 
 // output floats with three significant digits
 static const size_t PRECISION = 3;
+//! sentences per thread that input may run ahead of the output
+static const size_t OUTPUT_WINDOW_PER_THREAD = 16;
 
 /** Enforce rounding */
 void fix(std::ostream& stream, size_t size)
@@ -76,13 +79,15 @@ public:
                   OutputCollector* latticeSamplesCollector,
                   OutputCollector* wordGraphCollector, OutputCollector* searchGraphCollector,
                   OutputCollector* detailedTranslationCollector,
-                  OutputCollector* alignmentInfoCollector ) :
+                  OutputCollector* alignmentInfoCollector,
+                  OutputCollector* sentenceStatsCollector, SentenceStats* sentenceStatsTotals ) :
     m_source(source), m_lineNumber(lineNumber),
     m_outputCollector(outputCollector), m_nbestCollector(nbestCollector),
     m_latticeSamplesCollector(latticeSamplesCollector),
     m_wordGraphCollector(wordGraphCollector), m_searchGraphCollector(searchGraphCollector),
     m_detailedTranslationCollector(detailedTranslationCollector),
-    m_alignmentInfoCollector(alignmentInfoCollector) {}
+    m_alignmentInfoCollector(alignmentInfoCollector),
+    m_sentenceStatsCollector(sentenceStatsCollector), m_sentenceStatsTotals(sentenceStatsTotals) {}
 
 	/** Translate one sentence
    * gets called by main function implemented at end of this source file */
@@ -267,6 +272,15 @@ public:
       PrintUserTime("Sentence Decoding Time:");
     }
     manager.CalcDecoderStatistics();
+
+    // timing and counts of the decoding steps
+    if (m_sentenceStatsCollector) {
+      const SentenceStats &stats = manager.GetSentenceStats();
+      ostringstream out;
+      stats.WriteJson(out, SPrint(m_lineNumber), system.GetStatefulFeatureFunctions());
+      m_sentenceStatsCollector->Write(m_lineNumber, out.str());
+      m_sentenceStatsTotals->Accumulate(stats);
+    }
   }
 
   ~TranslationTask() {
@@ -283,6 +297,8 @@ private:
   OutputCollector* m_searchGraphCollector;
   OutputCollector* m_detailedTranslationCollector;
   OutputCollector* m_alignmentInfoCollector;
+  OutputCollector* m_sentenceStatsCollector;
+  SentenceStats* m_sentenceStatsTotals;
   std::ofstream *m_alignmentStream;
 
 
@@ -463,9 +479,42 @@ int main(int argc, char** argv)
     if (!staticData.GetAlignmentOutputFile().empty()) {
       alignmentInfoCollector.reset(new OutputCollector(ioWrapper->GetAlignmentOutputStream()));
     }
+
+    // initialize stream for the timing and counts of each sentence, and their totals
+    auto_ptr<OutputCollector> sentenceStatsCollector;
+    auto_ptr<SentenceStats> sentenceStatsTotals;
+    if (!staticData.GetSentenceStatsFilePath().empty()) {
+      sentenceStatsCollector.reset(new OutputCollector(&(ioWrapper->GetSentenceStatsStream())));
+      sentenceStatsTotals.reset(new SentenceStats());
+    }
   
 #ifdef WITH_THREADS
     ThreadPool pool(staticData.ThreadCount());
+    // don't read far ahead of a sentence that takes long to translate:
+    // queued input and output waiting for it are bounded by the window.
+    // One collector that every sentence writes to is enough to bound them all,
+    // the alignments are left out as they aren't written for every sentence
+    const size_t window = OUTPUT_WINDOW_PER_THREAD * staticData.ThreadCount();
+    pool.SetQueueLimit(window);
+    OutputCollector* const everySentence[] = {
+      outputCollector.get(),
+      staticData.UseLatticeMBR() ? NULL : nbestCollector.get(), // else only with 1-best
+      latticeSamplesCollector.get(),
+      wordGraphCollector.get(),
+      searchGraphCollector.get(),
+      detailedTranslationCollector.get(),
+      sentenceStatsCollector.get()
+    };
+    OutputCollector* windowCollector = NULL;
+    for (size_t i = 0; i < sizeof(everySentence) / sizeof(everySentence[0]) && !windowCollector; ++i) {
+      windowCollector = everySentence[i];
+    }
+    if (windowCollector) {
+      windowCollector->SetWindow(window);
+    }
+    if (staticData.GetReadAhead() > 0) {
+      ioWrapper->StartReadAhead(staticData.GetInputType(), staticData.GetReadAhead());
+    }
 #endif
   
     // main loop over set of input sentences
@@ -475,6 +524,11 @@ int main(int argc, char** argv)
       IFVERBOSE(1) {
         ResetUserTime();
       }
+#ifdef WITH_THREADS
+      if (windowCollector) {
+        windowCollector->WaitForSpace(lineCount);
+      }
+#endif
       // set up task of translating one sentence
       TranslationTask* task =
         new TranslationTask(lineCount,source, outputCollector.get(),
@@ -483,7 +537,9 @@ int main(int argc, char** argv)
                             wordGraphCollector.get(),
                             searchGraphCollector.get(),
                             detailedTranslationCollector.get(),
-                            alignmentInfoCollector.get() );
+                            alignmentInfoCollector.get(),
+                            sentenceStatsCollector.get(),
+                            sentenceStatsTotals.get() );
       // execute task
 #ifdef WITH_THREADS
     pool.Submit(task);
@@ -499,8 +555,24 @@ int main(int argc, char** argv)
   // we are done, finishing up
 #ifdef WITH_THREADS
     pool.Stop(true); //flush remaining jobs
+    if (windowCollector) {
+      VERBOSE(1, "Output: at most " << windowCollector->GetMaxWaiting() << " sentences waited for an earlier one, input waited "
+              << windowCollector->GetNumWaits() << " times for the output" << endl);
+    }
 #endif
 
+    if (sentenceStatsTotals.get()) {
+      const TranslationSystem& system = staticData.GetTranslationSystem(TranslationSystem::DEFAULT);
+      sentenceStatsTotals->WriteJson(ioWrapper->GetSentenceStatsStream(), "\"total\"",
+                                     system.GetStatefulFeatureFunctions());
+    }
+
+    IFVERBOSE(1) {
+      if (staticData.GetUseTransOptCache()) {
+        TRACE_ERR(staticData.GetTransOptCache() << endl);
+      }
+    }
+
   } catch (const std::exception &e) {
     std::cerr << "Exception: " << e.what() << std::endl;
     return EXIT_FAILURE;
@@ -0,0 +1,95 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdlib>
+#include <new>
+#include "Arena.h"
+
+namespace Moses
+{
+
+Arena::Arena(size_t blockSize)
+  :m_current(NULL)
+  ,m_end(NULL)
+  ,m_blockSize(RoundUp(blockSize))
+  ,m_reserved(0)
+{
+  for (size_t i = 0 ; i < NUM_FREE_LISTS ; ++i) {
+    m_freeLists[i] = NULL;
+  }
+}
+
+Arena::~Arena()
+{
+  for (size_t i = 0 ; i < m_blocks.size() ; ++i) {
+    free(m_blocks[i]);
+  }
+}
+
+char *Arena::NewBlock(size_t size)
+{
+  char *block = static_cast<char*>(malloc(size));
+  if (block == NULL) {
+    throw std::bad_alloc();
+  }
+  m_blocks.push_back(block);
+  m_reserved += size;
+  return block;
+}
+
+void *Arena::Allocate(size_t size)
+{
+  size = RoundUp(size);
+
+  const size_t list = size / ALIGNMENT - 1;
+  if (list < NUM_FREE_LISTS && m_freeLists[list] != NULL) {
+    FreeNode *node = m_freeLists[list];
+    m_freeLists[list] = node->next;
+    return node;
+  }
+
+  // big objects get a block of their own, so that little of a block is wasted
+  if (size > m_blockSize / 4) {
+    return NewBlock(size);
+  }
+
+  if (size > static_cast<size_t>(m_end - m_current)) {
+    m_current = NewBlock(m_blockSize);
+    m_end = m_current + m_blockSize;
+  }
+  void *ret = m_current;
+  m_current += size;
+  return ret;
+}
+
+void Arena::Free(void *ptr, size_t size)
+{
+  const size_t list = RoundUp(size) / ALIGNMENT - 1;
+  if (ptr == NULL || list >= NUM_FREE_LISTS) {
+    // bigger chunks are only released with the arena
+    return;
+  }
+  FreeNode *node = static_cast<FreeNode*>(ptr);
+  node->next = m_freeLists[list];
+  m_freeLists[list] = node;
+}
+
+}
@@ -0,0 +1,82 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_Arena_h
+#define moses_Arena_h
+
+#include <cstddef>
+#include <vector>
+
+namespace Moses
+{
+
+/** Memory for objects that live at most as long as the decoding of one
+ *  sentence. Objects are carved out of large blocks, and all blocks are
+ *  released at once when the arena is destroyed, typically together with
+ *  the Manager. Memory given back with Free() is kept in per-size free lists
+ *  and reused by the next allocation of the same size.
+ *  An arena is not thread safe: threads that create objects at the same time
+ *  each use their own arena.
+ */
+class Arena
+{
+public:
+  explicit Arena(size_t blockSize = 64 * 1024);
+  ~Arena();
+
+  //! size bytes, suitably aligned for any type
+  void *Allocate(size_t size);
+  //! give back memory from Allocate(size) for reuse
+  void Free(void *ptr, size_t size);
+
+  //! bytes reserved from the system
+  size_t GetReserved() const {
+    return m_reserved;
+  }
+
+protected:
+  struct FreeNode {
+    FreeNode *next;
+  };
+
+  static const size_t ALIGNMENT = 16;
+  static const size_t NUM_FREE_LISTS = 64; /**< sizes up to 1k are recycled */
+
+  static size_t RoundUp(size_t size) {
+    return size == 0 ? ALIGNMENT : (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  }
+
+  char *NewBlock(size_t size);
+
+  char *m_current, *m_end; /**< unused part of the current block */
+  size_t m_blockSize;
+  size_t m_reserved;
+  std::vector<char*> m_blocks;
+  FreeNode *m_freeLists[NUM_FREE_LISTS]; /**< index i holds chunks of (i+1)*ALIGNMENT bytes */
+
+private:
+  Arena(const Arena &); // not implemented
+  void operator=(const Arena &); // not implemented
+};
+
+}
+
+#endif
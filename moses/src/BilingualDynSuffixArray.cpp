@@ -9,7 +9,10 @@ using namespace std;
 
 namespace Moses {
 
+const size_t BilingualDynSuffixArray::MAX_CACHED_PHRASES;
+
 BilingualDynSuffixArray::BilingualDynSuffixArray():
+	m_cacheGeneration(0),
 	m_maxPhraseLength(StaticData::Instance().GetMaxPhraseLength()), 
 	m_maxSampleSize(20)
 { 
@@ -226,38 +229,27 @@ pair<float, float> BilingualDynSuffixArray::GetLexicalWeight(const PhrasePair& p
 	std::map<pair<wordID_t, wordID_t>, float> targetProbs; // collect sum of target probs given source words
 	//const SentenceAlignment& alignment = m_alignments[phrasepair.m_sntIndex];
 	const SentenceAlignment& alignment = GetSentenceAlignment(phrasepair.m_sntIndex);
-	std::map<pair<wordID_t, wordID_t>, pair<float, float> >::const_iterator itrCache; 
 	// for each source word
 	for(int srcIdx = phrasepair.m_startSource; srcIdx <= phrasepair.m_endSource; ++srcIdx) {
 		float srcSumPairProbs(0);
 		wordID_t srcWord = m_srcCorpus->at(srcIdx + m_srcSntBreaks[phrasepair.m_sntIndex]);	// localIDs
 		const std::vector<int>& srcWordAlignments = alignment.alignedList.at(srcIdx);
+		WordProbsPtr probs = GetWordProbs(srcWord);
     // for each target word aligned to this source word in this alignment
 		if(srcWordAlignments.size() == 0) { // get p(NULL|src)
-			pair<wordID_t, wordID_t> wordpair = make_pair(srcWord, m_srcVocab->GetkOOVWordID());
-			itrCache = m_wordPairCache.find(wordpair);
-			if(itrCache == m_wordPairCache.end()) { // if not in cache
-				CacheWordProbs(srcWord);
-				itrCache = m_wordPairCache.find(wordpair); // search cache again
-			}
-			CHECK(itrCache != m_wordPairCache.end());
-			srcSumPairProbs += itrCache->second.first;
-			targetProbs[wordpair] = itrCache->second.second;
+			wordID_t nullWord = m_srcVocab->GetkOOVWordID();
+			pair<float, float> prob = GetWordProb(srcWord, nullWord, probs);
+			srcSumPairProbs += prob.first;
+			targetProbs[make_pair(srcWord, nullWord)] = prob.second;
 		}
 		else { // extract p(trg|src) 
 			for(size_t i = 0; i < srcWordAlignments.size(); ++i) { // for each aligned word
 				int trgIdx = srcWordAlignments[i];
 				wordID_t trgWord = m_trgCorpus->at(trgIdx + m_trgSntBreaks[phrasepair.m_sntIndex]);
 				// get probability of this source->target word pair
-				pair<wordID_t, wordID_t> wordpair = make_pair(srcWord, trgWord);
-				itrCache = m_wordPairCache.find(wordpair);
-				if(itrCache == m_wordPairCache.end()) { // if not in cache
-          CacheWordProbs(srcWord);
-					itrCache = m_wordPairCache.find(wordpair); // search cache again
-				}
-				CHECK(itrCache != m_wordPairCache.end());
-				srcSumPairProbs += itrCache->second.first;
-				targetProbs[wordpair] = itrCache->second.second;	
+				pair<float, float> prob = GetWordProb(srcWord, trgWord, probs);
+				srcSumPairProbs += prob.first;
+				targetProbs[make_pair(srcWord, trgWord)] = prob.second;
 			} 
 		}
 		float srcNormalizer = srcWordAlignments.size() < 2 ? 1.0 : 1.0 / float(srcWordAlignments.size());
@@ -279,7 +271,7 @@ pair<float, float> BilingualDynSuffixArray::GetLexicalWeight(const PhrasePair& p
 	// TODO::Need to get p(NULL|trg)
 	return pair<float, float>(srcLexWeight, trgLexWeight);
 }
-void BilingualDynSuffixArray::CacheFreqWords() const {
+void BilingualDynSuffixArray::CacheFreqWords() {
   std::multimap<int, wordID_t> wordCnts;
   // for each source word in vocab
   Vocab::Word2Id::const_iterator it;  
@@ -296,12 +288,46 @@ void BilingualDynSuffixArray::CacheFreqWords() const {
 	std::multimap<int, wordID_t>::reverse_iterator ritr;
   for(ritr = wordCnts.rbegin(); ritr != wordCnts.rend(); ++ritr) { 
     m_freqWordsCached.insert(ritr->second);
-    CacheWordProbs(ritr->second);
+    GetWordProbs(ritr->second);
     if(++numSoFar == 50) break; // get top counts
   }
   cerr << "\tCached " << m_freqWordsCached.size() << " source words\n";
 }
-void BilingualDynSuffixArray::CacheWordProbs(wordID_t srcWord) const 
+BilingualDynSuffixArray::WordProbsPtr BilingualDynSuffixArray::GetWordProbs(wordID_t srcWord) const
+{
+	size_t generation;
+	{
+#ifdef WITH_THREADS
+		boost::mutex::scoped_lock lock(m_cacheMutex);
+#endif
+		boost::unordered_map<wordID_t, WordProbsPtr>::const_iterator itr = m_wordProbCache.find(srcWord);
+		if(itr != m_wordProbCache.end()) return itr->second;
+		generation = m_cacheGeneration;
+	}
+	// threads missing the same word both count it, rather than wait for each other
+	WordProbsPtr probs(CalcWordProbs(srcWord));
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_cacheMutex);
+#endif
+	if(generation == m_cacheGeneration)
+		m_wordProbCache[srcWord] = probs;
+	return probs;
+}
+
+pair<float, float> BilingualDynSuffixArray::GetWordProb(wordID_t srcWord, wordID_t trgWord, WordProbsPtr& probs) const
+{
+	WordProbs::const_iterator itr = probs->find(trgWord);
+	if(itr == probs->end()) {
+		// the phrase pair comes from a sentence pair added after probs were
+		// counted, and InvalidateCaches() has not dropped them yet
+		probs.reset(CalcWordProbs(srcWord));
+		itr = probs->find(trgWord);
+		CHECK(itr != probs->end());
+	}
+	return itr->second;
+}
+
+BilingualDynSuffixArray::WordProbs* BilingualDynSuffixArray::CalcWordProbs(wordID_t srcWord) const 
 {
 	std::map<wordID_t, int> counts;
 	std::vector<wordID_t> sword(1, srcWord), wrdIndices;
@@ -328,14 +354,15 @@ void BilingualDynSuffixArray::CacheWordProbs(wordID_t srcWord) const
 		}
 	}
 	// now we've gotten counts of all target words aligned to this source word
-	// get probs and cache all pairs
+	// get probs of all pairs
+	WordProbs* probs = new WordProbs();
 	for(std::map<wordID_t, int>::const_iterator itrCnt = counts.begin();
 			itrCnt != counts.end(); ++itrCnt) {
-		pair<wordID_t, wordID_t> wordPair = make_pair(srcWord, itrCnt->first);
 		float srcTrgPrb = float(itrCnt->second) / float(denom);	// gives p(src->trg)
 		float trgSrcPrb = float(itrCnt->second) / float(counts.size()); // gives p(trg->src) 
-		m_wordPairCache[wordPair] = pair<float, float>(srcTrgPrb, trgSrcPrb);
+		probs->insert(probs->end(), make_pair(itrCnt->first, pair<float, float>(srcTrgPrb, trgSrcPrb)));
 	}
+	return probs;
 }
 
 SAPhrase BilingualDynSuffixArray::TrgPhraseFromSntIdx(const PhrasePair& phrasepair) const 
@@ -363,12 +390,78 @@ TargetPhrase* BilingualDynSuffixArray::GetMosesFactorIDs(const SAPhrase& phrase)
 	return targetPhrase;
 }
 
+size_t BilingualDynSuffixArray::GetCacheGeneration() const
+{
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_cacheMutex);
+#endif
+	return m_cacheGeneration;
+}
+
+BilingualDynSuffixArray::PhraseScoresPtr BilingualDynSuffixArray::FindPhraseScores(const SAPhrase& phrase) const
+{
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_cacheMutex);
+#endif
+	boost::unordered_map<std::vector<wordID_t>, PhraseScoresPtr>::const_iterator itr = m_phraseCache.find(phrase.words);
+	return itr == m_phraseCache.end() ? PhraseScoresPtr() : itr->second;
+}
+
+void BilingualDynSuffixArray::AddPhraseScores(const SAPhrase& phrase, const PhraseScoresPtr& scores, size_t generation) const
+{
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_cacheMutex);
+#endif
+	if(generation != m_cacheGeneration) return; // a sentence pair was added meanwhile
+	if(m_phraseCache.size() >= MAX_CACHED_PHRASES) m_phraseCache.clear();
+	m_phraseCache[phrase.words] = scores;
+}
+
+void BilingualDynSuffixArray::InvalidateCaches(const vuint_t& srcWords)
+{
+	const std::set<wordID_t> words(srcWords.begin(), srcWords.end());
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_cacheMutex);
+#endif
+	++m_cacheGeneration;
+	for(std::set<wordID_t>::const_iterator itr = words.begin(); itr != words.end(); ++itr) {
+		m_wordProbCache.erase(*itr);
+	}
+	// the counts or the lexical weights of a phrase with any of the words may change
+	boost::unordered_map<std::vector<wordID_t>, PhraseScoresPtr>::iterator itr = m_phraseCache.begin();
+	while(itr != m_phraseCache.end()) {
+		bool affected = false;
+		for(size_t i = 0; i < itr->first.size() && !affected; ++i)
+			affected = words.find(itr->first[i]) != words.end();
+		if(affected) itr = m_phraseCache.erase(itr);
+		else ++itr;
+	}
+}
+
 void BilingualDynSuffixArray::GetTargetPhrasesByLexicalWeight(const Phrase& src, std::vector< std::pair<Scores, TargetPhrase*> > & target) const 
 {
   //cerr << "phrase is \"" << src << endl;
-	size_t sourceSize = src.GetSize();
-	SAPhrase localIDs(sourceSize);
+#ifdef WITH_THREADS
+	boost::shared_lock<boost::shared_mutex> lock(m_corpusMutex);
+#endif
+	SAPhrase localIDs(src.GetSize());
 	if(!GetLocalVocabIDs(src, localIDs)) return; 
+	PhraseScoresPtr scores = FindPhraseScores(localIDs);
+	if(!scores) {
+		const size_t generation = GetCacheGeneration();
+		PhraseScores* computed = new PhraseScores();
+		ScorePhrase(localIDs, *computed);
+		scores.reset(computed);
+		AddPhraseScores(localIDs, scores, generation);
+	}
+	for(PhraseScores::const_iterator itr = scores->begin(); itr != scores->end(); ++itr) {
+		target.push_back(make_pair(itr->first, GetMosesFactorIDs(itr->second)));
+	}
+}
+
+void BilingualDynSuffixArray::ScorePhrase(const SAPhrase& localIDs, PhraseScores& scores) const 
+{
+	size_t sourceSize = localIDs.words.size();
 	float totalTrgPhrases(0); 
 	std::map<SAPhrase, int> phraseCounts;
   //std::map<SAPhrase, PhrasePair> phraseColl; // (one of) the word indexes this phrase was taken from 
@@ -419,10 +512,8 @@ void BilingualDynSuffixArray::GetTargetPhrasesByLexicalWeight(const Phrase& src,
 	// return top scoring phrases
 	std::multimap<Scores, const SAPhrase*, ScoresComp>::reverse_iterator ritr;
 	for(ritr = phraseScores.rbegin(); ritr != phraseScores.rend(); ++ritr) {
-		Scores scoreVector = ritr->first;
-		TargetPhrase *targetPhrase = GetMosesFactorIDs(*ritr->second);
-		target.push_back(make_pair( scoreVector, targetPhrase));
-		if(target.size() == m_maxSampleSize) break;
+		scores.push_back(make_pair(ritr->first, *ritr->second));
+		if(scores.size() == m_maxSampleSize) break;
 	}
 }
 
@@ -456,61 +547,57 @@ void BilingualDynSuffixArray::addSntPair(string& source, string& target, string&
   vuint_t srcFactor, trgFactor;
   cerr << "source, target, alignment = " << source << ", " << target << ", " << alignment << endl;
 	const std::string& factorDelimiter = StaticData::Instance().GetFactorDelimiter();
-  const unsigned oldSrcCrpSize = m_srcCorpus->size(), oldTrgCrpSize = m_trgCorpus->size();
-  cerr << "old source corpus size = " << oldSrcCrpSize << "\told target size = " << oldTrgCrpSize << endl;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock updateLock(m_updateMutex);
+#endif
   Phrase sphrase(ARRAY_SIZE_INCR);
   sphrase.CreateFromString(m_inputFactors, source, factorDelimiter);
-  m_srcVocab->MakeOpen();
-  wordID_t sIDs[sphrase.GetSize()];
-  // store words in vocabulary and corpus
-  for(int i = sphrase.GetSize()-1; i >= 0; --i) {
-    sIDs[i] = m_srcVocab->GetWordID(sphrase.GetWord(i));  // get vocab id backwards
-  }
-  for(size_t i = 0; i < sphrase.GetSize(); ++i) {
-    srcFactor.push_back(sIDs[i]);
-    cerr << "srcFactor[" << (srcFactor.size() - 1) << "] = " << srcFactor.back() << endl;
-    m_srcCorpus->push_back(srcFactor.back()); // add word to corpus
-  }
-  m_srcSntBreaks.push_back(oldSrcCrpSize); // former end of corpus is index of new sentence 
-  m_srcVocab->MakeClosed();
   Phrase tphrase(ARRAY_SIZE_INCR);
   tphrase.CreateFromString(m_outputFactors, target, factorDelimiter);
-  m_trgVocab->MakeOpen();
-  wordID_t tIDs[tphrase.GetSize()];
-  for(int i = tphrase.GetSize()-1; i >= 0; --i) {
-    tIDs[i] = m_trgVocab->GetWordID(tphrase.GetWord(i));  // get vocab id
-  }
-  for(size_t i = 0; i < tphrase.GetSize(); ++i) {
-    trgFactor.push_back(tIDs[i]);
-    cerr << "trgFactor[" << (trgFactor.size() - 1) << "] = " << trgFactor.back() << endl;
-    m_trgCorpus->push_back(trgFactor.back());
+  unsigned oldSrcCrpSize, oldTrgCrpSize;
+  {
+    // lookups wait only while the sentence pair is appended
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(m_corpusMutex);
+#endif
+    oldSrcCrpSize = m_srcCorpus->size();
+    oldTrgCrpSize = m_trgCorpus->size();
+    cerr << "old source corpus size = " << oldSrcCrpSize << "\told target size = " << oldTrgCrpSize << endl;
+    m_srcVocab->MakeOpen();
+    wordID_t sIDs[sphrase.GetSize()];
+    // store words in vocabulary and corpus
+    for(int i = sphrase.GetSize()-1; i >= 0; --i) {
+      sIDs[i] = m_srcVocab->GetWordID(sphrase.GetWord(i));  // get vocab id backwards
+    }
+    for(size_t i = 0; i < sphrase.GetSize(); ++i) {
+      srcFactor.push_back(sIDs[i]);
+      cerr << "srcFactor[" << (srcFactor.size() - 1) << "] = " << srcFactor.back() << endl;
+      m_srcCorpus->push_back(srcFactor.back()); // add word to corpus
+    }
+    m_srcSntBreaks.push_back(oldSrcCrpSize); // former end of corpus is index of new sentence 
+    m_srcVocab->MakeClosed();
+    m_trgVocab->MakeOpen();
+    wordID_t tIDs[tphrase.GetSize()];
+    for(int i = tphrase.GetSize()-1; i >= 0; --i) {
+      tIDs[i] = m_trgVocab->GetWordID(tphrase.GetWord(i));  // get vocab id
+    }
+    for(size_t i = 0; i < tphrase.GetSize(); ++i) {
+      trgFactor.push_back(tIDs[i]);
+      cerr << "trgFactor[" << (trgFactor.size() - 1) << "] = " << trgFactor.back() << endl;
+      m_trgCorpus->push_back(trgFactor.back());
+    }
+    m_trgSntBreaks.push_back(oldTrgCrpSize);
+    LoadRawAlignments(alignment);
+    m_trgVocab->MakeClosed();
   }
-  cerr << "gets to 1\n";
-  m_trgSntBreaks.push_back(oldTrgCrpSize);
-  cerr << "gets to 2\n";
+  // the new suffixes are sorted while lookups go on, they only read the corpus
   m_srcSA->Insert(&srcFactor, oldSrcCrpSize);
-  cerr << "gets to 3\n";
   //m_trgSA->Insert(&trgFactor, oldTrgCrpSize);
-  LoadRawAlignments(alignment);
-  m_trgVocab->MakeClosed();
-  //for(size_t i=0; i < sphrase.GetSize(); ++i)
-    //ClearWordInCache(sIDs[i]);
-  
-}
-void BilingualDynSuffixArray::ClearWordInCache(wordID_t srcWord) {
-  if(m_freqWordsCached.find(srcWord) != m_freqWordsCached.end())
-    return;
-	std::map<std::pair<wordID_t, wordID_t>, std::pair<float, float> >::iterator it,
-    first, last;
-  for(it = m_wordPairCache.begin(); it != m_wordPairCache.end(); ++it) {
-    if(it->first.first == srcWord) {  // all source words grouped 
-      first = it; // copy first entry of srcWord
-      last = it++;
-      while(it != m_wordPairCache.end() && (it->first.first == srcWord)) {
-        last = it++;
-      }
-    }
-    m_wordPairCache.erase(first, last);
+  InvalidateCaches(srcFactor);
+  // don't leave the first lookup of a frequent word to count it again
+  for(size_t i = 0; i < srcFactor.size(); ++i) {
+    if(m_freqWordsCached.find(srcFactor[i]) != m_freqWordsCached.end())
+      GetWordProbs(srcFactor[i]);
   }
 }
 SentenceAlignment::SentenceAlignment(int sntIndex, int sourceSize, int targetSize) 
@@ -8,6 +8,13 @@
 #include "DynSAInclude/utils.h"
 #include "InputFileStream.h"
 #include "FactorTypeSet.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#endif
 
 namespace Moses {
 
@@ -104,9 +111,32 @@ private:
 	std::vector<SentenceAlignment> m_alignments;
 	std::vector<std::vector<short> > m_rawAlignments;
 
-	mutable std::map<std::pair<wordID_t, wordID_t>, std::pair<float, float> > m_wordPairCache; 
-  mutable std::set<wordID_t> m_freqWordsCached;
+#ifdef WITH_THREADS
+	//! lookups share the corpora, vocabularies and alignments, addSntPair() appends to them alone
+	mutable boost::shared_mutex m_corpusMutex;
+	boost::mutex m_updateMutex; //! one addSntPair() at a time
+#endif
+
+	//! p(trg|src) and p(src|trg) for each target word aligned to one source word
+	typedef std::map<wordID_t, std::pair<float, float> > WordProbs;
+	typedef boost::shared_ptr<const WordProbs> WordProbsPtr;
+	//! the best target phrases of one source phrase, with their scores
+	typedef std::vector<std::pair<Scores, SAPhrase> > PhraseScores;
+	typedef boost::shared_ptr<const PhraseScores> PhraseScoresPtr;
+
+	/* Both caches hold entries that are never changed once made, a lookup
+	 * copies the pointer under m_cacheMutex and reads the entry after releasing
+	 * it. An entry is only added if no sentence pair was added while it was
+	 * computed, as counted by m_cacheGeneration, else it might miss the new pair */
+	mutable boost::unordered_map<wordID_t, WordProbsPtr> m_wordProbCache;
+	mutable boost::unordered_map<std::vector<wordID_t>, PhraseScoresPtr> m_phraseCache;
+	mutable size_t m_cacheGeneration;
+#ifdef WITH_THREADS
+	mutable boost::mutex m_cacheMutex;
+#endif
+	std::set<wordID_t> m_freqWordsCached; //! counted again right away when sentence pairs are added
 	const size_t m_maxPhraseLength, m_maxSampleSize;
+	static const size_t MAX_CACHED_PHRASES = 100000;
 
 	int LoadCorpus(InputFileStream&, const std::vector<FactorType>& factors, 
 		std::vector<wordID_t>&, std::vector<wordID_t>&,
@@ -123,9 +153,16 @@ private:
 	TargetPhrase* GetMosesFactorIDs(const SAPhrase&) const;
 	SAPhrase TrgPhraseFromSntIdx(const PhrasePair&) const;
 	bool GetLocalVocabIDs(const Phrase&, SAPhrase &) const;
-	void CacheWordProbs(wordID_t) const;
-  void CacheFreqWords() const;
-  void ClearWordInCache(wordID_t);
+	WordProbsPtr GetWordProbs(wordID_t) const;
+	WordProbs* CalcWordProbs(wordID_t) const;
+	std::pair<float, float> GetWordProb(wordID_t srcWord, wordID_t trgWord, WordProbsPtr& probs) const;
+	void CacheFreqWords();
+	size_t GetCacheGeneration() const;
+	PhraseScoresPtr FindPhraseScores(const SAPhrase&) const;
+	void AddPhraseScores(const SAPhrase&, const PhraseScoresPtr&, size_t generation) const;
+	//! drop what was computed without the sentence made of these source words
+	void InvalidateCaches(const vuint_t& srcWords);
+	void ScorePhrase(const SAPhrase&, PhraseScores&) const;
 	std::pair<float, float> GetLexicalWeight(const PhrasePair&) const;
 
 	int GetSourceSentenceSize(size_t sentenceId) const
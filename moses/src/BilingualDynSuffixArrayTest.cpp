@@ -0,0 +1,98 @@
+#include "BilingualDynSuffixArray.h"
+
+#define BOOST_TEST_MODULE MosesBilingualDynSuffixArray
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Parameter.h"
+#include "Phrase.h"
+#include "StaticData.h"
+#include "TargetPhrase.h"
+#include "Util.h"
+
+using namespace std;
+using namespace Moses;
+
+namespace {
+
+// more occurrences than the minimum count of the frequent word cache
+const int FREQUENT = 1000;
+
+struct Corpus {
+  string dir;
+
+  Corpus() {
+    char name[] = "/tmp/dynsa_test_XXXXXX";
+    BOOST_REQUIRE(mkdtemp(name) != NULL);
+    dir = name;
+
+    ofstream source(File("source").c_str()), target(File("target").c_str()), align(File("align").c_str());
+    for (int i = 0; i < FREQUENT; ++i) {
+      source << "a b\n";
+      target << "x y\n";
+      align << "0-0 1-1\n";
+    }
+
+    // StaticData needs a phrase table, the suffix array is loaded on its own
+    ofstream table(File("phrase-table").c_str());
+    table << "a ||| x ||| 1\n";
+    ofstream ini(File("moses.ini").c_str());
+    ini << "[input-factors]\n0\n[mapping]\n0 T 0\n"
+        << "[ttable-file]\n0 0 0 1 " << File("phrase-table") << "\n[ttable-limit]\n20\n"
+        << "[weight-t]\n1\n[weight-d]\n1\n[weight-w]\n0\n"
+        << "[max-phrase-length]\n7\n";
+  }
+
+  ~Corpus() {
+    const char *files[] = { "source", "target", "align", "phrase-table", "moses.ini" };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+      remove(File(files[i]).c_str());
+    rmdir(dir.c_str());
+  }
+
+  string File(const string &name) const {
+    return dir + "/" + name;
+  }
+};
+
+size_t Lookup(const BilingualDynSuffixArray &sa, const string &source) {
+  const vector<FactorType> factors(1, 0);
+  Phrase phrase(ARRAY_SIZE_INCR);
+  phrase.CreateFromString(factors, source, "|");
+  vector< pair<Scores, TargetPhrase*> > targets;
+  sa.GetTargetPhrasesByLexicalWeight(phrase, targets);
+  for (size_t i = 0; i < targets.size(); ++i)
+    delete targets[i].second;
+  return targets.size();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(new_alignment_of_frequent_word) {
+  Corpus corpus;
+  Parameter *parameter = new Parameter();
+  BOOST_REQUIRE(parameter->LoadParam(corpus.File("moses.ini")));
+  BOOST_REQUIRE(StaticData::LoadDataStatic(parameter));
+
+  const vector<FactorType> factors(1, 0);
+  BilingualDynSuffixArray sa;
+  BOOST_REQUIRE(sa.Load(factors, factors, corpus.File("source"), corpus.File("target"),
+                        corpus.File("align"), vector<float>(3, 1)));
+  BOOST_CHECK(Lookup(sa, "a") > 0);
+
+  // a was only aligned to x when its probabilities were counted at load
+  string source("a c"), target("z w"), alignment("0-0 1-1");
+  sa.addSntPair(source, target, alignment);
+  BOOST_CHECK(Lookup(sa, "a c") > 0);
+
+  // and to nothing at all
+  source = "a d";
+  target = "v";
+  alignment = "1-0";
+  sa.addSntPair(source, target, alignment);
+  BOOST_CHECK(Lookup(sa, "a d") > 0);
+}
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "DummyScoreProducers.h"
 #include "TranslationOptionList.h"
 #include "TranslationSystem.h"
+#include "Manager.h"
 
 namespace Moses
 {
@@ -105,7 +106,8 @@ BackwardsEdge::BackwardsEdge(const BitmapContainer &prevBitmapContainer
   , m_parent(parent)
   , m_translations(translations)
   , m_futurescore(futureScore)
-  , m_seenPosition()
+  , m_numSeenPositions(0)
+  , m_seenShift(64)
 {
 
   // If either dimension is empty, we haven't got anything to do.
@@ -118,9 +120,7 @@ BackwardsEdge::BackwardsEdge(const BitmapContainer &prevBitmapContainer
   int maxDistortion = StaticData::Instance().GetMaxDistortion();
 
   if (maxDistortion == -1) {
-    for (HypothesisSet::const_iterator iter = m_prevBitmapContainer.GetHypotheses().begin(); iter != m_prevBitmapContainer.GetHypotheses().end(); ++iter) {
-      m_hypotheses.push_back(*iter);
-    }
+    m_hypotheses.assign(m_prevBitmapContainer.GetHypotheses().begin(), m_prevBitmapContainer.GetHypotheses().end());
     return;
   }
 
@@ -128,6 +128,7 @@ BackwardsEdge::BackwardsEdge(const BitmapContainer &prevBitmapContainer
 
   HypothesisSet::const_iterator iterHypo = m_prevBitmapContainer.GetHypotheses().begin();
   HypothesisSet::const_iterator iterEnd = m_prevBitmapContainer.GetHypotheses().end();
+  m_hypotheses.reserve(m_prevBitmapContainer.GetHypotheses().size());
 
   while (iterHypo != iterEnd) {
     const Hypothesis &hypo = **iterHypo;
@@ -164,8 +165,6 @@ BackwardsEdge::BackwardsEdge(const BitmapContainer &prevBitmapContainer
 
 BackwardsEdge::~BackwardsEdge()
 {
-  m_seenPosition.clear();
-  m_hypotheses.clear();
 }
 
 
@@ -186,26 +185,55 @@ BackwardsEdge::Initialize()
 Hypothesis *BackwardsEdge::CreateHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt)
 {
   // create hypothesis and calculate all its scores
-  Hypothesis *newHypo = hypothesis.CreateNext(transOpt, NULL); // TODO FIXME This is absolutely broken - don't pass null here
+  Hypothesis *newHypo = hypothesis.CreateNext(transOpt, NULL, hypothesis.GetManager().GetArena()); // TODO FIXME This is absolutely broken - don't pass null here
   newHypo->CalcScore(m_futurescore);
 
   return newHypo;
 }
 
+size_t
+BackwardsEdge::FindSeenSlot(size_t key) const
+{
+  // Fibonacci hashing: the top bits of the product, which depend on all
+  // bits of the key. Linear probing
+  const size_t mask = m_seenPosition.size() - 1;
+  size_t slot = static_cast< size_t >((static_cast< UINT64 >(key) * 11400714819323198485ULL) >> m_seenShift);
+  while (m_seenPosition[slot] != 0 && m_seenPosition[slot] != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
 bool
-BackwardsEdge::SeenPosition(const size_t x, const size_t y)
+BackwardsEdge::SeenPosition(const size_t x, const size_t y) const
 {
-  std::set< int >::iterator iter = m_seenPosition.find((x<<16) + y);
-  return (iter != m_seenPosition.end());
+  if (m_seenPosition.empty()) {
+    return false;
+  }
+  const size_t key = x * m_translations.size() + y + 1;
+  return m_seenPosition[FindSeenSlot(key)] == key;
 }
 
 void
 BackwardsEdge::SetSeenPosition(const size_t x, const size_t y)
 {
-  CHECK(x < (1<<17));
-  CHECK(y < (1<<17));
+  if (2 * (m_numSeenPositions + 1) > m_seenPosition.size()) {
+    std::vector< size_t > old(std::max< size_t >(16, 2 * m_seenPosition.size()), 0);
+    old.swap(m_seenPosition);
+    m_seenShift = old.empty() ? 60 : m_seenShift - 1;
+    for (size_t i = 0; i < old.size(); ++i) {
+      if (old[i] != 0) {
+        m_seenPosition[FindSeenSlot(old[i])] = old[i];
+      }
+    }
+  }
 
-  m_seenPosition.insert((x<<16) + y);
+  const size_t key = x * m_translations.size() + y + 1;
+  const size_t slot = FindSeenSlot(key);
+  if (m_seenPosition[slot] == 0) {
+    m_seenPosition[slot] = key;
+    ++m_numSeenPositions;
+  }
 }
 
 
@@ -254,20 +282,13 @@ BitmapContainer::BitmapContainer(const WordsBitmap &bitmap
   , m_stack(stack)
   , m_numStackInsertions(0)
 {
-  m_hypotheses = HypothesisSet();
-  m_edges = BackwardsEdgeSet();
-  m_queue = HypothesisQueue();
 }
 
 BitmapContainer::~BitmapContainer()
 {
-  // As we have created the square position objects we clean up now.
-  HypothesisQueueItem *item = NULL;
-
+  // The hypotheses still queued were never added to a stack.
   while (!m_queue.empty()) {
-    item = m_queue.top();
-    FREEHYPO(item->GetHypothesis());
-    delete item;
+    FREEHYPO(m_queue.top().GetHypothesis());
     m_queue.pop();
   }
 
@@ -280,35 +301,27 @@ BitmapContainer::~BitmapContainer()
 
 
 void
-BitmapContainer::Enqueue(int hypothesis_pos
-                         , int translation_pos
+BitmapContainer::Enqueue(size_t hypothesis_pos
+                         , size_t translation_pos
                          , Hypothesis *hypothesis
                          , BackwardsEdge *edge)
 {
-  HypothesisQueueItem *item = new HypothesisQueueItem(hypothesis_pos
-      , translation_pos
-      , hypothesis
-      , edge);
-  m_queue.push(item);
+  m_queue.push(HypothesisQueueItem(hypothesis_pos
+                                   , translation_pos
+                                   , hypothesis
+                                   , edge));
 }
 
-HypothesisQueueItem*
-BitmapContainer::Dequeue(bool keepValue)
+HypothesisQueueItem
+BitmapContainer::Dequeue()
 {
-  if (!m_queue.empty()) {
-    HypothesisQueueItem *item = m_queue.top();
-
-    if (!keepValue) {
-      m_queue.pop();
-    }
-
-    return item;
-  }
-
-  return NULL;
+  CHECK(!m_queue.empty());
+  HypothesisQueueItem item = m_queue.top();
+  m_queue.pop();
+  return item;
 }
 
-HypothesisQueueItem*
+const HypothesisQueueItem&
 BitmapContainer::Top() const
 {
   return m_queue.top();
@@ -374,7 +387,7 @@ BitmapContainer::AddHypothesis(Hypothesis *hypothesis)
 void
 BitmapContainer::AddBackwardsEdge(BackwardsEdge *edge)
 {
-  m_edges.insert(edge);
+  m_edges.push_back(edge);
 }
 
 void
@@ -407,25 +420,21 @@ BitmapContainer::ProcessBestHypothesis()
   }
 
   // Get the currently best hypothesis from the queue.
-  HypothesisQueueItem *item = Dequeue();
-
-  // If the priority queue is exhausted, we are done and should have exited
-  CHECK(item != NULL);
+  const HypothesisQueueItem item = Dequeue();
 
   // check we are pulling things off of priority queue in right order
   if (!Empty()) {
-    HypothesisQueueItem *check = Dequeue(true);
-    CHECK(item->GetHypothesis()->GetTotalScore() >= check->GetHypothesis()->GetTotalScore());
+    CHECK(item.GetScore() >= Top().GetScore());
   }
 
   // Logging for the criminally insane
   IFVERBOSE(3) {
     //		const StaticData &staticData = StaticData::Instance();
-    item->GetHypothesis()->PrintHypothesis();
+    item.GetHypothesis()->PrintHypothesis();
   }
 
   // Add best hypothesis to hypothesis stack.
-  const bool newstackentry = m_stack.AddPrune(item->GetHypothesis());
+  const bool newstackentry = m_stack.AddPrune(item.GetHypothesis());
   if (newstackentry)
     m_numStackInsertions++;
 
@@ -434,10 +443,7 @@ BitmapContainer::ProcessBestHypothesis()
   }
 
   // Create new hypotheses for the two successors of the hypothesis just added.
-  item->GetBackwardsEdge()->PushSuccessors(item->GetHypothesisPos(), item->GetTranslationPos());
-
-  // We are done with the queue item, we delete it.
-  delete item;
+  item.GetBackwardsEdge()->PushSuccessors(item.GetHypothesisPos(), item.GetTranslationPos());
 }
 
 void
@@ -23,7 +23,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_BitmapContainer_h
 
 #include <queue>
-#include <set>
 #include <vector>
 
 #include "Hypothesis.h"
@@ -44,21 +43,22 @@ class HypothesisQueueItem;
 class QueueItemOrderer;
 
 typedef std::vector< Hypothesis* > HypothesisSet;
-typedef std::set< BackwardsEdge* > BackwardsEdgeSet;
-typedef std::priority_queue< HypothesisQueueItem*, std::vector< HypothesisQueueItem* >, QueueItemOrderer> HypothesisQueue;
+typedef std::vector< BackwardsEdge* > BackwardsEdgeSet;
+typedef std::priority_queue< HypothesisQueueItem, std::vector< HypothesisQueueItem >, QueueItemOrderer> HypothesisQueue;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Hypothesis Priority Queue Code
 ////////////////////////////////////////////////////////////////////////////////
 
+// Held by value in the queue, whose vector is reused for all items, with the
+// score of the hypothesis so that ordering doesn't have to dereference it.
 class HypothesisQueueItem
 {
 private:
   size_t m_hypothesis_pos, m_translation_pos;
   Hypothesis *m_hypothesis;
   BackwardsEdge *m_edge;
-
-  HypothesisQueueItem();
+  float m_score;
 
 public:
   HypothesisQueueItem(const size_t hypothesis_pos
@@ -68,36 +68,39 @@ public:
     : m_hypothesis_pos(hypothesis_pos)
     , m_translation_pos(translation_pos)
     , m_hypothesis(hypothesis)
-    , m_edge(edge) {
-  }
-
-  ~HypothesisQueueItem() {
+    , m_edge(edge)
+    , m_score(hypothesis->GetTotalScore()) {
   }
 
-  int GetHypothesisPos() {
+  size_t GetHypothesisPos() const {
     return m_hypothesis_pos;
   }
 
-  int GetTranslationPos() {
+  size_t GetTranslationPos() const {
     return m_translation_pos;
   }
 
-  Hypothesis *GetHypothesis() {
+  Hypothesis *GetHypothesis() const {
     return m_hypothesis;
   }
 
-  BackwardsEdge *GetBackwardsEdge() {
+  BackwardsEdge *GetBackwardsEdge() const {
     return m_edge;
   }
+
+  //! total score of the hypothesis
+  float GetScore() const {
+    return m_score;
+  }
 };
 
 // Allows to compare two HypothesisQueueItem objects by the corresponding scores.
 class QueueItemOrderer
 {
 public:
-  bool operator()(HypothesisQueueItem* itemA, HypothesisQueueItem* itemB) const {
-    float scoreA = itemA->GetHypothesis()->GetTotalScore();
-    float scoreB = itemB->GetHypothesis()->GetTotalScore();
+  bool operator()(const HypothesisQueueItem &itemA, const HypothesisQueueItem &itemB) const {
+    float scoreA = itemA.GetScore();
+    float scoreB = itemB.GetScore();
 
     return (scoreA < scoreB);
 
@@ -163,13 +166,20 @@ private:
   const SquareMatrix &m_futurescore;
 
   std::vector< const Hypothesis* > m_hypotheses;
-  std::set< int > m_seenPosition;
+
+  // Open addressing hash set of the grid positions already expanded,
+  // x * m_translations.size() + y + 1, 0 marks a free slot. The size is a
+  // power of 2, kept at least twice the number of positions.
+  std::vector< size_t > m_seenPosition;
+  size_t m_numSeenPositions;
+  unsigned m_seenShift; // 64 - log2 of the size of m_seenPosition
 
   // We don't want to instantiate "empty" objects.
   BackwardsEdge();
 
   Hypothesis *CreateHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt);
-  bool SeenPosition(const size_t x, const size_t y);
+  size_t FindSeenSlot(size_t key) const;
+  bool SeenPosition(const size_t x, const size_t y) const;
   void SetSeenPosition(const size_t x, const size_t y);
 
 protected:
@@ -201,7 +211,8 @@ public:
 class BitmapContainer
 {
 private:
-  WordsBitmap m_bitmap;
+  // the key of the container in HypothesisStackCubePruning::m_bitmapAccessor
+  const WordsBitmap &m_bitmap;
   HypothesisStackCubePruning &m_stack;
   HypothesisSet m_hypotheses;
   BackwardsEdgeSet m_edges;
@@ -212,6 +223,7 @@ private:
   BitmapContainer();
   BitmapContainer(const BitmapContainer &);
 public:
+  //! bitmap must outlive the container
   BitmapContainer(const WordsBitmap &bitmap
                   , HypothesisStackCubePruning &stack);
 
@@ -219,9 +231,10 @@ public:
   // connected to this BitmapContainer.
   ~BitmapContainer();
 
-  void Enqueue(int hypothesis_pos, int translation_pos, Hypothesis *hypothesis, BackwardsEdge *edge);
-  HypothesisQueueItem *Dequeue(bool keepValue=false);
-  HypothesisQueueItem *Top() const;
+  void Enqueue(size_t hypothesis_pos, size_t translation_pos, Hypothesis *hypothesis, BackwardsEdge *edge);
+  //! remove and return the best item, the queue must not be empty
+  HypothesisQueueItem Dequeue();
+  const HypothesisQueueItem &Top() const;
   size_t Size();
   bool Empty() const;
 
@@ -42,7 +42,7 @@ ChartRuleLookupManagerMemory::ChartRuleLookupManagerMemory(
   size_t sourceSize = src.GetSize();
   m_dottedRuleColls.resize(sourceSize);
 
-  const PhraseDictionaryNodeSCFG &rootNode = m_ruleTable.GetRootNode();
+  const PhraseDictionaryFlatTrieSCFG::Node &rootNode = m_ruleTable.GetTrie().GetRootNode();
 
   for (size_t ind = 0; ind < m_dottedRuleColls.size(); ++ind) {
 #ifdef USE_BOOST_POOL
@@ -97,7 +97,7 @@ void ChartRuleLookupManagerMemory::GetChartRuleCollection(
       // look up in rule dictionary, if the current rule can be extended
       // with the source word in the last position
       const Word &sourceWord = sourceWordLabel.GetLabel();
-      const PhraseDictionaryNodeSCFG *node = prevDottedRule.GetLastNode().GetChild(sourceWord);
+      const PhraseDictionaryFlatTrieSCFG::Node *node = m_ruleTable.GetTrie().GetChild(prevDottedRule.GetLastNode(), sourceWord);
 
       // if we found a new rule -> create it and add it to the list
       if (node != NULL) {
@@ -154,7 +154,7 @@ void ChartRuleLookupManagerMemory::GetChartRuleCollection(
   DottedRuleList::const_iterator iterRule;
   for (iterRule = rules.begin(); iterRule != rules.end(); ++iterRule) {
     const DottedRuleInMemory &dottedRule = **iterRule;
-    const PhraseDictionaryNodeSCFG &node = dottedRule.GetLastNode();
+    const PhraseDictionaryFlatTrieSCFG::Node &node = dottedRule.GetLastNode();
 
     // look up target sides
     const TargetPhraseCollection *tpc = node.GetTargetPhraseCollection();
@@ -190,12 +190,10 @@ void ChartRuleLookupManagerMemory::ExtendPartialRuleApplication(
     GetCellCollection().Get(WordsRange(startPos, endPos)).GetTargetLabelSet();
 
   // note where it was found in the prefix tree of the rule dictionary
-  const PhraseDictionaryNodeSCFG &node = prevDottedRule.GetLastNode();
+  const PhraseDictionaryFlatTrieSCFG &trie = m_ruleTable.GetTrie();
+  const PhraseDictionaryFlatTrieSCFG::Node &node = prevDottedRule.GetLastNode();
 
-  const PhraseDictionaryNodeSCFG::NonTerminalMap & nonTermMap =
-    node.GetNonTerminalMap();
-
-  const size_t numChildren = nonTermMap.size();
+  const size_t numChildren = node.numNonTerminals;
   if (numChildren == 0) {
     return;
   }
@@ -225,8 +223,8 @@ void ChartRuleLookupManagerMemory::ExtendPartialRuleApplication(
         const ChartCellLabel &cellLabel = q->second;
 
         // try to match both source and target non-terminal
-        const PhraseDictionaryNodeSCFG * child =
-          node.GetChild(sourceNonTerm, cellLabel.GetLabel());
+        const PhraseDictionaryFlatTrieSCFG::Node * child =
+          trie.GetChild(node, sourceNonTerm, cellLabel.GetLabel());
 
         // nothing found? then we are done
         if (child == NULL) {
@@ -248,24 +246,23 @@ void ChartRuleLookupManagerMemory::ExtendPartialRuleApplication(
   else 
   {
     // loop over possible expansions of the rule
-    PhraseDictionaryNodeSCFG::NonTerminalMap::const_iterator p;
-    PhraseDictionaryNodeSCFG::NonTerminalMap::const_iterator end =
-      nonTermMap.end();
-    for (p = nonTermMap.begin(); p != end; ++p) {
+    const PhraseDictionaryFlatTrieSCFG::NonTerminalEdge *p;
+    const PhraseDictionaryFlatTrieSCFG::NonTerminalEdge *end =
+      trie.EndNonTerminals(node);
+    for (p = trie.BeginNonTerminals(node); p != end; ++p) {
       // does it match possible source and target non-terminals?
-      const PhraseDictionaryNodeSCFG::NonTerminalMapKey &key = p->first;
-      const Word &sourceNonTerm = key.first;
+      const Word &sourceNonTerm = trie.GetLabel(p->sourceLabel);
       if (sourceNonTerms.find(sourceNonTerm) == sourceNonTerms.end()) {
         continue;
       }
-      const Word &targetNonTerm = key.second;
+      const Word &targetNonTerm = trie.GetLabel(p->targetLabel);
       const ChartCellLabel *cellLabel = targetNonTerms.Find(targetNonTerm);
       if (!cellLabel) {
         continue;
       }
 
       // create new rule
-      const PhraseDictionaryNodeSCFG &child = p->second;
+      const PhraseDictionaryFlatTrieSCFG::Node &child = trie.GetNode(p->child);
 #ifdef USE_BOOST_POOL
       DottedRuleInMemory *rule = m_dottedRulePool.malloc();
       new (rule) DottedRuleInMemory(child, *cellLabel, prevDottedRule);
@@ -30,7 +30,7 @@
 #include "ChartRuleLookupManagerCYKPlus.h"
 #include "DotChartInMemory.h"
 #include "NonTerminal.h"
-#include "RuleTable/PhraseDictionaryNodeSCFG.h"
+#include "RuleTable/PhraseDictionaryFlatTrieSCFG.h"
 #include "RuleTable/PhraseDictionarySCFG.h"
 #include "StackVec.h"
 
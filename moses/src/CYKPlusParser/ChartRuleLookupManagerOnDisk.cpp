@@ -69,12 +69,6 @@ ChartRuleLookupManagerOnDisk::ChartRuleLookupManagerOnDisk(
 
 ChartRuleLookupManagerOnDisk::~ChartRuleLookupManagerOnDisk()
 {
-  std::map<UINT64, const TargetPhraseCollection*>::const_iterator iterCache;
-  for (iterCache = m_cache.begin(); iterCache != m_cache.end(); ++iterCache) {
-    delete iterCache->second;
-  }
-  m_cache.clear();
-
   RemoveAllInColl(m_expandableDottedRuleListVec);
   RemoveAllInColl(m_sourcePhraseNode);
 }
@@ -232,26 +226,31 @@ void ChartRuleLookupManagerOnDisk::GetChartRuleCollection(
         const OnDiskPt::PhraseNode *node = prevNode.GetChild(*sourceLHSBerkeleyDb, m_dbWrapper);
         if (node) {
           UINT64 tpCollFilePos = node->GetValue();
-          std::map<UINT64, const TargetPhraseCollection*>::const_iterator iterCache = m_cache.find(tpCollFilePos);
+          std::map<UINT64, OnDiskRuleCache::CollectionPtr>::const_iterator iterCache = m_cache.find(tpCollFilePos);
           if (iterCache == m_cache.end()) {
-
-            const OnDiskPt::TargetPhraseCollection *tpcollBerkeleyDb = node->GetTargetPhraseCollection(m_dictionary.GetTableLimit(), m_dbWrapper);
-
-            targetPhraseCollection
-            = tpcollBerkeleyDb->ConvertToMoses(m_inputFactorsVec
-                                               ,m_outputFactorsVec
-                                               ,m_dictionary
-                                               ,m_weight
-                                               ,m_wpProducer
-                                               ,*m_languageModels
-                                               ,m_filePath
-                                               , m_dbWrapper.GetVocab());
-
-            delete tpcollBerkeleyDb;
-            m_cache[tpCollFilePos] = targetPhraseCollection;
+            // converted for an earlier sentence or by another thread?
+            OnDiskRuleCache &ruleCache = StaticData::Instance().GetOnDiskRuleCache();
+            OnDiskRuleCache::CollectionPtr collection = ruleCache.Find(m_dictionary.GetFeature(), tpCollFilePos);
+            if (!collection) {
+              const OnDiskPt::TargetPhraseCollection *tpcollBerkeleyDb = node->GetTargetPhraseCollection(m_dictionary.GetTableLimit(), m_dbWrapper);
+
+              collection.reset(tpcollBerkeleyDb->ConvertToMoses(m_inputFactorsVec
+                               ,m_outputFactorsVec
+                               ,m_dictionary
+                               ,m_weight
+                               ,m_wpProducer
+                               ,*m_languageModels
+                               ,m_filePath
+                               , m_dbWrapper.GetVocab()));
+
+              delete tpcollBerkeleyDb;
+              ruleCache.Add(m_dictionary.GetFeature(), tpCollFilePos, collection);
+            }
+            m_cache[tpCollFilePos] = collection;
+            targetPhraseCollection = collection.get();
           } else {
             // just get out of cache
-            targetPhraseCollection = iterCache->second;
+            targetPhraseCollection = iterCache->second.get();
           }
 
           CHECK(targetPhraseCollection);
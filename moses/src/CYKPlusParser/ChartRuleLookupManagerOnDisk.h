@@ -28,6 +28,7 @@
 #include "DotChartOnDisk.h"
 #include "InputType.h"
 #include "RuleTable/PhraseDictionaryOnDisk.h"
+#include "RuleTable/OnDiskRuleCache.h"
 
 namespace Moses
 {
@@ -62,7 +63,9 @@ class ChartRuleLookupManagerOnDisk : public ChartRuleLookupManagerCYKPlus
   const std::vector<float> &m_weight;
   const std::string &m_filePath;
   std::vector<DottedRuleStackOnDisk*> m_expandableDottedRuleListVec;
-  std::map<UINT64, const TargetPhraseCollection*> m_cache;
+  // collections used by this sentence, which also keeps them from being freed
+  // when evicted from the cache of StaticData
+  std::map<UINT64, OnDiskRuleCache::CollectionPtr> m_cache;
   std::list<const OnDiskPt::PhraseNode*> m_sourcePhraseNode;
 };
 
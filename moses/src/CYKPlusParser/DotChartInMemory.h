@@ -20,7 +20,7 @@
 #pragma once
 
 #include "DotChart.h"
-#include "RuleTable/PhraseDictionaryNodeSCFG.h"
+#include "RuleTable/PhraseDictionaryFlatTrieSCFG.h"
 
 #include "util/check.hh"
 #include <vector>
@@ -32,20 +32,20 @@ class DottedRuleInMemory : public DottedRule
 {
  public:
   // used only to init dot stack.
-  explicit DottedRuleInMemory(const PhraseDictionaryNodeSCFG &node)
+  explicit DottedRuleInMemory(const PhraseDictionaryFlatTrieSCFG::Node &node)
       : DottedRule()
       , m_node(node) {}
 
-  DottedRuleInMemory(const PhraseDictionaryNodeSCFG &node,
+  DottedRuleInMemory(const PhraseDictionaryFlatTrieSCFG::Node &node,
                      const ChartCellLabel &cellLabel,
                      const DottedRuleInMemory &prev)
       : DottedRule(cellLabel, prev)
       , m_node(node) {}
              
-  const PhraseDictionaryNodeSCFG &GetLastNode() const { return m_node; }
+  const PhraseDictionaryFlatTrieSCFG::Node &GetLastNode() const { return m_node; }
 
  private:
-  const PhraseDictionaryNodeSCFG &m_node;
+  const PhraseDictionaryFlatTrieSCFG::Node &m_node;
 };
 
 typedef std::vector<const DottedRuleInMemory*> DottedRuleList;
@@ -53,7 +53,7 @@ typedef std::vector<const DottedRuleInMemory*> DottedRuleList;
 // Collection of all in-memory DottedRules that share a common start point,
 // grouped by end point.  Additionally, maintains a list of all
 // DottedRules that could be expanded further, i.e. for which the
-// corresponding PhraseDictionaryNodeSCFG is not a leaf.
+// corresponding trie node is not a leaf.
 class DottedRuleColl
 {
 protected:
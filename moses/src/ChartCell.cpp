@@ -78,19 +78,21 @@ void ChartCell::PruneToSize()
  *  (implementation of cube pruning)
  * \param transOptList list of applicable rules to create hypotheses for the cell
  * \param allChartCells entire chart - needed to look up underlying hypotheses
+ * \param arena memory for the new hypotheses, owned by the calling thread
  */
 void ChartCell::ProcessSentence(const ChartTranslationOptionList &transOptList
-                                , const ChartCellCollection &allChartCells)
+                                , const ChartCellCollection &allChartCells
+                                , Arena &arena)
 {
   const StaticData &staticData = StaticData::Instance();
 
   // priority queue for applicable rules with selected hypotheses
-  RuleCubeQueue queue(m_manager);
+  RuleCubeQueue queue(m_manager, arena);
 
   // add all trans opt into queue. using only 1st child node.
   for (size_t i = 0; i < transOptList.GetSize(); ++i) {
     const ChartTranslationOption &transOpt = transOptList.Get(i);
-    RuleCube *ruleCube = new RuleCube(transOpt, allChartCells, m_manager);
+    RuleCube *ruleCube = new RuleCube(transOpt, allChartCells, m_manager, arena);
     queue.Add(ruleCube);
   }
 
@@ -148,6 +150,16 @@ void ChartCell::CleanupArcList()
   }
 }
 
+/** Give the hypotheses with provisional ids from firstId on the ids from newFirstId on */
+void ChartCell::RenumberHypotheses(unsigned firstId, unsigned newFirstId)
+{
+  MapType::iterator iter;
+  for (iter = m_hypoColl.begin(); iter != m_hypoColl.end(); ++iter) {
+    ChartHypothesisCollection &coll = iter->second;
+    coll.RenumberHypotheses(firstId, newFirstId);
+  }
+}
+
 void ChartCell::OutputSizes(std::ostream &out) const
 {
   MapType::const_iterator iter;
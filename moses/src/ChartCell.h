@@ -74,7 +74,8 @@ public:
   ~ChartCell();
 
   void ProcessSentence(const ChartTranslationOptionList &transOptList
-                       ,const ChartCellCollection &allChartCells);
+                       ,const ChartCellCollection &allChartCells
+                       ,Arena &arena);
 
   /** Get all hypotheses in the cell that have the specified constituent label */
   const HypoList *GetSortedHypotheses(const Word &constituentLabel) const
@@ -100,6 +101,7 @@ public:
   }
 
   void CleanupArcList();
+  void RenumberHypotheses(unsigned firstId, unsigned newFirstId);
 
   void OutputSizes(std::ostream &out) const;
   size_t GetSize() const;
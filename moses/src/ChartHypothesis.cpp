@@ -49,7 +49,8 @@ ChartHypothesis::ChartHypothesis(const ChartTranslationOption &transOpt,
   ,m_arcList(NULL)
   ,m_winningHypo(NULL)
   ,m_manager(manager)
-  ,m_id(manager.GetNextHypoId())
+  ,m_arena(NULL)
+  ,m_id(manager.GetNextHypoId(transOpt.GetSourceWordsRange()))
 {
   // underlying hypotheses for sub-spans
   const std::vector<HypothesisDimension> &childEntries = item.GetHypothesisDimensions();
@@ -61,6 +62,20 @@ ChartHypothesis::ChartHypothesis(const ChartTranslationOption &transOpt,
   }
 }
 
+ChartHypothesis *ChartHypothesis::Create(const ChartTranslationOption &transOpt,
+                                         const RuleCubeItem &item,
+                                         ChartManager &manager,
+                                         Arena &arena)
+{
+#ifdef USE_HYPO_POOL
+  return new ChartHypothesis(transOpt, item, manager);
+#else
+  ChartHypothesis *ret = new(arena) ChartHypothesis(transOpt, item, manager);
+  ret->m_arena = &arena;
+  return ret;
+#endif
+}
+
 ChartHypothesis::~ChartHypothesis()
 {
 	// delete feature function states
@@ -27,6 +27,7 @@
 #include "Phrase.h"
 #include "ChartTranslationOption.h"
 #include "ObjectPool.h"
+#include "Arena.h"
 
 namespace Moses
 {
@@ -61,12 +62,27 @@ protected:
   std::vector<const ChartHypothesis*> m_prevHypos;
 
   ChartManager& m_manager;
+  Arena *m_arena; /*! memory of this hypothesis comes from here */
 
   unsigned m_id; /* pkoehn wants to log the order in which hypotheses were generated */
 
   ChartHypothesis(); // not implemented
   ChartHypothesis(const ChartHypothesis &copy); // not implemented
 
+  ChartHypothesis(const ChartTranslationOption &, const RuleCubeItem &item,
+                  ChartManager &manager);
+
+#ifndef USE_HYPO_POOL
+  // hypotheses are allocated from the arena of the search thread, see Create()
+  void *operator new(size_t num_bytes, Arena &arena) {
+    return arena.Allocate(num_bytes);
+  }
+  void operator delete(void *ptr, Arena &arena) {
+    arena.Free(ptr, sizeof(ChartHypothesis));
+  }
+  void operator delete(void *); // not implemented
+#endif
+
 public:
 #ifdef USE_HYPO_POOL
   void *operator new(size_t /* num_bytes */) {
@@ -78,17 +94,24 @@ public:
     s_objectPool.freeObject(hypo);
   }
 #else
+  //! destroy the hypothesis and give its memory back to its arena
   static void Delete(ChartHypothesis *hypo) {
-    delete hypo;
+    Arena *arena = hypo->m_arena;
+    hypo->~ChartHypothesis();
+    arena->Free(hypo, sizeof(ChartHypothesis));
   }
 #endif
 
-  ChartHypothesis(const ChartTranslationOption &, const RuleCubeItem &item,
-                  ChartManager &manager);
+  /** Create a hypothesis from a rule, allocated from arena.
+   *  The arena must belong to the calling thread */
+  static ChartHypothesis *Create(const ChartTranslationOption &, const RuleCubeItem &item,
+                                 ChartManager &manager, Arena &arena);
 
   ~ChartHypothesis();
 
   unsigned GetId() const { return m_id; }
+  //! replaces a provisional id, see ChartManager::GetNextHypoId()
+  void SetId(unsigned id) { m_id = id; }
 
   const TargetPhrase &GetCurrTargetPhrase()const {
     return m_targetPhrase;
@@ -103,6 +126,8 @@ public:
 		return m_ffStates[ featureID ];
 	}
 	inline const ChartManager& GetManager() const { return m_manager; }
+  //! arena for the states of this hypothesis, NULL with USE_HYPO_POOL
+  Arena *GetArena() const { return m_arena; }
 
   void CreateOutputPhrase(Phrase &outPhrase) const;
   Phrase GetOutputPhrase() const;
@@ -254,6 +254,29 @@ void ChartHypothesisCollection::CleanupArcList()
   }
 }
 
+/** Give the hypotheses and arcs with ids from firstId on the ids from newFirstId on.
+ *  Hypotheses from earlier widths keep their ids */
+void ChartHypothesisCollection::RenumberHypotheses(unsigned firstId, unsigned newFirstId)
+{
+  HCType::iterator iter;
+  for (iter = m_hypos.begin() ; iter != m_hypos.end() ; ++iter) {
+    ChartHypothesis *mainHypo = *iter;
+    if (mainHypo->GetId() >= firstId) {
+      mainHypo->SetId(mainHypo->GetId() - firstId + newFirstId);
+    }
+    const ChartArcList *arcList = mainHypo->GetArcList();
+    if (arcList) {
+      ChartArcList::const_iterator iterArc;
+      for (iterArc = arcList->begin(); iterArc != arcList->end(); ++iterArc) {
+        ChartHypothesis *arc = *iterArc;
+        if (arc->GetId() >= firstId) {
+          arc->SetId(arc->GetId() - firstId + newFirstId);
+        }
+      }
+    }
+  }
+}
+
 void ChartHypothesisCollection::GetSearchGraph(long translationId, std::ostream &outputSearchGraphStream, const std::map<unsigned, bool> &reachable) const
 {
   HCType::const_iterator iter;
@@ -108,6 +108,7 @@ public:
 
   void SortHypotheses();
   void CleanupArcList();
+  void RenumberHypotheses(unsigned firstId, unsigned newFirstId);
 
   const HypoList &GetSortedHypotheses() const {
     return m_hyposOrdered;
@@ -30,6 +30,11 @@
 #include "StaticData.h"
 #include "DecodeStep.h"
 #include "TreeInput.h"
+#include "PhraseDictionary.h"
+
+#ifdef WITH_THREADS
+#include "ThreadPool.h"
+#endif
 
 using namespace std;
 using namespace Moses;
@@ -38,6 +43,32 @@ namespace Moses
 {
 extern bool g_debug;
 
+#ifdef WITH_THREADS
+/** Processes the cells of one width that are assigned to one search thread */
+class ChartCellTask : public Task
+{
+public:
+  ChartCellTask(ChartManager &manager, size_t width, size_t thread, TaskLatch &latch)
+    :m_manager(manager)
+    ,m_width(width)
+    ,m_thread(thread)
+    ,m_latch(latch)
+  {}
+
+  void Run() {
+    m_manager.m_system->InitializeSearchThread(m_manager.m_source);
+    m_manager.ProcessCellsForThread(m_width, m_thread);
+    m_latch.CountDown();
+  }
+
+private:
+  ChartManager &m_manager;
+  size_t m_width;
+  size_t m_thread;
+  TaskLatch &m_latch;
+};
+#endif
+
 ChartManager::ChartManager(InputType const& source, const TranslationSystem* system)
   :m_source(source)
   ,m_hypoStackColl(source, *this)
@@ -45,16 +76,33 @@ ChartManager::ChartManager(InputType const& source, const TranslationSystem* sys
   ,m_system(system)
   ,m_start(clock())
   ,m_hypothesisId(0)
+  ,m_searchThreadCount(1)
 {
   m_system->InitializeBeforeSentenceProcessing(source);
+  CreateRuleLookupManagers(m_ruleLookupManagers);
+
+#ifdef WITH_THREADS
+  // a dictionary that isn't thread safe belongs to the decoding thread only
+  m_searchThreadCount = StaticData::Instance().SearchThreadCount();
   const std::vector<PhraseDictionaryFeature*> &dictionaries = m_system->GetPhraseDictionaries();
-  m_ruleLookupManagers.reserve(dictionaries.size());
   for (std::vector<PhraseDictionaryFeature*>::const_iterator p = dictionaries.begin();
        p != dictionaries.end(); ++p) {
-    PhraseDictionaryFeature *pdf = *p;
-    const PhraseDictionary *dict = pdf->GetDictionary();
-    PhraseDictionary *nonConstDict = const_cast<PhraseDictionary*>(dict);
-    m_ruleLookupManagers.push_back(nonConstDict->CreateRuleLookupManager(source, m_hypoStackColl));
+    if (!(*p)->IsThreadSafe()) {
+      m_searchThreadCount = 1;
+    }
+  }
+  m_searchThreadCount = std::max<size_t>(1, std::min(m_searchThreadCount, source.GetSize()));
+
+  for (size_t thread = 1; thread < m_searchThreadCount; ++thread) {
+    std::vector<ChartRuleLookupManager*> *ruleLookupManagers = new std::vector<ChartRuleLookupManager*>;
+    CreateRuleLookupManagers(*ruleLookupManagers);
+    m_threadRuleLookupManagers.push_back(ruleLookupManagers);
+    m_threadTransOptColls.push_back(new ChartTranslationOptionCollection(source, system, m_hypoStackColl, *ruleLookupManagers));
+  }
+#endif
+
+  for (size_t thread = 0; thread < m_searchThreadCount; ++thread) {
+    m_arenas.push_back(boost::shared_ptr<Arena>(new Arena));
   }
 }
 
@@ -62,6 +110,11 @@ ChartManager::~ChartManager()
 {
   m_system->CleanUpAfterSentenceProcessing();
 
+  RemoveAllInColl(m_threadTransOptColls);
+  for (size_t i = 0; i < m_threadRuleLookupManagers.size(); ++i) {
+    RemoveAllInColl(*m_threadRuleLookupManagers[i]);
+  }
+  RemoveAllInColl(m_threadRuleLookupManagers);
   RemoveAllInColl(m_ruleLookupManagers);
 
   clock_t end = clock();
@@ -85,22 +138,14 @@ void ChartManager::ProcessSentence()
   // MAIN LOOP
   size_t size = m_source.GetSize();
   for (size_t width = 1; width <= size; ++width) {
+    if (m_searchThreadCount > 1 && width < size) {
+      ProcessWidthParallel(width);
+      continue;
+    }
     for (size_t startPos = 0; startPos <= size-width; ++startPos) {
       size_t endPos = startPos + width - 1;
       WordsRange range(startPos, endPos);
-
-      // create trans opt
-      m_transOptColl.CreateTranslationOptionsForRange(range);
-
-      // decode
-      ChartCell &cell = m_hypoStackColl.Get(range);
-
-      cell.ProcessSentence(m_transOptColl.GetTranslationOptionList()
-                           ,m_hypoStackColl);
-      m_transOptColl.Clear();
-      cell.PruneToSize();
-      cell.CleanupArcList();
-      cell.SortHypotheses();
+      ProcessCell(range, m_transOptColl, *m_arenas[0]);
     }
   }
 
@@ -125,6 +170,84 @@ void ChartManager::ProcessSentence()
   }
 }
 
+/** Create one rule lookup manager per phrase dictionary */
+void ChartManager::CreateRuleLookupManagers(std::vector<ChartRuleLookupManager*> &ruleLookupManagers)
+{
+  const std::vector<PhraseDictionaryFeature*> &dictionaries = m_system->GetPhraseDictionaries();
+  ruleLookupManagers.reserve(dictionaries.size());
+  for (std::vector<PhraseDictionaryFeature*>::const_iterator p = dictionaries.begin();
+       p != dictionaries.end(); ++p) {
+    PhraseDictionaryFeature *pdf = *p;
+    const PhraseDictionary *dict = pdf->GetDictionary();
+    PhraseDictionary *nonConstDict = const_cast<PhraseDictionary*>(dict);
+    ruleLookupManagers.push_back(nonConstDict->CreateRuleLookupManager(m_source, m_hypoStackColl));
+  }
+}
+
+/** Fill the chart cell for one span.
+ *  Only reads cells of narrower spans, so cells of the same width can be processed at the same time
+ *  as long as each uses its own translation option collection and arena.
+ */
+void ChartManager::ProcessCell(const WordsRange &range, ChartTranslationOptionCollection &transOptColl, Arena &arena)
+{
+  // create trans opt
+  transOptColl.CreateTranslationOptionsForRange(range);
+
+  // decode
+  ChartCell &cell = m_hypoStackColl.Get(range);
+
+  cell.ProcessSentence(transOptColl.GetTranslationOptionList()
+                       ,m_hypoStackColl
+                       ,arena);
+  transOptColl.Clear();
+  cell.PruneToSize();
+  cell.CleanupArcList();
+  cell.SortHypotheses();
+}
+
+/** Process the cells of the given width whose start position belongs to the given thread */
+void ChartManager::ProcessCellsForThread(size_t width, size_t thread)
+{
+  ChartTranslationOptionCollection &transOptColl = (thread == 0) ? m_transOptColl : *m_threadTransOptColls[thread - 1];
+  size_t size = m_source.GetSize();
+  for (size_t startPos = thread; startPos <= size-width; startPos += m_searchThreadCount) {
+    WordsRange range(startPos, startPos + width - 1);
+    ProcessCell(range, transOptColl, *m_arenas[thread]);
+  }
+}
+
+/** Process all cells of one width, spread over the search threads.
+ *  Returns when every cell of this width is complete, and its hypotheses
+ *  are numbered as in a serial search.
+ */
+void ChartManager::ProcessWidthParallel(size_t width)
+{
+  size_t numCells = m_source.GetSize() - width + 1;
+  const unsigned firstId = m_hypothesisId;
+  m_cellHypothesisIds.assign(numCells, firstId);
+
+#ifdef WITH_THREADS
+  size_t numThreads = std::min(m_searchThreadCount, numCells);
+  TaskLatch latch(numThreads - 1);
+  ThreadPool &pool = StaticData::Instance().GetSearchThreadPool();
+  for (size_t thread = 1; thread < numThreads; ++thread) {
+    pool.Submit(new ChartCellTask(*this, width, thread, latch));
+  }
+  ProcessCellsForThread(width, 0);
+  latch.Wait();
+#else
+  ProcessCellsForThread(width, 0);
+#endif
+
+  // a serial search numbers the cells one after the other, each in the order it creates hypotheses
+  for (size_t startPos = 0; startPos < numCells; ++startPos) {
+    WordsRange range(startPos, startPos + width - 1);
+    m_hypoStackColl.Get(range).RenumberHypotheses(firstId, m_hypothesisId);
+    m_hypothesisId += m_cellHypothesisIds[startPos] - firstId;
+  }
+  m_cellHypothesisIds.clear();
+}
+
 void ChartManager::AddXmlChartOptions() {
   const std::vector <ChartTranslationOption*> xmlChartOptionsList = m_source.GetXmlChartTranslationOptions();
   IFVERBOSE(2) { cerr << "AddXmlChartOptions " << xmlChartOptionsList.size() << endl; }
@@ -139,7 +262,9 @@ void ChartManager::AddXmlChartOptions() {
 
     const WordsRange &range = opt->GetSourceWordsRange();
     RuleCubeItem* item = new RuleCubeItem( *opt, m_hypoStackColl );
-    ChartHypothesis* hypo = new ChartHypothesis(*opt, *item, *this);
+    // from the arena of the thread that will prune the cell
+    Arena &arena = *m_arenas[range.GetStartPos() % m_searchThreadCount];
+    ChartHypothesis* hypo = ChartHypothesis::Create(*opt, *item, *this, arena);
     hypo->CalcScore();
     ChartCell &cell = m_hypoStackColl.Get(range);
     cell.AddHypothesis(hypo);
@@ -30,6 +30,7 @@
 #include "SentenceStats.h"
 #include "TranslationSystem.h"
 #include "ChartRuleLookupManager.h"
+#include "Arena.h"
 
 #include <boost/shared_ptr.hpp>
 
@@ -41,9 +42,11 @@ class ChartTrellisDetourQueue;
 class ChartTrellisNode;
 class ChartTrellisPath;
 class ChartTrellisPathList;
+class ChartCellTask;
 
 class ChartManager
 {
+  friend class ChartCellTask;
 private:
   static void CreateDeviantPaths(boost::shared_ptr<const ChartTrellisPath>,
                                  ChartTrellisDetourQueue &);
@@ -53,6 +56,10 @@ private:
                                  ChartTrellisDetourQueue &);
 
   InputType const& m_source; /**< source sentence to be translated */
+  // memory of the hypotheses, one arena per search thread. The cells of a
+  // start position only ever allocate and free hypotheses in the arena of
+  // the thread that processes them. Declared before the chart, which it must outlive
+  std::vector<boost::shared_ptr<Arena> > m_arenas;
   ChartCellCollection m_hypoStackColl;
   ChartTranslationOptionCollection m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   std::auto_ptr<SentenceStats> m_sentenceStats;
@@ -60,6 +67,21 @@ private:
   clock_t m_start; /**< starting time, used for logging */
   std::vector<ChartRuleLookupManager*> m_ruleLookupManagers;
   unsigned m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
+  // while the cells of a width are processed in parallel, the cell starting at position p hands out
+  // provisional ids from m_cellHypothesisIds[p] on, which all start at m_hypothesisId
+  std::vector<unsigned> m_cellHypothesisIds;
+
+  // -search-threads: cells starting at position p are processed by thread p % m_searchThreadCount.
+  // Thread 0 uses m_transOptColl and m_ruleLookupManagers, the others have their own below,
+  // since the rule lookup managers keep per start position state from one width to the next.
+  size_t m_searchThreadCount;
+  std::vector<std::vector<ChartRuleLookupManager*>*> m_threadRuleLookupManagers;
+  std::vector<ChartTranslationOptionCollection*> m_threadTransOptColls;
+
+  void CreateRuleLookupManagers(std::vector<ChartRuleLookupManager*> &ruleLookupManagers);
+  void ProcessCell(const WordsRange &range, ChartTranslationOptionCollection &transOptColl, Arena &arena);
+  void ProcessCellsForThread(size_t width, size_t thread);
+  void ProcessWidthParallel(size_t width);
 
 public:
   ChartManager(InputType const& source, const TranslationSystem* system);
@@ -90,7 +112,14 @@ public:
     m_sentenceStats = std::auto_ptr<SentenceStats>(new SentenceStats(source));
   }
 
-  unsigned GetNextHypoId() { return m_hypothesisId++; }
+  /** id for a new hypothesis of the cell for range. While cells are processed in parallel
+   *  the id is provisional and is replaced by ProcessWidthParallel() */
+  unsigned GetNextHypoId(const WordsRange &range) {
+    if (m_cellHypothesisIds.empty()) {
+      return m_hypothesisId++;
+    }
+    return m_cellHypothesisIds[range.GetStartPos()]++;
+  }
 };
 
 }
@@ -102,7 +102,7 @@ FFState* DistortionScoreProducer::Evaluate(
                                   hypo.GetCurrSourceWordsRange(),
                                   prev->first_gap);
   out->PlusEquals(this, distortionScore);
-  DistortionState_traditional* res = new DistortionState_traditional(
+  DistortionState_traditional* res = new(hypo.GetArena()) DistortionState_traditional(
     hypo.GetCurrSourceWordsRange(),
     hypo.GetPrevHypo()->GetWordsBitmap().GetFirstGapPos());
   return res;
@@ -6,207 +6,149 @@ using namespace std;
 namespace Moses
 {
 
-DynSuffixArray::DynSuffixArray()
+namespace
 {
-  m_SA = new vuint_t();
-  m_ISA = new vuint_t();
-  m_F = new vuint_t();
-  m_L = new vuint_t();
-  std::cerr << "DYNAMIC SUFFIX ARRAY CLASS INSTANTIATED" << std::endl;
-}
 
-DynSuffixArray::~DynSuffixArray()
+/* compares the suffixes at pos1 and pos2 on their first depth words, as if
+ * the corpus ended at end. A suffix that ends first is the smaller */
+int CompareSuffixes(const vuint_t& corpus, unsigned end, unsigned pos1, unsigned pos2, unsigned depth)
 {
-  delete m_SA;
-  delete m_ISA;
-  delete m_F;
-  delete m_L;
+  for (unsigned i = 0; i < depth; ++i) {
+    const bool end1 = pos1 + i >= end, end2 = pos2 + i >= end;
+    if (end1 || end2)
+      return (end2 ? 1 : 0) - (end1 ? 1 : 0);
+    if (corpus[pos1 + i] != corpus[pos2 + i])
+      return corpus[pos1 + i] < corpus[pos2 + i] ? -1 : 1;
+  }
+  return 0;
 }
 
-DynSuffixArray::DynSuffixArray(vuint_t* crp)
+/* compares the suffix at pos with the first length words of the phrase */
+int CompareToPhrase(const vuint_t& corpus, unsigned end, unsigned pos, const vuint_t& phrase, unsigned length)
 {
-  // make native int array and pass to SA builder
-  m_corpus = crp;
-  int size = m_corpus->size();
-  int* tmpArr = new int[size];
-  for(int i=0 ; i < size; ++i) tmpArr[i] = i;
-
-  Qsort(tmpArr, 0, size-1);
-
-  m_SA = new vuint_t(tmpArr, tmpArr + size);
-  //std::cerr << "printing SA " << std::endl;
-  //for(int i=0; i < size; ++i) std::cerr << m_SA->at(i) << std::endl;
-  delete[] tmpArr;
-  std::cerr << "DYNAMIC SUFFIX ARRAY CLASS INSTANTIATED WITH SIZE " << size << std::endl;
-  BuildAuxArrays();
-  //printAuxArrays();
+  for (unsigned i = 0; i < length; ++i) {
+    if (pos + i >= end)
+      return -1;
+    if (corpus[pos + i] != phrase[i])
+      return corpus[pos + i] < phrase[i] ? -1 : 1;
+  }
+  return 0;
 }
 
-void DynSuffixArray::BuildAuxArrays()
+class SuffixLess
 {
-  int size = m_SA->size();
-  m_ISA = new vuint_t(size);
-  m_F = new vuint_t(size);
-  m_L = new vuint_t(size);
-
-  for(int i=0; i < size; ++i) {
-    m_ISA->at(m_SA->at(i)) = i;
-    //(*m_ISA)[(*m_SA)[i]] = i;
-    (*m_F)[i] = (*m_corpus)[m_SA->at(i)];
-    (*m_L)[i] = (*m_corpus)[(m_SA->at(i) == 0 ? size-1 : m_SA->at(i)-1)];
+public:
+  SuffixLess(const vuint_t& corpus, unsigned end, unsigned depth)
+    : m_corpus(corpus), m_end(end), m_depth(depth) {}
+  bool operator()(unsigned pos1, unsigned pos2) const {
+    return CompareSuffixes(m_corpus, m_end, pos1, pos2, m_depth) < 0;
   }
+private:
+  const vuint_t& m_corpus;
+  unsigned m_end, m_depth;
+};
+
 }
 
-int DynSuffixArray::Rank(unsigned word, unsigned idx)
+const unsigned DynSuffixArray::MAX_DEPTH;
+
+DynSuffixArray::DynSuffixArray()
+  : m_corpus(NULL)
+  , m_runs(new Runs())
 {
-  /* use Gerlach's code to make rank faster */
-  // the number of words in L[0..i] (minus 1 which is why 'i < idx', not '<=')
-  int r(0);
-  for(unsigned i=0; i < idx; ++i)
-    if(m_L->at(i) == word) ++r;
-  return r;
+  std::cerr << "DYNAMIC SUFFIX ARRAY CLASS INSTANTIATED" << std::endl;
 }
 
-/* count function should be implemented
- * with binary search over suffix array!! */
-int DynSuffixArray::F_firstIdx(unsigned word)
+DynSuffixArray::~DynSuffixArray()
 {
-  // return index of first row where word is found in m_F
-  /*for(int i=0; i < m_F->size(); ++i) {
-    if(m_F->at(i) == word) {
-      return i; 
-    }
-  }
-  return -1;*/
-  //NOTE: lower_bound  is faster than linear search above but may cause issues 
-  //      if ordering of vocab is not consecutive (ie..after deletions) 
-  int low = std::lower_bound(m_F->begin(), m_F->end(), word) - m_F->begin();
-  //cerr << "in F_firstIdx with word = " << word << " and low = " << low <<  " and F->size() =" << m_F->size() << endl;
-  if((size_t)low >= m_F->size())
-    return -1;
-  else
-    return low;
 }
 
-/* uses rank() and c() to obtain the LastFirstFunc function */
-int DynSuffixArray::LastFirstFunc(unsigned L_idx)
+DynSuffixArray::DynSuffixArray(vuint_t* crp)
+  : m_corpus(crp)
 {
-  int fIdx(-1);
-  //cerr << "in LastFirstFcn() with L_idx = " << L_idx << endl;
-  unsigned word = m_L->at(L_idx);
-  if((fIdx = F_firstIdx(word)) != -1) {
-    //cerr << "fidx + Rank(" << word << "," << L_idx << ") = " << fIdx << "+" << Rank(word, L_idx) << endl;
-    fIdx += Rank(word, L_idx);
+  Runs* runs = new Runs();
+  if (!m_corpus->empty()) {
+    runs->push_back(MakeRun(0, m_corpus->size()));
   }
-  return fIdx;
+  m_runs.reset(runs);
+  std::cerr << "DYNAMIC SUFFIX ARRAY CLASS INSTANTIATED WITH SIZE " << m_corpus->size() << std::endl;
 }
 
-void DynSuffixArray::Insert(vuint_t* newSent, unsigned newIndex)
+boost::shared_ptr<const DynSuffixArray::Runs> DynSuffixArray::GetRuns() const
 {
-  // for sentences
-  //stages 1, 2, 4 stay same from 1char case
-  //(use last word of new text in step 2 and save Ltmp until last insert?)
-  //stage 3...all words of new sentence are inserted backwards
-  // stage 2: k=ISA[newIndex], tmp= L[k], L[k]  = newChar
-  //PrintAuxArrays();
-  CHECK(newIndex <= m_SA->size());
-  int k(-1), kprime(-1);
-  k = (newIndex < m_SA->size() ? m_ISA->at(newIndex) : m_ISA->at(0)); // k is now index of the cycle that starts at newindex
-  int true_pos = LastFirstFunc(k); // track cycle shift (newIndex - 1)
-  int Ltmp = m_L->at(k);
-  m_L->at(k) = newSent->at(newSent->size()-1);  // cycle k now ends with correct word
-  for(int j = newSent->size()-1; j > -1; --j) {
-    kprime = LastFirstFunc(k);  // find cycle that starts with (newindex - 1)
-    //kprime += ((m_L[k] == Ltmp) && (k > isa[k]) ? 1 : 0); // yada yada
-    // only terminal char can be 0 so add new vocab at end
-    kprime = (kprime > 0 ? kprime : m_SA->size());
-    true_pos += (kprime <= true_pos ? 1 : 0); // track changes
-    // insert everything
-    m_F->insert(m_F->begin() + kprime, newSent->at(j));
-    int theLWord = (j == 0 ? Ltmp : newSent->at(j-1));
-
-    m_L->insert(m_L->begin() + kprime, theLWord);
-    for (vuint_t::iterator itr = m_SA->begin(); itr != m_SA->end(); ++itr) {
-      if(*itr >= newIndex) ++(*itr);
-    }
-    m_SA->insert(m_SA->begin() + kprime, newIndex);
-    for (vuint_t::iterator itr = m_ISA->begin(); itr != m_ISA->end(); ++itr) {
-      if((int)*itr >= kprime) ++(*itr);
-    }
-
-    m_ISA->insert(m_ISA->begin() + newIndex, kprime);
-    k = kprime;
-    //PrintAuxArrays();
-  }
-  // Begin stage 4
-  Reorder(true_pos, LastFirstFunc(kprime)); // actual position vs computed position of cycle (newIndex-1)
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_runsMutex);
+#endif
+  return m_runs;
 }
 
-void DynSuffixArray::Reorder(unsigned j, unsigned jprime)
+void DynSuffixArray::SetRuns(const boost::shared_ptr<const Runs>& runs)
 {
-  set<pair<unsigned, unsigned> > seen;
-  while(j != jprime) {
-    // this 'seenit' check added for data with many loops. will remove after double 
-    // checking.  
-    bool seenit = seen.insert(std::make_pair(j, jprime)).second;
-    if(seenit) {
-      for(size_t i=1; i < m_SA->size(); ++i) {
-        if(m_corpus->at(m_SA->at(i)) < m_corpus->at(m_SA->at(i-1))) {
-          cerr << "PROBLEM WITH SUFFIX ARRAY REORDERING. EXITING...\n";
-          exit(1);
-        }
-      }
-      return;
-    }
-    //cerr << "j=" << j << "\tj'=" << jprime << endl;
-    int isaIdx(-1);
-    int new_j = LastFirstFunc(j);
-    CHECK(j <= jprime);
-    // for SA and L, the element at pos j is moved to pos j'
-    m_L->insert(m_L->begin() + jprime + 1, m_L->at(j)); 
-    m_L->erase(m_L->begin() + j);
-    m_SA->insert(m_SA->begin() + jprime + 1, m_SA->at(j)); 
-    m_SA->erase(m_SA->begin() + j);
-    // all ISA values between (j...j'] decremented
-    for(size_t i = 0; i < m_ISA->size(); ++i) {
-      if((m_ISA->at(i) == j) && (isaIdx == -1))
-        isaIdx = i; // store index of ISA[i] = j
-      if((m_ISA->at(i) > j) && (m_ISA->at(i) <= jprime)) --(*m_ISA)[i];
-    }
-    // replace j with j' in ISA
-    //isa[isaIdx] = jprime;
-    m_ISA->at(isaIdx) = jprime;
-    j = new_j;
-    jprime = LastFirstFunc(jprime);
-  }
-  //cerr << "j=" << j << "\tj'=" << jprime << endl;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_runsMutex);
+#endif
+  m_runs = runs;
 }
 
-void DynSuffixArray::Delete(unsigned index, unsigned num2del)
+DynSuffixArray::RunPtr DynSuffixArray::MakeRun(unsigned begin, unsigned end) const
 {
-  int ltmp = m_L->at(m_ISA->at(index));
-  int true_pos = LastFirstFunc(m_ISA->at(index)); // track cycle shift (newIndex - 1)
-  for(size_t q = 0; q < num2del; ++q) {
-    int row = m_ISA->at(index); // gives the position of index in SA and m_F
-    //std::cerr << "row = " << row << std::endl;
-    //std::cerr << "SA[r]/index = " << m_SA->at(row) << "/" << index << std::endl;
-    true_pos -= (row <= true_pos ? 1 : 0); // track changes
-    m_L->erase(m_L->begin() + row);
-    m_F->erase(m_F->begin() + row);
+  Run* run = new Run();
+  run->m_corpusEnd = end;
+  run->m_SA.resize(end - begin);
+  for (unsigned i = begin; i < end; ++i) {
+    run->m_SA[i - begin] = i;
+  }
+  std::sort(run->m_SA.begin(), run->m_SA.end(), SuffixLess(*m_corpus, end, MAX_DEPTH));
+  return RunPtr(run);
+}
+
+DynSuffixArray::RunPtr DynSuffixArray::Merge(const Run& older, const Run& newer) const
+{
+  // the first words of suffixes close to the end of the older run changed
+  // when the newer sentences were appended, those are sorted again
+  const unsigned end = newer.m_corpusEnd;
+  const SuffixLess less(*m_corpus, end, MAX_DEPTH);
+  vuint_t clean, moved;
+  clean.reserve(older.m_SA.size());
+  for (vuint_t::const_iterator itr = older.m_SA.begin(); itr != older.m_SA.end(); ++itr) {
+    if (*itr + MAX_DEPTH > older.m_corpusEnd)
+      moved.push_back(*itr);
+    else
+      clean.push_back(*itr);
+  }
+  std::sort(moved.begin(), moved.end(), less);
 
-    m_ISA->erase(m_ISA->begin() + index);  // order is important
-    for (vuint_t::iterator itr = m_ISA->begin(); itr != m_ISA->end(); ++itr) {
-      if((int)*itr > row) --(*itr);
-    }
+  vuint_t merged(clean.size() + newer.m_SA.size());
+  std::merge(clean.begin(), clean.end(), newer.m_SA.begin(), newer.m_SA.end(), merged.begin(), less);
+  Run* run = new Run();
+  run->m_corpusEnd = end;
+  run->m_SA.resize(merged.size() + moved.size());
+  std::merge(merged.begin(), merged.end(), moved.begin(), moved.end(), run->m_SA.begin(), less);
+  return RunPtr(run);
+}
 
-    m_SA->erase(m_SA->begin() + row);
-    for (vuint_t::iterator itr = m_SA->begin(); itr != m_SA->end(); ++itr) {
-      if(*itr > index) --(*itr);
-    }
+void DynSuffixArray::Insert(vuint_t* newSent, unsigned newIndex)
+{
+  // sentences are only ever appended to the corpus
+  CHECK(m_corpus != NULL);
+  CHECK(newIndex + newSent->size() == m_corpus->size());
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_writeMutex);
+#endif
+  boost::shared_ptr<const Runs> current = GetRuns();
+  Runs* runs = new Runs(*current);
+  runs->push_back(MakeRun(newIndex, m_corpus->size()));
+
+  // merge while the newest run is at least half the size of the one before,
+  // so each suffix is merged a logarithmic number of times
+  while (runs->size() > 1 &&
+         2 * runs->back()->m_SA.size() >= (*runs)[runs->size() - 2]->m_SA.size()) {
+    RunPtr newer = runs->back();
+    runs->pop_back();
+    RunPtr older = runs->back();
+    runs->back() = Merge(*older, *newer);
   }
-  m_L->at(m_ISA->at(index))= ltmp;
-  Reorder(LastFirstFunc(m_ISA->at(index)), true_pos);
-  //PrintAuxArrays();
+  SetRuns(boost::shared_ptr<const Runs>(runs));
 }
 
 void DynSuffixArray::Substitute(vuint_t* /* newSents */, unsigned /* newIndex */)
@@ -215,99 +157,69 @@ void DynSuffixArray::Substitute(vuint_t* /* newSents */, unsigned /* newIndex */
   return;
 }
 
-bool DynSuffixArray::GetCorpusIndex(const vuint_t* phrase, vuint_t* indices)
+void DynSuffixArray::FindInRun(const Run& run, const vuint_t& phrase, vuint_t& indices) const
 {
-  pair<vuint_t::iterator,vuint_t::iterator> bounds;
-  indices->clear();
-  size_t phrasesize = phrase->size();
-  // find lower and upper bounds on phrase[0]
-  bounds = std::equal_range(m_F->begin(), m_F->end(), phrase->at(0));
-  // bounds holds first and (last + 1) index of phrase[0] in m_SA
-  size_t lwrBnd = size_t(bounds.first - m_F->begin());
-  size_t uprBnd = size_t(bounds.second - m_F->begin());
-  //cerr << "phrasesize = " << phrasesize << "\tuprBnd = " << uprBnd << "\tlwrBnd = " << lwrBnd;
-  //cerr << "\tcorpus size =  " << m_corpus->size() << endl;
-  if(uprBnd - lwrBnd == 0) return false;  // not found
-  if(phrasesize == 1) {
-    for(size_t i=lwrBnd; i < uprBnd; ++i) {
-      indices->push_back(m_SA->at(i));
-    }
-    return (indices->size() > 0);
+  const vuint_t& corpus = *m_corpus;
+  const unsigned length = phrase.size();
+  const unsigned depth = std::min(length, MAX_DEPTH);
+
+  // binary search for the suffixes starting with the phrase, words beyond
+  // the depth the run is sorted on are checked one by one
+  size_t first = 0, last = run.m_SA.size();
+  while (first < last) {
+    size_t middle = first + (last - first) / 2;
+    if (CompareToPhrase(corpus, run.m_corpusEnd, run.m_SA[middle], phrase, depth) < 0)
+      first = middle + 1;
+    else
+      last = middle;
   }
-  //find longer phrases if they exist
-  for(size_t i = lwrBnd; i < uprBnd; ++i) {
-    size_t crpIdx = m_SA->at(i);
-    if((crpIdx + phrasesize) > m_corpus->size()) continue; // past end of corpus
-    for(size_t pos = 1; pos < phrasesize; ++pos) { // for all following words
-      if(m_corpus->at(crpIdx + pos) != phrase->at(pos)) {  // if word doesn't match
-        if(indices->size() > 0) i = uprBnd;  // past the phrases since SA is ordered
-        break;
-      } else if(pos == phrasesize-1) { // found phrase
-        indices->push_back(crpIdx + pos);  // store rigthmost index of phrase
-      }
-    }
+  for (size_t i = first; i < run.m_SA.size(); ++i) {
+    const unsigned crpIdx = run.m_SA[i];
+    if (CompareToPhrase(corpus, run.m_corpusEnd, crpIdx, phrase, depth) != 0)
+      break;
+    if (length > depth && CompareToPhrase(corpus, run.m_corpusEnd, crpIdx, phrase, length) != 0)
+      continue;
+    indices.push_back(crpIdx + length - 1);  // store rigthmost index of phrase
   }
-  //cerr << "Total count of phrase = " << indices->size() << endl;
-  return (indices->size() > 0);
-}
 
-void DynSuffixArray::Save(FILE* fout)
-{
-  fWriteVector(fout, *m_SA);
+  // the run was sorted as if the corpus ended with it, so occurrences that
+  // go on into sentences appended later are looked for one by one
+  const unsigned begin = run.m_corpusEnd - run.m_SA.size();
+  const unsigned tail = run.m_corpusEnd - std::min(run.m_corpusEnd - begin, length - 1);
+  for (unsigned crpIdx = tail; crpIdx < run.m_corpusEnd; ++crpIdx) {
+    if (CompareToPhrase(corpus, corpus.size(), crpIdx, phrase, length) == 0)
+      indices.push_back(crpIdx + length - 1);
+  }
 }
 
-void DynSuffixArray::Load(FILE* fin)
+bool DynSuffixArray::GetCorpusIndex(const vuint_t* phrase, vuint_t* indices) const
 {
-  fReadVector(fin, *m_SA);
+  indices->clear();
+  if (phrase->empty()) return false;
+  boost::shared_ptr<const Runs> runs = GetRuns();
+  for (Runs::const_iterator itr = runs->begin(); itr != runs->end(); ++itr) {
+    FindInRun(**itr, *phrase, *indices);
+  }
+  return (indices->size() > 0);
 }
 
-int DynSuffixArray::Compare(int pos1, int pos2, int max)
+void DynSuffixArray::Save(FILE* fout)
 {
-  for (size_t i = 0; i < (unsigned)max; ++i) {
-    if((pos1 + i < m_corpus->size()) && (pos2 + i >= m_corpus->size()))
-      return 1;
-    if((pos2 + i < m_corpus->size()) && (pos1 + i >= m_corpus->size()))
-      return -1;
-
-    int diff = m_corpus->at(pos1+i) - m_corpus->at(pos2+i);
-    if(diff != 0) return diff;
+  // written as one run
+  boost::shared_ptr<const Runs> runs = GetRuns();
+  RunPtr all(new Run());
+  for (Runs::const_iterator itr = runs->begin(); itr != runs->end(); ++itr) {
+    all = Merge(*all, **itr);
   }
-  return 0;
+  fWriteVector(fout, all->m_SA);
 }
 
-void DynSuffixArray::Qsort(int* array, int begin, int end)
+void DynSuffixArray::Load(FILE* fin)
 {
-  if(end > begin) {
-    int index;
-    {
-      index = begin + (rand() % (end - begin + 1));
-      int pivot = array[index];
-      {
-        int tmp = array[index];
-        array[index] = array[end];
-        array[end] = tmp;
-      }
-      for(int i=index=begin; i < end; ++i) {
-        if (Compare(array[i], pivot, 20) <= 0) {
-          {
-            int tmp = array[index];
-            array[index] = array[i];
-            array[i] = tmp;
-            index++;
-          }
-        }
-      }
-      {
-        int tmp = array[index];
-        array[index] = array[end];
-        array[end] = tmp;
-      }
-    }
-    Qsort(array, begin, index - 1);
-    Qsort(array, index + 1,  end);
-  }
+  Run* run = new Run();
+  fReadVector(fin, run->m_SA);
+  run->m_corpusEnd = m_corpus ? m_corpus->size() : run->m_SA.size();
+  SetRuns(boost::shared_ptr<const Runs>(new Runs(1, RunPtr(run))));
 }
 
-
-
 } // end namespace
@@ -5,15 +5,31 @@
 #include <set>
 #include <algorithm>
 #include <utility>
+#include <boost/shared_ptr.hpp>
 #include "Util.h"
 #include "File.h"
 #include "DynSAInclude/types.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace Moses
 {
 
 typedef std::vector<unsigned> vuint_t;
 
+/** Suffix array of a corpus that sentences are appended to.
+ *  The suffixes are kept in runs, each sorted on its own and never changed
+ *  once made: a large one for the corpus that was loaded, and smaller ones for
+ *  the sentences added since. A new sentence becomes a run of its own, and
+ *  runs of similar size are merged into a new run, so there are only
+ *  logarithmically many. Lookups work on a snapshot of the list of runs, so
+ *  they are never held up by an insertion, which builds new runs on the side
+ *  and publishes them when done.
+ *  Suffixes are ordered by their first MAX_DEPTH words, as far as the corpus
+ *  reached when their run was made.
+ */
 class DynSuffixArray
 {
 
@@ -21,31 +37,37 @@ public:
   DynSuffixArray();
   DynSuffixArray(vuint_t*);
   ~DynSuffixArray();
-  bool GetCorpusIndex(const vuint_t*, vuint_t*);
+  //! positions of the last word of each occurrence of the phrase
+  bool GetCorpusIndex(const vuint_t*, vuint_t*) const;
   void Load(FILE*);
   void Save(FILE*);
+  //! add the suffixes of the sentence the corpus ends with, which starts at newIndex
   void Insert(vuint_t*, unsigned);
-  void Delete(unsigned, unsigned);
   void Substitute(vuint_t*, unsigned);
 
 private:
-  vuint_t* m_SA;
-  vuint_t* m_ISA;
-  vuint_t* m_F;
-  vuint_t* m_L;
+  static const unsigned MAX_DEPTH = 20;
+
+  struct Run {
+    vuint_t m_SA;
+    unsigned m_corpusEnd; /**< size of the corpus when the run was sorted */
+    Run() : m_corpusEnd(0) {}
+  };
+  typedef boost::shared_ptr<const Run> RunPtr;
+  typedef std::vector<RunPtr> Runs; /**< oldest and largest first */
+
   vuint_t* m_corpus;
-  void BuildAuxArrays();
-  void Qsort(int* array, int begin, int end);
-  int Compare(int, int, int);
-  void Reorder(unsigned, unsigned);
-  int LastFirstFunc(unsigned);
-  int Rank(unsigned, unsigned);
-  int F_firstIdx(unsigned);
-  void PrintAuxArrays() {
-    std::cerr << "SA\tISA\tF\tL\n";
-    for(size_t i=0; i < m_SA->size(); ++i)
-      std::cerr << m_SA->at(i) << "\t" << m_ISA->at(i) << "\t" << m_F->at(i) << "\t" << m_L->at(i) << std::endl;
-  }
+  boost::shared_ptr<const Runs> m_runs;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_runsMutex; /**< held only to copy or replace m_runs */
+  boost::mutex m_writeMutex; /**< serialises insertions */
+#endif
+
+  boost::shared_ptr<const Runs> GetRuns() const;
+  void SetRuns(const boost::shared_ptr<const Runs>& runs);
+  RunPtr MakeRun(unsigned begin, unsigned end) const;
+  RunPtr Merge(const Run& older, const Run& newer) const;
+  void FindInRun(const Run& run, const vuint_t& phrase, vuint_t& indices) const;
 };
 
 } //end namespace
@@ -0,0 +1,81 @@
+#include "DynSuffixArray.h"
+
+#define BOOST_TEST_MODULE MosesDynSuffixArray
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+using namespace Moses;
+
+namespace {
+
+const unsigned VOCAB = 4;
+
+// the positions the suffix array held for the whole corpus, which the runs
+// have to find between them
+vuint_t ScanCorpus(const vuint_t &corpus, const vuint_t &phrase) {
+  vuint_t indices;
+  for (size_t pos = 0; pos + phrase.size() <= corpus.size(); ++pos) {
+    if (equal(phrase.begin(), phrase.end(), corpus.begin() + pos))
+      indices.push_back(pos + phrase.size() - 1);
+  }
+  return indices;
+}
+
+void CheckLookup(const DynSuffixArray &sa, const vuint_t &corpus, const vuint_t &phrase) {
+  vuint_t expected = ScanCorpus(corpus, phrase), indices;
+  BOOST_CHECK_EQUAL(!expected.empty(), sa.GetCorpusIndex(&phrase, &indices));
+  sort(indices.begin(), indices.end());
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(expected.begin(), expected.end(), indices.begin(), indices.end());
+}
+
+// every phrase of up to three words over the vocabulary, and the ones in
+// the corpus that are longer than the words suffixes are sorted on
+void CheckAllLookups(const DynSuffixArray &sa, const vuint_t &corpus) {
+  for (unsigned i = 0; i < VOCAB * VOCAB * VOCAB; ++i) {
+    vuint_t phrase;
+    for (unsigned w = i; phrase.size() < 3; w /= VOCAB)
+      phrase.push_back(w % VOCAB);
+    for (size_t length = 1; length <= phrase.size(); ++length)
+      CheckLookup(sa, corpus, vuint_t(phrase.begin(), phrase.begin() + length));
+  }
+  for (size_t pos = 0; pos + 25 <= corpus.size(); pos += 37)
+    CheckLookup(sa, corpus, vuint_t(corpus.begin() + pos, corpus.begin() + pos + 25));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(insert_and_lookup) {
+  unsigned seed = 1;
+  vuint_t corpus;
+  for (size_t i = 0; i < 500; ++i) {
+    seed = seed * 1103515245 + 12345;
+    corpus.push_back((seed >> 16) % VOCAB);
+  }
+  DynSuffixArray sa(&corpus);
+  CheckAllLookups(sa, corpus);
+
+  // sentences of varying length, so that runs are merged at many sizes
+  for (size_t sentence = 0; sentence < 60; ++sentence) {
+    const unsigned newIndex = corpus.size();
+    vuint_t words;
+    for (size_t i = 0; i < 1 + sentence % 30; ++i) {
+      seed = seed * 1103515245 + 12345;
+      words.push_back((seed >> 16) % VOCAB);
+    }
+    corpus.insert(corpus.end(), words.begin(), words.end());
+    sa.Insert(&words, newIndex);
+    CheckAllLookups(sa, corpus);
+  }
+
+  FILE *file = tmpfile();
+  BOOST_REQUIRE(file != NULL);
+  sa.Save(file);
+  rewind(file);
+  DynSuffixArray loaded(&corpus);
+  loaded.Load(file);
+  fclose(file);
+  CheckAllLookups(loaded, corpus);
+}
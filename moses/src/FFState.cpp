@@ -1,9 +1,46 @@
+#include <new>
 #include "FFState.h"
+#include "Arena.h"
 
 namespace Moses
 {
 
+namespace
+{
+
+// in front of each state, where it came from
+struct Header {
+  Arena *arena;
+  size_t size;
+};
+
+// keeps the state aligned as the arena aligns
+const size_t HEADER_SIZE = 16;
+
+}
+
 FFState::~FFState() {}
 
+void *FFState::Allocate(size_t size, Arena *arena)
+{
+  size += HEADER_SIZE;
+  Header *header = static_cast<Header*>(arena ? arena->Allocate(size) : ::operator new(size));
+  header->arena = arena;
+  header->size = size;
+  return reinterpret_cast<char*>(header) + HEADER_SIZE;
 }
 
+void FFState::operator delete(void *ptr)
+{
+  if (ptr == NULL) {
+    return;
+  }
+  Header *header = reinterpret_cast<Header*>(static_cast<char*>(ptr) - HEADER_SIZE);
+  if (header->arena) {
+    header->arena->Free(header, header->size);
+  } else {
+    ::operator delete(header);
+  }
+}
+
+}
@@ -2,17 +2,40 @@
 #define moses_FFState_h
 
 #include "util/check.hh"
+#include <cstddef>
 #include <vector>
 
 
 namespace Moses
 {
 
+class Arena;
+
+/** State of a stateful feature function at the end of a hypothesis.
+ *  The states of a hypothesis are allocated with new(hypo.GetArena()) from the
+ *  arena of the hypothesis, with a NULL arena from the heap. delete gives the
+ *  memory back to where it came from, so owners don't need to know which.
+ */
 class FFState
 {
 public:
   virtual ~FFState();
   virtual int Compare(const FFState& other) const = 0;
+
+  static void *operator new(size_t size) {
+    return Allocate(size, NULL);
+  }
+  static void *operator new(size_t size, Arena *arena) {
+    return Allocate(size, arena);
+  }
+  static void operator delete(void *ptr);
+  //! only called if a constructor throws
+  static void operator delete(void *ptr, Arena *) {
+    operator delete(ptr);
+  }
+
+private:
+  static void *Allocate(size_t size, Arena *arena);
 };
 
 }
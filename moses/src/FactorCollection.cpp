@@ -19,9 +19,9 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
-#include <boost/version.hpp>
 #include <ostream>
 #include <string>
+#include "util/check.hh"
 #include "FactorCollection.h"
 #include "Util.h"
 
@@ -31,42 +31,134 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
+namespace
+{
+// everything written before a factor or table is published must be visible
+// to the threads that find it. Readers need no barrier: they only follow
+// the published pointers
+inline void PublishBarrier()
+{
+  __sync_synchronize();
+}
+
+const size_t INITIAL_TABLE_SIZE = 1 << 12;
+}
+
+FactorCollection::Table::Table(size_t size)
+  :m_slots(new const Factor *volatile[size])
+  ,m_mask(size - 1)
+{
+  CHECK((size & m_mask) == 0);
+  for (size_t i = 0; i < size; ++i) {
+    m_slots[i] = NULL;
+  }
+}
+
+FactorCollection::Table::~Table()
+{
+  delete [] m_slots;
+}
+
+FactorCollection::FactorCollection()
+{
+  Table *table = new Table(INITIAL_TABLE_SIZE);
+  m_tables.push_back(table);
+  m_table = table;
+}
+
+FactorCollection::~FactorCollection()
+{
+  RemoveAllInColl(m_tables);
+  RemoveAllInColl(m_factors);
+}
+
+const Factor *FactorCollection::Find(const Table &table, const StringPiece &str, size_t hash)
+{
+  for (size_t i = hash & table.m_mask; ; i = (i + 1) & table.m_mask) {
+    const Factor *factor = table.m_slots[i];
+    if (factor == NULL) {
+      return NULL;
+    }
+    if (StringPiece(factor->GetString()) == str) {
+      return factor;
+    }
+  }
+}
+
+const Factor *FactorCollection::Insert(const StringPiece &str, size_t hash)
+{
+  // another thread may have added it since the caller looked
+  const Factor *found = Find(*m_table, str, hash);
+  if (found) {
+    return found;
+  }
+
+  // keep the table at most half full, so probes stay short and end
+  if ((m_factors.size() + 1) * 2 > m_table->m_mask + 1) {
+    Table *bigger = new Table((m_table->m_mask + 1) * 2);
+    for (size_t id = 0; id < m_factors.size(); ++id) {
+      const Factor *factor = m_factors[id];
+      size_t i = Hash(factor->GetString()) & bigger->m_mask;
+      while (bigger->m_slots[i] != NULL) {
+        i = (i + 1) & bigger->m_mask;
+      }
+      bigger->m_slots[i] = factor;
+    }
+    m_tables.push_back(bigger);
+    PublishBarrier();
+    m_table = bigger;
+  }
+
+  Factor *factor = new Factor;
+  factor->m_string.assign(str.data(), str.size());
+  factor->m_id = m_factors.size();
+  m_factors.push_back(factor);
+
+  Table &table = *m_table;
+  size_t i = hash & table.m_mask;
+  while (table.m_slots[i] != NULL) {
+    i = (i + 1) & table.m_mask;
+  }
+  PublishBarrier();
+  table.m_slots[i] = factor;
+  return factor;
+}
+
 const Factor *FactorCollection::AddFactor(const StringPiece &factorString)
 {
-// Sorry this is so complicated.  Can't we just require everybody to use Boost >= 1.42?  The issue is that I can't check BOOST_VERSION unless we have Boost.  
+  const size_t hash = Hash(factorString);
+  const Factor *ret = Find(*m_table, factorString, hash);
+  if (ret) {
+    return ret;
+  }
 #ifdef WITH_THREADS
-#if BOOST_VERSION < 104200
-  FactorFriend to_ins;
-  to_ins.in.m_string.assign(factorString.data(), factorString.size());
-#endif // BOOST_VERSION
-  {
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#if BOOST_VERSION >= 104200
-    // If this line doesn't compile, upgrade your Boost.  
-    Set::const_iterator i = m_set.find(factorString, HashFactor(), EqualsFactor());
-#else // BOOST_VERSION
-    Set::const_iterator i = m_set.find(to_ins);
-#endif // BOOST_VERSION
-    if (i != m_set.end()) return &i->in;
+  boost::mutex::scoped_lock lock(m_insertLock);
+#endif
+  return Insert(factorString, hash);
+}
+
+void FactorCollection::AddFactors(const std::vector<StringPiece> &factorStrings, std::vector<const Factor*> &factors)
+{
+  factors.resize(factorStrings.size());
+  const Table &table = *m_table;
+  bool missing = false;
+  for (size_t i = 0; i < factorStrings.size(); ++i) {
+    factors[i] = Find(table, factorStrings[i], Hash(factorStrings[i]));
+    missing = missing || factors[i] == NULL;
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#if BOOST_VERSION >= 104200
-  FactorFriend to_ins;
-  to_ins.in.m_string.assign(factorString.data(), factorString.size());
-#endif // BOOST_VERSION
-#else // WITH_THREADS
-  FactorFriend to_ins;
-  to_ins.in.m_string.assign(factorString.data(), factorString.size());
-#endif // WITH_THREADS
-  to_ins.in.m_id = m_factorId;
-  std::pair<Set::iterator, bool> ret(m_set.insert(to_ins));
-  if (ret.second) {
-    m_factorId++;
+  if (!missing) {
+    return;
   }
-  return &ret.first->in;
-}
 
-FactorCollection::~FactorCollection() {}
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_insertLock);
+#endif
+  for (size_t i = 0; i < factorStrings.size(); ++i) {
+    if (factors[i] == NULL) {
+      factors[i] = Insert(factorStrings[i], Hash(factorStrings[i]));
+    }
+  }
+}
 
 TO_STRING_BODY(FactorCollection);
 
@@ -74,10 +166,10 @@ TO_STRING_BODY(FactorCollection);
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
+  boost::mutex::scoped_lock lock(factorCollection.m_insertLock);
 #endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin(); i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+  for (size_t id = 0; id < factorCollection.m_factors.size(); ++id) {
+    out << *factorCollection.m_factors[id];
   }
   return out;
 }
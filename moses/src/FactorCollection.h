@@ -23,14 +23,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_FactorCollection_h
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #endif
 
 #include "util/murmur_hash.hh"
-#include <boost/unordered_set.hpp>
 
-#include <functional>
 #include <string>
+#include <vector>
 
 #include "util/string_piece.hh"
 #include "Factor.h"
@@ -38,17 +37,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses
 {
 
-/* We don't want Factor to be copyable by anybody.  But we also want to store
- * it in an STL container.  The solution is that Factor's copy constructor is
- * private and friended to FactorFriend.  The STL containers can delegate
- * copying, so friending the container isn't sufficient.  STL containers see
- * FactorFriend's public copy constructor and everybody else sees Factor's
- * private copy constructor.  
- */
-struct FactorFriend {
-  Factor in;
-};
-
 /** collection of factors
  *
  * All Factors in moses are accessed and created by a FactorCollection.
@@ -56,45 +44,50 @@ struct FactorFriend {
  * from being created on the stack, etc), their memory addresses can
  * be used as keys to uniquely identify them.
  * Only 1 FactorCollection object should be created.
+ *
+ * Looking up a factor that already exists takes no lock: the factors are
+ * kept in an open addressing hash table whose slots, once filled, never
+ * change. Only adding a factor takes a lock. When the table is half full it
+ * is replaced by one twice the size, and the old table is kept until the
+ * collection is destroyed, since readers may still be probing it.
  */
 class FactorCollection
 {
   friend std::ostream& operator<<(std::ostream&, const FactorCollection&);
 
-  struct HashFactor : public std::unary_function<const FactorFriend &, std::size_t> {
-    std::size_t operator()(const StringPiece &str) const {
-      return util::MurmurHashNative(str.data(), str.size());
-    }
-    std::size_t operator()(const FactorFriend &factor) const {
-      return (*this)(factor.in.GetString());
-    }
-  };
-  struct EqualsFactor : public std::binary_function<const FactorFriend &, const FactorFriend &, bool> {
-    bool operator()(const FactorFriend &left, const FactorFriend &right) const {
-      return left.in.GetString() == right.in.GetString();
-    }
-    bool operator()(const FactorFriend &left, const StringPiece &right) const {
-      return left.in.GetString() == right;
-    }
-    bool operator()(const StringPiece &left, const FactorFriend &right) const {
-      return left == right.in.GetString();
-    }
+  struct Table {
+    explicit Table(size_t size);
+    ~Table();
+
+    const Factor *volatile *m_slots; /**< NULL for empty slots */
+    size_t m_mask; /**< number of slots - 1, a power of 2 minus 1 */
+
+  private:
+    Table(const Table &); // not implemented
+    void operator=(const Table &); // not implemented
   };
-  typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
+
+  static std::size_t Hash(const StringPiece &str) {
+    return util::MurmurHashNative(str.data(), str.size());
+  }
+
+  //! factor with string str in table, or NULL. Safe without the lock
+  static const Factor *Find(const Table &table, const StringPiece &str, std::size_t hash);
+  //! the factor with string str, created if necessary. Call with the lock held
+  const Factor *Insert(const StringPiece &str, std::size_t hash);
+
+  Table *volatile m_table; /**< current table, read without a lock */
+  std::vector<Table*> m_tables; /**< all tables, including replaced ones */
+  std::vector<Factor*> m_factors; /**< all factors, indexed by id */
 
   static FactorCollection s_instance;
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  //! taken to add factors
+  mutable boost::mutex m_insertLock;
 #endif
 
-  size_t m_factorId; /**< unique, contiguous ids, starting from 0, for each factor */
-
   //! constructor. only the 1 static variable can be created
-  FactorCollection()
-    :m_factorId(0)
-  {}
+  FactorCollection();
 
 public:
   static FactorCollection& Instance() {
@@ -113,6 +106,11 @@ public:
     return AddFactor(factorString);
   }
 
+  /** AddFactor() for each of factorStrings, e.g. all factors of a sentence.
+   *  Takes the lock at most once, for all the factors that are new.
+   */
+  void AddFactors(const std::vector<StringPiece> &factorStrings, std::vector<const Factor*> &factors);
+
   TO_STRING();
 
 };
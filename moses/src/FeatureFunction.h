@@ -59,6 +59,15 @@ public:
     const FFState* prev_state,
     ScoreComponentCollection* accumulator) const = 0;
 
+  /**
+   * Hint that Evaluate() will soon be called with the same arguments. The search
+   * calls this for a batch of hypotheses before it evaluates any of them, so
+   * that memory Evaluate() will need can be fetched in the meantime.
+   */
+  virtual void Prefetch(
+    const Hypothesis& /* cur_hypo */,
+    const FFState* /* prev_state */) const {}
+
   virtual FFState* EvaluateChart(
     const ChartHypothesis& /* cur_hypo */,
     int /* featureID */,
@@ -12,6 +12,11 @@ GlobalLexicalModel::GlobalLexicalModel(const string &filePath,
                                        const float weight,
                                        const vector< FactorType >& inFactors,
                                        const vector< FactorType >& outFactors)
+  : m_filePath(filePath)
+  , m_inFactorTypes(inFactors)
+  , m_outFactorTypes(outFactors)
+  , m_inputFactors(inFactors)
+  , m_outputFactors(outFactors)
 {
   std::cerr << "Creating global lexical model...\n";
 
@@ -21,9 +26,6 @@ GlobalLexicalModel::GlobalLexicalModel(const string &filePath,
   weights.push_back( weight );
   const_cast<StaticData&>(StaticData::Instance()).SetWeightsForScoreProducer(this, weights);
 
-  // load model
-  LoadData( filePath, inFactors, outFactors );
-
   // define bias word
   FactorCollection &factorCollection = FactorCollection::Instance();
   m_bias = new Word();
@@ -44,6 +46,11 @@ GlobalLexicalModel::~GlobalLexicalModel()
   }
 }
 
+void GlobalLexicalModel::Load()
+{
+  LoadData( m_filePath, m_inFactorTypes, m_outFactorTypes );
+}
+
 void GlobalLexicalModel::LoadData(const string &filePath,
                                   const vector< FactorType >& inFactors,
                                   const vector< FactorType >& outFactors)
@@ -53,8 +60,6 @@ void GlobalLexicalModel::LoadData(const string &filePath,
 
   VERBOSE(2, "Loading global lexical model from file " << filePath << endl);
 
-  m_inputFactors = FactorMask(inFactors);
-  m_outputFactors = FactorMask(outFactors);
   InputFileStream inFile(filePath);
 
   // reading in data one line at a time
@@ -54,6 +54,8 @@ private:
 
   Word *m_bias;
 
+  std::string m_filePath;
+  std::vector< FactorType > m_inFactorTypes, m_outFactorTypes;
   FactorMask m_inputFactors;
   FactorMask m_outputFactors;
 
@@ -71,6 +73,9 @@ public:
                      const std::vector< FactorType >& outFactors);
   virtual ~GlobalLexicalModel();
 
+  //! read the model file, which the constructor leaves to be done, possibly on another thread
+  void Load();
+
   virtual size_t GetNumScoreComponents() const {
     return 1;
   };
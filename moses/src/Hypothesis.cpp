@@ -63,7 +63,7 @@ Hypothesis::Hypothesis(Manager& manager, InputType const& source, const TargetPh
   , m_arcList(NULL)
   , m_transOpt(NULL)
   , m_manager(manager)
-
+  , m_arena(NULL)
   , m_id(m_manager.GetNextHypoId())
 {
   // used for initial seeding of trans process
@@ -80,7 +80,7 @@ Hypothesis::Hypothesis(Manager& manager, InputType const& source, const TargetPh
 /***
  * continue prevHypo by appending the phrases in transOpt
  */
-Hypothesis::Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt)
+Hypothesis::Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, int id)
   : m_prevHypo(&prevHypo)
   , m_targetPhrase(transOpt.GetTargetPhrase())
   , m_sourcePhrase(transOpt.GetSourcePhrase())
@@ -97,7 +97,8 @@ Hypothesis::Hypothesis(const Hypothesis &prevHypo, const TranslationOption &tran
   , m_arcList(NULL)
   , m_transOpt(&transOpt)
   , m_manager(prevHypo.GetManager())
-  , m_id(m_manager.GetNextHypoId())
+  , m_arena(NULL)
+  , m_id(id)
 {
   // assert that we are not extending our hypothesis by retranslating something
   // that this hypothesis has already translated!
@@ -153,15 +154,15 @@ void Hypothesis::AddArc(Hypothesis *loserHypo)
 /***
  * return the subclass of Hypothesis most appropriate to the given translation option
  */
-Hypothesis* Hypothesis::CreateNext(const TranslationOption &transOpt, const Phrase* constraint) const
+Hypothesis* Hypothesis::CreateNext(const TranslationOption &transOpt, const Phrase* constraint, Arena &arena, bool numbered) const
 {
-  return Create(*this, transOpt, constraint);
+  return Create(*this, transOpt, constraint, arena, numbered);
 }
 
 /***
  * return the subclass of Hypothesis most appropriate to the given translation option
  */
-Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Phrase* constrainingPhrase)
+Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Phrase* constrainingPhrase, Arena &arena, bool numbered)
 {
 
   // This method includes code for constraint decoding
@@ -197,11 +198,14 @@ Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOpti
 
   if (createHypothesis) {
 
+    int id = numbered ? prevHypo.GetManager().GetNextHypoId() : -1;
 #ifdef USE_HYPO_POOL
     Hypothesis *ptr = s_objectPool.getPtr();
-    return new(ptr) Hypothesis(prevHypo, transOpt);
+    return new(ptr) Hypothesis(prevHypo, transOpt, id);
 #else
-    return new Hypothesis(prevHypo, transOpt);
+    Hypothesis *ret = new(arena) Hypothesis(prevHypo, transOpt, id);
+    ret->m_arena = &arena;
+    return ret;
 #endif
 
   } else {
@@ -222,7 +226,9 @@ Hypothesis* Hypothesis::Create(Manager& manager, InputType const& m_source, cons
   Hypothesis *ptr = s_objectPool.getPtr();
   return new(ptr) Hypothesis(manager, m_source, emptyTarget);
 #else
-  return new Hypothesis(manager, m_source, emptyTarget);
+  Hypothesis *ret = new(manager.GetArena()) Hypothesis(manager, m_source, emptyTarget);
+  ret->m_arena = &manager.GetArena();
+  return ret;
 #endif
 }
 
@@ -258,17 +264,26 @@ void Hypothesis::ResetScore()
   m_futureScore = m_totalScore = 0.0f;
 }
 
+void Hypothesis::PrefetchScores(const std::vector<Hypothesis*> &newHypos)
+{
+  if (newHypos.empty()) return;
+
+  const vector<const StatefulFeatureFunction*>& ffs =
+    newHypos.front()->m_manager.GetTranslationSystem()->GetStatefulFeatureFunctions();
+  for (unsigned i = 0; i < ffs.size(); ++i) {
+    vector<Hypothesis*>::const_iterator iter;
+    for (iter = newHypos.begin(); iter != newHypos.end(); ++iter) {
+      const Hypothesis &hypo = **iter;
+      ffs[i]->Prefetch(hypo, hypo.m_prevHypo ? hypo.m_prevHypo->m_ffStates[i] : NULL);
+    }
+  }
+}
+
 /***
  * calculate the logarithm of our total translation score (sum up components)
  */
 void Hypothesis::CalcScore(const SquareMatrix &futureScore)
 {
-  // some stateless score producers cache their values in the translation
-  // option: add these here
-  // language model scores for n-grams completely contained within a target
-  // phrase are also included here
-  m_scoreBreakdown.PlusEquals(m_transOpt->GetScoreBreakdown());
-
   const StaticData &staticData = StaticData::Instance();
   clock_t t=0; // used to track time
 
@@ -283,24 +298,34 @@ void Hypothesis::CalcScore(const SquareMatrix &futureScore)
   const vector<const StatefulFeatureFunction*>& ffs =
     m_manager.GetTranslationSystem()->GetStatefulFeatureFunctions();
   for (unsigned i = 0; i < ffs.size(); ++i) {
+    IFSTATS {
+      t = GetThreadClock();
+    }
     m_ffStates[i] = ffs[i]->Evaluate(
                       *this,
                       m_prevHypo ? m_prevHypo->m_ffStates[i] : NULL,
                       &m_scoreBreakdown);
+    IFSTATS {
+      m_manager.GetSentenceStats().AddTimeFeature( i, GetThreadClock()-t );
+    }
   }
 
-  IFVERBOSE(2) {
-    t = clock();  // track time excluding LM
+  IFSTATS {
+    t = GetThreadClock();  // track time excluding stateful feature functions
   }
 
   // FUTURE COST
   m_futureScore = futureScore.CalcFutureScore( m_sourceCompleted );
 
   // TOTAL
-  m_totalScore = m_scoreBreakdown.InnerProduct(staticData.GetAllWeights()) + m_futureScore;
+  // some stateless score producers cache their values in the translation
+  // option: add these here, in the same pass as the weighted total.
+  // language model scores for n-grams completely contained within a target
+  // phrase are also included here
+  m_totalScore = m_scoreBreakdown.PlusEqualsInnerProduct(m_transOpt->GetScoreBreakdown(), staticData.GetAllWeights()) + m_futureScore;
 
-  IFVERBOSE(2) {
-    m_manager.GetSentenceStats().AddTimeOtherScore( clock()-t );
+  IFSTATS {
+    m_manager.GetSentenceStats().AddTimeOtherScore( GetThreadClock()-t );
   }
 }
 
@@ -314,8 +339,8 @@ float Hypothesis::CalcExpectedScore( const SquareMatrix &futureScore )
 {
   const StaticData &staticData = StaticData::Instance();
   clock_t t=0;
-  IFVERBOSE(2) {
-    t = clock();  // track time excluding LM
+  IFSTATS {
+    t = GetThreadClock();  // track time excluding LM
   }
 
   CHECK(!"Need to add code to get the distortion scores");
@@ -330,8 +355,8 @@ float Hypothesis::CalcExpectedScore( const SquareMatrix &futureScore )
   // TOTAL
   float total = m_scoreBreakdown.InnerProduct(staticData.GetAllWeights()) + m_futureScore + estimatedLMScore;
 
-  IFVERBOSE(2) {
-    m_manager.GetSentenceStats().AddTimeEstimateScore( clock()-t );
+  IFSTATS {
+    m_manager.GetSentenceStats().AddTimeEstimateScore( GetThreadClock()-t );
   }
   return total;
 }
@@ -345,8 +370,8 @@ void Hypothesis::CalcRemainingScore()
   CHECK(!"Need to add code to get the LM score(s)");
   //CalcLMScore(staticData.GetAllLM());
 
-  IFVERBOSE(2) {
-    t = clock();  // track time excluding LM
+  IFSTATS {
+    t = GetThreadClock();  // track time excluding LM
   }
 
   // WORD PENALTY
@@ -356,8 +381,8 @@ void Hypothesis::CalcRemainingScore()
   // TOTAL
   m_totalScore = m_scoreBreakdown.InnerProduct(staticData.GetAllWeights()) + m_futureScore;
 
-  IFVERBOSE(2) {
-    m_manager.GetSentenceStats().AddTimeOtherScore( clock()-t );
+  IFSTATS {
+    m_manager.GetSentenceStats().AddTimeOtherScore( GetThreadClock()-t );
   }
 }
 
@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "ScoreComponentCollection.h"
 #include "InputType.h"
 #include "ObjectPool.h"
+#include "Arena.h"
 
 namespace Moses
 {
@@ -84,13 +85,25 @@ protected:
   ArcList 					*m_arcList; /*! all arcs that end at the same trellis point as this hypothesis */
   const TranslationOption *m_transOpt;
   Manager& m_manager;
+  Arena *m_arena; /*! memory of this hypothesis comes from here */
 
   int m_id; /*! numeric ID of this hypothesis, used for logging */
 
   /*! used by initial seeding of the translation process */
   Hypothesis(Manager& manager, InputType const& source, const TargetPhrase &emptyTarget);
   /*! used when creating a new hypothesis using a translation option (phrase translation) */
-  Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt);
+  Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt, int id);
+
+#ifndef USE_HYPO_POOL
+  // hypotheses are allocated from the arena of the sentence, see Delete()
+  void *operator new(size_t num_bytes, Arena &arena) {
+    return arena.Allocate(num_bytes);
+  }
+  void operator delete(void *ptr, Arena &arena) {
+    arena.Free(ptr, sizeof(Hypothesis));
+  }
+  void operator delete(void *); // not implemented
+#endif
 
 public:
   static ObjectPool<Hypothesis> &GetObjectPool() {
@@ -99,8 +112,19 @@ public:
 
   ~Hypothesis();
 
-  /** return the subclass of Hypothesis most appropriate to the given translation option */
-  static Hypothesis* Create(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Phrase* constraint);
+#ifndef USE_HYPO_POOL
+  //! destroy the hypothesis and give its memory back to its arena
+  static void Delete(Hypothesis *hypo) {
+    Arena *arena = hypo->m_arena;
+    hypo->~Hypothesis();
+    arena->Free(hypo, sizeof(Hypothesis));
+  }
+#endif
+
+  /** return the subclass of Hypothesis most appropriate to the given translation option.
+   *  The hypothesis is allocated from arena, which must belong to the calling thread.
+   *  Unless numbered, it gets no id until SetId() is called */
+  static Hypothesis* Create(const Hypothesis &prevHypo, const TranslationOption &transOpt, const Phrase* constraint, Arena &arena, bool numbered = true);
 
   static Hypothesis* Create(Manager& manager, const WordsBitmap &initialCoverage);
 
@@ -108,7 +132,7 @@ public:
   static Hypothesis* Create(Manager& manager, InputType const& source, const TargetPhrase &emptyTarget);
 
   /** return the subclass of Hypothesis most appropriate to the given translation option */
-  Hypothesis* CreateNext(const TranslationOption &transOpt, const Phrase* constraint) const;
+  Hypothesis* CreateNext(const TranslationOption &transOpt, const Phrase* constraint, Arena &arena, bool numbered = true) const;
 
   void PrintHypothesis() const;
 
@@ -137,6 +161,11 @@ public:
     return m_manager;
   }
 
+  //! arena for the states of this hypothesis, NULL with USE_HYPO_POOL
+  Arena *GetArena() const {
+    return m_arena;
+  }
+
   /** output length of the translation option used to create this hypothesis */
   inline size_t GetCurrTargetLength() const {
     return m_currTargetWordsRange.GetNumWordsCovered();
@@ -145,6 +174,9 @@ public:
   void ResetScore();
 
   void CalcScore(const SquareMatrix &futureScore);
+  /** let the stateful feature functions prefetch what they need to score
+   *  each of newHypos, before CalcScore() is called for them */
+  static void PrefetchScores(const std::vector<Hypothesis*> &newHypos);
 
   float CalcExpectedScore( const SquareMatrix &futureScore );
   void CalcRemainingScore();
@@ -152,6 +184,10 @@ public:
   int GetId()const {
     return m_id;
   }
+  //! for hypotheses created without an id, see Create()
+  void SetId(int id) {
+    m_id = id;
+  }
 
   const Hypothesis* GetPrevHypo() const;
 
@@ -270,7 +306,7 @@ struct CompareHypothesisTotalScore {
 } \
  
 #else
-#define FREEHYPO(hypo) delete hypo
+#define FREEHYPO(hypo) Hypothesis::Delete(hypo)
 #endif
 
 /** defines less-than relation on hypotheses.
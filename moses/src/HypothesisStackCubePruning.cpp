@@ -110,6 +110,9 @@ bool HypothesisStackCubePruning::AddPrune(Hypothesis *hypo)
     VERBOSE(3,"better than matching hyp " << hypoExisting->GetId() << ", recombining, ");
     if (m_nBestIsEnabled) {
       hypo->AddArc(hypoExisting);
+      IFSTATS {
+        m_manager.GetSentenceStats().AddArc();
+      }
       Detach(iterExisting);
     } else {
       Remove(iterExisting);
@@ -127,6 +130,9 @@ bool HypothesisStackCubePruning::AddPrune(Hypothesis *hypo)
     VERBOSE(3,"worse than matching hyp " << hypoExisting->GetId() << ", recombining" << std::endl)
     if (m_nBestIsEnabled) {
       hypoExisting->AddArc(hypo);
+      IFSTATS {
+        m_manager.GetSentenceStats().AddArc();
+      }
     } else {
       FREEHYPO(hypo);
     }
@@ -139,8 +145,9 @@ void HypothesisStackCubePruning::AddInitial(Hypothesis *hypo)
   std::pair<iterator, bool> addRet = Add(hypo);
   CHECK(addRet.second);
 
-  const WordsBitmap &bitmap = hypo->GetWordsBitmap();
-  m_bitmapAccessor[bitmap] = new BitmapContainer(bitmap, *this);
+  // the container refers to the bitmap of the map
+  _BMType::iterator iter = m_bitmapAccessor.insert(std::make_pair(hypo->GetWordsBitmap(), (BitmapContainer*) NULL)).first;
+  iter->second = new BitmapContainer(iter->first, *this);
 }
 
 void HypothesisStackCubePruning::PruneToSize(size_t newSize)
@@ -248,8 +255,10 @@ void HypothesisStackCubePruning::SetBitmapAccessor(const WordsBitmap &newBitmap
 
   BitmapContainer *bmContainer;
   if (bcExists == m_bitmapAccessor.end()) {
-    bmContainer = new BitmapContainer(newBitmap, stack);
-    m_bitmapAccessor[newBitmap] = bmContainer;
+    // the container refers to the bitmap of the map
+    bcExists = m_bitmapAccessor.insert(std::make_pair(newBitmap, (BitmapContainer*) NULL)).first;
+    bmContainer = new BitmapContainer(bcExists->first, stack);
+    bcExists->second = bmContainer;
   } else {
     bmContainer = bcExists->second;
   }
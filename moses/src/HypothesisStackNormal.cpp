@@ -120,6 +120,9 @@ bool HypothesisStackNormal::AddPrune(Hypothesis *hypo)
     VERBOSE(3,"better than matching hyp " << hypoExisting->GetId() << ", recombining, ");
     if (m_nBestIsEnabled) {
       hypo->AddArc(hypoExisting);
+      IFSTATS {
+        m_manager.GetSentenceStats().AddArc();
+      }
       Detach(iterExisting);
     } else {
       Remove(iterExisting);
@@ -137,6 +140,9 @@ bool HypothesisStackNormal::AddPrune(Hypothesis *hypo)
     VERBOSE(3,"worse than matching hyp " << hypoExisting->GetId() << ", recombining" << std::endl)
     if (m_nBestIsEnabled) {
       hypoExisting->AddArc(hypo);
+      IFSTATS {
+        m_manager.GetSentenceStats().AddArc();
+      }
     } else {
       FREEHYPO(hypo);
     }
@@ -126,14 +126,9 @@ FFState *LanguageModelImplementation::Evaluate(const Hypothesis &hypo, const FFS
   if(GetNGramOrder() <= 1)
     return NULL;
 
-  clock_t t = 0;
-  IFVERBOSE(2) {
-    t = clock();  // track time
-  }
-
   // Empty phrase added? nothing to be done
   if (hypo.GetCurrTargetLength() == 0)
-    return ps ? NewState(ps) : NULL;
+    return ps ? NewState(ps, hypo.GetArena()) : NULL;
 
   const size_t currEndPos = hypo.GetCurrTargetWordsRange().GetEndPos();
   const size_t startPos = hypo.GetCurrTargetWordsRange().GetStartPos();
@@ -148,7 +143,7 @@ FFState *LanguageModelImplementation::Evaluate(const Hypothesis &hypo, const FFS
       contextFactor[index++] = &GetSentenceStartArray();
     }
   }
-  FFState *res = NewState(ps);
+  FFState *res = NewState(ps, hypo.GetArena());
   float lmScore = ps ? GetValueGivenState(contextFactor, *res).score : GetValueForgotState(contextFactor, *res).score;
 
   // main loop
@@ -200,10 +195,6 @@ FFState *LanguageModelImplementation::Evaluate(const Hypothesis &hypo, const FFS
     out->PlusEquals(feature, lmScore);
   }
 
-
-  IFVERBOSE(2) {
-    hypo.GetManager().GetSentenceStats().AddTimeCalcLM( clock()-t );
-  }
   return res;
 }
 
@@ -375,13 +366,14 @@ public:
 } // namespace
 
 FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo, int featureID, ScoreComponentCollection* out, const LanguageModel *scorer) const {
-  LanguageModelChartState *ret = new LanguageModelChartState(hypo, featureID, GetNGramOrder());
+  Arena *arena = hypo.GetArena();
+  LanguageModelChartState *ret = new(arena) LanguageModelChartState(hypo, featureID, GetNGramOrder());
   // data structure for factored context phrase (history and predicted word)
   vector<const Word*> contextFactor;
   contextFactor.reserve(GetNGramOrder());
 
   // initialize language model context state
-  FFState *lmState = NewState( GetNullContextState() );
+  FFState *lmState = NewState( GetNullContextState(), arena );
 
   // initial language model scores
   float prefixScore = 0.0;    // not yet final for initial words (lack context)
@@ -409,7 +401,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
       {        
         CHECK(phrasePos == 0);
         delete lmState;
-        lmState = NewState( GetBeginSentenceState() );
+        lmState = NewState( GetBeginSentenceState(), arena );
       }
       // score a regular word added by the rule
       else
@@ -439,7 +431,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
 
         // get language model state
         delete lmState;
-        lmState = NewState( prevState->GetRightContext() );
+        lmState = NewState( prevState->GetRightContext(), arena );
 
         // push suffix
         int suffixPos = prevState->GetSuffix().GetSize() - (GetNGramOrder()-1);
@@ -476,7 +468,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
 
           // copy language model state
           delete lmState;
-          lmState = NewState( prevState->GetRightContext() );
+          lmState = NewState( prevState->GetRightContext(), arena );
 
           // push its suffix
           size_t remainingWords = subPhraseLength - (GetNGramOrder()-1);
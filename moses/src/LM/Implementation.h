@@ -41,6 +41,7 @@ class LanguageModel;
 class FactorCollection;
 class Factor;
 class Phrase;
+class Arena;
 
 struct LMResult {
   // log probability
@@ -90,12 +91,16 @@ public:
 
   virtual const FFState *GetNullContextState() const = 0;
   virtual const FFState *GetBeginSentenceState() const = 0;
-  virtual FFState *NewState(const FFState *from = NULL) const = 0;
+  //! from arena, or from the heap if it is NULL
+  virtual FFState *NewState(const FFState *from = NULL, Arena *arena = NULL) const = 0;
 
   void CalcScore(const Phrase &phrase, float &fullScore, float &ngramScore, size_t &oovCount) const;
 
   FFState *Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out, const LanguageModel *feature) const;
 
+  //! hint that Evaluate() will be called for hypo, see StatefulFeatureFunction::Prefetch()
+  virtual void Prefetch(const Hypothesis &/*hypo*/, const FFState */*ps*/) const {}
+
   FFState* EvaluateChart(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection* accumulator, const LanguageModel *feature) const;
 
   void updateChartScore(float *prefixScore, float *finalScore, float score, size_t wordPos) const;
@@ -160,6 +165,10 @@ class LMRefCount : public LanguageModel {
       return m_impl->Evaluate(cur_hypo, prev_state, accumulator, this);
     }
 
+    void Prefetch(const Hypothesis& cur_hypo, const FFState* prev_state) const {
+      m_impl->Prefetch(cur_hypo, prev_state);
+    }
+
     FFState* EvaluateChart(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection* accumulator) const {
       return m_impl->EvaluateChart(cur_hypo, featureID, accumulator, this);
     }
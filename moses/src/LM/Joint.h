@@ -127,8 +127,8 @@ public:
     return m_lmImpl->GetBeginSentenceState();
   }
 
-  FFState *NewState(const FFState *from) const {
-    return m_lmImpl->NewState(from);
+  FFState *NewState(const FFState *from, Arena *arena) const {
+    return m_lmImpl->NewState(from, arena);
   }
 
 };
@@ -85,6 +85,8 @@ template <class Model> class LanguageModelKen : public LanguageModel {
 
     FFState *Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out) const;
 
+    void Prefetch(const Hypothesis &hypo, const FFState *ps) const;
+
     FFState *EvaluateChart(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection *accumulator) const;
 
   private:
@@ -213,7 +215,7 @@ template <class Model> void LanguageModelKen<Model>::CalcScore(const Phrase &phr
 template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out) const {
   const lm::ngram::State &in_state = static_cast<const KenLMState&>(*ps).state;
 
-  std::auto_ptr<KenLMState> ret(new KenLMState());
+  std::auto_ptr<KenLMState> ret(new(hypo.GetArena()) KenLMState());
   
   if (!hypo.GetCurrTargetLength()) {
     ret->state = in_state;
@@ -265,6 +267,26 @@ template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothes
   return ret.release();
 }
 
+template <class Model> void LanguageModelKen<Model>::Prefetch(const Hypothesis &hypo, const FFState *ps) const {
+  if (!hypo.GetCurrTargetLength()) return;
+
+  const lm::ngram::State &in_state = static_cast<const KenLMState&>(*ps).state;
+  const std::size_t begin = hypo.GetCurrTargetWordsRange().GetStartPos();
+  const std::size_t end = hypo.GetCurrTargetWordsRange().GetEndPos() + 1;
+  const std::size_t adjust_end = std::min(end, begin + m_ngram->Order() - 1);
+
+  // The words Evaluate() scores one at a time, each after its context in
+  // reverse order: the earlier words of the phrase, then those of the state.
+  lm::WordIndex context[2 * lm::ngram::kMaxOrder];
+  lm::WordIndex *context_rbegin = context + lm::ngram::kMaxOrder;
+  const lm::WordIndex *context_rend = std::copy(in_state.words, in_state.words + in_state.length, context_rbegin);
+  for (std::size_t position = begin; position < adjust_end; ++position) {
+    const lm::WordIndex index = TranslateID(hypo.GetWord(position));
+    m_ngram->Prefetch(context_rbegin, context_rend, index);
+    *--context_rbegin = index;
+  }
+}
+
 class LanguageModelChartStateKenLM : public FFState {
   public:
     LanguageModelChartStateKenLM() {}
@@ -284,7 +306,7 @@ class LanguageModelChartStateKenLM : public FFState {
 };
 
 template <class Model> FFState *LanguageModelKen<Model>::EvaluateChart(const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const {
-  LanguageModelChartStateKenLM *newState = new LanguageModelChartStateKenLM();
+  LanguageModelChartStateKenLM *newState = new(hypo.GetArena()) LanguageModelChartStateKenLM();
   lm::ngram::RuleScore<Model> ruleScore(*m_ngram, newState->GetChartState());
   const AlignmentInfo::NonTermIndexMap &nonTermIndexMap = hypo.GetCurrTargetPhrase().GetAlignmentInfo().GetNonTermIndexMap();
 
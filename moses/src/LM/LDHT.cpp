@@ -212,7 +212,7 @@ FFState* LanguageModelLDHT::Evaluate(
 
     // Create a new state and copy the contents of the input_state if
     // supplied.
-    LDHTLMState* new_state = new LDHTLMState();
+    LDHTLMState* new_state = new(hypo.GetArena()) LDHTLMState();
     if (input_state == NULL) {
         if (hypo.GetCurrTargetWordsRange().GetStartPos() != 0) {
             V("got a null state but not at start of sentence");
@@ -82,7 +82,7 @@ public:
   LMResult GetValueForgotState(const std::vector<const Word*> &contextFactor, FFState &outState) const;
   const FFState *GetNullContextState() const;
   const FFState *GetBeginSentenceState() const;
-  FFState *NewState(const FFState *from) const;
+  FFState *NewState(const FFState *from, Arena *arena) const;
 };
 
 LanguageModelParallelBackoff::~LanguageModelParallelBackoff()
@@ -330,7 +330,7 @@ LMResult LanguageModelParallelBackoff::GetValueForgotState(const std::vector<con
 }
 
 // The old version did not initialize finalState like it should.  Technically that makes the behavior undefined, so it's not clear what else to do here.
-FFState *LanguageModelParallelBackoff::NewState(const FFState * /*from*/) const
+FFState *LanguageModelParallelBackoff::NewState(const FFState * /*from*/, Arena * /*arena*/) const
 {
   return NULL;
 }
@@ -1,13 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <sstream>
+#include "util/check.hh"
+#include "util/murmur_hash.hh"
 #include "LM/Remote.h"
 #include "Factor.h"
+#include "Hypothesis.h"
 
 namespace Moses
 {
@@ -15,6 +21,49 @@ namespace Moses
 const Factor* LanguageModelRemote::BOS = NULL;
 const Factor* LanguageModelRemote::EOS = (LanguageModelRemote::BOS + 1);
 
+namespace
+{
+
+void WriteAll(int sock, const char *data, size_t size)
+{
+  while (size) {
+    ssize_t r = write(sock, data, size);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      perror("writing to lm server failed");
+      exit(1);
+    }
+    data += r;
+    size -= r;
+  }
+}
+
+void ReadAll(int sock, char *data, size_t size)
+{
+  while (size) {
+    ssize_t r = read(sock, data, size);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      perror("reading from lm server failed");
+      exit(1);
+    }
+    if (r == 0) {
+      std::cerr << "lm server closed the connection" << std::endl;
+      exit(1);
+    }
+    data += r;
+    size -= r;
+  }
+}
+
+}
+
+LanguageModelRemote::Connection::~Connection()
+{
+  // Step 8 When finished send all lingering transmissions and close the connection
+  if (sock >= 0) close(sock);
+}
+
 bool LanguageModelRemote::Load(const std::string &filePath
                                , FactorType factorType
                                , size_t nGramOrder)
@@ -29,6 +78,7 @@ bool LanguageModelRemote::Load(const std::string &filePath
   bool good = start(host,port);
   if (!good) {
     std::cerr << "failed to connect to lm server on " << host << " on port " << port << std::endl;
+    return false;
   }
   ClearSentenceCache();
   return good;
@@ -38,20 +88,29 @@ bool LanguageModelRemote::Load(const std::string &filePath
 bool LanguageModelRemote::start(const std::string& host, int port)
 {
   //std::cerr << "host = " << host << ", port = " << port << "\n";
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-  hp = gethostbyname(host.c_str());
+  // resolve once, the decoding threads only connect
+  struct hostent *hp = gethostbyname(host.c_str());
   if (hp==NULL) {
     herror("gethostbyname failed");
     exit(1);
   }
 
-  bzero((char *)&server, sizeof(server));
-  bcopy(hp->h_addr, (char *)&server.sin_addr, hp->h_length);
-  server.sin_family = hp->h_addrtype;
-  server.sin_port = htons(port);
+  bzero((char *)&m_server, sizeof(m_server));
+  bcopy(hp->h_addr, (char *)&m_server.sin_addr, hp->h_length);
+  m_server.sin_family = hp->h_addrtype;
+  m_server.sin_port = htons(port);
 
+  // the connection of the loading thread, which also checks the server is up
+  Connection *conn = new Connection;
+  m_connection.reset(conn);
+  return Connect(*conn);
+}
+
+bool LanguageModelRemote::Connect(Connection &conn) const
+{
+  conn.sock = socket(AF_INET, SOCK_STREAM, 0);
   int errors = 0;
-  while (connect(sock, (struct sockaddr *)&server, sizeof(server)) < 0) {
+  while (connect(conn.sock, (struct sockaddr *)&m_server, sizeof(m_server)) < 0) {
     //std::cerr << "Error: connect()\n";
     sleep(1);
     errors++;
@@ -60,39 +119,59 @@ bool LanguageModelRemote::start(const std::string& host, int port)
   return true;
 }
 
-LMResult LanguageModelRemote::GetValue(const std::vector<const Word*> &contextFactor, State* finalState) const
+LanguageModelRemote::Connection &LanguageModelRemote::GetConnection() const
 {
-  LMResult ret;
-  ret.unknown = false;
-  size_t count = contextFactor.size();
-  if (count == 0) {
-    if (finalState) *finalState = NULL;
-    ret.score = 0.0;
-    return ret;
+  if (m_connection.get() == NULL) {
+    Connection *conn = new Connection;
+    m_connection.reset(conn);
+    if (!Connect(*conn)) {
+      std::cerr << "failed to connect to lm server" << std::endl;
+      exit(1);
+    }
   }
-  //std::cerr << "contextFactor.size() = " << count << "\n";
-  size_t max = m_nGramOrder;
-  const FactorType factor = GetFactorType();
-  if (max > count) max = count;
+  return *m_connection;
+}
+
+void LanguageModelRemote::ClearSentenceCache()
+{
+  Connection &conn = GetConnection();
+  // replies still to come refer to the cache entries
+  Flush(conn);
+  conn.cache.tree.clear();
+}
 
-  Cache* cur = &m_cache;
-  int pc = static_cast<int>(count) - 1;
+LanguageModelRemote::Cache &LanguageModelRemote::Lookup(Connection &conn, const std::vector<const Word*> &contextFactor) const
+{
+  const FactorType factor = GetFactorType();
+  Cache* cur = &conn.cache;
+  int pc = static_cast<int>(contextFactor.size()) - 1;
   for (int i = 0; i < pc; ++i) {
     const Factor* f = contextFactor[i]->GetFactor(factor);
     cur = &cur->tree[f ? f : BOS];
   }
   const Factor* event_word = contextFactor[pc]->GetFactor(factor);
-  cur = &cur->tree[event_word ? event_word : EOS];
-  if (cur->prob) {
-    if (finalState) *finalState = cur->boState;
-    ret.score = cur->prob;
-    return ret;
+  return cur->tree[event_word ? event_word : EOS];
+}
+
+void LanguageModelRemote::Request(Connection &conn, Cache &entry, const std::vector<const Word*> &contextFactor) const
+{
+  size_t count = contextFactor.size();
+  size_t max = m_nGramOrder;
+  const FactorType factor = GetFactorType();
+  if (max > count) max = count;
+
+  // the state only has to be equal for equal n-grams, so it is derived from
+  // the n-gram rather than numbered, which would differ between threads
+  std::vector<const Factor*> words(count);
+  for (size_t i = 0; i < count; ++i) {
+    const Factor* f = contextFactor[i]->GetFactor(factor);
+    words[i] = f ? f : (i + 1 < count ? BOS : EOS);
   }
-  cur->boState = *reinterpret_cast<const State*>(&m_curId);
-  ++m_curId;
+  entry.boState = reinterpret_cast<State>(static_cast<size_t>(
+                    util::MurmurHashNative(&words[0], count * sizeof(const Factor*))));
 
   std::ostringstream os;
-  os << "prob ";
+  const Factor* event_word = contextFactor[count-1]->GetFactor(factor);
   if (event_word == NULL) {
     os << "</s>";
   } else {
@@ -106,39 +185,146 @@ LMResult LanguageModelRemote::GetValue(const std::vector<const Word*> &contextFa
       os << ' ' << f->GetString();
     }
   }
-  os << std::endl;
-  std::string out = os.str();
-  write(sock, out.c_str(), out.size());
-  char res[6];
-  int r = read(sock, res, 6);
-  int errors = 0;
-  int cnt = 0;
-  while (1) {
-    if (r < 0) {
-      errors++;
-      sleep(1);
-      //std::cerr << "Error: read()\n";
-      if (errors > 5) exit(1);
-    } else if (r==0 || res[cnt] == '\n') {
+  os << '\n';
+  conn.request += os.str();
+  conn.pending.push_back(&entry);
+  entry.requested = true;
+
+  if (conn.pending.size() >= BATCH_SIZE) {
+    SendBatch(conn);
+  }
+}
+
+void LanguageModelRemote::SendBatch(Connection &conn) const
+{
+  if (conn.pending.empty()) return;
+
+  // the server stops reading while its reply is unread, so don't get too far ahead
+  if (conn.outstanding.size() >= MAX_OUTSTANDING) {
+    ReceiveBatch(conn);
+  }
+
+  conn.outstanding.push_back(Batch());
+  Batch &batch = conn.outstanding.back();
+  batch.id = conn.nextId++;
+  batch.ngrams.swap(conn.pending);
+
+  std::ostringstream os;
+  os << "probs " << batch.id << ' ' << batch.ngrams.size() << '\n';
+  std::string header = os.str();
+  WriteAll(conn.sock, header.c_str(), header.size());
+  WriteAll(conn.sock, conn.request.c_str(), conn.request.size());
+  conn.request.clear();
+}
+
+void LanguageModelRemote::ReceiveBatch(Connection &conn) const
+{
+  CHECK(!conn.outstanding.empty());
+  Batch &batch = conn.outstanding.front();
+
+  // request id and count, then one float per n-gram, see contrib/lmserver
+  UINT32 header[2];
+  ReadAll(conn.sock, reinterpret_cast<char*>(header), sizeof(header));
+  if (header[0] != batch.id || header[1] != batch.ngrams.size()) {
+    std::cerr << "unexpected reply from lm server, expected request " << batch.id
+              << " with " << batch.ngrams.size() << " n-grams" << std::endl;
+    exit(1);
+  }
+  std::vector<float> probs(batch.ngrams.size());
+  ReadAll(conn.sock, reinterpret_cast<char*>(&probs[0]), probs.size() * sizeof(float));
+
+  for (size_t i = 0; i < probs.size(); ++i) {
+    Cache &entry = *batch.ngrams[i];
+    entry.prob = FloorScore(TransformLMScore(probs[i]));
+    entry.known = true;
+    entry.requested = false;
+  }
+  conn.outstanding.pop_front();
+}
+
+void LanguageModelRemote::Flush(Connection &conn) const
+{
+  SendBatch(conn);
+  while (!conn.outstanding.empty()) {
+    ReceiveBatch(conn);
+  }
+}
+
+void LanguageModelRemote::Prefetch(const Hypothesis &hypo, const FFState * /* ps */) const
+{
+  // the n-grams Evaluate() will score
+  if (GetNGramOrder() <= 1 || hypo.GetCurrTargetLength() == 0)
+    return;
+
+  Connection &conn = GetConnection();
+  const size_t currEndPos = hypo.GetCurrTargetWordsRange().GetEndPos();
+  const size_t startPos = hypo.GetCurrTargetWordsRange().GetStartPos();
+
+  std::vector<const Word*> contextFactor(GetNGramOrder());
+  size_t index = 0;
+  for (int currPos = (int) startPos - (int) GetNGramOrder() + 1 ; currPos <= (int) startPos ; currPos++) {
+    contextFactor[index++] = currPos >= 0 ? &hypo.GetWord(currPos) : &GetSentenceStartArray();
+  }
+
+  const size_t endPos = std::min(startPos + GetNGramOrder() - 2, currEndPos);
+  for (size_t currPos = startPos ; ; ) {
+    Cache &entry = Lookup(conn, contextFactor);
+    if (!entry.known && !entry.requested) {
+      Request(conn, entry, contextFactor);
+    }
+    if (++currPos > endPos)
       break;
-    } else {
-      cnt += r;
-      if (cnt==6) break;
-      read(sock, &res[cnt], 6-cnt);
+    for (size_t i = 0 ; i < GetNGramOrder() - 1 ; i++)
+      contextFactor[i] = contextFactor[i + 1];
+    contextFactor.back() = &hypo.GetWord(currPos);
+  }
+
+  if (hypo.IsSourceCompleted()) {
+    const size_t size = hypo.GetSize();
+    contextFactor.back() = &GetSentenceEndArray();
+    for (size_t i = 0 ; i < GetNGramOrder() - 1 ; i ++) {
+      int currPos = (int)(size - GetNGramOrder() + i + 1);
+      contextFactor[i] = currPos < 0 ? &GetSentenceStartArray() : &hypo.GetWord((size_t)currPos);
     }
+    Cache &entry = Lookup(conn, contextFactor);
+    if (!entry.known && !entry.requested) {
+      Request(conn, entry, contextFactor);
+    }
+  }
+}
+
+LMResult LanguageModelRemote::GetValue(const std::vector<const Word*> &contextFactor, State* finalState) const
+{
+  LMResult ret;
+  ret.unknown = false;
+  size_t count = contextFactor.size();
+  if (count == 0) {
+    if (finalState) *finalState = NULL;
+    ret.score = 0.0;
+    return ret;
   }
-  cur->prob = FloorScore(TransformLMScore(*reinterpret_cast<float*>(res)));
-  if (finalState) {
-    *finalState = cur->boState;
+  //std::cerr << "contextFactor.size() = " << count << "\n";
+
+  Connection &conn = GetConnection();
+  Cache &entry = Lookup(conn, contextFactor);
+  if (!entry.known) {
+    if (!entry.requested) {
+      Request(conn, entry, contextFactor);
+    }
+    SendBatch(conn);
+    // replies come in request order, the n-gram is in one of them
+    while (!entry.known) {
+      ReceiveBatch(conn);
+    }
   }
-  ret.score = cur->prob;
+
+  if (finalState) *finalState = entry.boState;
+  ret.score = entry.prob;
   return ret;
 }
 
 LanguageModelRemote::~LanguageModelRemote()
 {
-  // Step 8 When finished send all lingering transmissions and close the connection
-  close(sock);
 }
 
 }
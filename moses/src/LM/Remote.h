@@ -4,13 +4,28 @@
 #include "LM/SingleFactor.h"
 #include "TypeDef.h"
 #include "Factor.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netinet/in.h>
 
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
 namespace Moses
 {
 
+/** Language model served by contrib/lmserver.
+ *  Every decoding thread has its own connection to the server. The n-grams
+ *  that Prefetch() announces are sent in batches, without waiting for the
+ *  replies to earlier batches, and a reply is only read once one of its
+ *  scores is needed.
+ */
 class LanguageModelRemote : public LanguageModelPointerState
 {
 private:
@@ -18,23 +33,59 @@ private:
     std::map<const Factor*, Cache> tree;
     float prob;
     State boState;
-    Cache() : prob(0) {}
+    bool known; /**< prob and boState are set */
+    bool requested; /**< queued or sent, but the reply has not been read */
+    Cache() : prob(0), boState(NULL), known(false), requested(false) {}
+  };
+
+  //! a batch that was sent, and whose reply has not been read yet
+  struct Batch {
+    UINT32 id;
+    std::vector<Cache*> ngrams;
+  };
+
+  //! what one thread exchanges with the server
+  struct Connection {
+    int sock;
+    Cache cache;
+    std::string request; /**< n-gram lines of the next batch */
+    std::vector<Cache*> pending; /**< cache entries of those n-grams */
+    std::deque<Batch> outstanding; /**< oldest first, the order of the replies */
+    UINT32 nextId;
+
+    Connection() : sock(-1), nextId(0) {}
+    ~Connection();
   };
 
-  int sock, port;
-  struct hostent *hp;
-  struct sockaddr_in server;
-  mutable size_t m_curId;
-  mutable Cache m_cache;
+  static const size_t BATCH_SIZE = 256; //! n-grams per request
+  static const size_t MAX_OUTSTANDING = 8; //! requests sent ahead of the replies
+
+  struct sockaddr_in m_server;
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<Connection> m_connection;
+#else
+  mutable std::auto_ptr<Connection> m_connection;
+#endif
+
   bool start(const std::string& host, int port);
+  bool Connect(Connection &conn) const;
+  Connection &GetConnection() const;
+
+  Cache &Lookup(Connection &conn, const std::vector<const Word*> &contextFactor) const;
+  //! queue the n-gram for the next batch
+  void Request(Connection &conn, Cache &entry, const std::vector<const Word*> &contextFactor) const;
+  void SendBatch(Connection &conn) const;
+  //! read the reply to the oldest outstanding batch
+  void ReceiveBatch(Connection &conn) const;
+  //! send everything queued and read all replies
+  void Flush(Connection &conn) const;
+
   static const Factor* BOS;
   static const Factor* EOS;
 public:
   ~LanguageModelRemote();
-  void ClearSentenceCache() {
-    m_cache.tree.clear();
-    m_curId = 1000;
-  }
+  void ClearSentenceCache();
+  void Prefetch(const Hypothesis &hypo, const FFState *ps) const;
   virtual LMResult GetValue(const std::vector<const Word*> &contextFactor, State* finalState = 0) const;
   bool Load(const std::string &filePath
             , FactorType factorType
@@ -78,9 +78,9 @@ const FFState *LanguageModelPointerState::GetBeginSentenceState() const
   return m_beginSentenceState;
 }
 
-FFState *LanguageModelPointerState::NewState(const FFState *from) const
+FFState *LanguageModelPointerState::NewState(const FFState *from, Arena *arena) const
 {
-  return new PointerState(from ? static_cast<const PointerState*>(from)->lmstate : NULL);
+  return new(arena) PointerState(from ? static_cast<const PointerState*>(from)->lmstate : NULL);
 }
 
 LMResult LanguageModelPointerState::GetValueForgotState(const std::vector<const Word*> &contextFactor, FFState &outState) const
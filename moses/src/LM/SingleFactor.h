@@ -79,7 +79,7 @@ protected:
 
   virtual const FFState *GetNullContextState() const;
   virtual const FFState *GetBeginSentenceState() const;
-  virtual FFState *NewState(const FFState *from = NULL) const;
+  virtual FFState *NewState(const FFState *from = NULL, Arena *arena = NULL) const;
 
   virtual LMResult GetValueForgotState(const std::vector<const Word*> &contextFactor, FFState &outState) const;
 
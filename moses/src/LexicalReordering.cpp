@@ -14,6 +14,8 @@ LexicalReordering::LexicalReordering(std::vector<FactorType>& f_factors,
                                      const std::string &filePath,
                                      const std::vector<float>& weights)
   : m_configuration(this, modelType)
+  , m_filePath(filePath)
+  , m_table(NULL)
 {
   std::cerr << "Creating lexical reordering...\n";
   std::cerr << "weights: ";
@@ -57,8 +59,11 @@ LexicalReordering::LexicalReordering(std::vector<FactorType>& f_factors,
   // add ScoreProducer - don't do this before our object is set up
   const_cast<ScoreIndexManager&>(StaticData::Instance().GetScoreIndexManager()).AddScoreProducer(this);
   const_cast<StaticData&>(StaticData::Instance()).SetWeightsForScoreProducer(this, weights);
+}
 
-  m_table = LexicalReorderingTable::LoadAvailable(filePath, m_factorsF, m_factorsE, std::vector<FactorType>());
+void LexicalReordering::Load()
+{
+  m_table = LexicalReorderingTable::LoadAvailable(m_filePath, m_factorsF, m_factorsE, std::vector<FactorType>());
 }
 
 LexicalReordering::~LexicalReordering()
@@ -78,7 +83,7 @@ FFState* LexicalReordering::Evaluate(const Hypothesis& hypo,
 {
   Scores score(GetNumScoreComponents(), 0);
   const LexicalReorderingState *prev = dynamic_cast<const LexicalReorderingState *>(prev_state);
-  LexicalReorderingState *next_state = prev->Expand(hypo.GetTranslationOption(), score);
+  LexicalReorderingState *next_state = prev->Expand(hypo.GetTranslationOption(), score, hypo.GetArena());
 
   out->PlusEquals(this, score);
 
@@ -32,6 +32,9 @@ public:
                     const std::vector<float>& weights);
   virtual ~LexicalReordering();
 
+  //! read the table, which the constructor leaves to be done, possibly on another thread
+  void Load();
+
   virtual size_t GetNumScoreComponents() const {
     return m_configuration.GetNumScoreComponents();
   }
@@ -71,6 +74,7 @@ private:
   LexicalReorderingConfiguration m_configuration;
   std::string m_modelTypeString;
   std::vector<std::string> m_modelType;
+  std::string m_filePath;
   LexicalReorderingTable* m_table;
   size_t m_numScoreComponents;
   //std::vector<Direction> m_direction;
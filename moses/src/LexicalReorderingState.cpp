@@ -196,7 +196,7 @@ int PhraseBasedReorderingState::Compare(const FFState& o) const
   return 1;
 }
 
-LexicalReorderingState* PhraseBasedReorderingState::Expand(const TranslationOption& topt, Scores& scores) const
+LexicalReorderingState* PhraseBasedReorderingState::Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const
 {
   ReorderingType reoType;
   const WordsRange currWordsRange = topt.GetSourceWordsRange();
@@ -218,7 +218,7 @@ LexicalReorderingState* PhraseBasedReorderingState::Expand(const TranslationOpti
     CopyScores(scores, topt, reoType);
   }
 
-  return new PhraseBasedReorderingState(this, topt);
+  return new(arena) PhraseBasedReorderingState(this, topt);
 }
 
 LexicalReorderingState::ReorderingType PhraseBasedReorderingState::GetOrientationTypeMSD(WordsRange currRange) const
@@ -293,11 +293,11 @@ int BidirectionalReorderingState::Compare(const FFState& o) const
     return m_forward->Compare(*other.m_forward);
 }
 
-LexicalReorderingState* BidirectionalReorderingState::Expand(const TranslationOption& topt, Scores& scores) const
+LexicalReorderingState* BidirectionalReorderingState::Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const
 {
-  LexicalReorderingState *newbwd = m_backward->Expand(topt, scores);
-  LexicalReorderingState *newfwd = m_forward->Expand(topt, scores);
-  return new BidirectionalReorderingState(m_configuration, newbwd, newfwd, m_offset);
+  LexicalReorderingState *newbwd = m_backward->Expand(topt, scores, arena);
+  LexicalReorderingState *newfwd = m_forward->Expand(topt, scores, arena);
+  return new(arena) BidirectionalReorderingState(m_configuration, newbwd, newfwd, m_offset);
 }
 
 ///////////////////////////
@@ -317,10 +317,10 @@ int HierarchicalReorderingBackwardState::Compare(const FFState& o) const
   return m_reoStack.Compare(other.m_reoStack);
 }
 
-LexicalReorderingState* HierarchicalReorderingBackwardState::Expand(const TranslationOption& topt, Scores& scores) const
+LexicalReorderingState* HierarchicalReorderingBackwardState::Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const
 {
 
-  HierarchicalReorderingBackwardState* nextState = new HierarchicalReorderingBackwardState(this, topt, m_reoStack);
+  HierarchicalReorderingBackwardState* nextState = new(arena) HierarchicalReorderingBackwardState(this, topt, m_reoStack);
   ReorderingType reoType;
   const LexicalReorderingConfiguration::ModelType modelType = m_configuration.GetModelType();
 
@@ -420,7 +420,7 @@ int HierarchicalReorderingForwardState::Compare(const FFState& o) const
 //  dright: if the next phrase follows the conditioning phrase and other stuff comes in between
 //  dleft:  if the next phrase precedes the conditioning phrase and other stuff comes in between
 
-LexicalReorderingState* HierarchicalReorderingForwardState::Expand(const TranslationOption& topt, Scores& scores) const
+LexicalReorderingState* HierarchicalReorderingForwardState::Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const
 {
   const LexicalReorderingConfiguration::ModelType modelType = m_configuration.GetModelType();
   const WordsRange currWordsRange = topt.GetSourceWordsRange();
@@ -446,10 +446,10 @@ LexicalReorderingState* HierarchicalReorderingForwardState::Expand(const Transla
     CopyScores(scores, topt, reoType);
   }
 
-  return new HierarchicalReorderingForwardState(this, topt);
+  return new(arena) HierarchicalReorderingForwardState(this, topt);
 }
 
-LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeMSD(WordsRange currRange, WordsBitmap coverage) const
+LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeMSD(WordsRange currRange, const WordsBitmap &coverage) const
 {
   if (currRange.GetStartPos() > m_prevRange.GetEndPos() &&
       (!coverage.GetValue(m_prevRange.GetEndPos()+1) || currRange.GetStartPos() == m_prevRange.GetEndPos()+1)) {
@@ -461,7 +461,7 @@ LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOr
   return D;
 }
 
-LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeMSLR(WordsRange currRange, WordsBitmap coverage) const
+LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeMSLR(WordsRange currRange, const WordsBitmap &coverage) const
 {
   if (currRange.GetStartPos() > m_prevRange.GetEndPos() &&
       (!coverage.GetValue(m_prevRange.GetEndPos()+1) || currRange.GetStartPos() == m_prevRange.GetEndPos()+1)) {
@@ -475,7 +475,7 @@ LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOr
   return DL;
 }
 
-LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeMonotonic(WordsRange currRange, WordsBitmap coverage) const
+LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeMonotonic(WordsRange currRange, const WordsBitmap &coverage) const
 {
   if (currRange.GetStartPos() > m_prevRange.GetEndPos() &&
       (!coverage.GetValue(m_prevRange.GetEndPos()+1) || currRange.GetStartPos() == m_prevRange.GetEndPos()+1)) {
@@ -484,7 +484,7 @@ LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOr
   return NM;
 }
 
-LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeLeftRight(WordsRange currRange, WordsBitmap /* coverage */) const
+LexicalReorderingState::ReorderingType HierarchicalReorderingForwardState::GetOrientationTypeLeftRight(WordsRange currRange, const WordsBitmap &/* coverage */) const
 {
   if (currRange.GetStartPos() > m_prevRange.GetEndPos()) {
     return R;
@@ -71,7 +71,8 @@ class LexicalReorderingState : public FFState
 public:
 
   virtual int Compare(const FFState& o) const = 0;
-  virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores) const = 0;
+  //! the state after topt, allocated from arena like FFState
+  virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const = 0;
 
   static LexicalReorderingState* CreateLexicalReorderingState(const std::vector<std::string>& config,
       LexicalReorderingConfiguration::Direction dir, const InputType &input);
@@ -123,7 +124,7 @@ public:
   }
 
   virtual int Compare(const FFState& o) const;
-  virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores) const;
+  virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const;
 };
 
 //! State for the standard Moses implementation of lexical reordering models
@@ -138,7 +139,7 @@ public:
   PhraseBasedReorderingState(const PhraseBasedReorderingState *prev, const TranslationOption &topt);
 
   virtual int Compare(const FFState& o) const;
-  virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores) const;
+  virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores, Arena *arena) const;
 
   ReorderingType GetOrientationTypeMSD(WordsRange currRange) const;
   ReorderingType GetOrientationTypeMSLR(WordsRange currRange) const;
@@ -159,7 +160,7 @@ public:
                                       const TranslationOption &topt, ReorderingStack reoStack);
 
   virtual int Compare(const FFState& o) const;
-  virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores) const;
+  virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores, Arena *arena) const;
 
 private:
   ReorderingType GetOrientationTypeMSD(int reoDistance) const;
@@ -182,13 +183,13 @@ public:
   HierarchicalReorderingForwardState(const HierarchicalReorderingForwardState *prev, const TranslationOption &topt);
 
   virtual int Compare(const FFState& o) const;
-  virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores) const;
+  virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores, Arena *arena) const;
 
 private:
-  ReorderingType GetOrientationTypeMSD(WordsRange currRange, WordsBitmap coverage) const;
-  ReorderingType GetOrientationTypeMSLR(WordsRange currRange, WordsBitmap coverage) const;
-  ReorderingType GetOrientationTypeMonotonic(WordsRange currRange, WordsBitmap coverage) const;
-  ReorderingType GetOrientationTypeLeftRight(WordsRange currRange, WordsBitmap coverage) const;
+  ReorderingType GetOrientationTypeMSD(WordsRange currRange, const WordsBitmap &coverage) const;
+  ReorderingType GetOrientationTypeMSLR(WordsRange currRange, const WordsBitmap &coverage) const;
+  ReorderingType GetOrientationTypeMonotonic(WordsRange currRange, const WordsBitmap &coverage) const;
+  ReorderingType GetOrientationTypeLeftRight(WordsRange currRange, const WordsBitmap &coverage) const;
 };
 
 }
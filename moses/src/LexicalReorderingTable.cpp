@@ -8,6 +8,9 @@
 #include "TargetPhrase.h"
 #include "TargetPhraseCollection.h"
 
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
+
 namespace Moses
 {
 /*
@@ -41,6 +44,69 @@ void auxAppend(IPhrase& head, const IPhrase& tail)
     head.push_back(tail[i]);
   }
 }
+
+/*
+ * keys of the hashed tables: the factor strings of every word are hashed in
+ * order, followed by a marker for the end of the word, and every field (f, e
+ * or c) is followed by a marker for the end of the field. A word of the text
+ * table hashes like a Word with the same factors.
+ */
+const UINT64 auxWordEnd  = 1;
+const UINT64 auxFieldEnd = 2;
+
+inline UINT64 auxCombineHash(UINT64 current, UINT64 next)
+{
+  return (current * 8978948897894561157ULL) ^ ((1 + next) * 17894857484156487943ULL);
+}
+
+inline UINT64 auxHashString(UINT64 current, const char* str, size_t size)
+{
+  return auxCombineHash(current, util::MurmurHash64A(str, size));
+}
+
+UINT64 auxHashWord(UINT64 current, const Word& word, const FactorList& factors)
+{
+  for(size_t i = 0; i < factors.size(); ++i) {
+    const Factor* factor = word[factors[i]];
+    if(factor) {
+      const std::string& str = factor->GetString();
+      current = auxHashString(current, str.data(), str.size());
+    }
+  }
+  return auxCombineHash(current, auxWordEnd);
+}
+
+UINT64 auxHashWords(UINT64 current, const Phrase& phrase, size_t begin, const FactorList& factors)
+{
+  for(size_t i = begin; i < phrase.GetSize(); ++i) {
+    current = auxHashWord(current, phrase.GetWord(i), factors);
+  }
+  return auxCombineHash(current, auxFieldEnd);
+}
+
+//one word of a text table, its factors separated by factorDelimiter
+UINT64 auxHashToken(UINT64 current, const std::string& token, const std::string& factorDelimiter)
+{
+  size_t begin = 0;
+  while(true) {
+    size_t end = token.find(factorDelimiter, begin);
+    if(end == std::string::npos) {
+      current = auxHashString(current, token.data() + begin, token.size() - begin);
+      break;
+    }
+    current = auxHashString(current, token.data() + begin, end - begin);
+    begin = end + factorDelimiter.size();
+  }
+  return auxCombineHash(current, auxWordEnd);
+}
+
+//0 marks empty buckets
+inline UINT64 auxFinishKey(UINT64 key)
+{
+  return key ? key : 1;
+}
+
+const char auxHashMagic[8] = {'m', 'o', 's', 'e', 's', 'l', 'r', '2'};
 /*
  * functions for LexicalReorderingTable
  */
@@ -48,7 +114,10 @@ void auxAppend(IPhrase& head, const IPhrase& tail)
 LexicalReorderingTable* LexicalReorderingTable::LoadAvailable(const std::string& filePath, const FactorList& f_factors, const FactorList& e_factors, const FactorList& c_factors)
 {
   //decide use Tree or Memory table
-  if(FileExists(filePath+".binlexr.idx")) {
+  if(FileExists(filePath+".binlexr.hash")) {
+    //compiled hash table, mapped by the memory table
+    return new LexicalReorderingTableMemory(filePath, f_factors, e_factors, c_factors);
+  } else if(FileExists(filePath+".binlexr.idx")) {
     //there exists a binary version use that
     return new LexicalReorderingTableTree(filePath, f_factors, e_factors, c_factors);
   } else {
@@ -65,9 +134,13 @@ LexicalReorderingTableMemory::LexicalReorderingTableMemory(
   const std::vector<FactorType>& f_factors,
   const std::vector<FactorType>& e_factors,
   const std::vector<FactorType>& c_factors)
-  : LexicalReorderingTable(f_factors, e_factors, c_factors)
+  : LexicalReorderingTable(f_factors, e_factors, c_factors), m_Header(NULL), m_Scores(NULL)
 {
-  LoadFromFile(filePath);
+  if(FileExists(filePath+".binlexr.hash")) {
+    LoadBinary(filePath+".binlexr.hash");
+  } else {
+    LoadFromFile(filePath);
+  }
 }
 
 LexicalReorderingTableMemory::~LexicalReorderingTableMemory()
@@ -78,25 +151,12 @@ std::vector<float>  LexicalReorderingTableMemory::GetScore(const Phrase& f,
     const Phrase& e,
     const Phrase& c)
 {
-  //rather complicated because of const can't use []... as [] might enter new things into std::map
-  //also can't have to be careful with words range if c is empty can't use c.GetSize()-1 will underflow and be large
-  TableType::const_iterator r;
-  std::string key;
-  if(0 == c.GetSize()) {
-    key = MakeKey(f,e,c);
-    r = m_Table.find(key);
-    if(m_Table.end() != r) {
-      return r->second;
-    }
-  } else {
-    //right try from large to smaller context
-    for(size_t i = 0; i <= c.GetSize(); ++i) {
-      Phrase sub_c(c.GetSubString(WordsRange(i,c.GetSize()-1)));
-      key = MakeKey(f,e,sub_c);
-      r = m_Table.find(key);
-      if(m_Table.end() != r) {
-        return r->second;
-      }
+  //try from large to smaller context, the last try with empty context
+  TableType::ConstIterator r;
+  for(size_t i = 0; i <= c.GetSize(); ++i) {
+    if(m_Table.Find(MakeKey(f,e,c,i), r)) {
+      const float* scores = m_Scores + r->scores;
+      return Scores(scores, scores + m_Header->numScores);
     }
   }
   return Scores();
@@ -104,59 +164,138 @@ std::vector<float>  LexicalReorderingTableMemory::GetScore(const Phrase& f,
 
 void LexicalReorderingTableMemory::DbgDump(std::ostream* out) const
 {
-  TableType::const_iterator i;
-  for(i = m_Table.begin(); i != m_Table.end(); ++i) {
-    *out << " key: '" << i->first << "' score: ";
-    *out << "(num scores: " << (i->second).size() << ")";
-    for(size_t j = 0; j < (i->second).size(); ++j) {
-      *out << (i->second)[j] << " ";
+  //the keys are hashes, the strings are gone
+  const Entry* begin = reinterpret_cast<const Entry*>(m_Header + 1);
+  for(const Entry* i = begin; i != begin + m_Header->numBuckets; ++i) {
+    if(0 == i->key) {
+      continue;
+    }
+    *out << " key: " << i->key << " score: ";
+    *out << "(num scores: " << m_Header->numScores << ")";
+    for(size_t j = 0; j < m_Header->numScores; ++j) {
+      *out << m_Scores[i->scores + j] << " ";
     }
     *out << "\n";
   }
 };
 
-std::string  LexicalReorderingTableMemory::MakeKey(const Phrase& f,
+UINT64 LexicalReorderingTableMemory::MakeKey(const Phrase& f,
     const Phrase& e,
-    const Phrase& c) const
+    const Phrase& c,
+    size_t cBegin) const
 {
-  /*
-  std::string key;
-  if(!m_FactorsF.empty()){
-    key += f.GetStringRep(m_FactorsF);
+  UINT64 key = 0;
+  if(!m_FactorsF.empty()) {
+    key = auxHashWords(key, f, 0, m_FactorsF);
   }
-  if(!m_FactorsE.empty()){
-    if(!key.empty()){
-      key += " ||| ";
-    }
-    key += e.GetStringRep(m_FactorsE);
+  if(!m_FactorsE.empty()) {
+    key = auxHashWords(key, e, 0, m_FactorsE);
   }
-  */
-  return MakeKey(auxClearString(f.GetStringRep(m_FactorsF)),
-                 auxClearString(e.GetStringRep(m_FactorsE)),
-                 auxClearString(c.GetStringRep(m_FactorsC)));
+  if(!m_FactorsC.empty()) {
+    key = auxHashWords(key, c, cBegin, m_FactorsC);
+  }
+  return auxFinishKey(key);
 }
 
-std::string  LexicalReorderingTableMemory::MakeKey(const std::string& f,
-    const std::string& e,
-    const std::string& c) const
+bool LexicalReorderingTableMemory::Build(std::istream& inFile, const std::string& factorDelimiter, util::scoped_memory& to)
 {
-  std::string key;
-  if(!f.empty()) {
-    key += f;
-  }
-  if(!m_FactorsE.empty()) {
-    if(!key.empty()) {
-      key += "|||";
+  std::vector<UINT64> keys;
+  std::vector<float> scores;
+  size_t numKeyFields = 0, numScores = 0;
+  std::string line;
+  while(getline(inFile, line)) {
+    if(line.empty()) {
+      continue;
     }
-    key += e;
-  }
-  if(!m_FactorsC.empty()) {
-    if(!key.empty()) {
-      key += "|||";
+    std::vector<std::string> tokens = TokenizeMultiCharSeparator(line, "|||");
+    if(keys.empty()) {
+      //all fields but the last are the key
+      numKeyFields = tokens.size() - 1;
+    } else if(tokens.size() != numKeyFields + 1) {
+      TRACE_ERR("found inconsistent number of fields in line '" << line << "'" << std::endl);
+      return false;
+    }
+
+    UINT64 key = 0;
+    for(size_t t = 0; t < numKeyFields; ++t) {
+      std::istringstream is(tokens[t]);
+      std::string w;
+      while(is >> w) {
+        key = auxHashToken(key, w, factorDelimiter);
+      }
+      key = auxCombineHash(key, auxFieldEnd);
+    }
+    keys.push_back(auxFinishKey(key));
+
+    //last token are the probs
+    std::vector<float> p = Scan<float>(Tokenize(tokens[numKeyFields]));
+    //sanity check: all lines must have equall number of probs
+    if(1 == keys.size()) {
+      numScores = p.size(); //set in first line
+    }
+    if(p.size() != numScores) {
+      TRACE_ERR( "found inconsistent number of probabilities... found " << p.size() << " expected " << numScores << std::endl);
+      return false;
+    }
+    std::transform(p.begin(),p.end(),p.begin(),TransformScore);
+    std::transform(p.begin(),p.end(),p.begin(),FloorScore);
+    scores.insert(scores.end(), p.begin(), p.end());
+  }
+
+  const size_t tableSize = TableType::Size(keys.size(), 1.5);
+  util::MapAnonymous(sizeof(Header) + tableSize + scores.size() * sizeof(float), to);
+  char* base = static_cast<char*>(to.get());
+
+  Header* header = reinterpret_cast<Header*>(base);
+  std::copy(auxHashMagic, auxHashMagic + sizeof(auxHashMagic), header->magic);
+  factorDelimiter.copy(header->factorDelimiter, sizeof(header->factorDelimiter) - 1);
+  header->numKeyFields = numKeyFields;
+  header->numScores = numScores;
+  header->numBuckets = tableSize / sizeof(Entry);
+
+  //the memory is zeroed, i.e. all buckets are empty
+  TableType table(base + sizeof(Header), tableSize, 0);
+  UINT64 numEntries = 0;
+  for(size_t i = 0; i < keys.size(); ++i) {
+    //like the std::map the table used to be, the last line of a key wins
+    TableType::MutableIterator it;
+    if(table.UnsafeMutableFind(keys[i], it)) {
+      it->scores = i * numScores;
+    } else {
+      Entry entry;
+      entry.key = keys[i];
+      entry.scores = i * numScores;
+      table.Insert(entry);
+      ++numEntries;
     }
-    key += c;
   }
-  return key;
+  header->numEntries = numEntries;
+  if(!scores.empty()) {
+    std::copy(scores.begin(), scores.end(), reinterpret_cast<float*>(base + sizeof(Header) + tableSize));
+  }
+  return true;
+}
+
+bool LexicalReorderingTableMemory::Create(std::istream& inFile, const std::string& outFileName, const std::string& factorDelimiter)
+{
+  //stored in the header, zero terminated
+  const size_t maxDelimiterLength = sizeof(Header().factorDelimiter) - 1;
+  if(factorDelimiter.empty() || factorDelimiter.size() > maxDelimiterLength) {
+    TRACE_ERR("factor delimiter '" << factorDelimiter << "' must have 1 to " << maxDelimiterLength << " characters" << std::endl);
+    return false;
+  }
+  util::scoped_memory mem;
+  if(!Build(inFile, factorDelimiter, mem)) {
+    return false;
+  }
+  try {
+    util::scoped_fd file(util::CreateOrThrow((outFileName+".binlexr.hash").c_str()));
+    util::WriteOrThrow(file.get(), mem.get(), mem.size());
+  } catch (const util::Exception &e) {
+    TRACE_ERR(e.what() << std::endl);
+    return false;
+  }
+  return true;
 }
 
 void  LexicalReorderingTableMemory::LoadFromFile(const std::string& filePath)
@@ -166,47 +305,58 @@ void  LexicalReorderingTableMemory::LoadFromFile(const std::string& filePath)
     fileName += ".gz";
   }
   InputFileStream file(fileName);
-  std::string line(""), key("");
-  int numScores = -1;
   std::cerr << "Loading table into memory...";
-  while(!getline(file, line).eof()) {
-    std::vector<std::string> tokens = TokenizeMultiCharSeparator(line, "|||");
-    int t = 0 ;
-    std::string f(""),e(""),c("");
-
-    if(!m_FactorsF.empty()) {
-      //there should be something for f
-      f = auxClearString(tokens.at(t));
-      ++t;
-    }
-    if(!m_FactorsE.empty()) {
-      //there should be something for e
-      e = auxClearString(tokens.at(t));
-      ++t;
-    }
-    if(!m_FactorsC.empty()) {
-      //there should be something for c
-      c = auxClearString(tokens.at(t));
-      ++t;
-    }
-    //last token are the probs
-    std::vector<float> p = Scan<float>(Tokenize(tokens.at(t)));
-    //sanity check: all lines must have equall number of probs
-    if(-1 == numScores) {
-      numScores = (int)p.size(); //set in first line
-    }
-    if((int)p.size() != numScores) {
-      TRACE_ERR( "found inconsistent number of probabilities... found " << p.size() << " expected " << numScores << std::endl);
-      exit(0);
-    }
-    std::transform(p.begin(),p.end(),p.begin(),TransformScore);
-    std::transform(p.begin(),p.end(),p.begin(),FloorScore);
-    //save it all into our map
-    m_Table[MakeKey(f,e,c)] = p;
+  if(!Build(file, StaticData::Instance().GetFactorDelimiter(), m_Memory)) {
+    exit(1);
   }
+  SetTable();
   std::cerr << "done.\n";
 }
 
+void LexicalReorderingTableMemory::LoadBinary(const std::string& filePath)
+{
+  try {
+    util::scoped_fd file(util::OpenReadOrThrow(filePath.c_str()));
+    util::MapRead(util::LAZY, file.get(), 0, util::SizeFile(file.get()), m_Memory);
+  } catch (const util::Exception &e) {
+    TRACE_ERR(e.what() << std::endl);
+    exit(1);
+  }
+  if(m_Memory.size() < sizeof(Header)
+      || !std::equal(auxHashMagic, auxHashMagic + sizeof(auxHashMagic), m_Memory.begin())) {
+    TRACE_ERR(filePath << " is not a compiled reordering table" << std::endl);
+    exit(1);
+  }
+  //the keys hash the factors of each word, which the delimiter separates
+  const Header* header = reinterpret_cast<const Header*>(m_Memory.get());
+  const char* delimiterEnd = header->factorDelimiter + sizeof(header->factorDelimiter);
+  const std::string factorDelimiter(header->factorDelimiter, std::find(header->factorDelimiter, delimiterEnd, '\0'));
+  if(factorDelimiter != StaticData::Instance().GetFactorDelimiter()) {
+    TRACE_ERR(filePath << " was compiled with factor delimiter '" << factorDelimiter << "', but the decoder uses '"
+              << StaticData::Instance().GetFactorDelimiter() << "'. Compile it with processLexicalTable -factor-delimiter" << std::endl);
+    exit(1);
+  }
+  SetTable();
+  VERBOSE(2, "mapped reordering table " << filePath << ": " << m_Header->numEntries << " entries" << std::endl);
+}
+
+void LexicalReorderingTableMemory::SetTable()
+{
+  char* base = static_cast<char*>(m_Memory.get());
+  m_Header = reinterpret_cast<const Header*>(base);
+  const size_t tableSize = m_Header->numBuckets * sizeof(Entry);
+  CHECK(sizeof(Header) + tableSize <= m_Memory.size());
+  m_Table = TableType(base + sizeof(Header), tableSize, 0);
+  m_Scores = reinterpret_cast<const float*>(base + sizeof(Header) + tableSize);
+
+  //the fields of the table must be the ones of the factor masks
+  const size_t numKeyFields = !m_FactorsF.empty() + !m_FactorsE.empty() + !m_FactorsC.empty();
+  if(m_Header->numEntries && m_Header->numKeyFields != numKeyFields) {
+    TRACE_ERR("reordering table has " << m_Header->numKeyFields << " key fields, expected " << numKeyFields << std::endl);
+    exit(1);
+  }
+}
+
 /*
  * functions for LexicalReorderingTableTree
  */
@@ -509,20 +659,17 @@ bool LexicalReorderingTableTree::Create(std::istream& inFile,
   return true;
 }
 
-std::string LexicalReorderingTableTree::MakeCacheKey(const Phrase& f,
+UINT64 LexicalReorderingTableTree::MakeCacheKey(const Phrase& f,
     const Phrase& e) const
 {
-  std::string key;
+  UINT64 key = 0;
   if(!m_FactorsF.empty()) {
-    key += auxClearString(f.GetStringRep(m_FactorsF));
+    key = auxHashWords(key, f, 0, m_FactorsF);
   }
   if(!m_FactorsE.empty()) {
-    if(!key.empty()) {
-      key += "|||";
-    }
-    key += auxClearString(e.GetStringRep(m_FactorsE));
+    key = auxHashWords(key, e, 0, m_FactorsE);
   }
-  return key;
+  return auxFinishKey(key);
 };
 
 IPhrase LexicalReorderingTableTree::MakeTableKey(const Phrase& f,
@@ -560,10 +707,10 @@ IPhrase LexicalReorderingTableTree::MakeTableKey(const Phrase& f,
 
 
 struct State {
-  State(PPimp* t, const std::string& p) : pos(t), path(p) {
+  State(PPimp* t, UINT64 p) : pos(t), path(p) {
   }
   PPimp*      pos;
-  std::string path;
+  UINT64      path; //cache key of the words on the way here, without the end of the field
 };
 
 void LexicalReorderingTableTree::auxCacheForSrcPhrase(const Phrase& f)
@@ -590,19 +737,23 @@ void LexicalReorderingTableTree::auxCacheForSrcPhrase(const Phrase& f)
       return;
     }
     //2) explore whole subtree depth first & cache
-    std::string cache_key = auxClearString(f.GetStringRep(m_FactorsF)) + "|||";
+    const std::string& factorDelimiter = StaticData::Instance().GetFactorDelimiter();
+    UINT64 cache_key = 0;
+    if(!m_FactorsF.empty()) {
+      cache_key = auxHashWords(cache_key, f, 0, m_FactorsF);
+    }
 
     std::vector<State> stack;
-    stack.push_back(State(pool.get(PPimp(pPos->ptr()->getPtr(pPos->idx),0,0)),""));
+    stack.push_back(State(pool.get(PPimp(pPos->ptr()->getPtr(pPos->idx),0,0)),cache_key));
     Candidates cands;
     while(!stack.empty()) {
       if(stack.back().pos->isValid()) {
         LabelId w = stack.back().pos->ptr()->getKey(stack.back().pos->idx);
-        std::string next_path = stack.back().path + " " + m_Table->ConvertWord(w,TargetVocId);
+        UINT64 next_path = auxHashToken(stack.back().path, m_Table->ConvertWord(w,TargetVocId), factorDelimiter);
         //cache this
         m_Table->GetCandidates(*stack.back().pos,&cands);
         if(!cands.empty()) {
-          m_Cache[cache_key + auxClearString(next_path)] = cands;
+          m_Cache[auxFinishKey(auxCombineHash(next_path, auxFieldEnd))] = cands;
         }
         cands.clear();
         PPimp* next_pos = pool.get(PPimp(stack.back().pos->ptr()->getPtr(stack.back().pos->idx),0,0));
@@ -20,6 +20,9 @@
 #include "Sentence.h"
 #include "PrefixTreeMap.h"
 
+#include "util/mmap.hh"
+#include "util/probing_hash_table.hh"
+
 namespace Moses
 {
 
@@ -71,8 +74,9 @@ protected:
 
 class LexicalReorderingTableMemory : public LexicalReorderingTable
 {
-  //implements LexicalReorderingTable saving all scores in one large std::map<> thingy
-  //to be used for non binary tables... uses a LOT of memory
+  //implements LexicalReorderingTable as one hash table from a hash of the factors of f, e and c to the scores
+  //built from the text table, or mapped from a table compiled by Create() if there is one
+  //lookups don't build strings, and the table is shared between threads
 public:
   LexicalReorderingTableMemory( const std::string& filePath,
                                 const std::vector<FactorType>& f_factors,
@@ -82,14 +86,40 @@ public:
 public:
   virtual std::vector<float> GetScore(const Phrase& f, const Phrase& e, const Phrase& c);
   void DbgDump(std::ostream* out) const;
+public:
+  //! compile a text table to outFileName.binlexr.hash, whose keys only match with the same factor delimiter in the decoder
+  static bool Create(std::istream& inFile, const std::string& outFileName, const std::string& factorDelimiter = "|");
 private:
-  std::string MakeKey(const Phrase& f, const Phrase& e, const Phrase& c) const;
-  std::string MakeKey(const std::string& f, const std::string& e, const std::string& c) const;
+  struct Entry {
+    typedef UINT64 Key;
+    Key key;
+    UINT64 scores; //! index of the first score in the score array
+    Key GetKey() const {
+      return key;
+    }
+  };
+  typedef util::ProbingHashTable<Entry, util::IdentityHash> TableType;
+
+  //! start of the table, followed by the buckets of the hash table and then the scores
+  struct Header {
+    char magic[8];
+    char factorDelimiter[16]; //! of the words the keys were built from, zero terminated
+    UINT64 numKeyFields, numScores, numEntries, numBuckets;
+  };
+
+  //! hash of f, e and the suffix of c from cBegin on
+  UINT64 MakeKey(const Phrase& f, const Phrase& e, const Phrase& c, size_t cBegin = 0) const;
 
+  static bool Build(std::istream& inFile, const std::string& factorDelimiter, util::scoped_memory& to);
   void LoadFromFile(const std::string& filePath);
+  void LoadBinary(const std::string& filePath);
+  //! point m_Table and m_Scores into m_Memory
+  void SetTable();
 private:
-  typedef std::map< std::string, std::vector<float> > TableType;
+  util::scoped_memory m_Memory;
   TableType m_Table;
+  const Header *m_Header;
+  const float *m_Scores;
 };
 
 class LexicalReorderingTableTree : public LexicalReorderingTable
@@ -127,7 +157,7 @@ public:
 public:
   static bool Create(std::istream& inFile, const std::string& outFileName);
 private:
-  std::string MakeCacheKey(const Phrase& f, const Phrase& e) const;
+  UINT64      MakeCacheKey(const Phrase& f, const Phrase& e) const;
   IPhrase     MakeTableKey(const Phrase& f, const Phrase& e) const;
 
   void Cache(const ConfusionNet& input);
@@ -137,7 +167,7 @@ private:
   Scores auxFindScoreForContext(const Candidates& cands, const Phrase& contex);
 private:
   //typedef LexicalReorderingCand          CandType;
-  typedef std::map< std::string, Candidates > CacheType;
+  typedef std::map< UINT64, Candidates > CacheType; //keyed like LexicalReorderingTableMemory, but without c
 #ifdef WITH_THREADS
   typedef boost::thread_specific_ptr<PrefixTreeMap>        TableType;
 #else
@@ -82,6 +82,10 @@ void Manager::ProcessSentence()
 {
   // reset statistics
   ResetSentenceStats(m_source);
+  clock_t threadStart = 0;
+  IFSTATS {
+    threadStart = GetThreadClock();
+  }
 
   // collect translation options for this sentence
   m_system->InitializeBeforeSentenceProcessing(m_source);
@@ -90,8 +94,10 @@ void Manager::ProcessSentence()
   // some reporting on how long this took
   clock_t gotOptions = clock();
   float et = (gotOptions - m_start);
-  IFVERBOSE(2) {
-    GetSentenceStats().AddTimeCollectOpts( gotOptions - m_start );
+  IFSTATS {
+    const clock_t futureCost = m_transOptColl->GetTimeFutureCost();
+    GetSentenceStats().AddTimeCollectOpts( GetThreadClock() - threadStart - futureCost );
+    GetSentenceStats().AddTimeFutureCost( futureCost );
   }
   et /= (float)CLOCKS_PER_SEC;
   VERBOSE(1, "Collecting options took " << et << " seconds" << endl);
@@ -99,6 +105,12 @@ void Manager::ProcessSentence()
   // search for best translation with the specified algorithm
   m_search->ProcessSentence();
   VERBOSE(1, "Search took " << ((clock()-m_start)/(float)CLOCKS_PER_SEC) << " seconds" << endl);
+
+  // some more logging
+  IFSTATS {
+    GetSentenceStats().SetTimeTotal( GetThreadClock() - threadStart );
+  }
+  VERBOSE(2, GetSentenceStats());
 }
 
 /**
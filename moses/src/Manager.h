@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <ctime>
 #include "InputType.h"
 #include "Hypothesis.h"
+#include "Arena.h"
 #include "StaticData.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
@@ -105,6 +106,7 @@ protected:
   size_t interrupted_flag;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   int m_hypoId; //used to number the hypos as they are created.
+  Arena m_arena; /**< memory of the hypotheses created by the decoding thread */
 
   void GetConnectedGraph(
     std::map< int, bool >* pConnected,
@@ -133,6 +135,10 @@ public:
   void printThisHypothesis(long translationId, const Hypothesis* hypo, const std::vector <const TargetPhrase* > & remainingPhrases, float remainingScore , std::ostream& outputStream) const;
   void GetWordGraph(long translationId, std::ostream &outputWordGraphStream) const;
   int GetNextHypoId();
+  //! per-sentence memory for use by the decoding thread only
+  Arena &GetArena() {
+    return m_arena;
+  }
 #ifdef HAVE_PROTOBUF
   void SerializeSearchGraphPB(long translationId, std::ostream& outputStream) const;
 #endif
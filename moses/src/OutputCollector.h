@@ -23,28 +23,62 @@
 
 #ifdef WITH_THREADS
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #endif
 
 #ifdef BOOST_HAS_PTHREADS
 #include <pthread.h>
 #endif
 
+#include <cstddef>
 #include <iostream>
-#include <map>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace Moses
 {
 /**
   * Makes sure output goes in the correct order.
+  * Output that arrives early waits in a ring of slots, indexed by the
+  * distance from the next sentence to be written. Whenever the next sentence
+  * arrives, it and all waiting sentences that follow it are written at once.
+  * With a window, the thread that hands out the sentences can wait until
+  * it is less than that many sentences ahead of the output.
   **/
 class OutputCollector
 {
 public:
   OutputCollector(std::ostream* outStream= &std::cout, std::ostream* debugStream=&std::cerr) :
-    m_nextOutput(0),m_outStream(outStream),m_debugStream(debugStream)  {}
+    m_slots(16),m_first(0),m_nextOutput(0),m_outStream(outStream),m_debugStream(debugStream),
+    m_window(0),m_waiting(0),m_maxWaiting(0),m_waits(0)  {}
 
+  /**
+    * Let WaitForSpace() block until sourceId is less than window sentences
+    * ahead of the output. 0, the default, never blocks.
+    **/
+  void SetWindow(size_t window) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_window = window;
+  }
+
+  /**
+    * Wait until sourceId is within the window. Must not be called from a
+    * thread that still has to write one of the sentences before it.
+    **/
+  void WaitForSpace(int sourceId) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_window > 0 && sourceId >= m_nextOutput + (int) m_window) {
+      ++m_waits;
+      while (sourceId >= m_nextOutput + (int) m_window) {
+        m_written.wait(lock);
+      }
+    }
+#endif
+  }
 
   /**
     * Write or cache the output, as appropriate.
@@ -53,37 +87,97 @@ public:
 #ifdef WITH_THREADS
     boost::mutex::scoped_lock lock(m_mutex);
 #endif
-    if (sourceId == m_nextOutput) {
-      //This is the one we were expecting
-      *m_outStream << output << std::flush;
-      *m_debugStream << debug << std::flush;
-      ++m_nextOutput;
-      //see if there's any more
-      std::map<int,std::string>::iterator iter;
-      while ((iter = m_outputs.find(m_nextOutput)) != m_outputs.end()) {
-        *m_outStream << iter->second << std::flush;
-        m_outputs.erase(iter);
-        ++m_nextOutput;
-        std::map<int,std::string>::iterator debugIter = m_debugs.find(iter->first);
-        if (debugIter != m_debugs.end()) {
-          *m_debugStream << debugIter->second << std::flush;
-          m_debugs.erase(debugIter);
-        }
-      }
-    } else {
+    if (sourceId != m_nextOutput) {
       //save for later
-      m_outputs[sourceId] = output;
-      m_debugs[sourceId] = debug;
+      size_t ahead = sourceId - m_nextOutput;
+      while (ahead >= m_slots.size()) {
+        Grow();
+      }
+      Slot &slot = m_slots[Index(ahead)];
+      slot.filled = true;
+      slot.output = output;
+      slot.debug = debug;
+      if (++m_waiting > m_maxWaiting) {
+        m_maxWaiting = m_waiting;
+      }
+      return;
     }
+
+    //This is the one we were expecting, collect it and any that follow
+    m_output = output;
+    m_debug = debug;
+    Advance();
+    while (m_slots[m_first].filled) {
+      Slot &slot = m_slots[m_first];
+      m_output += slot.output;
+      m_debug += slot.debug;
+      slot.filled = false;
+      slot.output.clear();
+      slot.debug.clear();
+      --m_waiting;
+      Advance();
+    }
+    *m_outStream << m_output << std::flush;
+    *m_debugStream << m_debug << std::flush;
+    m_output.clear();
+    m_debug.clear();
+#ifdef WITH_THREADS
+    m_written.notify_all();
+#endif
   }
+
+  //! most sentences that were waiting for an earlier one at the same time
+  size_t GetMaxWaiting() const {
+    return m_maxWaiting;
+  }
+
+  //! number of times WaitForSpace() blocked
+  size_t GetNumWaits() const {
+    return m_waits;
+  }
+
 private:
-  std::map<int,std::string> m_outputs;
-  std::map<int,std::string> m_debugs;
+  struct Slot {
+    bool filled;
+    std::string output;
+    std::string debug;
+    Slot() : filled(false) {}
+  };
+
+  //! slot of the sentence ahead sentences after the next one to be written
+  size_t Index(size_t ahead) const {
+    return (m_first + ahead) & (m_slots.size() - 1);
+  }
+
+  void Advance() {
+    m_first = Index(1);
+    ++m_nextOutput;
+  }
+
+  //! double the ring, keeping the waiting output at its distance from the next sentence
+  void Grow() {
+    std::vector<Slot> slots(m_slots.size() * 2);
+    for (size_t ahead = 0; ahead < m_slots.size(); ++ahead) {
+      Slot &slot = m_slots[Index(ahead)];
+      slots[ahead].filled = slot.filled;
+      slots[ahead].output.swap(slot.output);
+      slots[ahead].debug.swap(slot.debug);
+    }
+    m_slots.swap(slots);
+    m_first = 0;
+  }
+
+  std::vector<Slot> m_slots; //! size is a power of 2
+  size_t m_first; //! slot of m_nextOutput
   int m_nextOutput;
+  std::string m_output, m_debug; //! a run of sentences being written
   std::ostream* m_outStream;
   std::ostream* m_debugStream;
+  size_t m_window;
+  size_t m_waiting, m_maxWaiting, m_waits;
 #ifdef WITH_THREADS
   boost::mutex m_mutex;
+  boost::condition_variable m_written;
 #endif
 };
 
@@ -76,7 +76,11 @@ Parameter::Parameter()
   AddParam("stack", "s", "maximum stack size for histogram pruning");
   AddParam("stack-diversity", "sd", "minimum number of hypothesis of each coverage in stack (default 0)");
   AddParam("threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam("search-threads", "number of threads used to decode a single sentence: the hypotheses of a stack (stack decoding) or the cells of a span width (chart decoding) are processed in parallel (default 1 = serial)");
+  AddParam("read-ahead", "number of input sentences read and parsed ahead of decoding on a separate thread (default 0 = read on the main thread)");
+  AddParam("load-threads", "number of threads reading the files of language models, phrase tables and other models at the same time (default 1)");
   AddParam("translation-details", "T", "for each best hypothesis, report translation details to the given file");
+  AddParam("sentence-stats", "for each sentence, write the time spent in each step of decoding and the hypothesis counts to the given file as a line of JSON, followed by the totals at the end");
   AddParam("ttable-file", "location and properties of the translation tables");
   AddParam("ttable-limit", "ttl", "maximum number of translation table entries per input phrase");
   AddParam("translation-option-threshold", "tot", "threshold for translation options relative to best for input phrase");
@@ -114,6 +118,7 @@ Parameter::Parameter()
   AddParam("clean-lm-cache", "clean language model caches after N translations (default N=1)");
   AddParam("use-persistent-cache", "cache translation options across sentences (default true)");
   AddParam("persistent-cache-size", "maximum size of cache for translation options (default 10,000 input phrases)");
+  AddParam("rule-cache-size", "maximum number of target phrase collections of on-disk rule tables kept across sentences (default 10,000, 0 disables)");
   AddParam("recover-input-path", "r", "(conf net/word lattice only) - recover input path corresponding to the best translation");
   AddParam("output-word-graph", "owg", "Output stack info as word graph. Takes filename, 0=only hypos in stack, 1=stack + nbest hypos");
   AddParam("time-out", "seconds after which is interrupted (-1=no time-out, default is -1)");
@@ -138,15 +138,15 @@ void Phrase::PrependWord(const Word &newWord)
 
 void Phrase::CreateFromString(const std::vector<FactorType> &factorOrder, const StringPiece &phraseString, const StringPiece &factorDelimiter)
 {
-  FactorCollection &factorCollection = FactorCollection::Instance();
-
-  for (util::TokenIter<util::AnyCharacter, true> word_it(phraseString, util::AnyCharacter(" \t")); word_it; ++word_it) {
-    Word &word = AddWord();
+  // split up all words first, so that the factors are added in one go
+  std::vector<StringPiece> factorStrings;
+  size_t numWords = 0;
+  for (util::TokenIter<util::AnyCharacter, true> word_it(phraseString, util::AnyCharacter(" \t")); word_it; ++word_it, ++numWords) {
     size_t index = 0;
     for (util::TokenIter<util::MultiCharacter, false> factor_it(*word_it, util::MultiCharacter(factorDelimiter)); 
         factor_it && (index < factorOrder.size()); 
         ++factor_it, ++index) {
-      word[factorOrder[index]] = factorCollection.AddFactor(*factor_it);
+      factorStrings.push_back(*factor_it);
     }
     if (index != factorOrder.size()) {
       TRACE_ERR( "[ERROR] Malformed input: '" << *word_it << "'" <<  std::endl
@@ -156,6 +156,16 @@ void Phrase::CreateFromString(const std::vector<FactorType> &factorOrder, const
       abort();
     }
   }
+
+  std::vector<const Factor*> factors;
+  FactorCollection::Instance().AddFactors(factorStrings, factors);
+  std::vector<const Factor*>::const_iterator factor = factors.begin();
+  for (size_t pos = 0; pos < numWords; ++pos) {
+    Word &word = AddWord();
+    for (size_t index = 0; index < factorOrder.size(); ++index) {
+      word[factorOrder[index]] = *factor++;
+    }
+  }
 }
 
 void Phrase::CreateFromStringNewFormat(FactorDirection direction
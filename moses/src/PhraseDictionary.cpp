@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "PhraseDictionary.h"
 #include "PhraseDictionaryTreeAdaptor.h"
+#include "PhraseDictionaryTreeMmap.h"
 #include "RuleTable/PhraseDictionarySCFG.h"
 #include "RuleTable/PhraseDictionaryOnDisk.h"
 #include "RuleTable/PhraseDictionaryALSuffixArray.h"
@@ -68,7 +69,8 @@ PhraseDictionaryFeature::PhraseDictionaryFeature
 {
   const StaticData& staticData = StaticData::Instance();
   const_cast<ScoreIndexManager&>(staticData.GetScoreIndexManager()).AddScoreProducer(this);
-  if (implementation == Memory || implementation == SCFG || implementation == SuffixArray) {
+  if (implementation == Memory || implementation == SCFG || implementation == SuffixArray ||
+      implementation == BinaryMmap || implementation == OnDisk) {
     m_useThreadSafePhraseDictionary = true;
   } else {
     m_useThreadSafePhraseDictionary = false;
@@ -110,6 +112,23 @@ PhraseDictionary* PhraseDictionaryFeature::LoadPhraseTable(const TranslationSyst
                , system->GetWeightWordPenalty());
     CHECK(ret);
     return pdta;
+  } else if (m_implementation == BinaryMmap) {
+    // same files as Binary, but mapped once and shared by all threads
+    VERBOSE(2,"using memory mapped binary phrase tables" << std::endl);
+    if (staticData.GetInputType() != SentenceInput) {
+      UserMessage::Add("Must use binary phrase table (1) for this input type");
+      CHECK(false);
+    }
+    PhraseDictionaryTreeMmap* pdtm = new PhraseDictionaryTreeMmap(m_numScoreComponent, this);
+    bool ret = pdtm->Load(GetInput()
+                          , GetOutput()
+                          , m_filePath
+                          , m_weight
+                          , m_tableLimit
+                          , system->GetLanguageModels()
+                          , system->GetWeightWordPenalty());
+    CHECK(ret);
+    return pdtm;
   } else if (m_implementation == SCFG || m_implementation == Hiero) {
     // memory phrase table
     if (m_implementation == Hiero) {
@@ -127,6 +127,15 @@ public:
   //Get the dictionary. Be sure to initialise it first.
   const PhraseDictionary* GetDictionary() const;
 
+  //Whether the same dictionary is shared by all threads
+  bool IsThreadSafe() const {
+    return m_useThreadSafePhraseDictionary;
+  }
+
+  const std::string &GetFilePath() const {
+    return m_filePath;
+  }
+
 private:
   /** Load the appropriate phrase table */
   PhraseDictionary* LoadPhraseTable(const TranslationSystem* system);
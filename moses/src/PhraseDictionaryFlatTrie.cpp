@@ -0,0 +1,160 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <limits>
+#include "util/check.hh"
+#include "PhraseDictionaryFlatTrie.h"
+#include "PhraseDictionaryNode.h"
+#include "Phrase.h"
+#include "Factor.h"
+#include "Util.h"
+
+namespace Moses
+{
+
+namespace
+{
+
+struct ChildEntry {
+  UINT32 key[MAX_NUM_FACTORS]; /**< unused factors are 0 for all children */
+  PhraseDictionaryNode *node;
+
+  bool operator<(const ChildEntry &other) const {
+    return std::lexicographical_compare(key, key + MAX_NUM_FACTORS, other.key, other.key + MAX_NUM_FACTORS);
+  }
+};
+
+}
+
+PhraseDictionaryFlatTrie::~PhraseDictionaryFlatTrie()
+{
+  Clear();
+}
+
+void PhraseDictionaryFlatTrie::Clear()
+{
+  for (size_t i = 0 ; i < m_nodes.size() ; ++i) {
+    delete m_nodes[i].targetPhraseCollection;
+  }
+  m_nodes.clear();
+  m_keys.clear();
+}
+
+void PhraseDictionaryFlatTrie::Build(PhraseDictionaryNode &root, const std::vector<FactorType> &factors)
+{
+  CHECK(!factors.empty() && factors.size() <= MAX_NUM_FACTORS);
+  Clear();
+  m_factors = factors;
+  const size_t stride = m_factors.size();
+
+  // nodes are numbered in the order they are queued, i.e. breadth first,
+  // so the children of each node get consecutive numbers
+  std::vector<PhraseDictionaryNode*> queue;
+  std::vector<ChildEntry> children;
+  queue.push_back(&root);
+  m_keys.resize(stride, 0);
+
+  for (size_t pos = 0 ; pos < queue.size() ; ++pos) {
+    PhraseDictionaryNode &node = *queue[pos];
+
+    Node flat;
+    flat.targetPhraseCollection = node.m_targetPhraseCollection;
+    flat.firstChild = queue.size();
+    flat.numChildren = node.m_map.size();
+    node.m_targetPhraseCollection = NULL;
+    m_nodes.push_back(flat);
+
+    children.clear();
+    for (PhraseDictionaryNode::iterator iter = node.begin() ; iter != node.end() ; ++iter) {
+      ChildEntry child;
+      std::fill(child.key, child.key + MAX_NUM_FACTORS, 0);
+      bool hasKey = GetKey(iter->first, child.key);
+      CHECK(hasKey);
+      child.node = &iter->second;
+      children.push_back(child);
+    }
+    std::sort(children.begin(), children.end());
+
+    for (size_t i = 0 ; i < children.size() ; ++i) {
+      queue.push_back(children[i].node);
+      m_keys.insert(m_keys.end(), children[i].key, children[i].key + stride);
+    }
+    CHECK(queue.size() < std::numeric_limits<UINT32>::max());
+  }
+
+  // the collections belong to the flat trie now
+  root.m_map.clear();
+  ShrinkToFit(m_nodes);
+  ShrinkToFit(m_keys);
+}
+
+bool PhraseDictionaryFlatTrie::GetKey(const Word &word, UINT32 *key) const
+{
+  for (size_t i = 0 ; i < m_factors.size() ; ++i) {
+    const Factor *factor = word[m_factors[i]];
+    if (factor == NULL)
+      return false;
+    CHECK(factor->GetId() < std::numeric_limits<UINT32>::max());
+    key[i] = factor->GetId();
+  }
+  return true;
+}
+
+UINT32 PhraseDictionaryFlatTrie::GetChild(UINT32 node, const UINT32 *key) const
+{
+  const size_t stride = m_factors.size();
+  const Node &parent = m_nodes[node];
+
+  size_t first = parent.firstChild, last = first + parent.numChildren;
+  while (first < last) {
+    const size_t middle = first + (last - first) / 2;
+    const UINT32 *middleKey = &m_keys[middle * stride];
+    const std::pair<const UINT32*, const UINT32*> diff = std::mismatch(middleKey, middleKey + stride, key);
+    if (diff.first == middleKey + stride)
+      return middle;
+    if (*diff.first < *diff.second)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+  return NOT_FOUND_NODE;
+}
+
+const TargetPhraseCollection *PhraseDictionaryFlatTrie::GetTargetPhraseCollection(const Phrase &source) const
+{
+  if (m_nodes.empty())
+    return NULL;
+
+  UINT32 key[MAX_NUM_FACTORS];
+  UINT32 node = 0;
+  for (size_t pos = 0 ; pos < source.GetSize() ; ++pos) {
+    if (!GetKey(source.GetWord(pos), key))
+      return NULL;
+    node = GetChild(node, key);
+    if (node == NOT_FOUND_NODE)
+      return NULL;
+  }
+
+  return m_nodes[node].targetPhraseCollection;
+}
+
+}
@@ -0,0 +1,87 @@
+// $Id$
+// vim:tabstop=2
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_PhraseDictionaryFlatTrie_h
+#define moses_PhraseDictionaryFlatTrie_h
+
+#include <vector>
+#include "TypeDef.h"
+
+namespace Moses
+{
+
+class Phrase;
+class Word;
+class PhraseDictionaryNode;
+class TargetPhraseCollection;
+
+/** Read-only form of the PhraseDictionaryMemory trie, built once loading is
+ *  finished.
+ *  All nodes live in one array in breadth first order, so the children of a
+ *  node are a contiguous range, sorted by the ids of the factors the table is
+ *  keyed on. A lookup step is a binary search over that range instead of a
+ *  walk through a std::map of Words.
+ */
+class PhraseDictionaryFlatTrie
+{
+public:
+  PhraseDictionaryFlatTrie() {}
+  ~PhraseDictionaryFlatTrie();
+
+  /** take over the target phrase collections of the tree under root and
+   *  free the tree. factors are the source factors the table was loaded with
+   */
+  void Build(PhraseDictionaryNode &root, const std::vector<FactorType> &factors);
+  void Clear();
+
+  //! translations of source, or NULL
+  const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase &source) const;
+
+  size_t GetSize() const {
+    return m_nodes.size();
+  }
+
+protected:
+  struct Node {
+    TargetPhraseCollection *targetPhraseCollection;
+    UINT32 firstChild;
+    UINT32 numChildren;
+  };
+
+  static const UINT32 NOT_FOUND_NODE = 0; /**< the root is nobody's child */
+
+  //! child of node labelled with key, or NOT_FOUND_NODE
+  UINT32 GetChild(UINT32 node, const UINT32 *key) const;
+  //! key of word, m_factors.size() factor ids. false if a factor is missing
+  bool GetKey(const Word &word, UINT32 *key) const;
+
+  std::vector<FactorType> m_factors;
+  std::vector<Node> m_nodes;
+  std::vector<UINT32> m_keys; /**< m_factors.size() factor ids per node, labels of the edges into the nodes */
+
+private:
+  PhraseDictionaryFlatTrie(const PhraseDictionaryFlatTrie &); // not implemented
+  void operator=(const PhraseDictionaryFlatTrie &); // not implemented
+};
+
+}
+#endif
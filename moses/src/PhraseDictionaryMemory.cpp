@@ -161,6 +161,10 @@ bool PhraseDictionaryMemory::Load(const std::vector<FactorType> &input
   // sort each target phrase collection
   m_collection.Sort(m_tableLimit);
 
+  // move the collections into the compact read-only trie
+  m_trie.Build(m_collection, input);
+  VERBOSE(2, "phrase table trie has " << m_trie.GetSize() << " nodes" << std::endl);
+
   return true;
 }
 
@@ -181,18 +185,7 @@ TargetPhraseCollection *PhraseDictionaryMemory::CreateTargetPhraseCollection(con
 
 const TargetPhraseCollection *PhraseDictionaryMemory::GetTargetPhraseCollection(const Phrase &source) const
 {
-  // exactly like CreateTargetPhraseCollection, but don't create
-  const size_t size = source.GetSize();
-
-  const PhraseDictionaryNode *currNode = &m_collection;
-  for (size_t pos = 0 ; pos < size ; ++pos) {
-    const Word& word = source.GetWord(pos);
-    currNode = currNode->GetChild(word);
-    if (currNode == NULL)
-      return NULL;
-  }
-
-  return currNode->GetTargetPhraseCollection();
+  return m_trie.GetTargetPhraseCollection(source);
 }
 
 PhraseDictionaryMemory::~PhraseDictionaryMemory()
@@ -204,12 +197,8 @@ TO_STRING_BODY(PhraseDictionaryMemory);
 // friend
 ostream& operator<<(ostream& out, const PhraseDictionaryMemory& phraseDict)
 {
-  const PhraseDictionaryNode &coll = phraseDict.m_collection;
-  PhraseDictionaryNode::const_iterator iter;
-  for (iter = coll.begin() ; iter != coll.end() ; ++iter) {
-    const Word &word = (*iter).first;
-    out << word;
-  }
+  // the words themselves are not kept after loading
+  out << "PhraseDictionaryMemory with " << phraseDict.m_trie.GetSize() << " trie nodes";
   return out;
 }
 
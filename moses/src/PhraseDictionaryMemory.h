@@ -25,12 +25,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "PhraseDictionary.h"
 #include "PhraseDictionaryNode.h"
+#include "PhraseDictionaryFlatTrie.h"
 
 namespace Moses
 {
 
 /*** Implementation of a phrase table in a trie.  Looking up a phrase of
  * length n words requires n look-ups to find the TargetPhraseCollection.
+ * The trie is built from PhraseDictionaryNodes and flattened into a
+ * PhraseDictionaryFlatTrie once the table is loaded.
  */
 class PhraseDictionaryMemory : public PhraseDictionary
 {
@@ -38,7 +41,8 @@ class PhraseDictionaryMemory : public PhraseDictionary
   friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryMemory&);
 
 protected:
-  PhraseDictionaryNode m_collection;
+  PhraseDictionaryNode m_collection; /**< only used while loading */
+  PhraseDictionaryFlatTrie m_trie;
 
   TargetPhraseCollection *CreateTargetPhraseCollection(const Phrase &source);
 
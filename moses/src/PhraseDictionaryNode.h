@@ -34,8 +34,10 @@ namespace Moses
 
 class PhraseDictionaryMemory;
 class PhraseDictionaryFeature;
+class PhraseDictionaryFlatTrie;
 
-/** One node of the PhraseDictionaryMemory structure
+/** One node of the PhraseDictionaryMemory structure while it is loaded.
+ *  Lookups go through the PhraseDictionaryFlatTrie built from it afterwards.
 */
 class PhraseDictionaryNode
 {
@@ -43,6 +45,7 @@ class PhraseDictionaryNode
 
   // only these classes are allowed to instantiate this class
   friend class PhraseDictionaryMemory;
+  friend class PhraseDictionaryFlatTrie;
   friend class std::map<Word, PhraseDictionaryNode>;
 
 protected:
@@ -0,0 +1,263 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/string_piece.hh"
+
+#include "PhraseDictionaryTreeMmap.h"
+#include "InputType.h"
+#include "StaticData.h"
+#include "TargetPhrase.h"
+#include "UserMessage.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+
+// the binary files are written with fwrite, so read values with memcpy
+// rather than assuming they are aligned in the mapping
+template <class T> inline T ReadMapped(const char *&pos)
+{
+  T ret;
+  memcpy(&ret, pos, sizeof(T));
+  pos += sizeof(T);
+  return ret;
+}
+
+void MapFile(const string &filePath, util::scoped_memory &to)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(filePath.c_str()));
+  util::MapRead(util::LAZY, file.get(), 0, util::SizeFile(file.get()), to);
+}
+
+}
+
+PhraseDictionaryTreeMmap::ThreadLocalStorage::~ThreadLocalStorage()
+{
+  for (SourceCache::iterator iter = cache.begin() ; iter != cache.end() ; ++iter) {
+    delete iter->second;
+  }
+}
+
+PhraseDictionaryTreeMmap::PhraseDictionaryTreeMmap(size_t numScoreComponent, const PhraseDictionaryFeature* feature)
+  : PhraseDictionary(numScoreComponent, feature)
+  , m_useAlignment(false)
+  , m_languageModels(NULL)
+  , m_weightWP(0)
+{
+}
+
+PhraseDictionaryTreeMmap::~PhraseDictionaryTreeMmap()
+{
+}
+
+bool PhraseDictionaryTreeMmap::Load(const std::vector<FactorType> &input
+                                    , const std::vector<FactorType> &output
+                                    , const std::string &filePath
+                                    , const std::vector<float> &weight
+                                    , size_t tableLimit
+                                    , const LMList &languageModels
+                                    , float weightWP)
+{
+  if(m_numScoreComponent!=weight.size()) {
+    std::stringstream strme;
+    strme << "ERROR: mismatch of number of scaling factors: "<<weight.size()
+          <<" "<<m_numScoreComponent<<"\n";
+    UserMessage::Add(strme.str());
+    return false;
+  }
+
+  m_tableLimit = tableLimit;
+  m_input = input;
+  m_output = output;
+  m_weight = weight;
+  m_languageModels = &languageModels;
+  m_weightWP = weightWP;
+  m_useAlignment = StaticData::Instance().UseAlignmentInfo();
+
+  const string suffix = m_useAlignment ? ".wa" : "";
+  const string srcTreeFile = filePath + ".binphr.srctree" + suffix
+               , tgtDataFile = filePath + ".binphr.tgtdata" + suffix
+               , idxFile = filePath + ".binphr.idx";
+  if (!FileExists(srcTreeFile) || !FileExists(tgtDataFile) || !FileExists(idxFile)) {
+    UserMessage::Add("binary phrase table " + filePath + " not found"
+                     + (m_useAlignment ? " (with word alignment, .wa)" : "") + "\n");
+    return false;
+  }
+
+  try {
+    MapFile(srcTreeFile, m_srcTree);
+    MapFile(tgtDataFile, m_tgtData);
+  } catch (const util::Exception &e) {
+    UserMessage::Add(e.what());
+    return false;
+  }
+
+  FILE *idx = fOpen(idxFile.c_str(), "rb");
+  fReadVector(idx, m_srcOffsets);
+  fClose(idx);
+
+  m_srcVoc.Read(filePath + ".binphr.srcvoc");
+  m_tgtVoc.Read(filePath + ".binphr.tgtvoc");
+
+  VERBOSE(2, "mapped binary phrase table " << filePath << ": " << m_srcTree.size()
+          << " bytes source tree, " << m_tgtData.size() << " bytes target data" << endl);
+  return true;
+}
+
+OFF_T PhraseDictionaryTreeMmap::FindSource(const IPhrase &src) const
+{
+  if (src.empty() || src[0] >= m_srcOffsets.size()) return InvalidOffT;
+  OFF_T node = m_srcOffsets[src[0]];
+  if (node == InvalidOffT) return InvalidOffT;
+
+  // node layout, see PrefixTreeF::create():
+  //   UINT32 size, LabelId keys[size], UINT32 size, OFF_T data[size], OFF_T children[size]
+  // every field is a multiple of 4 bytes, so the keys can be searched in place
+  for (size_t i = 0 ; ; ++i) {
+    CHECK(node >= 0 && static_cast<size_t>(node) < m_srcTree.size());
+    const char *pos = m_srcTree.begin() + node;
+    const UINT32 size = ReadMapped<UINT32>(pos);
+    const LabelId *keys = reinterpret_cast<const LabelId*>(pos);
+    const LabelId *key = std::lower_bound(keys, keys + size, src[i]);
+    if (key == keys + size || *key != src[i]) return InvalidOffT;
+    const size_t index = key - keys;
+    pos += size * sizeof(LabelId) + sizeof(UINT32);
+
+    if (i + 1 == src.size()) {
+      const char *data = pos + index * sizeof(OFF_T);
+      return ReadMapped<OFF_T>(data);
+    }
+    const char *child = pos + (size + index) * sizeof(OFF_T);
+    node = ReadMapped<OFF_T>(child);
+    if (node == 0) return InvalidOffT;
+  }
+}
+
+TargetPhraseCollection *PhraseDictionaryTreeMmap::CreateTargetPhraseCollection(OFF_T offset, const Phrase &src) const
+{
+  // record layout, see TgtCands::writeBin():
+  //   UINT32 count, then per candidate
+  //   UINT32 size, LabelId words[size], UINT32 size, float scores[size] [, UINT32 size, char alignment[size]]
+  CHECK(offset >= 0 && static_cast<size_t>(offset) < m_tgtData.size());
+  const char *pos = m_tgtData.begin() + offset;
+  const string &factorDelimiter = StaticData::Instance().GetFactorDelimiter();
+
+  TargetPhraseCollection *ret = new TargetPhraseCollection;
+  const UINT32 numCands = ReadMapped<UINT32>(pos);
+  std::vector<float> scoreVector;
+  for (UINT32 cand = 0 ; cand < numCands ; ++cand) {
+    TargetPhrase *targetPhrase = new TargetPhrase(Output);
+
+    const UINT32 numWords = ReadMapped<UINT32>(pos);
+    for (UINT32 i = 0 ; i < numWords ; ++i) {
+      const string &word = m_tgtVoc.symbol(ReadMapped<LabelId>(pos));
+      targetPhrase->CreateFromString(m_output, word, factorDelimiter);
+    }
+
+    const UINT32 numScores = ReadMapped<UINT32>(pos);
+    scoreVector.resize(numScores);
+    for (UINT32 i = 0 ; i < numScores ; ++i) {
+      scoreVector[i] = FloorScore(TransformScore(ReadMapped<float>(pos)));
+    }
+
+    if (m_useAlignment) {
+      const UINT32 alignmentSize = ReadMapped<UINT32>(pos);
+      targetPhrase->SetAlignmentInfo(StringPiece(pos, alignmentSize));
+      pos += alignmentSize;
+    }
+
+    targetPhrase->SetScore(m_feature, scoreVector, m_weight, m_weightWP, *m_languageModels);
+    targetPhrase->SetSourcePhrase(&src);
+    ret->Add(targetPhrase);
+  }
+
+  ret->Prune(m_tableLimit > 0, m_tableLimit);
+  return ret;
+}
+
+PhraseDictionaryTreeMmap::ThreadLocalStorage &PhraseDictionaryTreeMmap::GetLocal() const
+{
+  if (m_local.get() == NULL) {
+    m_local.reset(new ThreadLocalStorage);
+  }
+  return *m_local;
+}
+
+const TargetPhraseCollection *PhraseDictionaryTreeMmap::GetTargetPhraseCollection(const Phrase &src) const
+{
+  if (src.GetSize() == 0) return NULL;
+
+  // remember misses too, the translation option collection asks for every span
+  SourceCache &cache = GetLocal().cache;
+  std::pair<SourceCache::iterator, bool> inserted =
+    cache.insert(std::make_pair(src, static_cast<TargetPhraseCollection*>(NULL)));
+  if (!inserted.second) return inserted.first->second;
+
+  IPhrase f(src.GetSize());
+  for (size_t i = 0 ; i < f.size() ; ++i) {
+    f[i] = m_srcVoc.index(src.GetWord(i).GetString(m_input, false));
+    if (f[i] == InvalidLabelId) return NULL;
+  }
+
+  OFF_T offset = FindSource(f);
+  if (offset == InvalidOffT) return NULL;
+
+  // the cache key outlives the collection, so the target phrases can point to it
+  TargetPhraseCollection *ret = CreateTargetPhraseCollection(offset, inserted.first->first);
+  if (ret->IsEmpty()) {
+    delete ret;
+    return NULL;
+  }
+  inserted.first->second = ret;
+  return ret;
+}
+
+void PhraseDictionaryTreeMmap::InitializeForInput(InputType const& source)
+{
+  if (source.GetType() != SentenceInput) {
+    UserMessage::Add("memory mapped binary phrase table only supports sentence input\n");
+    CHECK(false);
+  }
+  m_local.reset(new ThreadLocalStorage);
+}
+
+std::string PhraseDictionaryTreeMmap::GetScoreProducerDescription(unsigned) const
+{
+  return "PhraseModel";
+}
+
+std::string PhraseDictionaryTreeMmap::GetScoreProducerWeightShortName(unsigned) const
+{
+  return "tm";
+}
+
+}
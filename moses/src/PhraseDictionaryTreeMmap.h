@@ -0,0 +1,121 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_PhraseDictionaryTreeMmap_h
+#define moses_PhraseDictionaryTreeMmap_h
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
+#include "util/check.hh"
+#include "util/mmap.hh"
+#include "File.h"
+#include "LVoc.h"
+#include "PhraseDictionary.h"
+#include "TypeDef.h"
+
+namespace Moses
+{
+
+class LMList;
+
+/** Read-only, memory mapped access to a binary phrase table as written by
+ *  processPhraseTable (the .binphr.* files of PhraseDictionaryTree).
+ *  The prefix tree and the target candidates are decoded in place from the
+ *  mapping, so there are no file handles or seek positions to protect and a
+ *  single instance is shared by all decoding threads. Only the target phrase
+ *  collections handed out for the current sentence are thread specific.
+ *  Supports sentence input only; confusion networks still need the
+ *  PhraseDictionaryTreeAdaptor.
+ */
+class PhraseDictionaryTreeMmap : public PhraseDictionary
+{
+  typedef LVoc<std::string> WordVoc;
+  typedef std::map<Phrase, TargetPhraseCollection*> SourceCache;
+
+  struct ThreadLocalStorage {
+    SourceCache cache;
+
+    ~ThreadLocalStorage();
+  };
+
+public:
+  PhraseDictionaryTreeMmap(size_t numScoreComponent, const PhraseDictionaryFeature* feature);
+  ~PhraseDictionaryTreeMmap();
+
+  bool Load(const std::vector<FactorType> &input
+            , const std::vector<FactorType> &output
+            , const std::string &filePath
+            , const std::vector<float> &weight
+            , size_t tableLimit
+            , const LMList &languageModels
+            , float weightWP);
+
+  const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase &src) const;
+  void InitializeForInput(InputType const& source);
+
+  virtual ChartRuleLookupManager *CreateRuleLookupManager(
+    const InputType &,
+    const ChartCellCollection &) {
+    CHECK(false);
+    return 0;
+  }
+
+  std::string GetScoreProducerDescription(unsigned idx=0) const;
+  std::string GetScoreProducerWeightShortName(unsigned idx=0) const;
+
+protected:
+  //! offset of the target candidates of src in the target data, or InvalidOffT
+  OFF_T FindSource(const IPhrase &src) const;
+  //! decode the candidates at offset into a new collection
+  TargetPhraseCollection *CreateTargetPhraseCollection(OFF_T offset, const Phrase &src) const;
+  ThreadLocalStorage &GetLocal() const;
+
+  util::scoped_memory m_srcTree, m_tgtData;
+  std::vector<OFF_T> m_srcOffsets; /**< root of the prefix tree for each first source word */
+  WordVoc m_srcVoc, m_tgtVoc;
+  bool m_useAlignment;
+
+  std::vector<FactorType> m_input, m_output;
+  std::vector<float> m_weight;
+  const LMList *m_languageModels;
+  float m_weightWP;
+
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<ThreadLocalStorage> m_local;
+#else
+  mutable std::auto_ptr<ThreadLocalStorage> m_local;
+#endif
+
+private:
+  PhraseDictionaryTreeMmap(const PhraseDictionaryTreeMmap &); // not implemented
+  void operator=(const PhraseDictionaryTreeMmap &); // not implemented
+};
+
+}
+
+#endif
@@ -37,7 +37,8 @@ namespace Moses
 // initialise the RuleCube by creating the top-left corner item
 RuleCube::RuleCube(const ChartTranslationOption &transOpt,
                    const ChartCellCollection &allChartCells,
-                   ChartManager &manager)
+                   ChartManager &manager,
+                   Arena &arena)
   : m_transOpt(transOpt)
 {
   RuleCubeItem *item = new RuleCubeItem(transOpt, allChartCells);
@@ -45,7 +46,7 @@ RuleCube::RuleCube(const ChartTranslationOption &transOpt,
   if (StaticData::Instance().GetCubePruningLazyScoring()) {
     item->EstimateScore();
   } else {
-    item->CreateHypothesis(transOpt, manager);
+    item->CreateHypothesis(transOpt, manager, arena);
   }
   m_queue.push(item);
 }
@@ -55,35 +56,36 @@ RuleCube::~RuleCube()
   RemoveAllInColl(m_covered);
 }
 
-RuleCubeItem *RuleCube::Pop(ChartManager &manager)
+RuleCubeItem *RuleCube::Pop(ChartManager &manager, Arena &arena)
 {
   RuleCubeItem *item = m_queue.top();
   m_queue.pop();
-  CreateNeighbors(*item, manager);
+  CreateNeighbors(*item, manager, arena);
   return item;
 }
 
 // create new RuleCube for neighboring principle rules
-void RuleCube::CreateNeighbors(const RuleCubeItem &item, ChartManager &manager)
+void RuleCube::CreateNeighbors(const RuleCubeItem &item, ChartManager &manager,
+                               Arena &arena)
 {
   // create neighbor along translation dimension
   const TranslationDimension &translationDimension =
     item.GetTranslationDimension();
   if (translationDimension.HasMoreTranslations()) {
-    CreateNeighbor(item, -1, manager);
+    CreateNeighbor(item, -1, manager, arena);
   }
 
   // create neighbors along all hypothesis dimensions
   for (size_t i = 0; i < item.GetHypothesisDimensions().size(); ++i) {
     const HypothesisDimension &dimension = item.GetHypothesisDimensions()[i];
     if (dimension.HasMoreHypo()) {
-      CreateNeighbor(item, i, manager);
+      CreateNeighbor(item, i, manager, arena);
     }
   }
 }
 
 void RuleCube::CreateNeighbor(const RuleCubeItem &item, int dimensionIndex,
-                              ChartManager &manager)
+                              ChartManager &manager, Arena &arena)
 {
   RuleCubeItem *newItem = new RuleCubeItem(item, dimensionIndex);
   std::pair<ItemSet::iterator, bool> result = m_covered.insert(newItem);
@@ -93,7 +95,7 @@ void RuleCube::CreateNeighbor(const RuleCubeItem &item, int dimensionIndex,
     if (StaticData::Instance().GetCubePruningLazyScoring()) {
       newItem->EstimateScore();
     } else {
-      newItem->CreateHypothesis(m_transOpt, manager);
+      newItem->CreateHypothesis(m_transOpt, manager, arena);
     }
     m_queue.push(newItem);
   }
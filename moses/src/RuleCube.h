@@ -35,6 +35,7 @@
 namespace Moses
 {
 
+class Arena;
 class ChartCellCollection;
 class ChartManager;
 class ChartTranslationOption;
@@ -84,7 +85,7 @@ class RuleCube
 {
  public:
   RuleCube(const ChartTranslationOption &, const ChartCellCollection &,
-           ChartManager &);
+           ChartManager &, Arena &);
 
   ~RuleCube();
 
@@ -94,7 +95,7 @@ class RuleCube
     return item->GetScore();
   }
 
-  RuleCubeItem *Pop(ChartManager &);
+  RuleCubeItem *Pop(ChartManager &, Arena &);
 
   bool IsEmpty() const { return m_queue.empty(); }
 
@@ -120,8 +121,8 @@ class RuleCube
   RuleCube(const RuleCube &);  // Not implemented
   RuleCube &operator=(const RuleCube &);  // Not implemented
 
-  void CreateNeighbors(const RuleCubeItem &, ChartManager &);
-  void CreateNeighbor(const RuleCubeItem &, int, ChartManager &);
+  void CreateNeighbors(const RuleCubeItem &, ChartManager &, Arena &);
+  void CreateNeighbor(const RuleCubeItem &, int, ChartManager &, Arena &);
 
   const ChartTranslationOption &m_transOpt;
   ItemSet m_covered;
@@ -62,7 +62,9 @@ RuleCubeItem::RuleCubeItem(const RuleCubeItem &copy, int hypoDimensionIncr)
 
 RuleCubeItem::~RuleCubeItem()
 {
-  delete m_hypothesis;
+  if (m_hypothesis) {
+    ChartHypothesis::Delete(m_hypothesis);
+  }
 }
 
 void RuleCubeItem::EstimateScore()
@@ -76,9 +78,9 @@ void RuleCubeItem::EstimateScore()
 }
 
 void RuleCubeItem::CreateHypothesis(const ChartTranslationOption &transOpt,
-                                    ChartManager &manager)
+                                    ChartManager &manager, Arena &arena)
 {
-  m_hypothesis = new ChartHypothesis(transOpt, *this, manager);
+  m_hypothesis = ChartHypothesis::Create(transOpt, *this, manager, arena);
   m_hypothesis->CalcScore();
   m_score = m_hypothesis->GetTotalScore();
 }
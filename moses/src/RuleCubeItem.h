@@ -26,6 +26,7 @@
 namespace Moses
 {
 
+class Arena;
 class ChartCellCollection;
 class ChartHypothesis;
 class ChartManager;
@@ -121,7 +122,7 @@ class RuleCubeItem
 
   void EstimateScore();
 
-  void CreateHypothesis(const ChartTranslationOption &, ChartManager &);
+  void CreateHypothesis(const ChartTranslationOption &, ChartManager &, Arena &);
 
   ChartHypothesis *ReleaseHypothesis();
 
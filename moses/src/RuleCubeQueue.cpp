@@ -49,9 +49,9 @@ ChartHypothesis *RuleCubeQueue::Pop()
 
   // pop the most promising item from the cube and get the corresponding
   // hypothesis
-  RuleCubeItem *item = cube->Pop(m_manager);
+  RuleCubeItem *item = cube->Pop(m_manager, m_arena);
   if (StaticData::Instance().GetCubePruningLazyScoring()) {
-    item->CreateHypothesis(cube->GetTranslationOption(), m_manager);
+    item->CreateHypothesis(cube->GetTranslationOption(), m_manager, m_arena);
   }
   ChartHypothesis *hypo = item->ReleaseHypothesis();
 
@@ -29,6 +29,7 @@
 namespace Moses
 {
 
+class Arena;
 class ChartManager;
 
 // Define an ordering between RuleCube based on their best item scores.  This
@@ -44,7 +45,9 @@ class RuleCubeOrderer
 class RuleCubeQueue
 {
  public:
-  RuleCubeQueue(ChartManager &manager) : m_manager(manager) {}
+  RuleCubeQueue(ChartManager &manager, Arena &arena)
+    : m_manager(manager)
+    , m_arena(arena) {}
   ~RuleCubeQueue();
 
   void Add(RuleCube *);
@@ -57,6 +60,7 @@ class RuleCubeQueue
 
   Queue m_queue;
   ChartManager &m_manager;
+  Arena &m_arena;
 };
 
 }
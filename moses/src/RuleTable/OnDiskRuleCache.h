@@ -0,0 +1,60 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <iostream>
+#include <utility>
+
+#include "ShardedCache.h"
+#include "TypeDef.h"
+
+namespace Moses
+{
+
+class PhraseDictionaryFeature;
+class TargetPhraseCollection;
+
+/** Persistent (cross-sentence) cache of the target phrase collections of
+ *  on-disk rule tables, converted to moses TargetPhrases, keyed by table
+ *  and position of the collection in the table's target file, see ShardedCache.
+ *  A collection stays alive while a sentence uses it.
+ */
+class OnDiskRuleCache : public ShardedCache<std::pair<const PhraseDictionaryFeature*, UINT64>, TargetPhraseCollection>
+{
+  typedef ShardedCache<std::pair<const PhraseDictionaryFeature*, UINT64>, TargetPhraseCollection> Base;
+
+public:
+  typedef ValuePtr CollectionPtr;
+
+  explicit OnDiskRuleCache(size_t maxSize = 0) : Base(maxSize) {}
+
+  //! cached collection at filePos of the table, or an empty pointer
+  CollectionPtr Find(const PhraseDictionaryFeature *table, UINT64 filePos) const {
+    return Base::Find(std::make_pair(table, filePos));
+  }
+  //! a collection converted by another thread meanwhile is kept, which is just as good
+  void Add(const PhraseDictionaryFeature *table, UINT64 filePos, const CollectionPtr &collection) {
+    Base::Add(std::make_pair(table, filePos), collection);
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, const OnDiskRuleCache& cache);
+
+}  // namespace Moses
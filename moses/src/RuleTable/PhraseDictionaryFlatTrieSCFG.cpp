@@ -0,0 +1,273 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include "util/check.hh"
+#include "RuleTable/PhraseDictionaryFlatTrieSCFG.h"
+#include "RuleTable/PhraseDictionaryNodeSCFG.h"
+#include "Factor.h"
+#include "TargetPhraseCollection.h"
+
+namespace Moses
+{
+
+namespace
+{
+
+struct TerminalEntry {
+  UINT32 key[MAX_NUM_FACTORS]; /**< unused factors are 0 for all children */
+  PhraseDictionaryNodeSCFG *node;
+
+  bool operator<(const TerminalEntry &other) const {
+    return std::lexicographical_compare(key, key + MAX_NUM_FACTORS, other.key, other.key + MAX_NUM_FACTORS);
+  }
+};
+
+struct NonTerminalEntry {
+  PhraseDictionaryFlatTrieSCFG::NonTerminalEdge edge;
+  PhraseDictionaryNodeSCFG *node;
+
+  bool operator<(const NonTerminalEntry &other) const {
+    return edge.sourceId < other.edge.sourceId
+           || (edge.sourceId == other.edge.sourceId && edge.targetId < other.edge.targetId);
+  }
+};
+
+bool EdgeKeyLess(const PhraseDictionaryFlatTrieSCFG::NonTerminalEdge &edge, const std::pair<UINT32, UINT32> &key)
+{
+  return edge.sourceId < key.first || (edge.sourceId == key.first && edge.targetId < key.second);
+}
+
+UINT32 GetFactorId(const Factor *factor)
+{
+  CHECK(factor->GetId() < std::numeric_limits<UINT32>::max());
+  return factor->GetId();
+}
+
+}
+
+PhraseDictionaryFlatTrieSCFG::PhraseDictionaryFlatTrieSCFG()
+{
+  Clear();
+}
+
+PhraseDictionaryFlatTrieSCFG::~PhraseDictionaryFlatTrieSCFG()
+{
+  for (size_t i = 0 ; i < m_nodes.size() ; ++i) {
+    delete m_nodes[i].targetPhraseCollection;
+  }
+}
+
+void PhraseDictionaryFlatTrieSCFG::Clear()
+{
+  for (size_t i = 0 ; i < m_nodes.size() ; ++i) {
+    delete m_nodes[i].targetPhraseCollection;
+  }
+  m_factors.clear();
+  m_nodes.clear();
+  m_terminalKeys.clear();
+  m_terminalChildren.clear();
+  m_nonTerminalEdges.clear();
+  m_labels.clear();
+
+  Node root;
+  root.targetPhraseCollection = NULL;
+  root.firstTerminal = root.numTerminals = 0;
+  root.firstNonTerminal = root.numNonTerminals = 0;
+  m_nodes.push_back(root);
+}
+
+void PhraseDictionaryFlatTrieSCFG::Build(PhraseDictionaryNodeSCFG &root)
+{
+  Clear();
+
+  // the arrays are allocated once at their final size, growing them would
+  // briefly need twice their size while the map trie is still there
+  size_t numNodes = 1, numTerminals = 0, numNonTerminals = 0;
+  Count(root, numNodes, numTerminals, numNonTerminals);
+  CHECK(numNodes < std::numeric_limits<UINT32>::max());
+  m_nodes.reserve(numNodes);
+  m_terminalKeys.reserve(numTerminals * m_factors.size());
+  m_terminalChildren.reserve(numTerminals);
+  m_nonTerminalEdges.reserve(numNonTerminals);
+
+  // the nodes are added in post-order, so each subtree of the map trie is
+  // freed as soon as it is copied. the root keeps index 0
+  std::map<const Factor*, UINT32> labels;
+  Node flatRoot = Flatten(root, labels);
+  m_nodes[0] = flatRoot;
+
+  // the collections belong to the flat trie now
+  root.Clear();
+}
+
+void PhraseDictionaryFlatTrieSCFG::Count(const PhraseDictionaryNodeSCFG &node, size_t &numNodes, size_t &numTerminals, size_t &numNonTerminals)
+{
+  PhraseDictionaryNodeSCFG::TerminalMap::const_iterator iterTerm;
+  for (iterTerm = node.m_sourceTermMap.begin() ; iterTerm != node.m_sourceTermMap.end() ; ++iterTerm) {
+    if (m_factors.empty()) {
+      // all source words of the table have the same factors
+      const Word &word = iterTerm->first;
+      for (size_t i = 0 ; i < MAX_NUM_FACTORS ; ++i) {
+        if (word[i] != NULL)
+          m_factors.push_back(i);
+      }
+    }
+    Count(iterTerm->second, numNodes, numTerminals, numNonTerminals);
+  }
+  PhraseDictionaryNodeSCFG::NonTerminalMap::const_iterator iterNonTerm;
+  for (iterNonTerm = node.m_nonTermMap.begin() ; iterNonTerm != node.m_nonTermMap.end() ; ++iterNonTerm) {
+    Count(iterNonTerm->second, numNodes, numTerminals, numNonTerminals);
+  }
+  numNodes += node.m_sourceTermMap.size() + node.m_nonTermMap.size();
+  numTerminals += node.m_sourceTermMap.size();
+  numNonTerminals += node.m_nonTermMap.size();
+}
+
+PhraseDictionaryFlatTrieSCFG::Node PhraseDictionaryFlatTrieSCFG::Flatten(PhraseDictionaryNodeSCFG &node, std::map<const Factor*, UINT32> &labels)
+{
+  Node flat;
+  flat.targetPhraseCollection = node.m_targetPhraseCollection;
+  node.m_targetPhraseCollection = NULL;
+
+  std::vector<TerminalEntry> terminals;
+  terminals.reserve(node.m_sourceTermMap.size());
+  PhraseDictionaryNodeSCFG::TerminalMap::iterator iterTerm;
+  for (iterTerm = node.m_sourceTermMap.begin() ; iterTerm != node.m_sourceTermMap.end() ; ++iterTerm) {
+    TerminalEntry entry;
+    std::fill(entry.key, entry.key + MAX_NUM_FACTORS, 0);
+    bool hasKey = GetKey(iterTerm->first, entry.key);
+    CHECK(hasKey);
+    entry.node = &iterTerm->second;
+    terminals.push_back(entry);
+  }
+  std::sort(terminals.begin(), terminals.end());
+
+  std::vector<NonTerminalEntry> nonTerminals;
+  nonTerminals.reserve(node.m_nonTermMap.size());
+  PhraseDictionaryNodeSCFG::NonTerminalMap::iterator iterNonTerm;
+  for (iterNonTerm = node.m_nonTermMap.begin() ; iterNonTerm != node.m_nonTermMap.end() ; ++iterNonTerm) {
+    const Word *words[2] = { &iterNonTerm->first.first, &iterNonTerm->first.second };
+    UINT32 ids[2], labelIndexes[2];
+    for (size_t i = 0 ; i < 2 ; ++i) {
+      const Factor *factor = (*words[i])[0];
+      ids[i] = GetFactorId(factor);
+      std::map<const Factor*, UINT32>::const_iterator label = labels.find(factor);
+      if (label == labels.end()) {
+        label = labels.insert(std::make_pair(factor, UINT32(m_labels.size()))).first;
+        m_labels.push_back(*words[i]);
+      }
+      labelIndexes[i] = label->second;
+    }
+    NonTerminalEntry entry;
+    entry.edge.sourceId = ids[0];
+    entry.edge.targetId = ids[1];
+    entry.edge.sourceLabel = labelIndexes[0];
+    entry.edge.targetLabel = labelIndexes[1];
+    entry.node = &iterNonTerm->second;
+    nonTerminals.push_back(entry);
+  }
+  std::sort(nonTerminals.begin(), nonTerminals.end());
+
+  // the children first, then the edges of this node, which stay contiguous
+  std::vector<UINT32> terminalChildren(terminals.size());
+  for (size_t i = 0 ; i < terminals.size() ; ++i) {
+    terminalChildren[i] = AddNode(*terminals[i].node, labels);
+  }
+  for (size_t i = 0 ; i < nonTerminals.size() ; ++i) {
+    nonTerminals[i].edge.child = AddNode(*nonTerminals[i].node, labels);
+  }
+
+  flat.firstTerminal = m_terminalChildren.size();
+  flat.numTerminals = terminals.size();
+  for (size_t i = 0 ; i < terminals.size() ; ++i) {
+    m_terminalKeys.insert(m_terminalKeys.end(), terminals[i].key, terminals[i].key + m_factors.size());
+  }
+  m_terminalChildren.insert(m_terminalChildren.end(), terminalChildren.begin(), terminalChildren.end());
+
+  flat.firstNonTerminal = m_nonTerminalEdges.size();
+  flat.numNonTerminals = nonTerminals.size();
+  for (size_t i = 0 ; i < nonTerminals.size() ; ++i) {
+    m_nonTerminalEdges.push_back(nonTerminals[i].edge);
+  }
+  return flat;
+}
+
+UINT32 PhraseDictionaryFlatTrieSCFG::AddNode(PhraseDictionaryNodeSCFG &node, std::map<const Factor*, UINT32> &labels)
+{
+  Node flat = Flatten(node, labels);
+  node.Clear();
+  m_nodes.push_back(flat);
+  return m_nodes.size() - 1;
+}
+
+bool PhraseDictionaryFlatTrieSCFG::GetKey(const Word &word, UINT32 *key) const
+{
+  for (size_t i = 0 ; i < m_factors.size() ; ++i) {
+    const Factor *factor = word[m_factors[i]];
+    if (factor == NULL)
+      return false;
+    key[i] = GetFactorId(factor);
+  }
+  return true;
+}
+
+const PhraseDictionaryFlatTrieSCFG::Node *PhraseDictionaryFlatTrieSCFG::GetChild(const Node &node, const Word &sourceTerm) const
+{
+  CHECK(!sourceTerm.IsNonTerminal());
+
+  UINT32 key[MAX_NUM_FACTORS];
+  if (node.numTerminals == 0 || !GetKey(sourceTerm, key))
+    return NULL;
+
+  const size_t stride = m_factors.size();
+  size_t first = node.firstTerminal, last = first + node.numTerminals;
+  while (first < last) {
+    const size_t middle = first + (last - first) / 2;
+    const UINT32 *middleKey = &m_terminalKeys[middle * stride];
+    const std::pair<const UINT32*, const UINT32*> diff = std::mismatch(middleKey, middleKey + stride, key);
+    if (diff.first == middleKey + stride)
+      return &m_nodes[m_terminalChildren[middle]];
+    if (*diff.first < *diff.second)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+  return NULL;
+}
+
+const PhraseDictionaryFlatTrieSCFG::Node *PhraseDictionaryFlatTrieSCFG::GetChild(const Node &node, const Word &sourceNonTerm, const Word &targetNonTerm) const
+{
+  CHECK(sourceNonTerm.IsNonTerminal());
+  CHECK(targetNonTerm.IsNonTerminal());
+
+  if (node.numNonTerminals == 0)
+    return NULL;
+
+  const std::pair<UINT32, UINT32> key(GetFactorId(sourceNonTerm[0]), GetFactorId(targetNonTerm[0]));
+  const NonTerminalEdge *end = EndNonTerminals(node);
+  const NonTerminalEdge *edge = std::lower_bound(BeginNonTerminals(node), end, key, EdgeKeyLess);
+  if (edge == end || edge->sourceId != key.first || edge->targetId != key.second)
+    return NULL;
+  return &m_nodes[edge->child];
+}
+
+}  // namespace Moses
@@ -0,0 +1,129 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include "TypeDef.h"
+#include "Word.h"
+
+namespace Moses
+{
+
+class Factor;
+class PhraseDictionaryNodeSCFG;
+class TargetPhraseCollection;
+
+/** Read-only form of the PhraseDictionarySCFG trie, built once loading is
+ *  finished.
+ *  All nodes live in one array, the root first and the others in post-order.
+ *  Each node refers to a contiguous range of the terminal edges and one of
+ *  the non-terminal edges, sorted by factor ids, so finding a child is a binary search
+ *  instead of a walk through a hash map of Words.
+ *  Terminal edges are keyed on the factors the table's source words have,
+ *  non-terminal edges on the first factor of the source and the target
+ *  non-terminal, as in PhraseDictionaryNodeSCFG.
+ */
+class PhraseDictionaryFlatTrieSCFG
+{
+public:
+  struct Node {
+    TargetPhraseCollection *targetPhraseCollection;
+    UINT32 firstTerminal;
+    UINT32 numTerminals;
+    UINT32 firstNonTerminal;
+    UINT32 numNonTerminals;
+
+    bool IsLeaf() const {
+      return numTerminals == 0 && numNonTerminals == 0;
+    }
+    const TargetPhraseCollection *GetTargetPhraseCollection() const {
+      return targetPhraseCollection;
+    }
+  };
+
+  struct NonTerminalEdge {
+    UINT32 sourceId; /**< factor ids of the labels, the key */
+    UINT32 targetId;
+    UINT32 sourceLabel; /**< index of the labels in GetLabel() */
+    UINT32 targetLabel;
+    UINT32 child;
+  };
+
+  PhraseDictionaryFlatTrieSCFG();
+  ~PhraseDictionaryFlatTrieSCFG();
+
+  /** take over the target phrase collections of the tree under root and
+   *  free the tree
+   */
+  void Build(PhraseDictionaryNodeSCFG &root);
+  //! leaves only an empty root
+  void Clear();
+
+  const Node &GetRootNode() const {
+    return m_nodes[0];
+  }
+  //! child of node along the terminal sourceTerm, or NULL
+  const Node *GetChild(const Node &node, const Word &sourceTerm) const;
+  //! child of node along the non-terminal pair, or NULL
+  const Node *GetChild(const Node &node, const Word &sourceNonTerm, const Word &targetNonTerm) const;
+
+  //! non-terminal edges of node, in the order of their keys
+  const NonTerminalEdge *BeginNonTerminals(const Node &node) const {
+    return m_nonTerminalEdges.empty() ? NULL : &m_nonTerminalEdges[0] + node.firstNonTerminal;
+  }
+  const NonTerminalEdge *EndNonTerminals(const Node &node) const {
+    return BeginNonTerminals(node) + node.numNonTerminals;
+  }
+  const Node &GetNode(UINT32 index) const {
+    return m_nodes[index];
+  }
+  //! a word of a non-terminal label of an edge
+  const Word &GetLabel(UINT32 label) const {
+    return m_labels[label];
+  }
+
+  size_t GetSize() const {
+    return m_nodes.size();
+  }
+
+protected:
+  //! key of a terminal, m_factors.size() factor ids. false if a factor is missing
+  bool GetKey(const Word &word, UINT32 *key) const;
+  //! count the nodes and edges below node, and find the factors of the terminals
+  void Count(const PhraseDictionaryNodeSCFG &node, size_t &numNodes, size_t &numTerminals, size_t &numNonTerminals);
+  //! add the nodes below node and the edges of node, freeing the subtrees below node
+  Node Flatten(PhraseDictionaryNodeSCFG &node, std::map<const Factor*, UINT32> &labels);
+  //! add node and the nodes below it, then free them. returns the index of node
+  UINT32 AddNode(PhraseDictionaryNodeSCFG &node, std::map<const Factor*, UINT32> &labels);
+
+  std::vector<FactorType> m_factors; /**< factors of the terminals */
+  std::vector<Node> m_nodes;
+  std::vector<UINT32> m_terminalKeys; /**< m_factors.size() factor ids per terminal edge */
+  std::vector<UINT32> m_terminalChildren; /**< child node of each terminal edge */
+  std::vector<NonTerminalEdge> m_nonTerminalEdges;
+  std::vector<Word> m_labels; /**< one word per distinct non-terminal label */
+
+private:
+  PhraseDictionaryFlatTrieSCFG(const PhraseDictionaryFlatTrieSCFG &); // not implemented
+  void operator=(const PhraseDictionaryFlatTrieSCFG &); // not implemented
+};
+
+}  // namespace Moses
@@ -109,7 +109,7 @@ void PhraseDictionaryNodeSCFG::Clear()
   m_sourceTermMap.clear();
   m_nonTermMap.clear();
   delete m_targetPhraseCollection;
-  
+  m_targetPhraseCollection = NULL;
 }
   
 std::ostream& operator<<(std::ostream &out, const PhraseDictionaryNodeSCFG &node)
@@ -38,6 +38,7 @@ namespace Moses
 {
 
 class PhraseDictionarySCFG;
+class PhraseDictionaryFlatTrieSCFG;
 
 class NonTerminalMapKeyHasher
 {
@@ -85,7 +86,8 @@ public:
   }
 };
 
-/** One node of the PhraseDictionarySCFG structure
+/** One node of the PhraseDictionarySCFG structure while it is loaded.
+ *  Lookups go through the PhraseDictionaryFlatTrieSCFG built from it afterwards.
 */
 class PhraseDictionaryNodeSCFG
 {
@@ -112,6 +114,7 @@ private:
 
   // only these classes are allowed to instantiate this class
   friend class PhraseDictionarySCFG;
+  friend class PhraseDictionaryFlatTrieSCFG;
   friend class std::map<Word, PhraseDictionaryNodeSCFG>;
 
 protected:
@@ -101,6 +101,10 @@ void PhraseDictionarySCFG::SortAndPrune()
   {
     m_collection.Sort(GetTableLimit());
   }
+
+  // move the collections into the compact read-only trie
+  m_trie.Build(m_collection);
+  VERBOSE(2, "rule table trie has " << m_trie.GetSize() << " nodes" << std::endl);
 }
 
 TO_STRING_BODY(PhraseDictionarySCFG);
@@ -108,18 +112,8 @@ TO_STRING_BODY(PhraseDictionarySCFG);
 // friend
 ostream& operator<<(ostream& out, const PhraseDictionarySCFG& phraseDict)
 {
-  typedef PhraseDictionaryNodeSCFG::TerminalMap TermMap;
-  typedef PhraseDictionaryNodeSCFG::NonTerminalMap NonTermMap;
-
-  const PhraseDictionaryNodeSCFG &coll = phraseDict.m_collection;
-  for (NonTermMap::const_iterator p = coll.m_nonTermMap.begin(); p != coll.m_nonTermMap.end(); ++p) {
-    const Word &sourceNonTerm = p->first.first;
-    out << sourceNonTerm;
-  }
-  for (TermMap::const_iterator p = coll.m_sourceTermMap.begin(); p != coll.m_sourceTermMap.end(); ++p) {
-    const Word &sourceTerm = p->first;
-    out << sourceTerm;
-  }
+  // the words themselves are not kept after loading
+  out << "PhraseDictionarySCFG with " << phraseDict.m_trie.GetSize() << " trie nodes";
   return out;
 }
 
@@ -21,6 +21,7 @@
 
 #include "PhraseDictionary.h"
 #include "PhraseDictionaryNodeSCFG.h"
+#include "PhraseDictionaryFlatTrieSCFG.h"
 #include "InputType.h"
 #include "NonTerminal.h"
 #include "RuleTable/Trie.h"
@@ -30,6 +31,8 @@ namespace Moses
 
 /*** Implementation of a SCFG rule table in a trie.  Looking up a rule of
  * length n symbols requires n look-ups to find the TargetPhraseCollection.
+ * The trie is built from PhraseDictionaryNodeSCFGs and flattened into a
+ * PhraseDictionaryFlatTrieSCFG once the table is loaded.
  */
 class PhraseDictionarySCFG : public RuleTableTrie
 {
@@ -41,7 +44,7 @@ class PhraseDictionarySCFG : public RuleTableTrie
                        PhraseDictionaryFeature* feature)
       : RuleTableTrie(numScoreComponents, feature) {}
 
-  const PhraseDictionaryNodeSCFG &GetRootNode() const { return m_collection; }
+  const PhraseDictionaryFlatTrieSCFG &GetTrie() const { return m_trie; }
 
   ChartRuleLookupManager *CreateRuleLookupManager(
     const InputType &,
@@ -59,7 +62,8 @@ class PhraseDictionarySCFG : public RuleTableTrie
 
   void SortAndPrune();
 
-  PhraseDictionaryNodeSCFG m_collection;
+  PhraseDictionaryNodeSCFG m_collection; /**< only used while loading */
+  PhraseDictionaryFlatTrieSCFG m_trie;
 };
 
 }  // namespace Moses
@@ -6,9 +6,11 @@
 namespace Moses
 {
 ScoreComponentCollection::ScoreComponentCollection()
-  : m_scores(StaticData::Instance().GetTotalScoreComponents(), 0.0f)
-  , m_sim(&StaticData::Instance().GetScoreIndexManager())
-{}
+  : m_sim(&StaticData::Instance().GetScoreIndexManager())
+{
+  Allocate(m_sim->GetTotalNumberOfScores());
+  ZeroAll();
+}
 
 float ScoreComponentCollection::GetWeightedScore() const
 {
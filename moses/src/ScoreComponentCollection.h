@@ -22,8 +22,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_ScoreComponentCollection_h
 #define moses_ScoreComponentCollection_h
 
+#include <algorithm>
+#include <cstring>
 #include <numeric>
 #include "util/check.hh"
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 #include "LMList.h"
 #include "ScoreProducer.h"
@@ -51,27 +56,125 @@ namespace Moses
  * to be tracked in the hypothesis (and thus to participate in the decoding process), a class
  * representing that score must extend the ScoreProducer abstract base class.  For an example
  * refer to the DistortionScoreProducer class.
+ *
+ * The scores are stored inside the object unless there are more than INLINE_SIZE of them,
+ * so creating a hypothesis doesn't need another allocation for its scores. The number of
+ * scores is that of the score producers registered when the collection is created, so
+ * collections made while the models are loading may be shorter than later ones.
  */
 class ScoreComponentCollection
 {
   friend std::ostream& operator<<(std::ostream& os, const ScoreComponentCollection& rhs);
   friend class ScoreIndexManager;
 private:
-  std::vector<float> m_scores;
+  static const size_t INLINE_SIZE = 32;
+
+  float m_inline[INLINE_SIZE];
+  float *m_scores; /**< m_inline, or on the heap if there are more than INLINE_SIZE scores */
+  size_t m_size;
   const ScoreIndexManager* m_sim;
 
+  void Allocate(size_t size) {
+    m_size = size;
+    m_scores = (size <= INLINE_SIZE) ? m_inline : new float[size];
+  }
+  void Release() {
+    if (m_scores != m_inline)
+      delete [] m_scores;
+  }
+
+  // the loops below work on 4 scores at a time where SSE is available
+  static void Add(float *to, const float *from, size_t size) {
+    size_t i = 0;
+#ifdef __SSE__
+    for (; i + 4 <= size; i += 4) {
+      _mm_storeu_ps(to + i, _mm_add_ps(_mm_loadu_ps(to + i), _mm_loadu_ps(from + i)));
+    }
+#endif
+    for (; i < size; ++i) {
+      to[i] += from[i];
+    }
+  }
+
+  static void Subtract(float *to, const float *from, size_t size) {
+    size_t i = 0;
+#ifdef __SSE__
+    for (; i + 4 <= size; i += 4) {
+      _mm_storeu_ps(to + i, _mm_sub_ps(_mm_loadu_ps(to + i), _mm_loadu_ps(from + i)));
+    }
+#endif
+    for (; i < size; ++i) {
+      to[i] -= from[i];
+    }
+  }
+
+  /** inner product of scores and weights. If from is given, it is first added to scores.
+   *  Product i is summed up in lane i % 4, then the lanes as (0 + 1) + (2 + 3),
+   *  then the last size % 4 products one by one. The order is the same with and
+   *  without SSE, and for InnerProduct() and PlusEqualsInnerProduct(), but not that of
+   *  a plain loop over the scores: totals differ from one in the last bits, which can
+   *  change the choice between hypotheses that score almost the same */
+  static float AddInnerProduct(float *scores, const float *from, const float *weights, size_t size) {
+    float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    size_t i = 0;
+#ifdef __SSE__
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= size; i += 4) {
+      __m128 x = _mm_loadu_ps(scores + i);
+      if (from) {
+        x = _mm_add_ps(x, _mm_loadu_ps(from + i));
+        _mm_storeu_ps(scores + i, x);
+      }
+      sum = _mm_add_ps(sum, _mm_mul_ps(x, _mm_loadu_ps(weights + i)));
+    }
+    _mm_storeu_ps(lanes, sum);
+#else
+    for (; i + 4 <= size; i += 4) {
+      for (size_t lane = 0; lane < 4; ++lane) {
+        if (from)
+          scores[i + lane] += from[i + lane];
+        lanes[lane] += scores[i + lane] * weights[i + lane];
+      }
+    }
+#endif
+    float ret = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < size; ++i) {
+      if (from)
+        scores[i] += from[i];
+      ret += scores[i] * weights[i];
+    }
+    return ret;
+  }
+
 public:
   //! Create a new score collection with all values set to 0.0
   ScoreComponentCollection();
 
   //! Clone a score collection
   ScoreComponentCollection(const ScoreComponentCollection& rhs)
-    : m_scores(rhs.m_scores)
-    , m_sim(rhs.m_sim)
-  {}
+    : m_sim(rhs.m_sim) {
+    Allocate(rhs.m_size);
+    std::memcpy(m_scores, rhs.m_scores, m_size * sizeof(float));
+  }
+
+  ~ScoreComponentCollection() {
+    Release();
+  }
+
+  ScoreComponentCollection &operator=(const ScoreComponentCollection& rhs) {
+    if (this != &rhs) {
+      if (m_size != rhs.m_size) {
+        Release();
+        Allocate(rhs.m_size);
+      }
+      std::memcpy(m_scores, rhs.m_scores, m_size * sizeof(float));
+      m_sim = rhs.m_sim;
+    }
+    return *this;
+  }
 
   inline size_t size() const {
-    return m_scores.size();
+    return m_size;
   }
   const float& operator[](size_t x) const {
     return m_scores[x];
@@ -79,26 +182,29 @@ public:
 
   //! Set all values to 0.0
   void ZeroAll() {
-    for (std::vector<float>::iterator i=m_scores.begin(); i!=m_scores.end(); ++i)
-      *i = 0.0f;
+    std::fill(m_scores, m_scores + m_size, 0.0f);
   }
 
-  //! add the score in rhs
+  //! add the score in rhs, which may be shorter (see above) but not longer
   void PlusEquals(const ScoreComponentCollection& rhs) {
-    CHECK(m_scores.size() >= rhs.m_scores.size());
-    const size_t l = rhs.m_scores.size();
-    for (size_t i=0; i<l; i++) {
-      m_scores[i] += rhs.m_scores[i];
-    }
+    CHECK(m_size >= rhs.m_size);
+    Add(m_scores, rhs.m_scores, rhs.m_size);
   }
 
   //! subtract the score in rhs
   void MinusEquals(const ScoreComponentCollection& rhs) {
-    CHECK(m_scores.size() >= rhs.m_scores.size());
-    const size_t l = rhs.m_scores.size();
-    for (size_t i=0; i<l; i++) {
-      m_scores[i] -= rhs.m_scores[i];
+    CHECK(m_size >= rhs.m_size);
+    Subtract(m_scores, rhs.m_scores, rhs.m_size);
+  }
+
+  //! PlusEquals(rhs) followed by InnerProduct(weights), in one pass over the scores
+  float PlusEqualsInnerProduct(const ScoreComponentCollection& rhs, const std::vector<float>& weights) {
+    CHECK(weights.size() >= m_size);
+    if (rhs.m_size != m_size) {
+      PlusEquals(rhs);
+      return InnerProduct(weights);
     }
+    return AddInnerProduct(m_scores, rhs.m_scores, &weights[0], m_size);
   }
 
   //! Add scores from a single ScoreProducer only
@@ -143,7 +249,7 @@ public:
   }
 
   void Assign(const ScoreComponentCollection &copy) {
-    m_scores =  copy.m_scores;
+    *this = copy;
   }
 
   //! Special version PlusEquals(ScoreProducer, vector<float>)
@@ -158,7 +264,10 @@ public:
   //! Used to find the weighted total of scores.  rhs should contain a vector of weights
   //! of the same length as the number of scores.
   float InnerProduct(const std::vector<float>& rhs) const {
-    return std::inner_product(m_scores.begin(), m_scores.end(), rhs.begin(), 0.0f);
+    if (m_size == 0)
+      return 0.0f;
+    CHECK(rhs.size() >= m_size);
+    return AddInnerProduct(m_scores, NULL, &rhs[0], m_size);
   }
 
   float PartialInnerProduct(const ScoreProducer* sp, const std::vector<float>& rhs) const {
@@ -202,7 +311,7 @@ public:
 inline std::ostream& operator<<(std::ostream& os, const ScoreComponentCollection& rhs)
 {
   os << "<<" << rhs.m_scores[0];
-  for (size_t i=1; i<rhs.m_scores.size(); i++)
+  for (size_t i=1; i<rhs.m_size; i++)
     os << ", " << rhs.m_scores[i];
   return os << ">>";
 }
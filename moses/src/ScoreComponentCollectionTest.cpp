@@ -0,0 +1,106 @@
+#include "ScoreComponentCollection.h"
+
+#define BOOST_TEST_MODULE MosesScoreComponentCollection
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Parameter.h"
+#include "PhraseDictionary.h"
+#include "StaticData.h"
+#include "TranslationSystem.h"
+
+using namespace std;
+using namespace Moses;
+
+namespace {
+
+// with distortion and the two word penalties, 9 scores: two groups of four
+// and one left over
+const size_t TABLE_SCORES = 6;
+
+struct Model {
+  string dir;
+
+  Model() {
+    char name[] = "/tmp/scores_test_XXXXXX";
+    BOOST_REQUIRE(mkdtemp(name) != NULL);
+    dir = name;
+
+    ofstream table(File("phrase-table").c_str());
+    table << "a ||| x ||| 1 1 1 1 1 1\n";
+    ofstream ini(File("moses.ini").c_str());
+    ini << "[input-factors]\n0\n[mapping]\n0 T 0\n"
+        << "[ttable-file]\n0 0 0 " << TABLE_SCORES << " " << File("phrase-table") << "\n[ttable-limit]\n20\n"
+        << "[weight-t]\n1\n1\n1\n1\n1\n1\n[weight-d]\n1\n[weight-w]\n0\n";
+  }
+
+  ~Model() {
+    remove(File("phrase-table").c_str());
+    remove(File("moses.ini").c_str());
+    rmdir(dir.c_str());
+  }
+
+  string File(const string &name) const {
+    return dir + "/" + name;
+  }
+};
+
+// the order AddInnerProduct() documents: four lanes, added up pairwise, then the rest
+float LaneOrderInnerProduct(const vector<float> &scores, const vector<float> &weights) {
+  float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  size_t i = 0;
+  for (; i + 4 <= scores.size(); i += 4) {
+    for (size_t lane = 0; lane < 4; ++lane)
+      lanes[lane] += scores[i + lane] * weights[i + lane];
+  }
+  float ret = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < scores.size(); ++i)
+    ret += scores[i] * weights[i];
+  return ret;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(inner_product_order) {
+  Model model;
+  Parameter *parameter = new Parameter();
+  BOOST_REQUIRE(parameter->LoadParam(model.File("moses.ini")));
+  BOOST_REQUIRE(StaticData::LoadDataStatic(parameter));
+
+  const TranslationSystem &system = StaticData::Instance().GetTranslationSystem(TranslationSystem::DEFAULT);
+  const PhraseDictionaryFeature *table = system.GetPhraseDictionaries()[0];
+
+  // magnitudes far apart, so that the order of the additions shows in the total
+  const float values[TABLE_SCORES] = { 1e-3f, 12345.678f, -0.1f, 3.3333f, 7e4f, -2.5f };
+  ScoreComponentCollection scores, other;
+  scores.PlusEquals(table, vector<float>(values, values + TABLE_SCORES));
+  other.PlusEquals(table, vector<float>(values, values + TABLE_SCORES));
+  BOOST_REQUIRE(scores.size() > 8 && scores.size() % 4 != 0);
+
+  vector<float> weights, sum;
+  for (size_t i = 0; i < scores.size(); ++i) {
+    weights.push_back(0.3f - 0.17f * i);
+    sum.push_back(scores[i] + other[i]);
+  }
+
+  float expected = LaneOrderInnerProduct(sum, weights);
+  float total = scores.PlusEqualsInnerProduct(other, weights);
+  BOOST_CHECK_EQUAL(expected, total);
+  BOOST_CHECK_EQUAL(expected, scores.InnerProduct(weights));
+  for (size_t i = 0; i < sum.size(); ++i)
+    BOOST_CHECK_EQUAL(sum[i], scores[i]);
+
+  // only close to a plain loop over the scores
+  float plain = 0.0f;
+  for (size_t i = 0; i < sum.size(); ++i)
+    plain += sum[i] * weights[i];
+  BOOST_CHECK_CLOSE(plain, total, 1e-3);
+
+  scores.MinusEquals(other);
+  for (size_t i = 0; i < sum.size(); ++i)
+    BOOST_CHECK_EQUAL(sum[i] - other[i], scores[i]);
+}
@@ -17,6 +17,10 @@ using namespace std;
 
 void ScoreIndexManager::AddScoreProducer(const ScoreProducer* sp)
 {
+  if (m_collectOnly) {
+    m_producers.push_back(sp);
+    return;
+  }
   // Producers must be inserted in the order they are created
   const_cast<ScoreProducer*>(sp)->CreateScoreBookkeepingID();
   CHECK(m_begins.size() == (sp->GetScoreBookkeepingID()));
@@ -36,7 +40,7 @@ void ScoreIndexManager::AddScoreProducer(const ScoreProducer* sp)
 
 void ScoreIndexManager::PrintLabeledScores(std::ostream& os, const ScoreComponentCollection& scores) const
 {
-  std::vector<float> weights(scores.m_scores.size(), 1.0f);
+  std::vector<float> weights(scores.size(), 1.0f);
   PrintLabeledWeightedScores(os, scores, weights);
 }
 
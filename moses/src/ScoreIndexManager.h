@@ -25,7 +25,11 @@ class ScoreIndexManager
 {
   friend std::ostream& operator<<(std::ostream& os, const ScoreIndexManager& sim);
 public:
-  ScoreIndexManager() : m_last(0) {}
+  ScoreIndexManager() : m_last(0), m_collectOnly(false) {}
+  /** collectOnly: only keep the producers added, without giving them scores.
+   *  For models loaded on other threads, which are then added to the real
+   *  manager in the order of the configuration, not the order they finish */
+  explicit ScoreIndexManager(bool collectOnly) : m_last(0), m_collectOnly(collectOnly) {}
 
   //! new score producer to manage. Producers must be inserted in the order they are created
   void AddScoreProducer(const ScoreProducer* producer);
@@ -60,6 +64,7 @@ private:
   std::vector<std::string> m_featureNames;
   std::vector<std::string> m_featureShortNames;
   size_t m_last;
+  bool m_collectOnly;
 };
 
 
@@ -24,8 +24,8 @@ public:
     }
 
     // Compare the top hypothesis of each bitmap container using the TotalScore, which includes future cost
-    const float scoreA = A->Top()->GetHypothesis()->GetTotalScore();
-    const float scoreB = B->Top()->GetHypothesis()->GetTotalScore();
+    const float scoreA = A->Top().GetScore();
+    const float scoreB = B->Top().GetScore();
 
     if (scoreA < scoreB) {
       return true;
@@ -136,9 +136,16 @@ void SearchCubePruning::ProcessSentence()
     // the stack is pruned before processing (lazy pruning):
     VERBOSE(3,"processing hypothesis from next stack");
     // VERBOSE("processing next stack at ");
+    clock_t t = 0;
+    IFSTATS {
+      t = GetThreadClock();
+    }
     sourceHypoColl.PruneToSize(staticData.GetMaxHypoStackSize());
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
+    IFSTATS {
+      m_manager.GetSentenceStats().AddTimePrune( GetThreadClock()-t );
+    }
 
     CreateForwardTodos(sourceHypoColl);
 
@@ -146,12 +153,6 @@ void SearchCubePruning::ProcessSentence()
   }
 
   PrintBitmapContainerGraph();
-
-  // some more logging
-  IFVERBOSE(2) {
-    m_manager.GetSentenceStats().SetTimeTotal( clock()-m_start );
-  }
-  VERBOSE(2, m_manager.GetSentenceStats());
 }
 
 void SearchCubePruning::CreateForwardTodos(HypothesisStackCubePruning &stack)
@@ -2,10 +2,49 @@
 #include "Timer.h"
 #include "SearchNormal.h"
 
+#ifdef WITH_THREADS
+#include "ThreadPool.h"
+#endif
+
 using namespace std;
 
 namespace Moses
 {
+
+#ifdef WITH_THREADS
+/** Expands a contiguous range of the hypotheses of one stack on a helper thread */
+class SearchNormalExpansionTask : public Task
+{
+public:
+  SearchNormalExpansionTask(SearchNormal &search
+                            , const std::vector<const Hypothesis*> &hypos
+                            , size_t begin, size_t end
+                            , SearchNormal::ExpansionBuffer &buffer
+                            , TaskLatch &latch)
+    :m_search(search)
+    ,m_hypos(hypos)
+    ,m_begin(begin)
+    ,m_end(end)
+    ,m_buffer(buffer)
+    ,m_latch(latch)
+  {}
+
+  void Run() {
+    m_search.m_manager.GetTranslationSystem()->InitializeSearchThread(m_search.m_source);
+    for (size_t i = m_begin ; i < m_end ; ++i) {
+      m_search.ProcessOneHypothesis(*m_hypos[i], &m_buffer);
+    }
+    m_latch.CountDown();
+  }
+
+private:
+  SearchNormal &m_search;
+  const std::vector<const Hypothesis*> &m_hypos;
+  size_t m_begin, m_end;
+  SearchNormal::ExpansionBuffer &m_buffer;
+  TaskLatch &m_latch;
+};
+#endif
 /**
  * Organizing main function
  *
@@ -20,6 +59,7 @@ SearchNormal::SearchNormal(Manager& manager, const InputType &source, const Tran
   ,m_start(clock())
   ,interrupted_flag(0)
   ,m_transOptColl(transOptColl)
+  ,m_searchThreadCount(1)
 {
   VERBOSE(1, "Translating: " << m_source << endl);
   const StaticData &staticData = StaticData::Instance();
@@ -44,11 +84,19 @@ SearchNormal::SearchNormal(Manager& manager, const InputType &source, const Tran
 
     m_hypoStackColl[ind] = sourceHypoColl;
   }
+
+#if defined(WITH_THREADS) && !defined(USE_HYPO_POOL)
+  // the hypothesis object pool is not thread safe, so expansion stays serial when it is used.
+  // without it, each range of a stack creates hypotheses in an arena of its own
+  m_searchThreadCount = staticData.SearchThreadCount();
+#endif
 }
 
 SearchNormal::~SearchNormal()
 {
   RemoveAllInColl(m_hypoStackColl);
+  // after the stacks, which still hold hypotheses allocated from the buffers
+  RemoveAllInColl(m_expansionBuffers);
 }
 
 /**
@@ -79,21 +127,25 @@ void SearchNormal::ProcessSentence()
 
     // the stack is pruned before processing (lazy pruning):
     VERBOSE(3,"processing hypothesis from next stack");
-    IFVERBOSE(2) {
-      t = clock();
+    IFSTATS {
+      t = GetThreadClock();
     }
     sourceHypoColl.PruneToSize(staticData.GetMaxHypoStackSize());
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
-    IFVERBOSE(2) {
-      stats.AddTimeStack( clock()-t );
+    IFSTATS {
+      stats.AddTimePrune( GetThreadClock()-t );
     }
 
     // go through each hypothesis on the stack and try to expand it
-    HypothesisStackNormal::const_iterator iterHypo;
-    for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
-      Hypothesis &hypothesis = **iterHypo;
-      ProcessOneHypothesis(hypothesis); // expand the hypothesis
+    if (m_searchThreadCount > 1 && sourceHypoColl.size() > 1) {
+      ProcessStackParallel(sourceHypoColl);
+    } else {
+      HypothesisStackNormal::const_iterator iterHypo;
+      for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
+        Hypothesis &hypothesis = **iterHypo;
+        ProcessOneHypothesis(hypothesis); // expand the hypothesis
+      }
     }
     // some logging
     IFVERBOSE(2) {
@@ -103,21 +155,72 @@ void SearchNormal::ProcessSentence()
     // this stack is fully expanded;
     actual_hypoStack = &sourceHypoColl;
   }
+}
 
-  // some more logging
-  IFVERBOSE(2) {
-    m_manager.GetSentenceStats().SetTimeTotal( clock()-m_start );
+
+/**
+ * Expand all hypotheses of one stack using several threads.
+ * The stack is cut into contiguous ranges, and each range is expanded into its
+ * own buffer of new hypotheses. Only stacks with more words translated are
+ * extended, so the source stack is not modified meanwhile. The buffers are
+ * then added to the stacks in the order of a serial run, which makes pruning
+ * and recombination, and therefore the search result, the same as in a serial run.
+ * Hypothesis ids are handed out in that order as well (see AddCandidate()),
+ * so the search graph is the same too.
+ * \param sourceHypoColl stack to be expanded
+ */
+void SearchNormal::ProcessStackParallel(const HypothesisStackNormal &sourceHypoColl)
+{
+#ifdef WITH_THREADS
+  std::vector<const Hypothesis*> hypos(sourceHypoColl.begin(), sourceHypoColl.end());
+
+  // a few ranges per thread, to even out the uneven cost of expanding hypotheses
+  size_t numRanges = std::min(hypos.size(), m_searchThreadCount * 4);
+  while (m_expansionBuffers.size() < numRanges) {
+    m_expansionBuffers.push_back(new ExpansionBuffer);
   }
-  VERBOSE(2, m_manager.GetSentenceStats());
-}
 
+  TaskLatch latch(numRanges - 1);
+  ThreadPool &pool = StaticData::Instance().GetSearchThreadPool();
+  for (size_t range = 1 ; range < numRanges ; ++range) {
+    size_t begin = hypos.size() * range / numRanges;
+    size_t end = hypos.size() * (range + 1) / numRanges;
+    pool.Submit(new SearchNormalExpansionTask(*this, hypos, begin, end, *m_expansionBuffers[range], latch));
+  }
+
+  // this thread takes the first range
+  size_t end = hypos.size() / numRanges;
+  for (size_t i = 0 ; i < end ; ++i) {
+    ProcessOneHypothesis(*hypos[i], m_expansionBuffers[0]);
+  }
+  latch.Wait();
+
+  // add to the stacks in the same order as the serial search.
+  // a buffer's hypotheses are only freed by the thread that fills it,
+  // or here once all helpers are done
+  for (size_t range = 0 ; range < numRanges ; ++range) {
+    std::vector<Candidate> &candidates = m_expansionBuffers[range]->candidates;
+    std::vector<Candidate>::const_iterator iter;
+    for (iter = candidates.begin() ; iter != candidates.end() ; ++iter) {
+      AddCandidate(*iter);
+    }
+    candidates.clear();
+  }
+#else
+  HypothesisStackNormal::const_iterator iterHypo;
+  for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
+    ProcessOneHypothesis(**iterHypo);
+  }
+#endif
+}
 
 /** Find all translation options to expand one hypothesis, trigger expansion
  * this is mostly a check for overlap with already covered words, and for
  * violation of reordering limits.
  * \param hypothesis hypothesis to be expanded upon
+ * \param buffer if not NULL, collects the new hypotheses instead of adding them to the stacks
  */
-void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
+void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis, ExpansionBuffer *buffer)
 {
   // since we check for reordering limits, its good to have that limit handy
   int maxDistortion = StaticData::Instance().GetMaxDistortion();
@@ -125,7 +228,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
 
   // no limit of reordering: only check for overlap
   if (maxDistortion < 0) {
-    const WordsBitmap hypoBitmap	= hypothesis.GetWordsBitmap();
+    const WordsBitmap &hypoBitmap	= hypothesis.GetWordsBitmap();
     const size_t hypoFirstGapPos	= hypoBitmap.GetFirstGapPos()
                                     , sourceSize			= m_source.GetSize();
 
@@ -146,7 +249,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
         }
 
         //TODO: does this method include incompatible WordLattice hypotheses?
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, buffer);
       }
     }
 
@@ -155,7 +258,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
 
   // if there are reordering limits, make sure it is not violated
   // the coverage bitmap is handy here (and the position of the first gap)
-  const WordsBitmap hypoBitmap = hypothesis.GetWordsBitmap();
+  const WordsBitmap &hypoBitmap = hypothesis.GetWordsBitmap();
   const size_t	hypoFirstGapPos	= hypoBitmap.GetFirstGapPos()
                                   , sourceSize			= m_source.GetSize();
 
@@ -220,7 +323,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
 
       // any length extension is okay if starting at left-most edge
       if (leftMostEdge) {
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, buffer);
       }
       // starting somewhere other than left-most edge, use caution
       else {
@@ -240,7 +343,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
         }
 
         // everything is fine, we're good to go
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, buffer);
 
       }
     }
@@ -253,106 +356,183 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
  * \param hypothesis hypothesis to be expanded upon
  * \param startPos first word position of span covered
  * \param endPos last word position of span covered
+ * \param buffer if not NULL, collects the new hypotheses instead of adding them to the stacks
  */
 
-void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos)
+void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos, ExpansionBuffer *buffer)
 {
+  const TranslationOptionList &transOptList = m_transOptColl.GetTranslationOptionList(WordsRange(startPos, endPos));
+
+  if (!StaticData::Instance().UseEarlyDiscarding()) {
+    ExpandHypothesisBatch(hypothesis, transOptList, buffer);
+    return;
+  }
+
   // early discarding: check if hypothesis is too bad to build
   // this idea is explained in (Moore&Quirk, MT Summit 2007)
-  float expectedScore = 0.0f;
-  if (StaticData::Instance().UseEarlyDiscarding()) {
-    // expected score is based on score of current hypothesis
-    expectedScore = hypothesis.GetScore();
+  // expected score is based on score of current hypothesis
+  float expectedScore = hypothesis.GetScore();
 
-    // add new future score estimate
-    expectedScore += m_transOptColl.GetFutureScore().CalcFutureScore( hypothesis.GetWordsBitmap(), startPos, endPos );
-  }
+  // add new future score estimate
+  expectedScore += m_transOptColl.GetFutureScore().CalcFutureScore( hypothesis.GetWordsBitmap(), startPos, endPos );
 
   // loop through all translation options
-  const TranslationOptionList &transOptList = m_transOptColl.GetTranslationOptionList(WordsRange(startPos, endPos));
   TranslationOptionList::const_iterator iter;
   for (iter = transOptList.begin() ; iter != transOptList.end() ; ++iter) {
-    ExpandHypothesis(hypothesis, **iter, expectedScore);
+    ExpandHypothesis(hypothesis, **iter, expectedScore, buffer);
   }
 }
 
 /**
- * Expand one hypothesis with a translation option.
- * this involves initial creation, scoring and adding it to the proper stack
+ * Expand one hypothesis with a translation option, with early discarding.
+ * this involves initial creation, scoring and adding it to the proper stack.
+ * Without early discarding, ExpandHypothesisBatch() is used instead
  * \param hypothesis hypothesis to be expanded upon
  * \param transOpt translation option (phrase translation)
  *        that is applied to create the new hypothesis
  * \param expectedScore base score for early discarding
  *        (base hypothesis score plus future score estimation)
+ * \param buffer if not NULL, collects the new hypothesis instead of adding it to its stack
  */
-void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore)
+void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore, ExpansionBuffer *buffer)
 {
   const StaticData &staticData = StaticData::Instance();
   SentenceStats &stats = m_manager.GetSentenceStats();
   clock_t t=0; // used to track time for steps
 
-  Hypothesis *newHypo;
-  if (! staticData.UseEarlyDiscarding()) {
-    // simple build, no questions asked
-    IFVERBOSE(2) {
-      t = clock();
-    }
-    newHypo = hypothesis.CreateNext(transOpt, m_constraint);
-    IFVERBOSE(2) {
-      stats.AddTimeBuildHyp( clock()-t );
-    }
-    if (newHypo==NULL) return;
-    newHypo->CalcScore(m_transOptColl.GetFutureScore());
-  } else
-    // early discarding: check if hypothesis is too bad to build
-  {
-    // worst possible score may have changed -> recompute
-    size_t wordsTranslated = hypothesis.GetWordsBitmap().GetNumWordsCovered() + transOpt.GetSize();
-    float allowedScore = m_hypoStackColl[wordsTranslated]->GetWorstScore();
-    if (staticData.GetMinHypoStackDiversity()) {
-      WordsBitmapID id = hypothesis.GetWordsBitmap().GetIDPlus(transOpt.GetStartPos(), transOpt.GetEndPos());
-      float allowedScoreForBitmap = m_hypoStackColl[wordsTranslated]->GetWorstScoreForBitmap( id );
-      allowedScore = std::min( allowedScore, allowedScoreForBitmap );
-    }
-    allowedScore += staticData.GetEarlyDiscardingThreshold();
+  Arena &arena = buffer ? buffer->arena : m_manager.GetArena();
 
-    // add expected score of translation option
-    expectedScore += transOpt.GetFutureScore();
-    // TRACE_ERR("EXPECTED diff: " << (newHypo->GetTotalScore()-expectedScore) << " (pre " << (newHypo->GetTotalScore()-expectedScorePre) << ") " << hypothesis.GetTargetPhrase() << " ... " << transOpt.GetTargetPhrase() << " [" << expectedScorePre << "," << expectedScore << "," << newHypo->GetTotalScore() << "]" << endl);
+  // early discarding: check if hypothesis is too bad to build
+  // worst possible score may have changed -> recompute
+  size_t wordsTranslated = hypothesis.GetWordsBitmap().GetNumWordsCovered() + transOpt.GetSize();
+  WordsBitmapID coverage = 0;
+  if (staticData.GetMinHypoStackDiversity()) {
+    coverage = hypothesis.GetWordsBitmap().GetIDPlus(transOpt.GetStartPos(), transOpt.GetEndPos());
+  }
+  float allowedScore = GetAllowedScore(wordsTranslated, coverage);
 
-    // check if transOpt score push it already below limit
-    if (expectedScore < allowedScore) {
-      IFVERBOSE(2) {
-        stats.AddNotBuilt();
-      }
-      return;
+  // add expected score of translation option
+  expectedScore += transOpt.GetFutureScore();
+  // TRACE_ERR("EXPECTED diff: " << (newHypo->GetTotalScore()-expectedScore) << " (pre " << (newHypo->GetTotalScore()-expectedScorePre) << ") " << hypothesis.GetTargetPhrase() << " ... " << transOpt.GetTargetPhrase() << " [" << expectedScorePre << "," << expectedScore << "," << newHypo->GetTotalScore() << "]" << endl);
+
+  // check if transOpt score push it already below limit
+  if (expectedScore < allowedScore) {
+    IFSTATS {
+      stats.AddNotBuilt();
     }
+    return;
+  }
 
-    // build the hypothesis without scoring
-    IFVERBOSE(2) {
-      t = clock();
+  // build the hypothesis without scoring
+  IFSTATS {
+    t = GetThreadClock();
+  }
+  float expectedScorePre = expectedScore;
+  Hypothesis *newHypo = hypothesis.CreateNext(transOpt, m_constraint, arena, buffer == NULL);
+  if (newHypo==NULL) return;
+  IFSTATS {
+    stats.AddTimeBuildHyp( GetThreadClock()-t );
+  }
+
+  // compute expected score (all but correct LM)
+  expectedScore = newHypo->CalcExpectedScore( m_transOptColl.GetFutureScore() );
+  // ... and check if that is below the limit
+  if (expectedScore < allowedScore) {
+    FREEHYPO( newHypo );
+    if (buffer) {
+      // the serial search may not have built it at all, see AddCandidate()
+      buffer->candidates.push_back(Candidate(NULL, wordsTranslated, coverage, expectedScorePre, expectedScore));
+      return;
     }
-    newHypo = hypothesis.CreateNext(transOpt, m_constraint);
-    if (newHypo==NULL) return;
-    IFVERBOSE(2) {
-      stats.AddTimeBuildHyp( clock()-t );
+    IFSTATS {
+      stats.AddEarlyDiscarded();
     }
+    return;
+  }
 
-    // compute expected score (all but correct LM)
-    expectedScore = newHypo->CalcExpectedScore( m_transOptColl.GetFutureScore() );
-    // ... and check if that is below the limit
-    if (expectedScore < allowedScore) {
-      IFVERBOSE(2) {
-        stats.AddEarlyDiscarded();
-      }
-      FREEHYPO( newHypo );
-      return;
+  // ok, all is good, compute remaining scores
+  newHypo->CalcRemainingScore();
+
+  if (buffer) {
+    buffer->candidates.push_back(Candidate(newHypo, wordsTranslated, coverage, expectedScorePre, expectedScore));
+    return;
+  }
+
+  StoreHypothesis(newHypo, buffer);
+}
+
+/**
+ * Expand one hypothesis with all translation options of a span, without early discarding.
+ * All new hypotheses are built before any of them is scored, so that the
+ * feature functions can prefetch for the whole batch (see StatefulFeatureFunction::Prefetch()).
+ * \param hypothesis hypothesis to be expanded upon
+ * \param transOptList translation options of the span
+ * \param buffer if not NULL, collects the new hypotheses instead of adding them to the stacks
+ */
+void SearchNormal::ExpandHypothesisBatch(const Hypothesis &hypothesis, const TranslationOptionList &transOptList, ExpansionBuffer *buffer)
+{
+  SentenceStats &stats = m_manager.GetSentenceStats();
+  Arena &arena = buffer ? buffer->arena : m_manager.GetArena();
+  clock_t t=0; // used to track time for steps
+
+  IFSTATS {
+    t = GetThreadClock();
+  }
+  std::vector<Hypothesis*> newHypos;
+  newHypos.reserve(transOptList.size());
+  TranslationOptionList::const_iterator iterTransOpt;
+  for (iterTransOpt = transOptList.begin() ; iterTransOpt != transOptList.end() ; ++iterTransOpt) {
+    Hypothesis *newHypo = hypothesis.CreateNext(**iterTransOpt, m_constraint, arena, buffer == NULL);
+    if (newHypo != NULL) {
+      newHypos.push_back(newHypo);
     }
+  }
+  IFSTATS {
+    stats.AddTimeBuildHyp( GetThreadClock()-t );
+  }
 
-    // ok, all is good, compute remaining scores
-    newHypo->CalcRemainingScore();
+  Hypothesis::PrefetchScores(newHypos);
+  std::vector<Hypothesis*>::const_iterator iter;
+  for (iter = newHypos.begin() ; iter != newHypos.end() ; ++iter) {
+    (*iter)->CalcScore(m_transOptColl.GetFutureScore());
+    StoreHypothesis(*iter, buffer);
+  }
+}
 
+/**
+ * Lowest score a new hypothesis may be expected to have without being discarded early
+ * \param wordsTranslated stack the hypothesis goes to
+ * \param coverage id of its coverage, only used with stack diversity
+ */
+float SearchNormal::GetAllowedScore(size_t wordsTranslated, WordsBitmapID coverage)
+{
+  const StaticData &staticData = StaticData::Instance();
+  float allowedScore = m_hypoStackColl[wordsTranslated]->GetWorstScore();
+  if (staticData.GetMinHypoStackDiversity()) {
+    float allowedScoreForBitmap = m_hypoStackColl[wordsTranslated]->GetWorstScoreForBitmap( coverage );
+    allowedScore = std::min( allowedScore, allowedScoreForBitmap );
   }
+  return allowedScore + staticData.GetEarlyDiscardingThreshold();
+}
+
+/** Add a new hypothesis to its stack, or to buffer if given */
+void SearchNormal::StoreHypothesis(Hypothesis *newHypo, ExpansionBuffer *buffer)
+{
+  if (buffer) {
+    buffer->candidates.push_back(Candidate(newHypo));
+  } else {
+    AddHypothesisToStack(newHypo);
+  }
+}
+
+/**
+ * Add a fully scored hypothesis to the stack for its number of translated words
+ * \param newHypo hypothesis to be added; the stack takes ownership
+ */
+void SearchNormal::AddHypothesisToStack(Hypothesis *newHypo)
+{
+  SentenceStats &stats = m_manager.GetSentenceStats();
+  clock_t t=0; // used to track time for steps
 
   // logging for the curious
   IFVERBOSE(3) {
@@ -361,13 +541,58 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const Translat
 
   // add to hypothesis stack
   size_t wordsTranslated = newHypo->GetWordsBitmap().GetNumWordsCovered();
-  IFVERBOSE(2) {
-    t = clock();
+  IFSTATS {
+    t = GetThreadClock();
   }
   m_hypoStackColl[wordsTranslated]->AddPrune(newHypo);
-  IFVERBOSE(2) {
-    stats.AddTimeStack( clock()-t );
+  IFSTATS {
+    stats.AddTimeRecombine( GetThreadClock()-t );
+  }
+}
+
+/**
+ * Add a hypothesis created by a helper thread as the serial search would have.
+ * Without early discarding, it only gets its id, in the order of a serial run.
+ * With early discarding, the helper checked against the stacks from before
+ * this stack was expanded. The worst scores of the stacks only go up while
+ * hypotheses are added, so everything the helper discarded would have been
+ * discarded by the serial search too, but not the other way round. Both
+ * checks of ExpandHypothesis() are repeated here against the current stacks.
+ * A hypothesis gets an id if the serial search would have built it.
+ * \param candidate hypothesis and its early discarding estimates
+ */
+void SearchNormal::AddCandidate(const Candidate &candidate)
+{
+  SentenceStats &stats = m_manager.GetSentenceStats();
+  Hypothesis *newHypo = candidate.hypo;
+
+  if (StaticData::Instance().UseEarlyDiscarding()) {
+    float allowedScore = GetAllowedScore(candidate.wordsTranslated, candidate.coverage);
+    if (candidate.expectedScorePre < allowedScore) {
+      IFSTATS {
+        stats.AddNotBuilt();
+      }
+      if (newHypo != NULL) {
+        FREEHYPO( newHypo );
+      }
+      return;
+    }
+    int id = m_manager.GetNextHypoId();
+    if (newHypo == NULL || candidate.expectedScore < allowedScore) {
+      IFSTATS {
+        stats.AddEarlyDiscarded();
+      }
+      if (newHypo != NULL) {
+        FREEHYPO( newHypo );
+      }
+      return;
+    }
+    newHypo->SetId(id);
+  } else {
+    newHypo->SetId(m_manager.GetNextHypoId());
   }
+
+  AddHypothesisToStack(newHypo);
 }
 
 const std::vector < HypothesisStack* >& SearchNormal::GetHypothesisStacks() const
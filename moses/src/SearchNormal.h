@@ -6,6 +6,7 @@
 #include "HypothesisStackNormal.h"
 #include "TranslationOptionCollection.h"
 #include "Timer.h"
+#include "Arena.h"
 
 namespace Moses
 {
@@ -13,9 +14,11 @@ namespace Moses
 class Manager;
 class InputType;
 class TranslationOptionCollection;
+class SearchNormalExpansionTask;
 
 class SearchNormal: public Search
 {
+  friend class SearchNormalExpansionTask;
 protected:
   const InputType &m_source;
   std::vector < HypothesisStack* > m_hypoStackColl; /**< stacks to store hypotheses (partial translations) */
@@ -25,11 +28,47 @@ protected:
   size_t interrupted_flag; /**< flag indicating that decoder ran out of time (see switch -time-out) */
   HypothesisStackNormal* actual_hypoStack; /**actual (full expanded) stack of hypotheses*/
   const TranslationOptionCollection &m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
+  size_t m_searchThreadCount; /**< number of threads expanding one stack (see switch -search-threads) */
 
-  // functions for creating hypotheses
-  void ProcessOneHypothesis(const Hypothesis &hypothesis);
-  void ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos);
-  void ExpandHypothesis(const Hypothesis &hypothesis,const TranslationOption &transOpt, float expectedScore);
+  /** a hypothesis created by a helper thread, with what is needed to repeat
+   *  the early discarding checks of ExpandHypothesis() when it is added to its stack */
+  struct Candidate {
+    Hypothesis *hypo; /**< NULL if the helper discarded it early after building it */
+    size_t wordsTranslated; /**< stack the hypothesis goes to */
+    WordsBitmapID coverage;
+    float expectedScorePre; /**< estimate checked before building the hypothesis */
+    float expectedScore; /**< estimate checked after building it */
+
+    Candidate(Hypothesis *hypo, size_t wordsTranslated = 0, WordsBitmapID coverage = 0, float expectedScorePre = 0, float expectedScore = 0)
+      :hypo(hypo)
+      ,wordsTranslated(wordsTranslated)
+      ,coverage(coverage)
+      ,expectedScorePre(expectedScorePre)
+      ,expectedScore(expectedScore)
+    {}
+  };
+
+  /** hypotheses created by one range of a parallel stack expansion, allocated
+   *  from an arena of their own since arenas are not thread safe */
+  struct ExpansionBuffer {
+    std::vector<Candidate> candidates;
+    Arena arena;
+  };
+  std::vector<ExpansionBuffer*> m_expansionBuffers; /**< one per range, reused for all stacks */
+
+  // functions for creating hypotheses.
+  // if buffer is given, new hypotheses are created in its arena and collected there instead of being added to the stacks
+  void ProcessOneHypothesis(const Hypothesis &hypothesis, ExpansionBuffer *buffer = NULL);
+  void ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos, ExpansionBuffer *buffer = NULL);
+  void ExpandHypothesis(const Hypothesis &hypothesis,const TranslationOption &transOpt, float expectedScore, ExpansionBuffer *buffer = NULL);
+  void ExpandHypothesisBatch(const Hypothesis &hypothesis, const TranslationOptionList &transOptList, ExpansionBuffer *buffer = NULL);
+  float GetAllowedScore(size_t wordsTranslated, WordsBitmapID coverage);
+  void StoreHypothesis(Hypothesis *newHypo, ExpansionBuffer *buffer);
+  void AddHypothesisToStack(Hypothesis *newHypo);
+  void AddCandidate(const Candidate &candidate);
+
+  // parallel expansion of one stack
+  void ProcessStackParallel(const HypothesisStackNormal &sourceHypoColl);
 
 public:
   SearchNormal(Manager& manager, const InputType &source, const TranslationOptionCollection &transOptColl);
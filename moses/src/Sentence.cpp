@@ -20,6 +20,7 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
 #include <stdexcept>
 
 #include "Sentence.h"
@@ -43,19 +44,64 @@ Sentence::Sentence()
   }
 }
 
+namespace
+{
+//! whether the line may hold SGML or XML markup, which needs the full parse
+bool HasMarkup(const StringPiece &line)
+{
+  const char *end = line.data() + line.size();
+  if (std::find(line.data(), end, '<') != end) {
+    return true;
+  }
+  const StaticData &staticData = StaticData::Instance();
+  if (staticData.GetXmlInputType() == XmlPassThrough) {
+    return false;
+  }
+  const std::string &bracket = staticData.GetXmlBrackets().first;
+  return std::search(line.data(), end, bracket.begin(), bracket.end()) != end;
+}
+}
+
 int Sentence::Read(std::istream& in,const std::vector<FactorType>& factorOrder)
 {
-  const std::string& factorDelimiter = StaticData::Instance().GetFactorDelimiter();
   std::string line;
-  std::map<std::string, std::string> meta;
-
   if (getline(in, line, '\n').eof())
     return 0;
 
-  //get covered words - if continual-partial-translation is switched on, parse input
+  InitFromLine(line, factorOrder);
+  return 1;
+}
+
+void Sentence::InitFromLine(const StringPiece &input, const std::vector<FactorType>& factorOrder)
+{
   const StaticData &staticData = StaticData::Instance();
+  const std::string& factorDelimiter = staticData.GetFactorDelimiter();
   m_frontSpanCoveredLength = 0;
   m_sourceCompleted.resize(0);
+
+  std::vector<XmlOption*> xmlOptionsList(0);
+  std::vector< size_t > xmlWalls;
+  if (!staticData.ContinuePartialTranslation() && !HasMarkup(input)) {
+    // plain words: CreateFromString() skips the surrounding spaces, only line ends are left to drop
+    StringPiece words(input);
+    while (words.size() > 0 && (words[words.size() - 1] == '\r' || words[words.size() - 1] == '\n')) {
+      words.remove_suffix(1);
+    }
+    Phrase::CreateFromString(factorOrder, words, factorDelimiter);
+  } else {
+    std::string line(input.as_string());
+    ParseMarkup(line, xmlOptionsList, xmlWalls);
+    Phrase::CreateFromString(factorOrder, line, factorDelimiter);
+  }
+  InitAfterWords(xmlOptionsList, xmlWalls);
+}
+
+void Sentence::ParseMarkup(std::string &line, std::vector<XmlOption*> &xmlOptionsList, std::vector<size_t> &xmlWalls)
+{
+  std::map<std::string, std::string> meta;
+
+  //get covered words - if continual-partial-translation is switched on, parse input
+  const StaticData &staticData = StaticData::Instance();
   if (staticData.ContinuePartialTranslation()) {
     string initialTargetPhrase;
     string sourceCompletedStr;
@@ -94,9 +140,6 @@ int Sentence::Read(std::istream& in,const std::vector<FactorType>& factorOrder)
   }
 
   // parse XML markup in translation line
-  //const StaticData &staticData = StaticData::Instance();
-  std::vector<XmlOption*> xmlOptionsList(0);
-  std::vector< size_t > xmlWalls;
   if (staticData.GetXmlInputType() != XmlPassThrough) {
     if (!ProcessAndStripXMLTags(line, xmlOptionsList, m_reorderingConstraint, xmlWalls, staticData.GetXmlBrackets().first, staticData.GetXmlBrackets().second)) {
       const string msg("Unable to parse XML in line: " + line);
@@ -104,8 +147,11 @@ int Sentence::Read(std::istream& in,const std::vector<FactorType>& factorOrder)
       throw runtime_error(msg);
     }
   }
-  Phrase::CreateFromString(factorOrder, line, factorDelimiter);
+}
 
+void Sentence::InitAfterWords(const std::vector<XmlOption*> &xmlOptionsList, const std::vector<size_t> &xmlWalls)
+{
+  const StaticData &staticData = StaticData::Instance();
   if (staticData.GetSearchAlgorithm() == ChartDecoding) {
     InitStartEndWord();
   }
@@ -150,8 +196,6 @@ int Sentence::Read(std::istream& in,const std::vector<FactorType>& factorOrder)
     if( xmlWalls[i] < GetSize() ) // no buggy walls, please
       m_reorderingConstraint.SetWall( xmlWalls[i], true );
   m_reorderingConstraint.FinalizeWalls();
-
-  return 1;
 }
 
 void Sentence::InitStartEndWord()
@@ -57,6 +57,10 @@ private:
   NonTerminalSet m_defaultLabelSet;
 
   void InitStartEndWord();
+  //! continued partial translation, SGML and XML of a line, which is left with the words only
+  void ParseMarkup(std::string &line, std::vector<XmlOption*> &xmlOptionsList, std::vector<size_t> &xmlWalls);
+  //! XML options and reordering constraints, once the words are known
+  void InitAfterWords(const std::vector<XmlOption*> &xmlOptionsList, const std::vector<size_t> &xmlWalls);
 
 
 public:
@@ -88,6 +92,9 @@ public:
   void GetXmlTranslationOptions(std::vector <TranslationOption*> &list, size_t startPos, size_t endPos) const;
 
   int Read(std::istream& in,const std::vector<FactorType>& factorOrder);
+  /** fill the sentence from one line of input, without its newline. A line
+   *  without markup is split into words and factors in place, without copies */
+  void InitFromLine(const StringPiece &line, const std::vector<FactorType>& factorOrder);
   void Print(std::ostream& out) const;
 
   TranslationOptionCollection* CreateTranslationOptionCollection(const TranslationSystem* system) const;
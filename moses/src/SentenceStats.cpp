@@ -24,9 +24,118 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 using std::cout;
 using std::endl;
 #include "SentenceStats.h"
+#include "FeatureFunction.h"
 
 namespace Moses
 {
+
+namespace
+{
+
+void WriteJsonString(std::ostream& out, const std::string& str)
+{
+  out << '"';
+  for (size_t i = 0; i < str.size(); ++i) {
+    const char c = str[i];
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out << ' ';
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+}
+
+void SentenceStats::Clear()
+{
+  m_numSentences = 0;
+  m_numHyposCreated = 0;
+  m_numHyposPruned = 0;
+  m_numHyposDiscarded = 0;
+  m_numHyposEarlyDiscarded = 0;
+  m_numHyposNotBuilt = 0;
+  m_numHyposRecombined = 0;
+  m_numArcs = 0;
+  m_timeCollectOpts = 0;
+  m_timeFutureCost = 0;
+  m_timeBuildHyp = 0;
+  m_timeEstimateScore = 0;
+  m_timeFeatures.clear();
+  m_timeOtherScore = 0;
+  m_timePrune = 0;
+  m_timeRecombine = 0;
+  m_timeTotal = 0;
+  m_totalSourceWords = 0;
+  m_recombinationInfos.clear();
+  m_deletedWords.clear();
+  m_insertedWords.clear();
+}
+
+void SentenceStats::Accumulate(const SentenceStats& sentence)
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_accessLock);
+#endif
+  m_numSentences += sentence.m_numSentences;
+  m_numHyposCreated += sentence.m_numHyposCreated;
+  m_numHyposPruned += sentence.m_numHyposPruned;
+  m_numHyposDiscarded += sentence.m_numHyposDiscarded;
+  m_numHyposEarlyDiscarded += sentence.m_numHyposEarlyDiscarded;
+  m_numHyposNotBuilt += sentence.m_numHyposNotBuilt;
+  m_numHyposRecombined += sentence.m_numHyposRecombined;
+  m_numArcs += sentence.m_numArcs;
+  m_timeCollectOpts += sentence.m_timeCollectOpts;
+  m_timeFutureCost += sentence.m_timeFutureCost;
+  m_timeBuildHyp += sentence.m_timeBuildHyp;
+  m_timeEstimateScore += sentence.m_timeEstimateScore;
+  if (m_timeFeatures.size() < sentence.m_timeFeatures.size()) {
+    m_timeFeatures.resize(sentence.m_timeFeatures.size(), 0);
+  }
+  for (size_t i = 0; i < sentence.m_timeFeatures.size(); ++i) {
+    m_timeFeatures[i] += sentence.m_timeFeatures[i];
+  }
+  m_timeOtherScore += sentence.m_timeOtherScore;
+  m_timePrune += sentence.m_timePrune;
+  m_timeRecombine += sentence.m_timeRecombine;
+  m_timeTotal += sentence.m_timeTotal;
+  m_totalSourceWords += sentence.m_totalSourceWords;
+}
+
+void SentenceStats::WriteJson(std::ostream& out, const std::string& id,
+                              const std::vector<const StatefulFeatureFunction*>& ffs) const
+{
+  out << "{\"id\":" << id
+      << ",\"sentences\":" << GetNumSentences()
+      << ",\"source_words\":" << GetTotalSourceWords()
+      << ",\"hypos\":{\"created\":" << m_numHyposCreated
+      << ",\"not_built\":" << GetNumHyposNotBuilt()
+      << ",\"early_discarded\":" << GetNumHyposEarlyDiscarded()
+      << ",\"discarded\":" << GetNumHyposDiscarded()
+      << ",\"recombined\":" << GetNumHyposRecombined()
+      << ",\"pruned\":" << GetNumHyposPruned()
+      << ",\"arcs\":" << GetNumArcs()
+      << "},\"time\":{\"total\":" << GetTimeTotal()
+      << ",\"collect_opts\":" << GetTimeCollectOpts()
+      << ",\"future_cost\":" << GetTimeFutureCost()
+      << ",\"create_hyps\":" << GetTimeBuildHyp()
+      << ",\"estimate_score\":" << GetTimeEstimateScore()
+      << ",\"other_score\":" << GetTimeOtherScore()
+      << ",\"prune\":" << GetTimePrune()
+      << ",\"recombine\":" << GetTimeRecombine()
+      << ",\"features\":[";
+  // a list, as two feature functions may have the same description
+  for (size_t i = 0; i < ffs.size(); ++i) {
+    if (i > 0) out << ',';
+    out << "{\"name\":";
+    WriteJsonString(out, ffs[i]->GetScoreProducerDescription());
+    out << ",\"time\":" << GetTimeFeature(i) << '}';
+  }
+  out << "]}}" << std::endl;
+}
 /***
  * to be called after decoding a sentence
  */
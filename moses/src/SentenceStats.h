@@ -26,6 +26,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 #include <vector>
 #include <time.h>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 #include "Phrase.h"
 #include "Hypothesis.h"
 #include "TypeDef.h" //FactorArray
@@ -35,6 +40,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses
 {
 
+class StatefulFeatureFunction;
+
 struct RecombinationInfo {
   RecombinationInfo() {} //for std::vector
   RecombinationInfo(size_t srcWords, float gProb, float bProb)
@@ -45,7 +52,11 @@ struct RecombinationInfo {
 };
 
 /***
- * stats relating to decoder operation on a given sentence
+ * stats relating to decoder operation on a given sentence.
+ * The counters may be updated from several search threads
+ * (see -search-threads) and are guarded by a lock.
+ * Times are CPU time of the thread doing the work (see GetThreadClock()),
+ * so with several search threads the steps may add up to more than the total.
  */
 class SentenceStats
 {
@@ -57,22 +68,16 @@ public:
   SentenceStats(const InputType& source) {
     Initialize(source);
   }
+  /***
+   * for the totals over all sentences, see Accumulate()
+   */
+  SentenceStats() {
+    Clear();
+  }
   void Initialize(const InputType& source) {
-    m_numHyposCreated = 0;
-    m_numHyposPruned = 0;
-    m_numHyposDiscarded = 0;
-    m_numHyposEarlyDiscarded = 0;
-    m_numHyposNotBuilt = 0;
-    m_timeCollectOpts = 0;
-    m_timeBuildHyp = 0;
-    m_timeEstimateScore = 0;
-    m_timeCalcLM = 0;
-    m_timeOtherScore = 0;
-    m_timeStack = 0;
+    Clear();
+    m_numSentences = 1;
     m_totalSourceWords = source.GetSize();
-    m_recombinationInfos.clear();
-    m_deletedWords.clear();
-    m_insertedWords.clear();
   }
 
   /***
@@ -80,11 +85,29 @@ public:
    */
   void CalcFinalStats(const Hypothesis& bestHypo);
 
+  /***
+   * add the counters and times of a decoded sentence, but not its words
+   */
+  void Accumulate(const SentenceStats& sentence);
+
+  /***
+   * the counters and times as one line of JSON, with the time of each stateful
+   * feature function. id is written as given, so strings must be quoted.
+   */
+  void WriteJson(std::ostream& out, const std::string& id,
+                 const std::vector<const StatefulFeatureFunction*>& ffs) const;
+
+  size_t GetNumSentences() const {
+    return m_numSentences;
+  }
   unsigned int GetTotalHypos() const {
     return m_numHyposCreated + m_numHyposNotBuilt;
   }
   size_t GetNumHyposRecombined() const {
-    return m_recombinationInfos.size();
+    return m_numHyposRecombined;
+  }
+  size_t GetNumArcs() const {
+    return m_numArcs;
   }
   unsigned int GetNumHyposPruned() const {
     return m_numHyposPruned;
@@ -101,11 +124,23 @@ public:
   float GetTimeCollectOpts() const {
     return m_timeCollectOpts/(float)CLOCKS_PER_SEC;
   }
+  float GetTimeFutureCost() const {
+    return m_timeFutureCost/(float)CLOCKS_PER_SEC;
+  }
   float GetTimeBuildHyp() const {
     return m_timeBuildHyp/(float)CLOCKS_PER_SEC;
   }
-  float GetTimeCalcLM() const {
-    return m_timeCalcLM/(float)CLOCKS_PER_SEC;
+  //! time in the Evaluate() of all stateful feature functions
+  float GetTimeFeatures() const {
+    clock_t sum = 0;
+    for (size_t i = 0; i < m_timeFeatures.size(); ++i) {
+      sum += m_timeFeatures[i];
+    }
+    return sum/(float)CLOCKS_PER_SEC;
+  }
+  //! time in the Evaluate() of the i-th stateful feature function
+  float GetTimeFeature(size_t i) const {
+    return i < m_timeFeatures.size() ? m_timeFeatures[i]/(float)CLOCKS_PER_SEC : 0;
   }
   float GetTimeEstimateScore() const {
     return m_timeEstimateScore/(float)CLOCKS_PER_SEC;
@@ -113,8 +148,15 @@ public:
   float GetTimeOtherScore() const {
     return m_timeOtherScore/(float)CLOCKS_PER_SEC;
   }
+  float GetTimePrune() const {
+    return m_timePrune/(float)CLOCKS_PER_SEC;
+  }
+  //! time adding hypotheses to the stacks, which recombines them
+  float GetTimeRecombine() const {
+    return m_timeRecombine/(float)CLOCKS_PER_SEC;
+  }
   float GetTimeStack() const {
-    return m_timeStack/(float)CLOCKS_PER_SEC;
+    return (m_timePrune + m_timeRecombine)/(float)CLOCKS_PER_SEC;
   }
   float GetTimeTotal() const {
     return m_timeTotal/(float)CLOCKS_PER_SEC;
@@ -136,42 +178,98 @@ public:
   }
 
   void AddRecombination(const Hypothesis& worseHypo, const Hypothesis& betterHypo) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_recombinationInfos.push_back(RecombinationInfo(worseHypo.GetWordsBitmap().GetNumWordsCovered(),
                                    betterHypo.GetTotalScore(), worseHypo.GetTotalScore()));
+    m_numHyposRecombined++;
+  }
+  //! no lock, hypotheses are only added to a stack by one thread at a time
+  void AddArc() {
+    m_numArcs++;
   }
   void AddCreated() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_numHyposCreated++;
   }
   void AddPruning() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_numHyposPruned++;
   }
   void AddEarlyDiscarded() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_numHyposEarlyDiscarded++;
   }
   void AddNotBuilt() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_numHyposNotBuilt++;
   }
   void AddDiscarded() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_numHyposDiscarded++;
   }
 
   void AddTimeCollectOpts( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_timeCollectOpts += t;
   }
+  void AddTimeFutureCost( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
+    m_timeFutureCost += t;
+  }
   void AddTimeBuildHyp( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_timeBuildHyp += t;
   }
-  void AddTimeCalcLM( clock_t t ) {
-    m_timeCalcLM += t;
+  void AddTimeFeature( size_t i, clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
+    if (m_timeFeatures.size() <= i) {
+      m_timeFeatures.resize(i + 1, 0);
+    }
+    m_timeFeatures[i] += t;
   }
   void AddTimeEstimateScore( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_timeEstimateScore += t;
   }
   void AddTimeOtherScore( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
     m_timeOtherScore += t;
   }
-  void AddTimeStack( clock_t t ) {
-    m_timeStack += t;
+  void AddTimePrune( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
+    m_timePrune += t;
+  }
+  void AddTimeRecombine( clock_t t ) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_accessLock);
+#endif
+    m_timeRecombine += t;
   }
   void SetTimeTotal( clock_t t ) {
     m_timeTotal = t;
@@ -179,50 +277,65 @@ public:
 
 protected:
 
+  void Clear();
+
   /***
    * auxiliary to CalcFinalStats()
    */
   void AddDeletedWords(const Hypothesis& hypo);
 
+  size_t m_numSentences;
+
   //hypotheses
   std::vector<RecombinationInfo> m_recombinationInfos;
+  size_t m_numHyposRecombined;
+  size_t m_numArcs;
   unsigned int m_numHyposCreated;
   unsigned int m_numHyposPruned;
   unsigned int m_numHyposDiscarded;
   unsigned int m_numHyposEarlyDiscarded;
   unsigned int m_numHyposNotBuilt;
-  clock_t m_timeCollectOpts;
+  clock_t m_timeCollectOpts; /**< without the future cost */
+  clock_t m_timeFutureCost;
   clock_t m_timeBuildHyp;
   clock_t m_timeEstimateScore;
-  clock_t m_timeCalcLM;
+  std::vector<clock_t> m_timeFeatures; /**< by index of the stateful feature function */
   clock_t m_timeOtherScore;
-  clock_t m_timeStack;
+  clock_t m_timePrune;
+  clock_t m_timeRecombine;
   clock_t m_timeTotal;
 
   //words
   size_t m_totalSourceWords;
   std::vector<const Phrase*> m_deletedWords; //count deleted words/phrases in the final hypothesis
   std::vector<std::string> m_insertedWords; //count inserted words in the final hypothesis
+
+#ifdef WITH_THREADS
+  boost::mutex m_accessLock;
+#endif
 };
 
 inline std::ostream& operator<<(std::ostream& os, const SentenceStats& ss)
 {
   float totalTime = ss.GetTimeTotal();
-  float otherTime = totalTime - (ss.GetTimeCollectOpts() + ss.GetTimeBuildHyp() + ss.GetTimeEstimateScore() + ss.GetTimeCalcLM() + ss.GetTimeOtherScore() + ss.GetTimeStack());
+  float otherTime = totalTime - (ss.GetTimeCollectOpts() + ss.GetTimeFutureCost() + ss.GetTimeBuildHyp() + ss.GetTimeEstimateScore() + ss.GetTimeFeatures() + ss.GetTimeOtherScore() + ss.GetTimeStack());
 
   return os << "total hypotheses considered = " << ss.GetTotalHypos() << std::endl
          << "           number not built = " << ss.GetNumHyposNotBuilt() << std::endl
          << "     number discarded early = " << ss.GetNumHyposEarlyDiscarded() << std::endl
          << "           number discarded = " << ss.GetNumHyposDiscarded() << std::endl
          << "          number recombined = " << ss.GetNumHyposRecombined() << std::endl
+         << "                number arcs = " << ss.GetNumArcs() << std::endl
          << "              number pruned = " << ss.GetNumHyposPruned() << std::endl
 
          << "time to collect opts    " << ss.GetTimeCollectOpts()   << " (" << (int)(100 * ss.GetTimeCollectOpts()/totalTime) << "%)" << std::endl
+         << "        future cost     " << ss.GetTimeFutureCost()    << " (" << (int)(100 * ss.GetTimeFutureCost()/totalTime) << "%)" << std::endl
          << "        create hyps     " << ss.GetTimeBuildHyp()      << " (" << (int)(100 * ss.GetTimeBuildHyp()/totalTime) << "%)" << std::endl
          << "        estimate score  " << ss.GetTimeEstimateScore() << " (" << (int)(100 * ss.GetTimeEstimateScore()/totalTime) << "%)" << std::endl
-         << "        calc lm         " << ss.GetTimeCalcLM()        << " (" << (int)(100 * ss.GetTimeCalcLM()/totalTime) << "%)" << std::endl
+         << "        stateful ffs    " << ss.GetTimeFeatures()      << " (" << (int)(100 * ss.GetTimeFeatures()/totalTime) << "%)" << std::endl
          << "        other hyp score " << ss.GetTimeOtherScore()    << " (" << (int)(100 * ss.GetTimeOtherScore()/totalTime) << "%)" << std::endl
-         << "        manage stacks   " << ss.GetTimeStack()         << " (" << (int)(100 * ss.GetTimeStack()/totalTime) << "%)" << std::endl
+         << "        prune stacks    " << ss.GetTimePrune()         << " (" << (int)(100 * ss.GetTimePrune()/totalTime) << "%)" << std::endl
+         << "        recombine       " << ss.GetTimeRecombine()     << " (" << (int)(100 * ss.GetTimeRecombine()/totalTime) << "%)" << std::endl
          << "        other           " << otherTime                 << " (" << (int)(100 * otherTime/totalTime) << "%)" << std::endl
 
          << "total source words = " << ss.GetTotalSourceWords() << std::endl
@@ -0,0 +1,229 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_ShardedCache_h
+#define moses_ShardedCache_h
+
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace Moses
+{
+
+/** Persistent (cross-sentence) cache shared by all decoding threads.
+ *  The cache is split into shards by hash of the key, each with its own lock,
+ *  so that decoding threads rarely wait for each other. Each shard evicts with
+ *  the CLOCK approximation of least recently used, which costs O(1) per insertion.
+ *  Values are handed out as shared pointers, so eviction by one thread never
+ *  frees a value another thread is still using.
+ */
+template <class Key, class Value, class Hash = boost::hash<Key> >
+class ShardedCache
+{
+public:
+  typedef boost::shared_ptr<const Value> ValuePtr;
+
+  explicit ShardedCache(size_t maxSize = 0) {
+    SetMaxSize(maxSize);
+  }
+
+  //! maximum number of values held. 0 disables the cache
+  void SetMaxSize(size_t maxSize);
+  size_t GetMaxSize() const {
+    return m_maxSize;
+  }
+
+  //! cached value for the key, or an empty pointer
+  ValuePtr Find(const Key &key) const;
+  //! a value already added for the key, e.g. by another thread, is kept
+  void Add(const Key &key, const ValuePtr &value);
+  void Clear();
+
+  size_t GetSize() const;
+  size_t GetHits() const;
+  size_t GetMisses() const;
+  size_t GetEvictions() const;
+
+protected:
+  struct Slot {
+    Slot(const Key &key, const ValuePtr &value) : key(key), value(value), referenced(false) {}
+
+    Key key;
+    ValuePtr value;
+    bool referenced; /**< used since the clock hand last passed */
+  };
+
+  struct Shard {
+    Shard() : hand(0), hits(0), misses(0), evictions(0) {}
+
+    boost::unordered_map<Key, size_t, Hash> index; /**< key -> position in slots */
+    std::vector<Slot> slots;
+    size_t hand;
+    size_t hits, misses, evictions;
+#ifdef WITH_THREADS
+    boost::mutex lock;
+#endif
+  };
+
+  static const size_t NUM_SHARDS = 64;
+
+  size_t m_maxSize;
+  size_t m_shardCapacity;
+  mutable Shard m_shards[NUM_SHARDS];
+
+  Shard &GetShard(const Key &key) const {
+    return m_shards[Hash()(key) % NUM_SHARDS];
+  }
+
+private:
+  ShardedCache(const ShardedCache &); // not implemented
+  void operator=(const ShardedCache &); // not implemented
+};
+
+#ifdef WITH_THREADS
+#define LOCK_SHARD(shard) boost::mutex::scoped_lock lock((shard).lock)
+#else
+#define LOCK_SHARD(shard)
+#endif
+
+template <class Key, class Value, class Hash>
+void ShardedCache<Key, Value, Hash>::SetMaxSize(size_t maxSize)
+{
+  Clear();
+  m_maxSize = maxSize;
+  m_shardCapacity = (maxSize + NUM_SHARDS - 1) / NUM_SHARDS;
+}
+
+template <class Key, class Value, class Hash>
+typename ShardedCache<Key, Value, Hash>::ValuePtr ShardedCache<Key, Value, Hash>::Find(const Key &key) const
+{
+  Shard &shard = GetShard(key);
+  LOCK_SHARD(shard);
+
+  typename boost::unordered_map<Key, size_t, Hash>::const_iterator iter = shard.index.find(key);
+  if (iter == shard.index.end()) {
+    ++shard.misses;
+    return ValuePtr();
+  }
+  ++shard.hits;
+  Slot &slot = shard.slots[iter->second];
+  slot.referenced = true; // update last used
+  return slot.value;
+}
+
+template <class Key, class Value, class Hash>
+void ShardedCache<Key, Value, Hash>::Add(const Key &key, const ValuePtr &value)
+{
+  if (m_maxSize == 0) return;
+  Shard &shard = GetShard(key);
+  LOCK_SHARD(shard);
+
+  typename boost::unordered_map<Key, size_t, Hash>::iterator iter = shard.index.find(key);
+  if (iter != shard.index.end()) {
+    shard.slots[iter->second].referenced = true;
+    return;
+  }
+
+  if (shard.slots.size() < m_shardCapacity) {
+    shard.index[key] = shard.slots.size();
+    shard.slots.push_back(Slot(key, value));
+  } else {
+    // CLOCK: give every recently used entry a second chance, evict the first one that isn't
+    while (shard.slots[shard.hand].referenced) {
+      shard.slots[shard.hand].referenced = false;
+      shard.hand = (shard.hand + 1) % shard.slots.size();
+    }
+    size_t pos = shard.hand;
+    shard.hand = (shard.hand + 1) % shard.slots.size();
+    shard.index.erase(shard.slots[pos].key);
+    ++shard.evictions;
+
+    shard.slots[pos] = Slot(key, value);
+    shard.index[key] = pos;
+  }
+}
+
+template <class Key, class Value, class Hash>
+void ShardedCache<Key, Value, Hash>::Clear()
+{
+  for (size_t i = 0 ; i < NUM_SHARDS ; ++i) {
+    Shard &shard = m_shards[i];
+    LOCK_SHARD(shard);
+    shard.index.clear();
+    shard.slots.clear();
+    shard.hand = 0;
+  }
+}
+
+template <class Key, class Value, class Hash>
+size_t ShardedCache<Key, Value, Hash>::GetSize() const
+{
+  size_t ret = 0;
+  for (size_t i = 0 ; i < NUM_SHARDS ; ++i) {
+    LOCK_SHARD(m_shards[i]);
+    ret += m_shards[i].index.size();
+  }
+  return ret;
+}
+
+template <class Key, class Value, class Hash>
+size_t ShardedCache<Key, Value, Hash>::GetHits() const
+{
+  size_t ret = 0;
+  for (size_t i = 0 ; i < NUM_SHARDS ; ++i) {
+    LOCK_SHARD(m_shards[i]);
+    ret += m_shards[i].hits;
+  }
+  return ret;
+}
+
+template <class Key, class Value, class Hash>
+size_t ShardedCache<Key, Value, Hash>::GetMisses() const
+{
+  size_t ret = 0;
+  for (size_t i = 0 ; i < NUM_SHARDS ; ++i) {
+    LOCK_SHARD(m_shards[i]);
+    ret += m_shards[i].misses;
+  }
+  return ret;
+}
+
+template <class Key, class Value, class Hash>
+size_t ShardedCache<Key, Value, Hash>::GetEvictions() const
+{
+  size_t ret = 0;
+  for (size_t i = 0 ; i < NUM_SHARDS ; ++i) {
+    LOCK_SHARD(m_shards[i]);
+    ret += m_shards[i].evictions;
+  }
+  return ret;
+}
+
+#undef LOCK_SHARD
+
+}
+
+#endif
@@ -40,6 +40,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TranslationOption.h"
 #include "DecodeGraph.h"
 #include "InputFileStream.h"
+#include "ThreadPool.h"
 
 #ifdef HAVE_SYNLM
 #include "SyntacticLanguageModel.h"
@@ -71,6 +72,208 @@ static size_t CalcMax(size_t x, const vector<size_t>& y, const vector<size_t>& z
   return max;
 }
 
+/** Reads the files of one model, which doesn't depend on the other models
+ *  being read: with -load-threads, several tasks run at once. The models are
+ *  created, and their scores given indexes, in the order of the configuration,
+ *  on the thread loading StaticData, either before the task runs or by
+ *  Finish(), once all tasks that run together are done.
+ */
+class ModelLoadTask : public Task
+{
+public:
+  //! description: what is loaded, for reporting the time it took. Empty if nothing is read
+  explicit ModelLoadTask(const string &description)
+    : m_description(description), m_loaded(false) {}
+  virtual ~ModelLoadTask() {}
+
+  void Run() {
+    Timer timer;
+    timer.start();
+    try {
+      m_loaded = Load();
+    } catch (const std::exception &e) {
+      m_error = e.what();
+    }
+    if (!m_description.empty()) {
+      VERBOSE(1, "Loaded " << m_description << " in " << timer.get_elapsed_time() << " seconds" << endl);
+    }
+  }
+
+  bool DeleteAfterExecution() {
+    return false;
+  }
+
+  //! whether Run() succeeded, an exception it caught is thrown here, on the loading thread
+  bool IsLoaded() const {
+    if (!m_error.empty()) {
+      throw runtime_error(m_error);
+    }
+    return m_loaded;
+  }
+
+  //! add the model to StaticData, in the order of the tasks
+  virtual void Finish() {}
+
+protected:
+  virtual bool Load() = 0;
+
+private:
+  string m_description;
+  bool m_loaded;
+  string m_error;
+};
+
+namespace
+{
+
+class LexicalReorderingLoadTask : public ModelLoadTask
+{
+public:
+  LexicalReorderingLoadTask(LexicalReordering *model, const string &filePath)
+    : ModelLoadTask("lexical reordering table " + filePath), m_model(model) {}
+
+protected:
+  bool Load() {
+    m_model->Load();
+    return true;
+  }
+
+private:
+  LexicalReordering *m_model;
+};
+
+/** A language model adds itself to the ScoreIndexManager after reading its
+ *  file, so it is created with one that only collects it, and added to the
+ *  real one by Finish(). A file listed again shares the model loaded first */
+class LanguageModelLoadTask : public ModelLoadTask
+{
+public:
+  LanguageModelLoadTask(LMImplementation implementation
+                        , const vector<FactorType> &factorTypes
+                        , size_t nGramOrder
+                        , const string &filePath
+                        , int dub
+                        , ScoreIndexManager &scoreIndexManager
+                        , LMList &languageModels)
+    : ModelLoadTask("language model " + filePath)
+    , m_implementation(implementation)
+    , m_factorTypes(factorTypes)
+    , m_nGramOrder(nGramOrder)
+    , m_filePath(filePath)
+    , m_dub(dub)
+    , m_collector(true)
+    , m_scoreIndexManager(scoreIndexManager)
+    , m_languageModels(languageModels)
+    , m_original(NULL)
+    , m_languageModel(NULL) {}
+
+  //! the same model as original, which is earlier in the configuration
+  LanguageModelLoadTask(const LanguageModelLoadTask &original)
+    : ModelLoadTask("")
+    , m_implementation(original.m_implementation)
+    , m_nGramOrder(original.m_nGramOrder)
+    , m_dub(original.m_dub)
+    , m_collector(true)
+    , m_scoreIndexManager(original.m_scoreIndexManager)
+    , m_languageModels(original.m_languageModels)
+    , m_original(&original)
+    , m_languageModel(NULL) {}
+
+  void Finish() {
+    if (m_original != NULL) {
+      m_languageModel = m_original->m_languageModel->Duplicate(m_scoreIndexManager);
+    } else {
+      m_scoreIndexManager.AddScoreProducer(m_languageModel);
+    }
+    m_languageModels.Add(m_languageModel);
+  }
+
+protected:
+  bool Load() {
+    if (m_original != NULL) {
+      return true;
+    }
+    IFVERBOSE(1)
+    PrintUserTime(string("Start loading LanguageModel ") + m_filePath);
+
+    m_languageModel = LanguageModelFactory::CreateLanguageModel(
+                        m_implementation
+                        , m_factorTypes
+                        , m_nGramOrder
+                        , m_filePath
+                        , m_collector
+                        , m_dub);
+    if (m_languageModel == NULL) {
+      UserMessage::Add("no LM created. We probably don't have it compiled");
+      return false;
+    }
+    return true;
+  }
+
+private:
+  LMImplementation m_implementation;
+  vector<FactorType> m_factorTypes;
+  size_t m_nGramOrder;
+  string m_filePath;
+  int m_dub;
+  ScoreIndexManager m_collector;
+  ScoreIndexManager &m_scoreIndexManager;
+  LMList &m_languageModels;
+  const LanguageModelLoadTask *m_original;
+  LanguageModel *m_languageModel;
+};
+
+class GenerationLoadTask : public ModelLoadTask
+{
+public:
+  GenerationLoadTask(GenerationDictionary *dictionary, const string &filePath)
+    : ModelLoadTask("generation table " + filePath), m_dictionary(dictionary), m_filePath(filePath) {}
+
+protected:
+  bool Load() {
+    return m_dictionary->Load(m_filePath, Output);
+  }
+
+private:
+  GenerationDictionary *m_dictionary;
+  string m_filePath;
+};
+
+class GlobalLexicalLoadTask : public ModelLoadTask
+{
+public:
+  GlobalLexicalLoadTask(GlobalLexicalModel *model, const string &filePath)
+    : ModelLoadTask("global lexical model " + filePath), m_model(model) {}
+
+protected:
+  bool Load() {
+    m_model->Load();
+    return true;
+  }
+
+private:
+  GlobalLexicalModel *m_model;
+};
+
+class PhraseTableLoadTask : public ModelLoadTask
+{
+public:
+  PhraseTableLoadTask(PhraseDictionaryFeature *feature, const TranslationSystem *system, const string &filePath)
+    : ModelLoadTask("phrase table " + filePath), m_feature(feature), m_system(system) {}
+
+protected:
+  bool Load() {
+    m_feature->InitDictionary(m_system);
+    return true;
+  }
+
+private:
+  PhraseDictionaryFeature *m_feature;
+  const TranslationSystem *m_system;
+};
+
+}
+
 StaticData StaticData::s_instance;
 
 StaticData::StaticData()
@@ -253,9 +456,12 @@ bool StaticData::LoadData(Parameter *parameter)
     SetBooleanParameter( &m_useTransOptCache, "use-persistent-cache", true );
     m_transOptCacheMaxSize = (m_parameter->GetParam("persistent-cache-size").size() > 0)
                              ? Scan<size_t>(m_parameter->GetParam("persistent-cache-size")[0]) : DEFAULT_MAX_TRANS_OPT_CACHE_SIZE;
+    m_transOptCache.SetMaxSize(m_transOptCacheMaxSize);
   } else {
     m_useTransOptCache = false;
   }
+  m_onDiskRuleCache.SetMaxSize((m_parameter->GetParam("rule-cache-size").size() > 0)
+                               ? Scan<size_t>(m_parameter->GetParam("rule-cache-size")[0]) : DEFAULT_MAX_ON_DISK_RULE_CACHE_SIZE);
 
 
   //input factors
@@ -297,6 +503,15 @@ bool StaticData::LoadData(Parameter *parameter)
       return false;
     }
   }
+  if (m_parameter->isParamSpecified("sentence-stats")) {
+    const vector<string> &args = m_parameter->GetParam("sentence-stats");
+    if (args.size() == 1) {
+      m_sentenceStatsFilePath = args[0];
+    } else {
+      UserMessage::Add(string("the sentence-stats option requires exactly one filename argument"));
+      return false;
+    }
+  }
 
   // word penalties
   for (size_t i = 0; i < m_parameter->GetParam("weight-w").size(); ++i) {
@@ -437,6 +652,41 @@ bool StaticData::LoadData(Parameter *parameter)
     }
   }
 
+  m_searchThreadCount = (m_parameter->GetParam("search-threads").size() > 0) ?
+                        Scan<size_t>(m_parameter->GetParam("search-threads")[0]) : 1;
+  if (m_searchThreadCount < 1) {
+    UserMessage::Add("Specify at least one search thread.");
+    return false;
+  }
+#ifndef WITH_THREADS
+  if (m_searchThreadCount > 1) {
+    UserMessage::Add("Error: search-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
+
+  m_readAhead = (m_parameter->GetParam("read-ahead").size() > 0) ?
+                Scan<size_t>(m_parameter->GetParam("read-ahead")[0]) : 0;
+#ifndef WITH_THREADS
+  if (m_readAhead > 0) {
+    UserMessage::Add("Error: read-ahead > 0 but moses not built with thread support");
+    return false;
+  }
+#endif
+
+  m_loadThreadCount = (m_parameter->GetParam("load-threads").size() > 0) ?
+                      Scan<size_t>(m_parameter->GetParam("load-threads")[0]) : 1;
+  if (m_loadThreadCount < 1) {
+    UserMessage::Add("Specify at least one load thread.");
+    return false;
+  }
+#ifndef WITH_THREADS
+  if (m_loadThreadCount > 1) {
+    UserMessage::Add("Error: load-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
+
   m_startTranslationId = (m_parameter->GetParam("start-translation-id").size() > 0) ?
           Scan<long>(m_parameter->GetParam("start-translation-id")[0]) : 0;
 
@@ -502,12 +752,26 @@ bool StaticData::LoadData(Parameter *parameter)
 	}
 #endif
 	
-  if (!LoadLexicalReorderingModel()) return false;
-  if (!LoadLanguageModels()) return false;
-  if (!LoadGenerationTables()) return false;
-  if (!LoadPhraseTables()) return false;
-  if (!LoadGlobalLexicalModel()) return false;
-  if (!LoadDecodeGraphs()) return false;
+  // the files of the models are read by tasks, several at once with
+  // -load-threads. Generation and memory phrase tables need the language
+  // models to be loaded, and added to the ScoreIndexManager, first
+  vector<ModelLoadTask*> loadTasks;
+  if (!LoadLexicalReorderingModel(loadTasks) || !LoadLanguageModels(loadTasks)) {
+    RemoveAllInColl(loadTasks);
+    return false;
+  }
+  if (!RunLoadTasks(loadTasks)) return false;
+  // flag indicating that language models were loaded,
+  // since phrase table loading requires their presence
+  m_fLMsLoaded = true;
+  IFVERBOSE(1)
+  PrintUserTime("Finished loading LanguageModels");
+
+  if (!LoadGenerationTables(loadTasks) || !LoadPhraseTables()
+      || !LoadGlobalLexicalModel(loadTasks) || !LoadDecodeGraphs()) {
+    RemoveAllInColl(loadTasks);
+    return false;
+  }
 
 
   //configure the translation systems with these tables
@@ -532,6 +796,7 @@ bool StaticData::LoadData(Parameter *parameter)
     }
   }
 
+  vector<string> systemIds;
   for (size_t i = 0; i < tsConfig.size(); ++i) {
     vector<string> config = Tokenize(tsConfig[i]);
     if (config.size() % 2 != 1) {
@@ -584,8 +849,8 @@ bool StaticData::LoadData(Parameter *parameter)
         return false;
       }
     }
-    //Instigate dictionary loading
     m_translationSystems.find(config[0])->second.ConfigDictionaries();
+    systemIds.push_back(config[0]);
 
 
 
@@ -597,12 +862,57 @@ bool StaticData::LoadData(Parameter *parameter)
 #endif
   }
 
+  //Instigate dictionary loading, each phrase table once, with the first system using it
+  set<const PhraseDictionaryFeature*> phraseTablesLoaded;
+  for (size_t i = 0; i < systemIds.size(); ++i) {
+    const TranslationSystem &system = m_translationSystems.find(systemIds[i])->second;
+    const vector<PhraseDictionaryFeature*> &phraseTables = system.GetPhraseDictionaries();
+    for (size_t j = 0; j < phraseTables.size(); ++j) {
+      if (phraseTables[j]->IsThreadSafe() && phraseTablesLoaded.insert(phraseTables[j]).second) {
+        loadTasks.push_back(new PhraseTableLoadTask(phraseTables[j], &system, phraseTables[j]->GetFilePath()));
+      }
+    }
+  }
+  if (!RunLoadTasks(loadTasks)) return false;
 
   m_scoreIndexManager.InitFeatureNames();
 
   return true;
 }
 
+bool StaticData::RunLoadTasks(vector<ModelLoadTask*> &loadTasks)
+{
+#ifdef WITH_THREADS
+  if (m_loadThreadCount > 1 && loadTasks.size() > 1) {
+    ThreadPool pool(min(m_loadThreadCount, loadTasks.size()));
+    for (size_t i = 0; i < loadTasks.size(); ++i) {
+      pool.Submit(loadTasks[i]);
+    }
+    pool.Stop(true);
+  } else
+#endif
+  {
+    for (size_t i = 0; i < loadTasks.size(); ++i) {
+      loadTasks[i]->Run();
+    }
+  }
+
+  bool ret = true;
+  try {
+    for (size_t i = 0; i < loadTasks.size() && ret; ++i) {
+      ret = loadTasks[i]->IsLoaded();
+      if (ret) {
+        loadTasks[i]->Finish();
+      }
+    }
+  } catch (...) {
+    RemoveAllInColl(loadTasks);
+    throw;
+  }
+  RemoveAllInColl(loadTasks);
+  return ret;
+}
+
 void StaticData::SetBooleanParameter( bool *parameter, string parameterName, bool defaultValue )
 {
   // default value if nothing is specified
@@ -624,6 +934,9 @@ void StaticData::SetBooleanParameter( bool *parameter, string parameterName, boo
 
 StaticData::~StaticData()
 {
+#ifdef WITH_THREADS
+  m_searchThreadPool.reset();
+#endif
   RemoveAllInColl(m_phraseDictionary);
   RemoveAllInColl(m_generationDictionary);
   RemoveAllInColl(m_reorderModels);
@@ -707,7 +1020,7 @@ StaticData::~StaticData()
   }
 #endif
 
-bool StaticData::LoadLexicalReorderingModel()
+bool StaticData::LoadLexicalReorderingModel(vector<ModelLoadTask*> &loadTasks)
 {
   VERBOSE(1, "Loading lexical distortion models...");
   const vector<string> fileStr    = m_parameter->GetParam("distortion-file");
@@ -775,11 +1088,12 @@ bool StaticData::LoadLexicalReorderingModel()
     string filePath = spec[3];
 
     m_reorderModels.push_back(new LexicalReordering(input, output, modelType, filePath, mweights));
+    loadTasks.push_back(new LexicalReorderingLoadTask(m_reorderModels.back(), filePath));
   }
   return true;
 }
 
-bool StaticData::LoadGlobalLexicalModel()
+bool StaticData::LoadGlobalLexicalModel(vector<ModelLoadTask*> &loadTasks)
 {
   const vector<float> &weight = Scan<float>(m_parameter->GetParam("weight-lex"));
   const vector<string> &file = m_parameter->GetParam("global-lexical-file");
@@ -804,11 +1118,12 @@ bool StaticData::LoadGlobalLexicalModel()
     vector<FactorType> inputFactors = Tokenize<FactorType>(factors[0],",");
     vector<FactorType> outputFactors = Tokenize<FactorType>(factors[1],",");
     m_globalLexicalModels.push_back( new GlobalLexicalModel( spec[1], weight[i], inputFactors, outputFactors ) );
+    loadTasks.push_back(new GlobalLexicalLoadTask(m_globalLexicalModels.back(), spec[1]));
   }
   return true;
 }
 
-bool StaticData::LoadLanguageModels()
+bool StaticData::LoadLanguageModels(vector<ModelLoadTask*> &loadTasks)
 {
   if (m_parameter->GetParam("lmodel-file").size() > 0) {
     // weights
@@ -828,12 +1143,11 @@ bool StaticData::LoadLanguageModels()
     // initialize n-gram order for each factor. populated only by factored lm
     const vector<string> &lmVector = m_parameter->GetParam("lmodel-file");
     //prevent language models from being loaded twice
-    map<string,LanguageModel*> languageModelsLoaded;
+    map<string,const LanguageModelLoadTask*> languageModelsLoaded;
 
     for(size_t i=0; i<lmVector.size(); i++) {
-      LanguageModel* lm = NULL;
       if (languageModelsLoaded.find(lmVector[i]) != languageModelsLoaded.end()) {
-        lm = languageModelsLoaded[lmVector[i]]->Duplicate(m_scoreIndexManager); 
+        loadTasks.push_back(new LanguageModelLoadTask(*languageModelsLoaded[lmVector[i]]));
       } else {
         vector<string>	token		= Tokenize(lmVector[i]);
         if (token.size() != 4 && token.size() != 5 ) {
@@ -858,35 +1172,23 @@ bool StaticData::LoadLanguageModels()
             return false;
           }
         }
-        IFVERBOSE(1)
-        PrintUserTime(string("Start loading LanguageModel ") + languageModelFile);
-
-        lm = LanguageModelFactory::CreateLanguageModel(
-               lmImplementation
-               , factorTypes
-               , nGramOrder
-               , languageModelFile
-               , m_scoreIndexManager
-               , LMdub[i]);
-        if (lm == NULL) {
-          UserMessage::Add("no LM created. We probably don't have it compiled");
-          return false;
-        }
-        languageModelsLoaded[lmVector[i]] = lm;
+        LanguageModelLoadTask *task = new LanguageModelLoadTask(
+          lmImplementation
+          , factorTypes
+          , nGramOrder
+          , languageModelFile
+          , LMdub[i]
+          , m_scoreIndexManager
+          , m_languageModel);
+        loadTasks.push_back(task);
+        languageModelsLoaded[lmVector[i]] = task;
       }
-
-      m_languageModel.Add(lm);
     }
   }
-  // flag indicating that language models were loaded,
-  // since phrase table loading requires their presence
-  m_fLMsLoaded = true;
-  IFVERBOSE(1)
-  PrintUserTime("Finished loading LanguageModels");
   return true;
 }
 
-bool StaticData::LoadGenerationTables()
+bool StaticData::LoadGenerationTables(vector<ModelLoadTask*> &loadTasks)
 {
   if (m_parameter->GetParam("generation-file").size() > 0) {
     const vector<string> &generationVector = m_parameter->GetParam("generation-file");
@@ -920,10 +1222,7 @@ bool StaticData::LoadGenerationTables()
 
       m_generationDictionary.push_back(new GenerationDictionary(numFeatures, m_scoreIndexManager, input,output));
       CHECK(m_generationDictionary.back() && "could not create GenerationDictionary");
-      if (!m_generationDictionary.back()->Load(filePath, Output)) {
-        delete m_generationDictionary.back();
-        return false;
-      }
+      loadTasks.push_back(new GenerationLoadTask(m_generationDictionary.back(), filePath));
       for(size_t i = 0; i < numFeatures; i++) {
         CHECK(currWeightNum < weight.size());
         m_allWeights.push_back(weight[currWeightNum++]);
@@ -1276,66 +1575,31 @@ void StaticData::SetWeightsForScoreProducer(const ScoreProducer* sp, const std::
     m_allWeights[i] = *weightIter++;
 }
 
-const TranslationOptionList* StaticData::FindTransOptListInCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase) const
-{
-  std::pair<size_t, Phrase> key(decodeGraph.GetPosition(), sourcePhrase);
 #ifdef WITH_THREADS
-  boost::mutex::scoped_lock lock(m_transOptCacheMutex);
-#endif
-  std::map<std::pair<size_t, Phrase>, std::pair<TranslationOptionList*,clock_t> >::iterator iter
-  = m_transOptCache.find(key);
-  if (iter == m_transOptCache.end())
-    return NULL;
-  iter->second.second = clock(); // update last used time
-  return iter->second.first;
+ThreadPool &StaticData::GetSearchThreadPool() const
+{
+  boost::mutex::scoped_lock lock(m_searchThreadPoolMutex);
+  if (!m_searchThreadPool.get()) {
+    // the decoding thread does its own share of the work, so one thread less
+    m_searchThreadPool.reset(new ThreadPool(m_searchThreadCount - 1));
+  }
+  return *m_searchThreadPool;
 }
+#endif
 
-void StaticData::ReduceTransOptCache() const
+TranslationOptionCache::ListPtr StaticData::FindTransOptListInCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase) const
 {
-  if (m_transOptCache.size() <= m_transOptCacheMaxSize) return; // not full
-  clock_t t = clock();
-
-  // find cutoff for last used time
-  priority_queue< clock_t > lastUsedTimes;
-  std::map<std::pair<size_t, Phrase>, std::pair<TranslationOptionList*,clock_t> >::iterator iter;
-  iter = m_transOptCache.begin();
-  while( iter != m_transOptCache.end() ) {
-    lastUsedTimes.push( iter->second.second );
-    iter++;
-  }
-  for( size_t i=0; i < lastUsedTimes.size()-m_transOptCacheMaxSize/2; i++ )
-    lastUsedTimes.pop();
-  clock_t cutoffLastUsedTime = lastUsedTimes.top();
-
-  // remove all old entries
-  iter = m_transOptCache.begin();
-  while( iter != m_transOptCache.end() ) {
-    if (iter->second.second < cutoffLastUsedTime) {
-      std::map<std::pair<size_t, Phrase>, std::pair<TranslationOptionList*,clock_t> >::iterator iterRemove = iter++;
-      delete iterRemove->second.first;
-      m_transOptCache.erase(iterRemove);
-    } else iter++;
-  }
-  VERBOSE(2,"Reduced persistent translation option cache in " << ((clock()-t)/(float)CLOCKS_PER_SEC) << " seconds." << std::endl);
+  return m_transOptCache.Find(decodeGraph.GetPosition(), sourcePhrase);
 }
 
 void StaticData::AddTransOptListToCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase, const TranslationOptionList &transOptList) const
 {
-  if (m_transOptCacheMaxSize == 0) return;
-  std::pair<size_t, Phrase> key(decodeGraph.GetPosition(), sourcePhrase);
-  TranslationOptionList* storedTransOptList = new TranslationOptionList(transOptList);
-#ifdef WITH_THREADS
-  boost::mutex::scoped_lock lock(m_transOptCacheMutex);
-#endif
-  m_transOptCache[key] = make_pair( storedTransOptList, clock() );
-  ReduceTransOptCache();
+  m_transOptCache.Add(decodeGraph.GetPosition(), sourcePhrase, transOptList);
 }
-void StaticData::ClearTransOptionCache() const {
-  map<std::pair<size_t, Phrase>, std::pair< TranslationOptionList*, clock_t > >::iterator iterCache;
-  for (iterCache = m_transOptCache.begin() ; iterCache != m_transOptCache.end() ; ++iterCache) {
-    TranslationOptionList *transOptList = iterCache->second.first;
-    delete transOptList;
-  }
+
+void StaticData::ClearTransOptionCache() const
+{
+  m_transOptCache.Clear();
 }
 
 }
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #ifdef WITH_THREADS
 #include <boost/thread/mutex.hpp>
+#include "ThreadPool.h"
 #endif
 
 #include "TypeDef.h"
@@ -45,6 +46,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "SentenceStats.h"
 #include "DecodeGraph.h"
 #include "TranslationOptionList.h"
+#include "TranslationOptionCache.h"
+#include "RuleTable/OnDiskRuleCache.h"
 #include "TranslationSystem.h"
 
 namespace Moses
@@ -62,6 +65,7 @@ class UnknownWordPenaltyProducer;
 class SyntacticLanguageModel;
 #endif
 class TranslationSystem;
+class ModelLoadTask;
 
 typedef std::pair<std::string, float> UnknownLHSEntry;
 typedef std::vector<UnknownLHSEntry>  UnknownLHSList;
@@ -142,6 +146,7 @@ protected:
   bool m_reportAllFactors;
   bool m_reportAllFactorsNBest;
   std::string m_detailedTranslationReportingFilePath;
+  std::string m_sentenceStatsFilePath;
   bool m_onlyDistinctNBest;
   bool m_UseAlignmentInfo;
   bool m_PrintAlignmentInfo;
@@ -175,13 +180,9 @@ protected:
   size_t m_timeout_threshold; //! seconds after which time out is activated
 
   bool m_useTransOptCache; //! flag indicating, if the persistent translation option cache should be used
-  mutable std::map<std::pair<size_t, Phrase>, std::pair<TranslationOptionList*,clock_t> > m_transOptCache; //! persistent translation option cache
+  mutable TranslationOptionCache m_transOptCache; //! persistent translation option cache
   size_t m_transOptCacheMaxSize; //! maximum size for persistent translation option cache
-  //FIXME: Single lock for cache not most efficient. However using a
-  //reader-writer for LRU cache is tricky - how to record last used time?
-#ifdef WITH_THREADS
-  mutable boost::mutex m_transOptCacheMutex;
-#endif
+  mutable OnDiskRuleCache m_onDiskRuleCache; //! rules of on-disk rule tables, shared by all threads
   bool m_isAlwaysCreateDirectTranslationOption;
   //! constructor. only the 1 static variable can be created
 
@@ -207,6 +208,13 @@ protected:
   WordAlignmentSort m_wordAlignmentSort;
 
   int m_threadCount;
+  size_t m_searchThreadCount;
+  size_t m_readAhead;
+  size_t m_loadThreadCount;
+#ifdef WITH_THREADS
+  mutable std::auto_ptr<ThreadPool> m_searchThreadPool; //! helper threads for -search-threads, created on first use
+  mutable boost::mutex m_searchThreadPoolMutex;
+#endif
   long m_startTranslationId;
   
   StaticData();
@@ -218,7 +226,7 @@ protected:
   //! helper fn to set bool param from ini file/command line
   void SetBooleanParameter(bool *paramter, std::string parameterName, bool defaultValue);
   //! load all language models as specified in ini file
-  bool LoadLanguageModels();
+  bool LoadLanguageModels(std::vector<ModelLoadTask*> &loadTasks);
 #ifdef HAVE_SYNLM
   //! load syntactic language model
 	bool LoadSyntacticLanguageModel();
@@ -226,12 +234,13 @@ protected:
   //! load not only the main phrase table but also any auxiliary tables that depend on which features are being used (e.g., word-deletion, word-insertion tables)
   bool LoadPhraseTables();
   //! load all generation tables as specified in ini file
-  bool LoadGenerationTables();
+  bool LoadGenerationTables(std::vector<ModelLoadTask*> &loadTasks);
   //! load decoding steps
   bool LoadDecodeGraphs();
-  bool LoadLexicalReorderingModel();
-  bool LoadGlobalLexicalModel();
-  void ReduceTransOptCache() const;
+  bool LoadLexicalReorderingModel(std::vector<ModelLoadTask*> &loadTasks);
+  bool LoadGlobalLexicalModel(std::vector<ModelLoadTask*> &loadTasks);
+  //! run the tasks, up to m_loadThreadCount at a time, then finish and delete them in order
+  bool RunLoadTasks(std::vector<ModelLoadTask*> &loadTasks);
   bool m_continuePartialTranslation;
 
 public:
@@ -380,6 +389,13 @@ public:
   const std::string &GetDetailedTranslationReportingFilePath() const {
     return m_detailedTranslationReportingFilePath;
   }
+  const std::string &GetSentenceStatsFilePath() const {
+    return m_sentenceStatsFilePath;
+  }
+  //! whether decoding steps are timed and counted in SentenceStats
+  bool CollectSentenceStats() const {
+    return m_verboseLevel >= 2 || !m_sentenceStatsFilePath.empty();
+  }
 
   const std::string &GetAlignmentOutputFile() const {
     return m_alignmentOutputFile;
@@ -573,7 +589,15 @@ public:
   void ClearTransOptionCache() const;
 
 
-  const TranslationOptionList* FindTransOptListInCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase) const;
+  TranslationOptionCache::ListPtr FindTransOptListInCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase) const;
+
+  const TranslationOptionCache &GetTransOptCache() const {
+    return m_transOptCache;
+  }
+
+  OnDiskRuleCache &GetOnDiskRuleCache() const {
+    return m_onDiskRuleCache;
+  }
 
   bool PrintAllDerivations() const {
     return m_printAllDerivations;
@@ -615,6 +639,19 @@ public:
   int ThreadCount() const {
     return m_threadCount;
   }
+
+  //! number of threads decoding a single sentence (1 = serial)
+  size_t SearchThreadCount() const {
+    return m_searchThreadCount;
+  }
+  //! number of input sentences parsed ahead of decoding on a separate thread (0 = none)
+  size_t GetReadAhead() const {
+    return m_readAhead;
+  }
+#ifdef WITH_THREADS
+  //! helper threads shared by all sentences, used when SearchThreadCount() > 1
+  ThreadPool &GetSearchThreadPool() const;
+#endif
   
   long GetStartTranslationId() const
   { return m_startTranslationId; }
@@ -100,10 +100,10 @@ namespace Moses
       const std::string& string = factor->GetString();
       
       if (i==0) {
-	nextState = new SyntacticLanguageModelState<YModel,XModel,S,R>((const SyntacticLanguageModelState<YModel,XModel,S,R>*)prev_state, string);
+	nextState = new(cur_hypo.GetArena()) SyntacticLanguageModelState<YModel,XModel,S,R>((const SyntacticLanguageModelState<YModel,XModel,S,R>*)prev_state, string);
       } else {
 	tmpState = nextState;
-	nextState = new SyntacticLanguageModelState<YModel,XModel,S,R>(tmpState, string);
+	nextState = new(cur_hypo.GetArena()) SyntacticLanguageModelState<YModel,XModel,S,R>(tmpState, string);
 	delete tmpState;
       }
       
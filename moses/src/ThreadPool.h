@@ -102,6 +102,35 @@ private:
   size_t m_queueLimit;
 };
 
+/**
+ * Lets a thread wait until a known number of tasks have finished.
+ * Each task calls CountDown() when it is done.
+ **/
+class TaskLatch
+{
+public:
+  explicit TaskLatch(size_t count) : m_count(count) {}
+
+  void CountDown() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (--m_count == 0) {
+      m_done.notify_all();
+    }
+  }
+
+  void Wait() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_count > 0) {
+      m_done.wait(lock);
+    }
+  }
+
+private:
+  size_t m_count;
+  boost::mutex m_mutex;
+  boost::condition_variable m_done;
+};
+
 class TestTask : public Task
 {
 public:
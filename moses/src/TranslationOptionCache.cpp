@@ -0,0 +1,69 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/functional/hash.hpp>
+
+#include "TranslationOptionCache.h"
+#include "TranslationOption.h"
+#include "Factor.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+size_t TranslationOptionCacheKeyHash::operator()(const std::pair<size_t, Phrase> &key) const
+{
+  // equal phrases have identical factor pointers, see Word::Compare()
+  size_t seed = key.first;
+  const Phrase &phrase = key.second;
+  for (size_t pos = 0 ; pos < phrase.GetSize() ; ++pos) {
+    const Word &word = phrase.GetWord(pos);
+    boost::hash_combine(seed, word.IsNonTerminal());
+    for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; ++factorType) {
+      const Factor *factor = word[factorType];
+      if (factor != NULL) {
+        boost::hash_combine(seed, factor->GetId());
+      }
+    }
+  }
+  return seed;
+}
+
+void TranslationOptionCache::Add(size_t decodeGraphPos, const Phrase &sourcePhrase, const TranslationOptionList &transOptList)
+{
+  if (m_maxSize == 0) return;
+  // copy outside of the lock
+  ListPtr list(new TranslationOptionList(transOptList));
+  Base::Add(std::make_pair(decodeGraphPos, sourcePhrase), list);
+}
+
+std::ostream& operator<<(std::ostream& out, const TranslationOptionCache& cache)
+{
+  out << "translation option cache: size=" << cache.GetSize()
+      << " max=" << cache.GetMaxSize()
+      << " hits=" << cache.GetHits()
+      << " misses=" << cache.GetMisses()
+      << " evictions=" << cache.GetEvictions();
+  return out;
+}
+
+}
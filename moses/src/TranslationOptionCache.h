@@ -0,0 +1,64 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_TranslationOptionCache_h
+#define moses_TranslationOptionCache_h
+
+#include <iostream>
+#include <utility>
+
+#include "Phrase.h"
+#include "ShardedCache.h"
+#include "TranslationOptionList.h"
+
+namespace Moses
+{
+
+//! hash of the decode graph position and the factors of the source phrase
+struct TranslationOptionCacheKeyHash : public std::unary_function<std::pair<size_t, Phrase>, size_t> {
+  size_t operator()(const std::pair<size_t, Phrase> &key) const;
+};
+
+/** Persistent (cross-sentence) cache of translation options, keyed by
+ *  decode graph and source phrase, see ShardedCache.
+ */
+class TranslationOptionCache : public ShardedCache<std::pair<size_t, Phrase>, TranslationOptionList, TranslationOptionCacheKeyHash>
+{
+  typedef ShardedCache<std::pair<size_t, Phrase>, TranslationOptionList, TranslationOptionCacheKeyHash> Base;
+
+public:
+  typedef ValuePtr ListPtr;
+
+  explicit TranslationOptionCache(size_t maxSize = 0) : Base(maxSize) {}
+
+  //! cached options for the source phrase, or an empty pointer
+  ListPtr Find(size_t decodeGraphPos, const Phrase &sourcePhrase) const {
+    return Base::Find(std::make_pair(decodeGraphPos, sourcePhrase));
+  }
+  //! store a copy of the options for the source phrase
+  void Add(size_t decodeGraphPos, const Phrase &sourcePhrase, const TranslationOptionList &transOptList);
+};
+
+std::ostream& operator<<(std::ostream& out, const TranslationOptionCache& cache);
+
+}
+
+#endif
@@ -54,6 +54,7 @@ TranslationOptionCollection::TranslationOptionCollection(const TranslationSystem
     ,m_futureScore(src.GetSize())
     ,m_maxNoTransOptPerCoverage(maxNoTransOptPerCoverage)
     ,m_translationOptionThreshold(translationOptionThreshold)
+    ,m_timeFutureCost(0)
 {
   // create 2-d vector
   size_t size = src.GetSize();
@@ -406,7 +407,14 @@ void TranslationOptionCollection::CreateTranslationOptions()
   Sort();
 
   // future score matrix
+  clock_t t = 0;
+  IFSTATS {
+    t = GetThreadClock();
+  }
   CalcFutureScore();
+  IFSTATS {
+    m_timeFutureCost = GetThreadClock() - t;
+  }
 
   // Cached lex reodering costs
   CacheLexReordering();
@@ -453,9 +461,9 @@ void TranslationOptionCollection::CreateTranslationOptionsForRange(
       const WordsRange wordsRange(startPos, endPos);
       sourcePhrase = new Phrase(m_source.GetSubString(wordsRange));
 
-      const TranslationOptionList *transOptList = StaticData::Instance().FindTransOptListInCache(decodeGraph, *sourcePhrase);
+      TranslationOptionCache::ListPtr transOptList = StaticData::Instance().FindTransOptListInCache(decodeGraph, *sourcePhrase);
       // is phrase in cache?
-      if (transOptList != NULL) {
+      if (transOptList) {
         skipTransOptCreation = true;
         TranslationOptionList::const_iterator iterTransOpt;
         for (iterTransOpt = transOptList->begin() ; iterTransOpt != transOptList->end() ; ++iterTransOpt) {
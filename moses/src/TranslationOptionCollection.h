@@ -71,6 +71,7 @@ protected:
   const size_t				m_maxNoTransOptPerCoverage; /*< maximum number of translation options per input span */
   const float				m_translationOptionThreshold; /*< threshold for translation options with regard to best option for input span */
   std::vector<Phrase*> m_unksrcs;
+  clock_t m_timeFutureCost; /*< time spent in CalcFutureScore(), if collecting SentenceStats */
 
 
   TranslationOptionCollection(const TranslationSystem* system, InputType const& src, size_t maxNoTransOptPerCoverage,
@@ -131,6 +132,11 @@ public:
     return m_futureScore;
   }
 
+  //! part of the time in CreateTranslationOptions() taken by the future cost matrix
+  clock_t GetTimeFutureCost() const {
+    return m_timeFutureCost;
+  }
+
   //! list of trans opt for a particular span
   const TranslationOptionList &GetTranslationOptionList(const WordsRange &coverage) const {
     return GetTranslationOptionList(coverage.GetStartPos(), coverage.GetEndPos());
@@ -103,7 +103,6 @@ void TranslationSystem::ConfigDictionaries()
       if (pdict) {
         m_phraseDictionaries.push_back(pdict);
         AddFeatureFunction(pdict);
-        const_cast<PhraseDictionaryFeature*>(pdict)->InitDictionary(this);
       }
       GenerationDictionary* gdict = const_cast<GenerationDictionary*>(step->GetGenerationDictionaryFeature());
       if (gdict) {
@@ -135,6 +134,14 @@ void TranslationSystem::InitializeBeforeSentenceProcessing(const InputType& sour
   }
 }
 
+void TranslationSystem::InitializeSearchThread(const InputType& source) const
+{
+  // global lexical models keep the input sentence in thread local storage
+  for(size_t i=0; i<m_globalLexicalModels.size(); ++i) {
+    m_globalLexicalModels[i]->InitializeForInput((Sentence const&)source);
+  }
+}
+
 void TranslationSystem::CleanUpAfterSentenceProcessing() const
 {
 
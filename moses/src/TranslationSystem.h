@@ -63,7 +63,8 @@ public:
   //Insert non-core feature function
   void AddFeatureFunction(const FeatureFunction* featureFunction);
 
-  //Called after adding the tables in order to set up the dictionaries
+  //Called after adding the tables in order to set up the dictionaries.
+  //The phrase tables are loaded afterwards, with PhraseDictionaryFeature::InitDictionary()
   void ConfigDictionaries();
 
 
@@ -115,6 +116,8 @@ public:
   //sentence (and thread) specific initialisationn and cleanup
   void InitializeBeforeSentenceProcessing(const InputType& source) const;
   void CleanUpAfterSentenceProcessing() const;
+  //thread specific state needed to score hypotheses, for helper threads of the search
+  void InitializeSearchThread(const InputType& source) const;
 
 
 
@@ -55,6 +55,7 @@ const size_t DEFAULT_CUBE_PRUNING_POP_LIMIT = 1000;
 const size_t DEFAULT_CUBE_PRUNING_DIVERSITY = 0;
 const size_t DEFAULT_MAX_HYPOSTACK_SIZE = 200;
 const size_t DEFAULT_MAX_TRANS_OPT_CACHE_SIZE = 10000;
+const size_t DEFAULT_MAX_ON_DISK_RULE_CACHE_SIZE = 10000;
 const size_t DEFAULT_MAX_TRANS_OPT_SIZE	= 5000;
 const size_t DEFAULT_MAX_PART_TRANS_OPT_SIZE = 10000;
 const size_t DEFAULT_MAX_PHRASE_LENGTH = 20;
@@ -135,6 +136,7 @@ enum PhraseTableImplementation {
   ,SuffixArray	= 8
   ,Hiero        = 9
   ,ALSuffixArray = 10
+  ,BinaryMmap   = 11
 };
 
 enum InputTypeEnum {
@@ -122,6 +122,18 @@ double GetUserTime()
   return g_timer.get_elapsed_time();
 }
 
+clock_t GetThreadClock()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec now;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0) {
+    return static_cast<clock_t>(now.tv_sec) * CLOCKS_PER_SEC
+           + static_cast<clock_t>(now.tv_nsec / (1000000000 / CLOCKS_PER_SEC));
+  }
+#endif
+  return clock();
+}
+
 std::map<std::string, std::string> ProcessAndStripSGML(std::string &line)
 {
   std::map<std::string, std::string> meta;
@@ -32,6 +32,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <map>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include "util/check.hh"
 #include "TypeDef.h"
 
@@ -57,6 +58,8 @@ namespace Moses
  * */
 #define VERBOSE(level,str) { if (StaticData::Instance().GetVerboseLevel() >= level) { TRACE_ERR(str); } }
 #define IFVERBOSE(level) if (StaticData::Instance().GetVerboseLevel() >= level)
+//! guards the timing and counting for SentenceStats, see StaticData::CollectSentenceStats()
+#define IFSTATS if (StaticData::Instance().CollectSentenceStats())
 
 //! delete white spaces at beginning and end of string
 const std::string Trim(const std::string& str, const std::string dropChars = " \t\n\r");
@@ -342,6 +345,8 @@ bool FileExists(const std::string& filePath);
 void ResetUserTime();
 void PrintUserTime(const std::string &message);
 double GetUserTime();
+//! CPU time of the calling thread in clock() units, which unlike clock() leaves out the other threads
+clock_t GetThreadClock();
 
 // dump SGML parser for <seg> tags
 std::map<std::string, std::string> ProcessAndStripSGML(std::string &line);
@@ -29,17 +29,17 @@ TO_STRING_BODY(WordsBitmap);
 int WordsBitmap::GetFutureCosts(int lastPos) const
 {
   int sum=0;
-  bool aim1=0,ai=0,aip1=m_bitmap[0];
+  bool aim1=0,ai=0,aip1=GetValue(0);
 
   for(size_t i=0; i<m_size; ++i) {
     aim1 = ai;
     ai   = aip1;
-    aip1 = (i+1==m_size || m_bitmap[i+1]);
+    aip1 = (i+1==m_size || GetValue(i+1));
 
 #ifndef NDEBUG
-    if( i>0 ) CHECK( aim1==(i==0||m_bitmap[i-1]==1));
+    if( i>0 ) CHECK( aim1==(i==0||GetValue(i-1)));
     //CHECK( ai==a[i] );
-    if( i+1<m_size ) CHECK( aip1==m_bitmap[i+1]);
+    if( i+1<m_size ) CHECK( aip1==GetValue(i+1));
 #endif
     if((i==0||aim1)&&ai==0) {
       sum+=abs(lastPos-static_cast<int>(i)+1);
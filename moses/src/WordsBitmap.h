@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_WordsBitmap_h
 #define moses_WordsBitmap_h
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <iostream>
@@ -35,73 +36,146 @@ namespace Moses
 {
 typedef unsigned long WordsBitmapID;
 
-/** vector of boolean used to represent whether a word has been translated or not
+/** vector of boolean used to represent whether a word has been translated or not.
+ *  Bits are packed into 64-bit blocks; sentences of up to kInlineBlocks*64 words
+ *  are stored inline without touching the heap.
 */
 class WordsBitmap
 {
   friend std::ostream& operator<<(std::ostream& out, const WordsBitmap& wordsBitmap);
 protected:
+  typedef uint64_t Block;
+  static const size_t kBlockBits = 64;
+  static const size_t kInlineBlocks = 2;
+
   const size_t m_size; /**< number of words in sentence */
-  bool	*m_bitmap;	/**< ticks of words that have been done */
+  Block m_inline[kInlineBlocks]; /**< storage for short sentences */
+  Block *m_bitmap;	/**< ticks of words that have been done. Bits past m_size are always 0 */
 
   WordsBitmap(); // not implemented
+  WordsBitmap &operator=(const WordsBitmap &); // not implemented
+
+  static size_t NumBlocks(size_t size) {
+    return (size + kBlockBits - 1) / kBlockBits;
+  }
+  size_t GetNumBlocks() const {
+    return NumBlocks(m_size);
+  }
+  //! mask with bits [from, to] of one block set, 0 <= from <= to < kBlockBits
+  static Block RangeMask(size_t from, size_t to) {
+    Block upper = (to + 1 == kBlockBits) ? ~Block(0) : ((Block(1) << (to + 1)) - 1);
+    return upper & ~((Block(1) << from) - 1);
+  }
+  //! mask of the valid bits in the last block
+  Block LastBlockMask() const {
+    size_t used = m_size % kBlockBits;
+    return used ? RangeMask(0, used - 1) : ~Block(0);
+  }
+  static size_t PopCount(Block b) {
+    return __builtin_popcountll(b);
+  }
+  static size_t LowestBit(Block b) {
+    return __builtin_ctzll(b);
+  }
+  static size_t HighestBit(Block b) {
+    return kBlockBits - 1 - __builtin_clzll(b);
+  }
+
+  void Allocate() {
+    size_t numBlocks = GetNumBlocks();
+    m_bitmap = (numBlocks <= kInlineBlocks) ? m_inline : (Block*) malloc(sizeof(Block) * numBlocks);
+  }
 
   //! set all elements to false
   void Initialize() {
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      m_bitmap[pos] = false;
-    }
+    std::memset(m_bitmap, 0, sizeof(Block) * GetNumBlocks());
   }
 
   //sets elements by vector
-  void Initialize(std::vector<bool> vector) {
-    size_t vector_size = vector.size();
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (pos < vector_size && vector[pos] == true) m_bitmap[pos] = true;
-      else m_bitmap[pos] = false;
+  void Initialize(const std::vector<bool> &vector) {
+    Initialize();
+    size_t size = std::min(m_size, vector.size());
+    for (size_t pos = 0 ; pos < size ; pos++) {
+      if (vector[pos]) m_bitmap[pos / kBlockBits] |= Block(1) << (pos % kBlockBits);
+    }
+  }
+
+  //! bits [pos, pos+count) as an integer with pos as the least significant bit. count <= kBlockBits
+  Block GetBits(size_t pos, size_t count) const {
+    if (count == 0) return 0;
+    size_t block = pos / kBlockBits, offset = pos % kBlockBits;
+    Block ret = m_bitmap[block] >> offset;
+    if (offset && block + 1 < GetNumBlocks())
+      ret |= m_bitmap[block + 1] << (kBlockBits - offset);
+    return (count == kBlockBits) ? ret : (ret & ((Block(1) << count) - 1));
+  }
+
+  //! calls op(blockIndex, mask) for each block touched by [startPos, endPos]; stops when op returns true
+  template <class Op> bool ForEachBlockInRange(size_t startPos, size_t endPos, Op &op) const {
+    size_t firstBlock = startPos / kBlockBits, lastBlock = endPos / kBlockBits;
+    for (size_t block = firstBlock; block <= lastBlock; ++block) {
+      size_t from = (block == firstBlock) ? startPos % kBlockBits : 0;
+      size_t to = (block == lastBlock) ? endPos % kBlockBits : kBlockBits - 1;
+      if (op(block, RangeMask(from, to))) return true;
     }
+    return false;
   }
 
+  struct OverlapOp {
+    const Block *bitmap;
+    bool operator()(size_t block, Block mask) const {
+      return (bitmap[block] & mask) != 0;
+    }
+  };
+  struct SetOp {
+    Block *bitmap;
+    bool value;
+    bool operator()(size_t block, Block mask) const {
+      if (value) bitmap[block] |= mask;
+      else bitmap[block] &= ~mask;
+      return false;
+    }
+  };
 
 public:
   //! create WordsBitmap of length size and initialise with vector
-  WordsBitmap(size_t size, std::vector<bool> initialize_vector)
+  WordsBitmap(size_t size, const std::vector<bool> &initialize_vector)
     :m_size	(size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * size);
+    Allocate();
     Initialize(initialize_vector);
   }
   //! create WordsBitmap of length size and initialise
   WordsBitmap(size_t size)
     :m_size	(size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * size);
+    Allocate();
     Initialize();
   }
   //! deep copy
   WordsBitmap(const WordsBitmap &copy)
     :m_size	(copy.m_size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * m_size);
-    for (size_t pos = 0 ; pos < copy.m_size ; pos++) {
-      m_bitmap[pos] = copy.GetValue(pos);
-    }
+    Allocate();
+    std::memcpy(m_bitmap, copy.m_bitmap, sizeof(Block) * GetNumBlocks());
   }
   ~WordsBitmap() {
-    free(m_bitmap);
+    if (m_bitmap != m_inline) free(m_bitmap);
   }
   //! count of words translated
   size_t GetNumWordsCovered() const {
     size_t count = 0;
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (m_bitmap[pos])
-        count++;
+    for (size_t block = 0 ; block < GetNumBlocks() ; block++) {
+      count += PopCount(m_bitmap[block]);
     }
     return count;
   }
 
   //! position of 1st word not yet translated, or NOT_FOUND if everything already translated
   size_t GetFirstGapPos() const {
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (!m_bitmap[pos]) {
-        return pos;
+    size_t numBlocks = GetNumBlocks();
+    for (size_t block = 0 ; block < numBlocks ; block++) {
+      Block gaps = ~m_bitmap[block];
+      if (block + 1 == numBlocks) gaps &= LastBlockMask();
+      if (gaps) {
+        return block * kBlockBits + LowestBit(gaps);
       }
     }
     // no starting pos
@@ -111,9 +185,12 @@ public:
 
   //! position of last word not yet translated, or NOT_FOUND if everything already translated
   size_t GetLastGapPos() const {
-    for (int pos = (int) m_size - 1 ; pos >= 0 ; pos--) {
-      if (!m_bitmap[pos]) {
-        return pos;
+    size_t numBlocks = GetNumBlocks();
+    for (size_t block = numBlocks ; block > 0 ; block--) {
+      Block gaps = ~m_bitmap[block - 1];
+      if (block == numBlocks) gaps &= LastBlockMask();
+      if (gaps) {
+        return (block - 1) * kBlockBits + HighestBit(gaps);
       }
     }
     // no starting pos
@@ -123,9 +200,9 @@ public:
 
   //! position of last translated word
   size_t GetLastPos() const {
-    for (int pos = (int) m_size - 1 ; pos >= 0 ; pos--) {
-      if (m_bitmap[pos]) {
-        return pos;
+    for (size_t block = GetNumBlocks() ; block > 0 ; block--) {
+      if (m_bitmap[block - 1]) {
+        return (block - 1) * kBlockBits + HighestBit(m_bitmap[block - 1]);
       }
     }
     // no starting pos
@@ -134,29 +211,32 @@ public:
 
   //! whether a word has been translated at a particular position
   bool GetValue(size_t pos) const {
-    return m_bitmap[pos];
+    return (m_bitmap[pos / kBlockBits] >> (pos % kBlockBits)) & 1;
   }
   //! set value at a particular position
   void SetValue( size_t pos, bool value ) {
-    m_bitmap[pos] = value;
+    Block bit = Block(1) << (pos % kBlockBits);
+    if (value) m_bitmap[pos / kBlockBits] |= bit;
+    else m_bitmap[pos / kBlockBits] &= ~bit;
   }
   //! set value between 2 positions, inclusive
   void SetValue( size_t startPos, size_t endPos, bool value ) {
-    for(size_t pos = startPos ; pos <= endPos ; pos++) {
-      m_bitmap[pos] = value;
-    }
+    if (endPos < startPos) return;
+    SetOp op;
+    op.bitmap = m_bitmap;
+    op.value = value;
+    ForEachBlockInRange(startPos, endPos, op);
   }
   //! whether every word has been translated
   bool IsComplete() const {
-    return GetSize() == GetNumWordsCovered();
+    return GetFirstGapPos() == NOT_FOUND;
   }
   //! whether the wordrange overlaps with any translated word in this bitmap
   bool Overlap(const WordsRange &compare) const {
-    for (size_t pos = compare.GetStartPos() ; pos <= compare.GetEndPos() ; pos++) {
-      if (m_bitmap[pos])
-        return true;
-    }
-    return false;
+    if (compare.GetEndPos() < compare.GetStartPos()) return false;
+    OverlapOp op;
+    op.bitmap = m_bitmap;
+    return ForEachBlockInRange(compare.GetStartPos(), compare.GetEndPos(), op);
   }
   //! number of elements
   size_t GetSize() const {
@@ -175,27 +255,43 @@ public:
     if (thisSize != compareSize) {
       return (thisSize < compareSize) ? -1 : 1;
     }
-    return std::memcmp(m_bitmap, compare.m_bitmap, thisSize * sizeof(bool));
+    // same order as a position-by-position comparison: the lowest differing position decides
+    for (size_t block = 0 ; block < GetNumBlocks() ; block++) {
+      Block diff = m_bitmap[block] ^ compare.m_bitmap[block];
+      if (diff) {
+        return (m_bitmap[block] & (diff & (~diff + 1))) ? 1 : -1;
+      }
+    }
+    return 0;
   }
 
   bool operator< (const WordsBitmap &compare) const {
     return Compare(compare) < 0;
   }
 
+  //! position just right of the closest translated word left of l, or 0 if there is none
   inline size_t GetEdgeToTheLeftOf(size_t l) const {
     if (l == 0) return l;
-    while (l && !m_bitmap[l-1]) {
-      --l;
+    size_t block = (l - 1) / kBlockBits;
+    Block bits = m_bitmap[block] & RangeMask(0, (l - 1) % kBlockBits);
+    while (true) {
+      if (bits) return block * kBlockBits + HighestBit(bits) + 1;
+      if (block == 0) return 0;
+      bits = m_bitmap[--block];
     }
-    return l;
   }
 
+  //! position just left of the closest translated word right of r, or the last position if there is none
   inline size_t GetEdgeToTheRightOf(size_t r) const {
-    if (r+1 == m_size) return r;
-    while (r+1 < m_size && !m_bitmap[r+1]) {
-      ++r;
+    if (r+1 >= m_size) return r;
+    size_t numBlocks = GetNumBlocks();
+    size_t block = (r + 1) / kBlockBits;
+    Block bits = m_bitmap[block] & RangeMask((r + 1) % kBlockBits, kBlockBits - 1);
+    while (true) {
+      if (bits) return block * kBlockBits + LowestBit(bits) - 1;
+      if (++block == numBlocks) return m_size - 1;
+      bits = m_bitmap[block];
     }
-    return r;
   }
 
 
@@ -214,8 +310,8 @@ public:
 
     CHECK(end < start || end-start <= 16);
     WordsBitmapID id = 0;
-    for(size_t pos = end; pos > start; pos--) {
-      id = id*2 + (int) GetValue(pos);
+    if (end > start) {
+      id = GetBits(start + 1, end - start);
     }
     return id + (1<<16) * start;
   }
@@ -235,10 +331,13 @@ public:
 
     CHECK(end < start || end-start <= 16);
     WordsBitmapID id = 0;
-    for(size_t pos = end; pos > start; pos--) {
-      id = id*2;
-      if (GetValue(pos) || (startPos<=pos && pos<=endPos))
-        id++;
+    if (end > start) {
+      id = GetBits(start + 1, end - start);
+      // add the span [startPos, endPos], clipped to the window (start, end]
+      size_t from = std::max(startPos, start + 1), to = std::min(endPos, end);
+      if (from <= to) {
+        id |= RangeMask(from - start - 1, to - start - 1);
+      }
     }
     return id + (1<<16) * start;
   }
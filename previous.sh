@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam cxxflags=-std=gnu++98 -include unistd.h -w moses/src//score_component_collection_test moses/src//dyn_suffix_array_test moses/src//bilingual_dyn_suffix_array_test lm//left_test lm//model_test
@@ -104,6 +104,13 @@ template <class EntryT, class HashT, class EqualT = std::equal_to<typename Entry
       }    
     }
 
+    // Start fetching the bucket where Find(key) will start probing.  
+    template <class Key> void Prefetch(const Key key) const {
+#ifdef __GNUC__
+      __builtin_prefetch(begin_ + (hash_(key) % buckets_));
+#endif
+    }
+
   private:
     MutableIterator begin_;
     std::size_t buckets_;